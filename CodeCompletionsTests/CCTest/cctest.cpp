@@ -14,6 +14,8 @@
 #include <stringsearcher.h>
 #include <parse_thread.h>
 #include <wx/tokenzr.h>
+#include <wx/stopwatch.h>
+#include <tags_storage_sqlite3.h>
 
 // CodeLite includes
 #include <ctags_manager.h>
@@ -560,6 +562,75 @@ void testRetagWorkspace()
     LanguageST::Free();
 }
 
+/**
+ * @brief store 'totalTags' synthetic tags into a fresh database and report the rows/sec
+ * @param deferIndexes build the search indexes after the tags are stored
+ */
+void benchmarkTagsStorageBulkInsert(size_t totalTags, bool deferIndexes)
+{
+    static const size_t TAGS_PER_FILE = 200;
+
+    wxFileName dbfile(wxT("benchmark.tags"));
+    if(dbfile.FileExists()) {
+        wxRemoveFile(dbfile.GetFullPath());
+    }
+
+    TagsStorageSQLite db;
+    db.OpenDatabase(dbfile);
+
+    wxStopWatch sw;
+    db.BeginBulkInsert(deferIndexes);
+    db.Begin();
+
+    // Generate the tags file by file, so we dont hold 2M tags in memory
+    size_t stored = 0;
+    size_t fileIndex = 0;
+    TagEntryPtrVector_t tags;
+    tags.reserve(TAGS_PER_FILE);
+    while(stored < totalTags) {
+        wxString file = wxString::Format(wxT("/tmp/benchmark/file_%u.cpp"), (unsigned int)fileIndex);
+        wxString klass = wxString::Format(wxT("Class_%u"), (unsigned int)fileIndex);
+        tags.clear();
+        for(size_t i = 0; i < TAGS_PER_FILE && stored < totalTags; ++i, ++stored) {
+            TagEntryPtr tag(new TagEntry());
+            wxString name = wxString::Format(wxT("Method_%u"), (unsigned int)i);
+            tag->SetName(name);
+            tag->SetFile(file);
+            tag->SetLine((int)i + 1);
+            tag->SetKind(i == 0 ? wxT("class") : wxT("function"));
+            tag->SetAccess(wxT("public"));
+            tag->SetSignature(wxT("(int a, const wxString& b)"));
+            tag->SetPattern(wxT("/^void ") + name + wxT("(int a, const wxString& b) {$/"));
+            tag->SetParent(i == 0 ? wxString(wxT("<global>")) : klass);
+            tag->SetPath(i == 0 ? klass : klass + wxT("::") + name);
+            tag->SetScope(i == 0 ? wxString(wxT("<global>")) : klass);
+            tag->SetReturnValue(wxT("void"));
+            tags.push_back(tag);
+        }
+        db.Store(tags, false);
+
+        // Same commit pattern as the parser thread
+        if(++fileIndex % 500 == 0) {
+            db.Commit();
+            db.Begin();
+        }
+    }
+
+    db.Commit();
+    long insertTime = sw.Time();
+    db.EndBulkInsert();
+    long totalTime = sw.Time();
+
+    double rowsPerSec = totalTime > 0 ? ((double)stored * 1000.0 / (double)totalTime) : 0.0;
+    wxPrintf(wxT("Bulk insert (%s): %u tags, inserts: %ld ms, indexes: %ld ms, total: %ld ms (%.0f rows/sec)\n"),
+             deferIndexes ? wxT("deferred indexes") : wxT("live indexes"),
+             (unsigned int)stored,
+             insertTime,
+             totalTime - insertTime,
+             totalTime,
+             rowsPerSec);
+}
+
 /**
  * @brief call the test framework
  */
@@ -569,6 +640,17 @@ int main(int argc, char** argv)
     wxInitializer initializer;
     // testRetagWorkspace();
     // testStringSearcher();
+
+    // cctest --benchmark-bulk-insert [number of tags]
+    if(argc > 1 && wxString(argv[1]) == wxT("--benchmark-bulk-insert")) {
+        long totalTags = 2000000;
+        if(argc > 2) {
+            wxString(argv[2]).ToLong(&totalTags);
+        }
+        benchmarkTagsStorageBulkInsert((size_t)totalTags, false);
+        benchmarkTagsStorageBulkInsert((size_t)totalTags, true);
+        return 0;
+    }
     testCC();
     return 0;
 }
@@ -1,4 +1,5 @@
 #include "CxxPreProcessor.h"
+#include "CxxPreProcessorSharedCache.h"
 #include <wx/regex.h>
 #include "file_logger.h"
 
@@ -50,10 +51,6 @@ CxxPreProcessor::ExpandInclude(const wxFileName& currentFile, const wxString& in
     includeName.Replace("<", "");
     includeName.Replace(">", "");
 
-    // Try the current file's directory first
-    wxArrayString paths = m_includePaths;
-    paths.Insert(currentFile.GetPath(), 0);
-
     if(m_noSuchFiles.count(includeStatement)) {
         // wxPrintf("No such file hit\n");
         return false;
@@ -67,22 +64,14 @@ CxxPreProcessor::ExpandInclude(const wxFileName& currentFile, const wxString& in
         return false;
     }
 
-    for(size_t i = 0; i < paths.GetCount(); ++i) {
-        wxString tmpfile;
-        tmpfile << paths.Item(i) << "/" << includeName;
-        wxFileName fn(tmpfile);
-        tmpfile = fn.GetFullPath();
-        // CL_DEBUG(" ... Checking include file: %s\n", fn.GetFullPath());
-        struct stat buff;
-        if(stat(tmpfile.mb_str(wxConvUTF8).data(), &buff) == 0) {
-            CL_DEBUG1(" ==> Creating scanner for file: %s\n", tmpfile);
-            wxFileName fixedFileName(tmpfile);
-            fixedFileName.Normalize(wxPATH_NORM_DOTS);
-            tmpfile = fixedFileName.GetFullPath();
-            m_fileMapping.insert(std::make_pair(includeStatement, tmpfile));
-            outFile = fixedFileName;
-            return true;
-        }
+    // The resolution (the current file's directory first, then the include paths) is shared with
+    // the other translation units
+    wxString tmpfile;
+    if(CxxPreProcessorSharedCache::Get().ResolveInclude(m_includePaths, currentFile.GetPath(), includeName, tmpfile)) {
+        CL_DEBUG1(" ==> Creating scanner for file: %s\n", tmpfile);
+        m_fileMapping.insert(std::make_pair(includeStatement, tmpfile));
+        outFile = wxFileName(tmpfile);
+        return true;
     }
 
     // remember that we could not locate this include statement
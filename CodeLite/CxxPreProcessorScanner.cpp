@@ -6,25 +6,37 @@
 #include "file_logger.h"
 
 CxxPreProcessorScanner::CxxPreProcessorScanner(const wxFileName& filename, size_t options)
-    : m_scanner(NULL)
+    : m_pos(0)
     , m_filename(filename)
     , m_options(options)
 {
-    m_scanner = ::LexerNew(m_filename, m_options);
+    m_tokens = CxxPreProcessorSharedCache::Get().GetFileTokens(m_filename, m_options);
 }
 
 CxxPreProcessorScanner::~CxxPreProcessorScanner()
 {
-    if(m_scanner) {
-        ::LexerDestroy(&m_scanner);
+    if(m_tokens) {
+        CxxPreProcessorSharedCache::Get().ReleaseFile(m_filename);
     }
 }
 
+bool CxxPreProcessorScanner::Next(CxxLexerToken& token)
+{
+    if(!m_tokens || m_pos >= m_tokens->GetCount()) return false;
+    m_tokens->GetToken(m_pos++, token);
+    return true;
+}
+
+void CxxPreProcessorScanner::Unget()
+{
+    if(m_pos > 0) --m_pos;
+}
+
 void CxxPreProcessorScanner::GetRestOfPPLine(wxString& rest, bool collectNumberOnly)
 {
     CxxLexerToken token;
     bool numberFound = false;
-    while(::LexerNext(m_scanner, token) && token.type != T_PP_STATE_EXIT) {
+    while(Next(token) && token.type != T_PP_STATE_EXIT) {
         if(!numberFound && collectNumberOnly) {
             if(token.type == T_PP_DEC_NUMBER || token.type == T_PP_OCTAL_NUMBER || token.type == T_PP_HEX_NUMBER ||
                token.type == T_PP_FLOAT_NUMBER) {
@@ -42,7 +54,7 @@ bool CxxPreProcessorScanner::ConsumeBlock()
 {
     CxxLexerToken token;
     int depth = 1;
-    while(::LexerNext(m_scanner, token)) {
+    while(Next(token)) {
         switch(token.type) {
         case T_PP_ENDIF:
             depth--;
@@ -69,7 +81,7 @@ void CxxPreProcessorScanner::Parse(CxxPreProcessor* pp) throw(CxxLexerException)
     CxxLexerToken token;
     bool searchingForBranch = false;
     CxxPreProcessorToken::Map_t& ppTable = pp->GetTokens();
-    while(::LexerNext(m_scanner, token)) {
+    while(Next(token)) {
         // Pre Processor state
         switch(token.type) {
         case T_PP_INCLUDE_FILENAME: {
@@ -78,7 +90,9 @@ void CxxPreProcessorScanner::Parse(CxxPreProcessor* pp) throw(CxxLexerException)
             if(pp->ExpandInclude(m_filename, token.text, include)) {
                 CxxPreProcessorScanner* scanner = new CxxPreProcessorScanner(include, pp->GetOptions());
                 try {
-                    scanner->Parse(pp);
+                    if(!scanner->IsNull()) {
+                        scanner->Parse(pp);
+                    }
                 } catch(CxxLexerException& e) {
                     // catch the exception
                     CL_DEBUG("Exception caught: %s\n", e.message);
@@ -164,7 +178,7 @@ void CxxPreProcessorScanner::Parse(CxxPreProcessor* pp) throw(CxxLexerException)
             return;
         }
         case T_PP_DEFINE: {
-            if(!::LexerNext(m_scanner, token) || token.type != T_PP_IDENTIFIER) {
+            if(!Next(token) || token.type != T_PP_IDENTIFIER) {
                 // Recover
                 wxString dummy;
                 GetRestOfPPLine(dummy);
@@ -192,7 +206,7 @@ void CxxPreProcessorScanner::Parse(CxxPreProcessor* pp) throw(CxxLexerException)
 bool CxxPreProcessorScanner::CheckIfDefined(const CxxPreProcessorToken::Map_t& table)
 {
     CxxLexerToken token;
-    if(::LexerNext(m_scanner, token)) {
+    if(Next(token)) {
         if(token.type == T_PP_STATE_EXIT) {
             return false;
         }
@@ -235,7 +249,7 @@ bool CxxPreProcessorScanner::CheckIf(const CxxPreProcessorToken::Map_t& table)
     CxxPreProcessorExpression* cur = new CxxPreProcessorExpression(false);
     ExpressionLocker locker(cur);
     CxxPreProcessorExpression* head = cur;
-    while(::LexerNext(m_scanner, token)) {
+    while(Next(token)) {
         if(token.type == T_PP_STATE_EXIT) {
             bool res = head->IsTrue();
             return res;
@@ -357,7 +371,7 @@ bool CxxPreProcessorScanner::ConsumeCurrentBranch()
     // T_PP_ELIF
     // T_PP_ELSE
     // T_PP_ENDIF
-    while(::LexerNext(m_scanner, token)) {
+    while(Next(token)) {
         switch(token.type) {
         case T_PP_IF:
         case T_PP_IFDEF:
@@ -375,7 +389,7 @@ bool CxxPreProcessorScanner::ConsumeCurrentBranch()
         case T_PP_ELSE:
             if(depth == 1) {
                 DEBUGMSG("=> ConsumeCurrentBranch until line %d (before token '%s')\n", token.lineNumber, token.text);
-                ::LexerUnget(m_scanner);
+                Unget();
                 return true;
             }
             break;
@@ -388,7 +402,7 @@ bool CxxPreProcessorScanner::ConsumeCurrentBranch()
 
 void CxxPreProcessorScanner::ReadUntilMatch(int type, CxxLexerToken& token) throw(CxxLexerException)
 {
-    while(::LexerNext(m_scanner, token)) {
+    while(Next(token)) {
         if(token.type == type) {
             return;
         } else if(token.type == T_PP_STATE_EXIT) {
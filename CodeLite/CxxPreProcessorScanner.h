@@ -2,6 +2,7 @@
 #define CXXPREPROCESSORSCANNER_H
 
 #include "CxxLexerAPI.h"
+#include "CxxPreProcessorSharedCache.h"
 #include <wx/string.h>
 #include <list>
 #include <wx/sharedptr.h>
@@ -11,7 +12,8 @@ class CxxPreProcessor;
 class WXDLLIMPEXP_CL CxxPreProcessorScanner
 {
 protected:
-    Scanner_t m_scanner;
+    CxxPreProcessorSharedCache::FileTokens::Ptr_t m_tokens;
+    size_t m_pos;
     wxFileName m_filename;
     size_t m_options;
     
@@ -19,6 +21,14 @@ public:
     typedef wxSharedPtr<CxxPreProcessorScanner> Ptr_t;
     
 private:
+    /**
+     * @brief return the next token of the file (from the shared cache)
+     */
+    bool Next(CxxLexerToken& token);
+    /**
+     * @brief unget the last token
+     */
+    void Unget();
     /**
      * @brief run the scanner until we reach the closing #endif
      * directive
@@ -51,7 +61,7 @@ public:
      * @brief return true if we got a valid scanner
      */
     bool IsNull() const {
-        return m_scanner == NULL;;
+        return !m_tokens;
     }
     
     virtual ~CxxPreProcessorScanner();
@@ -0,0 +1,238 @@
+#include "CxxPreProcessorSharedCache.h"
+#include "CxxScannerTokens.h"
+#include <string.h>
+#include <sys/stat.h>
+
+CxxPreProcessorSharedCache::FileTokens::FileTokens()
+    : m_lastModified(0)
+    , m_size(0)
+    , m_lexerOptions(0)
+{
+}
+
+CxxPreProcessorSharedCache::FileTokens::~FileTokens() {}
+
+void CxxPreProcessorSharedCache::FileTokens::GetToken(size_t index, CxxLexerToken& token) const
+{
+    const Token& t = m_tokens.at(index);
+    token.type = t.type;
+    token.lineNumber = t.lineNumber;
+    token.column = 0;
+    // the consumers never modify the token text
+    token.text = const_cast<char*>(&m_text.at(t.text));
+}
+
+CxxPreProcessorSharedCache::CxxPreProcessorSharedCache() {}
+
+CxxPreProcessorSharedCache::~CxxPreProcessorSharedCache() {}
+
+CxxPreProcessorSharedCache& CxxPreProcessorSharedCache::Get()
+{
+    static CxxPreProcessorSharedCache cache;
+    return cache;
+}
+
+bool CxxPreProcessorSharedCache::DoStat(const wxString& filename, time_t& lastModified, off_t& size)
+{
+    struct stat buff;
+    if(stat(filename.mb_str(wxConvUTF8).data(), &buff) != 0) return false;
+    lastModified = buff.st_mtime;
+    size = buff.st_size;
+    return true;
+}
+
+wxString CxxPreProcessorSharedCache::DoNormalize(const wxString& filename)
+{
+    wxFileName fn(filename);
+    fn.Normalize(wxPATH_NORM_DOTS);
+    return fn.GetFullPath();
+}
+
+wxString CxxPreProcessorSharedCache::DoGetFullPath(const wxFileName& filename)
+{
+    wxFileName fn = filename;
+    if(fn.IsRelative()) {
+        fn.MakeAbsolute();
+    }
+    return fn.GetFullPath();
+}
+
+CxxPreProcessorSharedCache::FileTokens::Ptr_t CxxPreProcessorSharedCache::DoCollectTokens(const wxString& filename,
+                                                                                          size_t lexerOptions)
+{
+    Scanner_t scanner = ::LexerNew(wxFileName(filename), lexerOptions);
+    if(!scanner) return FileTokens::Ptr_t(NULL);
+
+    FileTokens::Ptr_t tokens(new FileTokens());
+    tokens->m_lexerOptions = lexerOptions;
+
+    // Keep only the tokens found in the pre processor state: everything else is skipped by the
+    // pre processor scanner anyway. A directive starts with a T_PP_* token and ends with T_PP_STATE_EXIT
+    bool inPP = false;
+    CxxLexerToken token;
+    while(::LexerNext(scanner, token)) {
+        bool isPP = (token.type >= T_PP_DEFINE && token.type <= T_PP_LTEQ);
+        if(!isPP && !inPP) continue;
+        inPP = (token.type != T_PP_STATE_EXIT);
+
+        FileTokens::Token t;
+        t.type = token.type;
+        t.lineNumber = token.lineNumber;
+        t.text = tokens->m_text.size();
+        if(token.text) {
+            tokens->m_text.insert(tokens->m_text.end(), token.text, token.text + strlen(token.text));
+        }
+        tokens->m_text.push_back(0);
+        tokens->m_tokens.push_back(t);
+    }
+    ::LexerDestroy(&scanner);
+    return tokens;
+}
+
+CxxPreProcessorSharedCache::FileTokens::Ptr_t CxxPreProcessorSharedCache::GetFileTokens(const wxFileName& filename,
+                                                                                        size_t options)
+{
+    wxString path = DoGetFullPath(filename);
+    // Only these options change what the lexer returns
+    size_t lexerOptions = options & (kLexerOpt_ReturnComments | kLexerOpt_ReturnWhitespace);
+
+    time_t lastModified;
+    off_t size;
+    if(!DoStat(path, lastModified, size)) {
+        wxMutexLocker locker(m_mutex);
+        m_files.erase(path);
+        return FileTokens::Ptr_t(NULL);
+    }
+
+    {
+        wxMutexLocker locker(m_mutex);
+        FileTokensMap_t::iterator iter = m_files.find(path);
+        if(iter != m_files.end() && iter->second->m_lastModified == lastModified && iter->second->m_size == size &&
+           iter->second->m_lexerOptions == lexerOptions) {
+            return iter->second;
+        }
+    }
+
+    // Lex the file without holding the lock
+    FileTokens::Ptr_t tokens = DoCollectTokens(path, lexerOptions);
+    if(!tokens) return tokens;
+    tokens->m_lastModified = lastModified;
+    tokens->m_size = size;
+
+    // The cache is shared by all the threads, keep a copy of the content of the strings
+    wxMutexLocker locker(m_mutex);
+    m_files[wxString(path.c_str())] = tokens;
+    return tokens;
+}
+
+void CxxPreProcessorSharedCache::ReleaseFile(const wxFileName& filename)
+{
+    wxString path = DoGetFullPath(filename);
+    time_t lastModified;
+    off_t size;
+    if(DoStat(path, lastModified, size)) return;
+
+    wxMutexLocker locker(m_mutex);
+    m_files.erase(path);
+}
+
+bool CxxPreProcessorSharedCache::DoFileExists(const wxString& filename)
+{
+    {
+        wxMutexLocker locker(m_mutex);
+        std::map<wxString, bool>::iterator iter = m_fileExists.find(filename);
+        if(iter != m_fileExists.end()) return iter->second;
+    }
+
+    time_t lastModified;
+    off_t size;
+    bool exists = DoStat(filename, lastModified, size);
+
+    wxMutexLocker locker(m_mutex);
+    m_fileExists[wxString(filename.c_str())] = exists;
+    return exists;
+}
+
+bool CxxPreProcessorSharedCache::ResolveInclude(const wxArrayString& includePaths,
+                                                const wxString& currentDir,
+                                                const wxString& includeName,
+                                                wxString& fullpath)
+{
+    // Try the current file's directory first
+    wxString tmpfile;
+    tmpfile << currentDir << "/" << includeName;
+    tmpfile = wxFileName(tmpfile).GetFullPath();
+    if(DoFileExists(tmpfile)) {
+        fullpath = DoNormalize(tmpfile);
+        return true;
+    }
+
+    wxString key;
+    for(size_t i = 0; i < includePaths.GetCount(); ++i) {
+        key << includePaths.Item(i) << "\n";
+    }
+
+    IncludePathsCache::Ptr_t cache;
+    {
+        wxMutexLocker locker(m_mutex);
+        IncludePathsCacheMap_t::iterator iter = m_includePaths.find(key);
+        if(iter == m_includePaths.end()) {
+            cache.reset(new IncludePathsCache());
+            m_includePaths.insert(std::make_pair(wxString(key.c_str()), cache));
+        } else {
+            cache = iter->second;
+            std::map<wxString, wxString>::iterator resolved = cache->resolved.find(includeName);
+            if(resolved != cache->resolved.end()) {
+                fullpath = resolved->second.c_str();
+                return !fullpath.IsEmpty();
+            }
+        }
+    }
+
+    fullpath.Clear();
+    for(size_t i = 0; i < includePaths.GetCount(); ++i) {
+        wxString tmpfile;
+        tmpfile << includePaths.Item(i) << "/" << includeName;
+        tmpfile = wxFileName(tmpfile).GetFullPath();
+        time_t lastModified;
+        off_t size;
+        if(DoStat(tmpfile, lastModified, size)) {
+            fullpath = DoNormalize(tmpfile);
+            break;
+        }
+    }
+
+    // remember the result, even if we could not locate the include file
+    wxMutexLocker locker(m_mutex);
+    cache->resolved[wxString(includeName.c_str())] = fullpath.c_str();
+    return !fullpath.IsEmpty();
+}
+
+void CxxPreProcessorSharedCache::FileSaved(const wxString& filename)
+{
+    wxString path = DoGetFullPath(wxFileName(filename));
+
+    wxMutexLocker locker(m_mutex);
+    if(m_files.count(path)) return;
+    std::map<wxString, bool>::iterator iter = m_fileExists.find(path);
+    if(iter != m_fileExists.end() && iter->second) return;
+
+    // a file we did not know about
+    m_includePaths.clear();
+    m_fileExists.clear();
+}
+
+void CxxPreProcessorSharedCache::ClearIncludes()
+{
+    wxMutexLocker locker(m_mutex);
+    m_includePaths.clear();
+    m_fileExists.clear();
+}
+
+void CxxPreProcessorSharedCache::Clear()
+{
+    wxMutexLocker locker(m_mutex);
+    m_includePaths.clear();
+    m_fileExists.clear();
+    m_files.clear();
+}
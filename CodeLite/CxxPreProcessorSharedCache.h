@@ -0,0 +1,130 @@
+#ifndef CXXPREPROCESSORSHAREDCACHE_H
+#define CXXPREPROCESSORSHAREDCACHE_H
+
+#include "CxxLexerAPI.h"
+#include "codelite_exports.h"
+#include <wx/arrstr.h>
+#include <wx/filename.h>
+#include <wx/sharedptr.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+#include <map>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * @class CxxPreProcessorSharedCache
+ * @brief a process-wide cache shared by all the CxxPreProcessor instances.
+ * It keeps:
+ * - for every file that was scanned: its pre processor tokens (the directives only, not evaluated). A translation
+ *   unit replays the tokens of a header instead of lexing it again. The tokens are re-collected when the file
+ *   modification time (or size) changes
+ * - for every set of include paths: how each include statement was resolved, including the statements that could
+ *   not be resolved. Candidates relative to the including file's directory are cached as well
+ * The directives are kept as-is, so the same tokens serve any set of definitions and any include paths
+ */
+class WXDLLIMPEXP_CL CxxPreProcessorSharedCache
+{
+public:
+    /**
+     * @class FileTokens
+     * @brief the pre processor tokens of a single file, in the order the lexer returned them
+     */
+    class WXDLLIMPEXP_CL FileTokens
+    {
+        friend class CxxPreProcessorSharedCache;
+        struct Token {
+            int type;
+            int lineNumber;
+            size_t text; // offset into m_text
+        };
+        std::vector<Token> m_tokens;
+        std::vector<char> m_text; // NULL terminated tokens text
+        time_t m_lastModified;
+        off_t m_size;
+        size_t m_lexerOptions;
+
+    public:
+        typedef wxSharedPtr<FileTokens> Ptr_t;
+
+        FileTokens();
+        virtual ~FileTokens();
+
+        size_t GetCount() const { return m_tokens.size(); }
+        /**
+         * @brief fill 'token' with the token at 'index'. The token text remains valid as long as this object is alive
+         */
+        void GetToken(size_t index, CxxLexerToken& token) const;
+    };
+
+protected:
+    class IncludePathsCache
+    {
+    public:
+        typedef wxSharedPtr<IncludePathsCache> Ptr_t;
+        std::map<wxString, wxString> resolved; // include name -> full path, empty for "not found"
+    };
+
+    typedef std::map<wxString, FileTokens::Ptr_t> FileTokensMap_t;
+    typedef std::map<wxString, IncludePathsCache::Ptr_t> IncludePathsCacheMap_t;
+
+    wxMutex m_mutex;
+    FileTokensMap_t m_files;
+    IncludePathsCacheMap_t m_includePaths;
+    std::map<wxString, bool> m_fileExists; // include candidates relative to the including file's directory
+
+protected:
+    static FileTokens::Ptr_t DoCollectTokens(const wxString& filename, size_t lexerOptions);
+    static bool DoStat(const wxString& filename, time_t& lastModified, off_t& size);
+    static wxString DoNormalize(const wxString& filename);
+    static wxString DoGetFullPath(const wxFileName& filename);
+    bool DoFileExists(const wxString& filename);
+
+    CxxPreProcessorSharedCache();
+    virtual ~CxxPreProcessorSharedCache();
+
+public:
+    static CxxPreProcessorSharedCache& Get();
+
+    /**
+     * @brief return the pre processor tokens of 'filename'. The file is lexed only if it was not seen yet, or if
+     * it was modified since
+     * @param options the lexer options (only the ones that affect the lexer output are used)
+     * @return NULL if the file could not be opened
+     */
+    FileTokens::Ptr_t GetFileTokens(const wxFileName& filename, size_t options);
+
+    /**
+     * @brief the caller is done with 'filename'. Its tokens are dropped if the file no longer exists (e.g. a
+     * temporary file), it will not be scanned again
+     */
+    void ReleaseFile(const wxFileName& filename);
+
+    /**
+     * @brief resolve an include name: first relative to 'currentDir' and then using 'includePaths' (in order)
+     * @param fullpath [output] the normalized full path of the include file
+     * @return false if the include file could not be found
+     */
+    bool ResolveInclude(const wxArrayString& includePaths,
+                        const wxString& currentDir,
+                        const wxString& includeName,
+                        wxString& fullpath);
+
+    /**
+     * @brief a file was saved. If the file is new to the cache, all the include resolutions are dropped: it
+     * might satisfy an include statement that was not found before (or shadow another file)
+     */
+    void FileSaved(const wxString& filename);
+
+    /**
+     * @brief drop all the include resolutions (e.g. files were generated by a build)
+     */
+    void ClearIncludes();
+
+    /**
+     * @brief clear the cache content
+     */
+    void Clear();
+};
+
+#endif // CXXPREPROCESSORSHAREDCACHE_H
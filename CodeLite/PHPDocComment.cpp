@@ -1,7 +1,79 @@
 #include "PHPDocComment.h"
 #include <wx/regex.h>
 #include <wx/tokenzr.h>
+#include <wx/thread.h>
 #include <set>
+#include <vector>
+
+namespace
+{
+/**
+ * @brief the doc comment regular expressions. Source files are parsed on several threads at once and
+ * a wxRegEx can not be used by two threads at the same time: every comment takes a private set from the pool
+ */
+struct PHPDocRegexes {
+    wxRegEx reReturnStatement;
+    wxRegEx reVarType;
+    wxRegEx reVarType2;
+    wxRegEx reParam2; // @param PDO $name
+
+    PHPDocRegexes()
+        : reReturnStatement(wxT("@(return)[ \t]+([\\a-zA-Z_]{1}[\\|\\a-zA-Z0-9_]*)"))
+        , reVarType(wxT("@(var|variable)[ \t]+([\\a-zA-Z_]{1}[\\a-zA-Z0-9_]*)"))
+        , reVarType2(wxT("@(var|variable)[ \t]+([\\$]{1}[\\a-zA-Z0-9_]*)[ \t]+([\\a-zA-Z0-9_]+)"))
+        , reParam2(wxT("@(param|parameter)[ \t]+([\\a-zA-Z0-9_]*)[ \t]+([\\$]{1}[\\a-zA-Z0-9_]+)"))
+    {
+    }
+};
+
+class PHPDocRegexesPool
+{
+    std::vector<PHPDocRegexes*> m_free;
+    wxMutex m_mutex;
+
+public:
+    ~PHPDocRegexesPool()
+    {
+        for(size_t i = 0; i < m_free.size(); ++i) {
+            delete m_free.at(i);
+        }
+    }
+
+    PHPDocRegexes* Take()
+    {
+        {
+            wxMutexLocker locker(m_mutex);
+            if(!m_free.empty()) {
+                PHPDocRegexes* regexes = m_free.back();
+                m_free.pop_back();
+                return regexes;
+            }
+        }
+        return new PHPDocRegexes();
+    }
+
+    void Return(PHPDocRegexes* regexes)
+    {
+        wxMutexLocker locker(m_mutex);
+        m_free.push_back(regexes);
+    }
+};
+
+PHPDocRegexesPool& GetRegexesPool()
+{
+    static PHPDocRegexesPool pool;
+    return pool;
+}
+
+struct PHPDocRegexesLocker {
+    PHPDocRegexes* regexes;
+    PHPDocRegexesLocker()
+        : regexes(GetRegexesPool().Take())
+    {
+    }
+    ~PHPDocRegexesLocker() { GetRegexesPool().Return(regexes); }
+};
+}
 
 PHPDocComment::PHPDocComment(PHPSourceFile& sourceFile, const wxString& comment)
     : m_comment(comment)
@@ -21,7 +93,8 @@ PHPDocComment::PHPDocComment(PHPSourceFile& sourceFile, const wxString& comment)
     nativeTypes.insert("mixed");
     nativeTypes.insert("null");
 
-    static wxRegEx reReturnStatement(wxT("@(return)[ \t]+([\\a-zA-Z_]{1}[\\|\\a-zA-Z0-9_]*)"));
+    PHPDocRegexesLocker locker;
+    wxRegEx& reReturnStatement = locker.regexes->reReturnStatement;
     if(reReturnStatement.IsValid() && reReturnStatement.Matches(m_comment)) {
         wxString returnValue = reReturnStatement.GetMatch(m_comment, 2);
         wxArrayString types = ::wxStringTokenize(returnValue, "|", wxTOKEN_STRTOK);
@@ -44,14 +117,14 @@ PHPDocComment::PHPDocComment(PHPSourceFile& sourceFile, const wxString& comment)
         }
     }
 
-    static wxRegEx reVarType(wxT("@(var|variable)[ \t]+([\\a-zA-Z_]{1}[\\a-zA-Z0-9_]*)"));
+    wxRegEx& reVarType = locker.regexes->reVarType;
     if(reVarType.IsValid() && reVarType.Matches(m_comment)) {
         m_varType = reVarType.GetMatch(m_comment, 2);
         m_varType = sourceFile.MakeIdentifierAbsolute(m_varType);
         m_varName.Clear();
     }
 
-    static wxRegEx reVarType2(wxT("@(var|variable)[ \t]+([\\$]{1}[\\a-zA-Z0-9_]*)[ \t]+([\\a-zA-Z0-9_]+)"));
+    wxRegEx& reVarType2 = locker.regexes->reVarType2;
     if(reVarType2.IsValid() && reVarType2.Matches(m_comment)) {
         m_varType = reVarType2.GetMatch(m_comment, 3);
         m_varType = sourceFile.MakeIdentifierAbsolute(m_varType);
@@ -59,7 +132,7 @@ PHPDocComment::PHPDocComment(PHPSourceFile& sourceFile, const wxString& comment)
     }
 
     // @param PDO $name
-    static wxRegEx reParam2(wxT("@(param|parameter)[ \t]+([\\a-zA-Z0-9_]*)[ \t]+([\\$]{1}[\\a-zA-Z0-9_]+)"));
+    wxRegEx& reParam2 = locker.regexes->reParam2;
     wxArrayString lines2 = wxStringTokenize(m_comment, wxT("\n"), wxTOKEN_STRTOK);
     if(reParam2.IsValid()) {
         for(size_t i = 0; i < lines2.GetCount(); i++) {
@@ -7,8 +7,12 @@
 #include "PHPEntityFunction.h"
 #include "event_notifier.h"
 #include "fileutils.h"
+#include "clTaskExecutor.h"
 #include <wx/stopwatch.h>
 #include <wx/log.h>
+#include <algorithm>
+#include <deque>
+#include <map>
 
 wxDEFINE_EVENT(wxPHP_PARSE_STARTED, clParseEvent);
 wxDEFINE_EVENT(wxPHP_PARSE_ENDED, clParseEvent);
@@ -16,6 +20,10 @@ wxDEFINE_EVENT(wxPHP_PARSE_PROGRESS, clParseEvent);
 
 static wxString PHP_SCHEMA_VERSION = "7.0.6";
 
+// When more files than this are parsed at once, reloading the whole symbols index is cheaper than updating it
+// file by file
+static const size_t PHP_INDEX_RELOAD_THRESHOLD = 500;
+
 //------------------------------------------------
 // Metadata table
 //------------------------------------------------
@@ -115,6 +123,17 @@ const static wxString CREATE_FILES_TABLE_SQL =
 const static wxString CREATE_FILES_TABLE_SQL_IDX1 =
     "CREATE UNIQUE INDEX IF NOT EXISTS FILES_TABLE_IDX_1 ON FILES_TABLE(FILE_NAME)";
 
+static PHPSymbolIndex::eTable IndexTableFromName(const wxString& tableName)
+{
+    if(tableName == "FUNCTION_TABLE") {
+        return PHPSymbolIndex::kFunctionTable;
+    } else if(tableName == "VARIABLES_TABLE") {
+        return PHPSymbolIndex::kVariablesTable;
+    } else {
+        return PHPSymbolIndex::kScopeTable;
+    }
+}
+
 PHPLookupTable::PHPLookupTable()
     : m_sizeLimit(50)
 {
@@ -171,6 +190,7 @@ void PHPLookupTable::Open(const wxFileName& dbfile)
         m_db.SetBusyTimeout(10); // Don't lock when we cant access to the database
         m_filename = dbfile;
         CreateSchema();
+        m_index = PHPSymbolIndex::Get(dbfile);
 
     } catch(wxSQLite3Exception& e) {
         CL_WARNING("PHPLookupTable::Open: %s", e.GetMessage());
@@ -329,6 +349,13 @@ void PHPLookupTable::UpdateSourceFile(PHPSourceFile& source, bool autoCommit)
 
         if(autoCommit) m_db.Commit();
 
+        // The index follows what is committed, when we don't commit the caller updates it
+        if(autoCommit && m_index) {
+            wxArrayString files;
+            files.Add(source.GetFilename().GetFullPath());
+            m_index->ReloadFiles(m_db, files);
+        }
+
     } catch(wxSQLite3Exception& e) {
         if(autoCommit) m_db.Rollback();
         CL_WARNING("PHPLookupTable::SaveSourceFile: %s", e.GetMessage());
@@ -422,6 +449,17 @@ void PHPLookupTable::DoGetInheritanceParentIDs(PHPEntityBase::Ptr_t cls,
                                                std::set<wxLongLong>& parentsVisited,
                                                bool excludeSelf)
 {
+    PHPSymbolIndex::IdVec_t closure;
+    if(m_index && m_index->GetInheritanceParentIDs(cls->GetDbId(), closure)) {
+        // The index returns the class itself followed by its parents
+        for(size_t i = 0; i < closure.size(); ++i) {
+            if(!parentsVisited.insert(closure.at(i)).second) continue;
+            if(i == 0 && excludeSelf) continue;
+            parents.push_back(closure.at(i));
+        }
+        return;
+    }
+
     if(!excludeSelf) {
         parents.push_back(cls->GetDbId());
     }
@@ -584,6 +622,166 @@ wxString PHPLookupTable::EscapeWildCards(const wxString& str)
 
 void PHPLookupTable::DoAddLimit(wxString& sql) { sql << " LIMIT " << m_sizeLimit; }
 
+//------------------------------------------------
+// Parallel parsing
+//------------------------------------------------
+
+/**
+ * @class PHPParseFilesQueue
+ * @brief hand out the files to the parsing tasks and collect the parsed files for the database writer.
+ * The parsed files wait in the queue until the writer takes them, the tasks stop parsing ahead when
+ * too many are waiting
+ */
+class PHPParseFilesQueue
+{
+    const wxArrayString& m_files;
+    size_t m_nextFile;
+    size_t m_workers;
+    bool m_stopped;
+    std::deque<PHPSourceFile*> m_parsed;
+    size_t m_failed;
+    wxMutex m_mutex;
+    wxCondition m_cond;
+
+public:
+    enum { kMaxPending = 256 };
+
+    PHPParseFilesQueue(const wxArrayString& files)
+        : m_files(files)
+        , m_nextFile(0)
+        , m_workers(0)
+        , m_stopped(false)
+        , m_failed(0)
+        , m_cond(m_mutex)
+    {
+    }
+
+    ~PHPParseFilesQueue()
+    {
+        for(size_t i = 0; i < m_parsed.size(); ++i) {
+            wxDELETE(m_parsed.at(i));
+        }
+    }
+
+    /**
+     * @brief return the next file to parse. Return false when there are no more files
+     */
+    bool Next(wxString& filename)
+    {
+        wxMutexLocker locker(m_mutex);
+        if(m_stopped || m_nextFile >= m_files.GetCount()) return false;
+        // The files array is shared, make a copy of the content
+        filename = m_files.Item(m_nextFile++).c_str();
+        return true;
+    }
+
+    void AddWorker()
+    {
+        wxMutexLocker locker(m_mutex);
+        ++m_workers;
+    }
+
+    /**
+     * @brief a worker is gone: it parsed all the files it could get or it was discarded
+     */
+    void WorkerDone()
+    {
+        wxMutexLocker locker(m_mutex);
+        --m_workers;
+        m_cond.Broadcast();
+    }
+
+    /**
+     * @brief a file was parsed, or could not be read (source is NULL). The queue takes the ownership of source
+     */
+    void Done(PHPSourceFile* source)
+    {
+        wxMutexLocker locker(m_mutex);
+        while(!m_stopped && m_parsed.size() >= kMaxPending) {
+            m_cond.Wait();
+        }
+
+        if(!source) {
+            ++m_failed;
+        } else if(m_stopped) {
+            wxDELETE(source);
+        } else {
+            m_parsed.push_back(source);
+        }
+        m_cond.Broadcast();
+    }
+
+    /**
+     * @brief wait up to 'timeoutMs' for parsed files and move them into 'parsed'
+     * @param failed set to the number of files that could not be read since the last call
+     * @return false once all the workers are gone and everything was taken
+     */
+    bool Take(std::vector<PHPSourceFile*>& parsed, size_t& failed, long timeoutMs)
+    {
+        wxMutexLocker locker(m_mutex);
+        if(m_parsed.empty() && !m_failed && m_workers) {
+            m_cond.WaitTimeout(timeoutMs);
+        }
+
+        parsed.insert(parsed.end(), m_parsed.begin(), m_parsed.end());
+        m_parsed.clear();
+        failed = m_failed;
+        m_failed = 0;
+        m_cond.Broadcast();
+        return !parsed.empty() || failed || m_workers;
+    }
+
+    /**
+     * @brief stop handing out files and wait for all the workers to be gone
+     */
+    void Stop()
+    {
+        wxMutexLocker locker(m_mutex);
+        m_stopped = true;
+        m_cond.Broadcast();
+        while(m_workers > 0) {
+            m_cond.Wait();
+        }
+    }
+};
+
+class PHPParseFilesTask : public clTask
+{
+    PHPParseFilesQueue* m_queue;
+    bool m_parseFuncBodies;
+
+public:
+    PHPParseFilesTask(PHPParseFilesQueue* queue, bool parseFuncBodies)
+        : clTask(clTask::kLow)
+        , m_queue(queue)
+        , m_parseFuncBodies(parseFuncBodies)
+    {
+        m_queue->AddWorker();
+    }
+    // The task is deleted once it ran, or when the executor discards it
+    virtual ~PHPParseFilesTask() { m_queue->WorkerDone(); }
+
+    virtual void Run()
+    {
+        wxString filename;
+        while(m_queue->Next(filename)) {
+            // For performance reaons, load the file into memory and then parse it
+            wxFileName fnSourceFile(filename);
+            wxString content;
+            if(!FileUtils::ReadFileContent(fnSourceFile, content, wxConvISO8859_1)) {
+                CL_WARNING("PHP: Failed to read file: %s for parsing", fnSourceFile.GetFullPath());
+                m_queue->Done(NULL);
+                continue;
+            }
+            PHPSourceFile* sourceFile = new PHPSourceFile(content);
+            sourceFile->SetFilename(fnSourceFile);
+            sourceFile->SetParseFunctionBody(m_parseFuncBodies);
+            sourceFile->Parse();
+            m_queue->Done(sourceFile);
+        }
+    }
+};
+
 void PHPLookupTable::RecreateSymbolsDatabase(const wxArrayString& files, eUpdateMode updateMode, bool parseFuncBodies)
 {
     try {
@@ -598,62 +796,91 @@ void PHPLookupTable::RecreateSymbolsDatabase(const wxArrayString& files, eUpdate
         wxStopWatch sw;
         sw.Start();
 
-        m_db.Begin();
-        for(size_t i = 0; i < files.GetCount(); ++i) {
-            {
-                clParseEvent event(wxPHP_PARSE_PROGRESS);
-                event.SetTotalFiles(files.GetCount());
-                event.SetCurfileIndex(i);
-                event.SetFileName(files.Item(i));
-                EventNotifier::Get()->AddPendingEvent(event);
-            }
+        // Load the last parsed timestamps with a single query
+        std::map<wxString, wxLongLong> timestamps;
+        if(updateMode == kUpdateMode_Fast) {
+            GetFilesLastParsedTimestamp(timestamps);
+        }
 
+        wxArrayString filesToParse;
+        for(size_t i = 0; i < files.GetCount(); ++i) {
             wxFileName fnFile(files.Item(i));
-            bool reParseNeeded(true);
+
+            // Parse only valid PHP files
+            if((fnFile.GetExt() != "php") && (fnFile.GetExt() != "inc") && (fnFile.GetExt() != "phtml")) continue;
+
+            // Ensure that the file exists
+            if(!fnFile.Exists()) continue;
 
             if(updateMode == kUpdateMode_Fast) {
                 // Check to see if we need to re-parse this file
                 // and store it to the database
-
-                if(!fnFile.Exists()) {
-                    reParseNeeded = false;
-                } else {
+                std::map<wxString, wxLongLong>::iterator iter = timestamps.find(fnFile.GetFullPath());
+                if(iter != timestamps.end()) {
                     time_t lastModifiedOnDisk = fnFile.GetModificationTime().GetTicks();
-                    wxLongLong lastModifiedInDB = GetFileLastParsedTimestamp(fnFile);
-                    if(lastModifiedOnDisk <= lastModifiedInDB.ToLong()) {
-                        reParseNeeded = false;
-                    }
+                    if(lastModifiedOnDisk <= iter->second.ToLong()) continue;
                 }
             }
+            filesToParse.Add(fnFile.GetFullPath());
+        }
 
-            // Ensure that the file exists
-            if(!fnFile.Exists()) {
-                reParseNeeded = false;
+        // The files are parsed by the executor threads while this thread stores them. The progress is reported
+        // at most every PARSE_PROGRESS_INTERVAL ms
+        static const long PARSE_PROGRESS_INTERVAL = 100;
+        static clTaskQueue* tasksQueue = clTaskExecutor::Get()->CreateQueue("PHP Parser", false);
+
+        m_db.Begin();
+        PHPParseFilesQueue queue(filesToParse);
+        size_t workers = clTaskExecutor::Get()->GetWorkersCount();
+        if(workers == 0) {
+            // the executor threads are started on the first task
+            workers = wxThread::GetCPUCount() > 0 ? (size_t)wxThread::GetCPUCount() : 1;
+        }
+        workers = std::min(workers, filesToParse.GetCount());
+        for(size_t i = 0; i < workers; ++i) {
+            tasksQueue->Submit(new PHPParseFilesTask(&queue, parseFuncBodies));
+        }
+
+        wxArrayString parsedFiles;
+        size_t filesDone = files.GetCount() - filesToParse.GetCount();
+        long lastProgress = 0;
+
+        std::vector<PHPSourceFile*> parsed;
+        size_t failed(0);
+        while(queue.Take(parsed, failed, PARSE_PROGRESS_INTERVAL)) {
+            for(size_t i = 0; i < parsed.size(); ++i) {
+                UpdateSourceFile(*parsed.at(i), false);
+                parsedFiles.Add(parsed.at(i)->GetFilename().GetFullPath());
+                wxDELETE(parsed.at(i));
             }
+            filesDone += parsed.size() + failed;
 
-            // Parse only valid PHP files
-            if((fnFile.GetExt() != "php") && (fnFile.GetExt() != "inc") && (fnFile.GetExt() != "phtml"))
-                reParseNeeded = false;
-
-            if(reParseNeeded) {
-                // For performance reaons, load the file into memory and then parse it
-                wxFileName fnSourceFile(files.Item(i));
-                wxString content;
-                if(!FileUtils::ReadFileContent(fnSourceFile, content, wxConvISO8859_1)) {
-                    CL_WARNING("PHP: Failed to read file: %s for parsing", fnSourceFile.GetFullPath());
-                    continue;
-                }
-                PHPSourceFile sourceFile(content);
-                sourceFile.SetFilename(fnSourceFile);
-                sourceFile.SetParseFunctionBody(parseFuncBodies);
-                sourceFile.Parse();
-                UpdateSourceFile(sourceFile, false);
+            if((sw.Time() - lastProgress) >= PARSE_PROGRESS_INTERVAL && !parsedFiles.IsEmpty()) {
+                lastProgress = sw.Time();
+                clParseEvent event(wxPHP_PARSE_PROGRESS);
+                event.SetTotalFiles(files.GetCount());
+                event.SetCurfileIndex(filesDone);
+                event.SetFileName(parsedFiles.Last());
+                EventNotifier::Get()->AddPendingEvent(event);
             }
+            parsed.clear();
         }
+        queue.Stop();
+
         m_db.Commit();
+
+        if(m_index) {
+            if(parsedFiles.GetCount() > PHP_INDEX_RELOAD_THRESHOLD) {
+                m_index->Reload(m_db);
+            } else {
+                m_index->ReloadFiles(m_db, parsedFiles);
+            }
+        }
+
         long elapsedMs = sw.Time();
         wxString message;
-        message << _("PHP: parsed ") << files.GetCount() << " in " << elapsedMs << " milliseconds";
+        message << _("PHP: parsed ") << parsedFiles.GetCount() << " out of " << files.GetCount() << " files in "
+                << elapsedMs << " milliseconds";
         CL_DEBUGS(message);
 
         {
@@ -707,6 +934,49 @@ void PHPLookupTable::DoAddNameFilter(wxString& sql, const wxString& nameHint, si
     }
 }
 
+bool PHPLookupTable::DoAddIndexFilter(wxString& sql,
+                                      PHPSymbolIndex::eTable table,
+                                      wxLongLong parentId,
+                                      const wxString& nameHint,
+                                      size_t flags,
+                                      size_t limit)
+{
+    if(!m_index) return false;
+
+    wxString name = nameHint;
+    name.Trim().Trim(false);
+
+    // Same rules as DoAddNameFilter
+    PHPSymbolIndex::eMatch match = PHPSymbolIndex::kMatchAll;
+    if(!name.IsEmpty()) {
+        if(flags & kLookupFlags_ExactMatch) {
+            match = PHPSymbolIndex::kMatchExact;
+        } else if(flags & kLookupFlags_Contains) {
+            match = PHPSymbolIndex::kMatchContains;
+        } else if(flags & kLookupFlags_StartsWith) {
+            match = PHPSymbolIndex::kMatchStartsWith;
+        }
+    }
+
+    PHPSymbolIndex::IdVec_t ids;
+    if(parentId == wxNOT_FOUND) {
+        // Don't load an entire table
+        if(match == PHPSymbolIndex::kMatchAll) return false;
+        if(!m_index->FindByName(table, name, match, limit, ids)) return false;
+
+    } else if(!m_index->FindChildren(table, parentId, name, match, limit, ids)) {
+        return false;
+    }
+
+    sql << " ID IN (";
+    for(size_t i = 0; i < ids.size(); ++i) {
+        if(i) sql << ",";
+        sql << ids.at(i);
+    }
+    sql << ") ";
+    return true;
+}
+
 void PHPLookupTable::LoadAllByFilter(PHPEntityBase::List_t& matches, const wxString& nameHint, eLookupFlags flags)
 {
     try {
@@ -743,7 +1013,9 @@ void PHPLookupTable::LoadFromTableByNameHint(PHPEntityBase::List_t& matches,
 
     wxString sql;
     sql << "SELECT * from " << tableName << " WHERE ";
-    DoAddNameFilter(sql, trimmedNameHint, flags);
+    if(!DoAddIndexFilter(sql, IndexTableFromName(tableName), wxNOT_FOUND, trimmedNameHint, flags, m_sizeLimit)) {
+        DoAddNameFilter(sql, trimmedNameHint, flags);
+    }
     DoAddLimit(sql);
 
     try {
@@ -808,6 +1080,12 @@ void PHPLookupTable::DeleteFileEntries(const wxFileName& filename, bool autoComm
         }
 
         if(autoCommit) m_db.Commit();
+
+        if(autoCommit && m_index) {
+            wxArrayString files;
+            files.Add(filename.GetFullPath());
+            m_index->ReloadFiles(m_db, files);
+        }
     } catch(wxSQLite3Exception& e) {
         if(autoCommit) m_db.Rollback();
         CL_WARNING("PHPLookupTable::DeleteFileEntries: %s", e.GetMessage());
@@ -821,6 +1099,7 @@ void PHPLookupTable::Close()
             m_db.Close();
         }
         m_filename.Clear();
+        m_index.reset();
 
     } catch(wxSQLite3Exception& e) {
         CL_WARNING("PHPLookupTable::Close: %s", e.GetMessage());
@@ -829,6 +1108,12 @@ void PHPLookupTable::Close()
 
 bool PHPLookupTable::IsOpened() const { return m_db.IsOpen(); }
 
+bool PHPLookupTable::LoadSymbolsIndex()
+{
+    if(!IsOpened() || !m_index) return false;
+    return m_index->Load(m_db);
+}
+
 void PHPLookupTable::DoFindChildren(PHPEntityBase::List_t& matches,
                                     wxLongLong parentId,
                                     size_t flags,
@@ -839,8 +1124,11 @@ void PHPLookupTable::DoFindChildren(PHPEntityBase::List_t& matches,
         // Load classes
         if(!(flags & kLookupFlags_FunctionsAndConstsOnly)) {
             wxString sql;
-            sql << "SELECT * from SCOPE_TABLE WHERE SCOPE_ID=" << parentId << " AND SCOPE_TYPE = 1 AND ";
-            DoAddNameFilter(sql, nameHint, flags);
+            sql << "SELECT * from SCOPE_TABLE WHERE ";
+            if(!DoAddIndexFilter(sql, PHPSymbolIndex::kScopeTable, parentId, nameHint, flags, m_sizeLimit)) {
+                sql << "SCOPE_ID=" << parentId << " AND SCOPE_TYPE = 1 AND ";
+                DoAddNameFilter(sql, nameHint, flags);
+            }
             DoAddLimit(sql);
 
             wxSQLite3Statement st = m_db.PrepareStatement(sql);
@@ -856,8 +1144,11 @@ void PHPLookupTable::DoFindChildren(PHPEntityBase::List_t& matches,
         {
             // load functions
             wxString sql;
-            sql << "SELECT * from FUNCTION_TABLE WHERE SCOPE_ID=" << parentId << " AND ";
-            DoAddNameFilter(sql, nameHint, flags);
+            sql << "SELECT * from FUNCTION_TABLE WHERE ";
+            if(!DoAddIndexFilter(sql, PHPSymbolIndex::kFunctionTable, parentId, nameHint, flags, m_sizeLimit)) {
+                sql << "SCOPE_ID=" << parentId << " AND ";
+                DoAddNameFilter(sql, nameHint, flags);
+            }
             DoAddLimit(sql);
 
             wxSQLite3Statement st = m_db.PrepareStatement(sql);
@@ -879,8 +1170,11 @@ void PHPLookupTable::DoFindChildren(PHPEntityBase::List_t& matches,
         {
             // Add members from the variables table
             wxString sql;
-            sql << "SELECT * from VARIABLES_TABLE WHERE SCOPE_ID=" << parentId << " AND ";
-            DoAddNameFilter(sql, nameHint, flags);
+            sql << "SELECT * from VARIABLES_TABLE WHERE ";
+            if(!DoAddIndexFilter(sql, PHPSymbolIndex::kVariablesTable, parentId, nameHint, flags, m_sizeLimit)) {
+                sql << "SCOPE_ID=" << parentId << " AND ";
+                DoAddNameFilter(sql, nameHint, flags);
+            }
             DoAddLimit(sql);
 
             wxSQLite3Statement st = m_db.PrepareStatement(sql);
@@ -913,6 +1207,19 @@ void PHPLookupTable::DoFindChildren(PHPEntityBase::List_t& matches,
     }
 }
 
+void PHPLookupTable::GetFilesLastParsedTimestamp(std::map<wxString, wxLongLong>& timestamps)
+{
+    try {
+        wxSQLite3Statement st = m_db.PrepareStatement("SELECT FILE_NAME, LAST_UPDATED FROM FILES_TABLE");
+        wxSQLite3ResultSet res = st.ExecuteQuery();
+        while(res.NextRow()) {
+            timestamps.insert(std::make_pair(res.GetString("FILE_NAME"), res.GetInt64("LAST_UPDATED")));
+        }
+    } catch(wxSQLite3Exception& e) {
+        CL_WARNING("PHPLookupTable::GetFilesLastParsedTimestamp: %s", e.GetMessage());
+    }
+}
+
 wxLongLong PHPLookupTable::GetFileLastParsedTimestamp(const wxFileName& filename)
 {
     try {
@@ -976,6 +1283,9 @@ void PHPLookupTable::ClearAll(bool autoCommit)
         }
 
         if(autoCommit) m_db.Commit();
+        if(m_index) {
+            m_index->Clear();
+        }
     } catch(wxSQLite3Exception& e) {
         if(autoCommit) m_db.Rollback();
         CL_WARNING("PHPLookupTable::ClearAll: %s", e.GetMessage());
@@ -1116,6 +1426,7 @@ PHPEntityBase::Ptr_t PHPLookupTable::FindFunctionByLineAndFile(const wxFileName&
 void PHPLookupTable::ResetDatabase()
 {
     wxFileName curfile = m_filename;
+    PHPSymbolIndex::Ptr_t index = m_index; // keep the index (and its loaded state) for the new database
     Close(); // Close the databse releasing any file capture we have
     // Delete the file
     if(curfile.IsOk() && curfile.Exists()) {
@@ -1126,6 +1437,9 @@ void PHPLookupTable::ResetDatabase()
         }
     }
     Open(curfile);
+    if(m_index) {
+        m_index->Clear();
+    }
 }
 
 bool PHPLookupTable::CheckDiskImage(wxSQLite3Database& db)
@@ -1170,7 +1484,10 @@ PHPEntityBase::List_t PHPLookupTable::FindSymbol(const wxString& name)
             // Load scopes (classes / namespaces)
             //---------------------------------------------------------------------
             wxString sql;
-            sql << "SELECT * from SCOPE_TABLE WHERE NAME='" << name << "'";
+            sql << "SELECT * from SCOPE_TABLE WHERE ";
+            if(!DoAddIndexFilter(sql, PHPSymbolIndex::kScopeTable, wxNOT_FOUND, name, kLookupFlags_ExactMatch, 0)) {
+                sql << "NAME='" << name << "'";
+            }
 
             wxSQLite3Statement st = m_db.PrepareStatement(sql);
             wxSQLite3ResultSet res = st.ExecuteQuery();
@@ -1193,7 +1510,10 @@ PHPEntityBase::List_t PHPLookupTable::FindSymbol(const wxString& name)
             // Load functions
             //---------------------------------------------------------------------
             wxString sql;
-            sql << "SELECT * from FUNCTION_TABLE WHERE NAME='" << name << "'";
+            sql << "SELECT * from FUNCTION_TABLE WHERE ";
+            if(!DoAddIndexFilter(sql, PHPSymbolIndex::kFunctionTable, wxNOT_FOUND, name, kLookupFlags_ExactMatch, 0)) {
+                sql << "NAME='" << name << "'";
+            }
 
             wxSQLite3Statement st = m_db.PrepareStatement(sql);
             wxSQLite3ResultSet res = st.ExecuteQuery();
@@ -1210,7 +1530,10 @@ PHPEntityBase::List_t PHPLookupTable::FindSymbol(const wxString& name)
             // Load variables
             //---------------------------------------------------------------------
             wxString sql;
-            sql << "SELECT * from VARIABLES_TABLE WHERE NAME='" << name << "'";
+            sql << "SELECT * from VARIABLES_TABLE WHERE ";
+            if(!DoAddIndexFilter(sql, PHPSymbolIndex::kVariablesTable, wxNOT_FOUND, name, kLookupFlags_ExactMatch, 0)) {
+                sql << "NAME='" << name << "'";
+            }
 
             wxSQLite3Statement st = m_db.PrepareStatement(sql);
             wxSQLite3ResultSet res = st.ExecuteQuery();
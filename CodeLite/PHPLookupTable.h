@@ -8,9 +8,11 @@
 #include "PHPSourceFile.h"
 #include <vector>
 #include <set>
+#include <map>
 #include <wx/longlong.h>
 #include "cl_command_event.h"
 #include "smart_ptr.h"
+#include "PHPSymbolIndex.h"
 
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxPHP_PARSE_STARTED, clParseEvent);
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxPHP_PARSE_ENDED, clParseEvent);
@@ -32,6 +34,7 @@ class WXDLLIMPEXP_CL PHPLookupTable
     wxSQLite3Database m_db;
     wxFileName m_filename;
     size_t m_sizeLimit;
+    PHPSymbolIndex::Ptr_t m_index;
 
 public:
     enum eLookupFlags {
@@ -62,6 +65,19 @@ private:
     void EnsureIntegrity(const wxFileName& filename);
     void DoAddNameFilter(wxString& sql, const wxString& nameHint, size_t flags);
 
+    /**
+     * @brief when the symbols index is loaded, use it to find the IDs of the 'table' entries that match nameHint
+     * (children of parentId, unless parentId is wxNOT_FOUND) and add them to sql as an "ID IN (...)" filter
+     * @param limit maximum number of matches, 0 means no limit
+     * @return false if the index can not be used, the caller should filter by name instead
+     */
+    bool DoAddIndexFilter(wxString& sql,
+                          PHPSymbolIndex::eTable table,
+                          wxLongLong parentId,
+                          const wxString& nameHint,
+                          size_t flags,
+                          size_t limit);
+
     void CreateSchema();
     PHPEntityBase::Ptr_t
     DoFindMemberOf(wxLongLong parentDbId, const wxString& exactName, bool parentIsNamespace = false);
@@ -118,6 +134,11 @@ private:
      */
     wxLongLong GetFileLastParsedTimestamp(const wxFileName& filename);
 
+    /**
+     * @brief return the timestamp of the last parse of all the files in the database
+     */
+    void GetFilesLastParsedTimestamp(std::map<wxString, wxLongLong>& timestamps);
+
     /**
      * @brief update the file's last updated timestamp
      */
@@ -157,6 +178,14 @@ public:
      * @brief close the lookup table database
      */
     void Close();
+
+    /**
+     * @brief load the in-memory symbols index of the database. The index is shared by all the lookup tables
+     * that open the same database and is kept up to date by UpdateSourceFile / RecreateSymbolsDatabase.
+     * Until it is loaded, lookups go to the database
+     * @return true on success
+     */
+    bool LoadSymbolsIndex();
     
     /**
      * @brief delete the symbols database file from the file system and recreate an empty one
@@ -229,7 +258,8 @@ public:
     void UpdateSourceFile(PHPSourceFile& source, bool autoCommit = true);
 
     /**
-     * @brief update list of source files
+     * @brief update list of source files. The files are parsed in parallel by the task executor
+     * while the calling thread stores them into the database
      */
     void RecreateSymbolsDatabase(const wxArrayString& files, eUpdateMode updateMode, bool parseFuncBodies = true);
 
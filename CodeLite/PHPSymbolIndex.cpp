@@ -0,0 +1,527 @@
+#include "PHPSymbolIndex.h"
+#include "PHPLookupTable.h"
+#include "PHPEntityClass.h"
+#include "file_logger.h"
+#include <algorithm>
+
+wxMutex PHPSymbolIndex::ms_registryLock;
+std::map<wxString, std::weak_ptr<PHPSymbolIndex> > PHPSymbolIndex::ms_registry;
+
+namespace
+{
+struct LowerNameLess {
+    const std::vector<wxString>& m_names;
+    LowerNameLess(const std::vector<wxString>& names)
+        : m_names(names)
+    {
+    }
+    bool operator()(size_t a, size_t b) const { return m_names[a] < m_names[b]; }
+    bool operator()(size_t a, const wxString& b) const { return m_names[a] < b; }
+};
+
+void EraseIndex(std::vector<size_t>& indexes, size_t index)
+{
+    indexes.erase(std::remove(indexes.begin(), indexes.end(), index), indexes.end());
+}
+}
+
+PHPSymbolIndex::PHPSymbolIndex()
+    : m_loaded(false)
+    , m_loading(false)
+    , m_reloadPending(false)
+    , m_sortedNamesDirty(false)
+{
+}
+
+PHPSymbolIndex::~PHPSymbolIndex() {}
+
+PHPSymbolIndex::Ptr_t PHPSymbolIndex::Get(const wxFileName& dbfile)
+{
+    wxMutexLocker locker(ms_registryLock);
+
+    // Forget the indexes that are no longer used
+    std::map<wxString, std::weak_ptr<PHPSymbolIndex> >::iterator iter = ms_registry.begin();
+    while(iter != ms_registry.end()) {
+        if(iter->second.expired()) {
+            ms_registry.erase(iter++);
+        } else {
+            ++iter;
+        }
+    }
+
+    wxString key = dbfile.GetFullPath();
+    PHPSymbolIndex::Ptr_t index = ms_registry[key].lock();
+    if(!index) {
+        index.reset(new PHPSymbolIndex());
+        ms_registry[key] = index;
+    }
+    return index;
+}
+
+void PHPSymbolIndex::DoReadRows(wxSQLite3Database& db, const wxString& filename, eTable table, RowVec_t& rows)
+{
+    static const char* tableNames[] = { "SCOPE_TABLE", "FUNCTION_TABLE", "VARIABLES_TABLE" };
+
+    wxString sql;
+    if(table == kScopeTable) {
+        // We need the inheritance of the classes as well
+        sql << "SELECT * from SCOPE_TABLE";
+    } else {
+        sql << "SELECT ID, SCOPE_ID, NAME, FILE_NAME from " << tableNames[table];
+    }
+    if(!filename.IsEmpty()) {
+        sql << " WHERE FILE_NAME=:FILE_NAME";
+    }
+
+    wxSQLite3Statement st = db.PrepareStatement(sql);
+    if(!filename.IsEmpty()) {
+        st.Bind(st.GetParamIndex(":FILE_NAME"), filename);
+    }
+
+    wxSQLite3ResultSet res = st.ExecuteQuery();
+    while(res.NextRow()) {
+        Row row;
+        row.entry.id = res.GetInt64("ID");
+        row.entry.scopeId = res.GetInt64("SCOPE_ID");
+        row.entry.name = 0;
+        row.entry.file = 0;
+        row.entry.table = table;
+        row.entry.isNamespace =
+            (table == kScopeTable) && (res.GetInt("SCOPE_TYPE", 1) == kPhpScopeTypeNamespace);
+        row.name = res.GetString("NAME");
+        row.file = res.GetString("FILE_NAME");
+
+        if(table == kScopeTable && !row.entry.isNamespace) {
+            PHPEntityClass cls;
+            cls.FromResultSet(res);
+            row.fullname = cls.GetFullName();
+
+            wxArrayString inherits = cls.GetInheritanceArray();
+            for(size_t i = 0; i < inherits.GetCount(); ++i) {
+                if(!inherits.Item(i).IsEmpty()) {
+                    row.inherits.Add(inherits.Item(i));
+                }
+            }
+        }
+        rows.push_back(row);
+    }
+}
+
+size_t PHPSymbolIndex::DoInternName(const wxString& name)
+{
+    std::map<wxString, size_t>::iterator iter = m_nameIds.find(name);
+    if(iter != m_nameIds.end()) {
+        return iter->second;
+    }
+
+    size_t nameId = m_names.size();
+    m_names.push_back(name.c_str());
+    m_lowerNames.push_back(name.Lower());
+    m_nameIds.insert(std::make_pair(m_names.back(), nameId));
+    m_nameEntries.push_back(std::vector<size_t>());
+
+    if(m_sortedNamesDirty) {
+        // Bulk loading, the names are sorted once at the end
+        m_sortedNames.push_back(nameId);
+    } else {
+        LowerNameLess less(m_lowerNames);
+        m_sortedNames.insert(std::lower_bound(m_sortedNames.begin(), m_sortedNames.end(), nameId, less), nameId);
+    }
+    return nameId;
+}
+
+size_t PHPSymbolIndex::DoInternFile(const wxString& filename)
+{
+    std::map<wxString, size_t>::iterator iter = m_fileIds.find(filename);
+    if(iter != m_fileIds.end()) {
+        return iter->second;
+    }
+
+    size_t fileId = m_fileEntries.size();
+    m_fileIds.insert(std::make_pair(wxString(filename.c_str()), fileId));
+    m_fileEntries.push_back(std::vector<size_t>());
+    return fileId;
+}
+
+void PHPSymbolIndex::DoSortNames()
+{
+    if(!m_sortedNamesDirty) return;
+    LowerNameLess less(m_lowerNames);
+    std::sort(m_sortedNames.begin(), m_sortedNames.end(), less);
+    m_sortedNamesDirty = false;
+}
+
+void PHPSymbolIndex::DoAddRow(const Row& row)
+{
+    if(row.entry.isNamespace && m_namespaces.count(row.entry.id)) {
+        // Namespaces are kept when their file is removed (just like the database does)
+        return;
+    }
+
+    Entry entry = row.entry;
+    entry.name = DoInternName(row.name);
+    entry.file = DoInternFile(row.file);
+
+    size_t index;
+    if(m_freeEntries.empty()) {
+        index = m_entries.size();
+        m_entries.push_back(entry);
+    } else {
+        index = m_freeEntries.back();
+        m_freeEntries.pop_back();
+        m_entries[index] = entry;
+    }
+
+    m_nameEntries[entry.name].push_back(index);
+    m_fileEntries[entry.file].push_back(index);
+    if(entry.scopeId != wxNOT_FOUND) {
+        m_children[entry.table][entry.scopeId].push_back(index);
+    }
+
+    if(entry.isNamespace) {
+        m_namespaces.insert(entry.id);
+
+    } else if(entry.table == kScopeTable) {
+        ClassInfo& info = m_classes[entry.id];
+        info.fullname = row.fullname.c_str();
+        for(size_t i = 0; i < row.inherits.GetCount(); ++i) {
+            info.inherits.Add(row.inherits.Item(i).c_str());
+        }
+        m_classIds[info.fullname].insert(entry.id);
+    }
+    m_closures.clear();
+}
+
+void PHPSymbolIndex::DoRemoveFile(const wxString& filename)
+{
+    std::map<wxString, size_t>::iterator iter = m_fileIds.find(filename);
+    if(iter == m_fileIds.end()) return;
+
+    std::vector<size_t>& fileEntries = m_fileEntries[iter->second];
+    std::vector<size_t> namespaces;
+    for(size_t i = 0; i < fileEntries.size(); ++i) {
+        size_t index = fileEntries[i];
+        const Entry& entry = m_entries[index];
+        if(entry.isNamespace) {
+            namespaces.push_back(index);
+            continue;
+        }
+
+        EraseIndex(m_nameEntries[entry.name], index);
+        if(entry.scopeId != wxNOT_FOUND) {
+            ChildrenMap_t::iterator children = m_children[entry.table].find(entry.scopeId);
+            if(children != m_children[entry.table].end()) {
+                EraseIndex(children->second, index);
+                if(children->second.empty()) {
+                    m_children[entry.table].erase(children);
+                }
+            }
+        }
+
+        if(entry.table == kScopeTable) {
+            std::map<wxLongLong, ClassInfo>::iterator cls = m_classes.find(entry.id);
+            if(cls != m_classes.end()) {
+                // The same class might be defined by another file as well
+                std::map<wxString, std::set<wxLongLong> >::iterator clsIds = m_classIds.find(cls->second.fullname);
+                if(clsIds != m_classIds.end()) {
+                    clsIds->second.erase(entry.id);
+                    if(clsIds->second.empty()) {
+                        m_classIds.erase(clsIds);
+                    }
+                }
+                m_classes.erase(cls);
+            }
+        }
+        m_freeEntries.push_back(index);
+    }
+    fileEntries.swap(namespaces);
+    m_closures.clear();
+}
+
+void PHPSymbolIndex::DoSwap(PHPSymbolIndex& other)
+{
+    m_entries.swap(other.m_entries);
+    m_freeEntries.swap(other.m_freeEntries);
+    m_names.swap(other.m_names);
+    m_lowerNames.swap(other.m_lowerNames);
+    m_nameIds.swap(other.m_nameIds);
+    m_nameEntries.swap(other.m_nameEntries);
+    m_sortedNames.swap(other.m_sortedNames);
+    std::swap(m_sortedNamesDirty, other.m_sortedNamesDirty);
+    m_fileIds.swap(other.m_fileIds);
+    m_fileEntries.swap(other.m_fileEntries);
+    for(int i = 0; i < kTableCount; ++i) {
+        m_children[i].swap(other.m_children[i]);
+    }
+    m_namespaces.swap(other.m_namespaces);
+    m_classes.swap(other.m_classes);
+    m_classIds.swap(other.m_classIds);
+    m_closures.swap(other.m_closures);
+}
+
+void PHPSymbolIndex::DoClear()
+{
+    PHPSymbolIndex empty;
+    DoSwap(empty);
+}
+
+bool PHPSymbolIndex::DoLoadAll(wxSQLite3Database& db)
+{
+    try {
+        m_sortedNamesDirty = true;
+        for(int table = 0; table < kTableCount; ++table) {
+            RowVec_t rows;
+            DoReadRows(db, "", (eTable)table, rows);
+            for(size_t i = 0; i < rows.size(); ++i) {
+                DoAddRow(rows[i]);
+            }
+        }
+        DoSortNames();
+        return true;
+
+    } catch(wxSQLite3Exception& e) {
+        CL_WARNING("PHPSymbolIndex::Load: %s", e.GetMessage());
+    }
+    return false;
+}
+
+void PHPSymbolIndex::DoReloadFiles(wxSQLite3Database& db, const wxArrayString& files)
+{
+    // Read the rows without holding the lock
+    RowVec_t rows;
+    try {
+        for(size_t i = 0; i < files.GetCount(); ++i) {
+            for(int table = 0; table < kTableCount; ++table) {
+                DoReadRows(db, files.Item(i), (eTable)table, rows);
+            }
+        }
+    } catch(wxSQLite3Exception& e) {
+        CL_WARNING("PHPSymbolIndex::ReloadFiles: %s", e.GetMessage());
+        // We can't tell what is in the database, stop using the index until it is loaded again
+        wxMutexLocker locker(m_mutex);
+        m_loaded = false;
+        DoClear();
+        return;
+    }
+
+    wxMutexLocker locker(m_mutex);
+    for(size_t i = 0; i < files.GetCount(); ++i) {
+        DoRemoveFile(files.Item(i));
+    }
+    for(size_t i = 0; i < rows.size(); ++i) {
+        DoAddRow(rows[i]);
+    }
+}
+
+bool PHPSymbolIndex::Load(wxSQLite3Database& db)
+{
+    {
+        wxMutexLocker locker(m_mutex);
+        if(m_loading) {
+            // Let the current loading start over once it is done, so it picks up the latest content
+            m_reloadPending = true;
+            return true;
+        }
+        m_loading = true;
+        m_reloadPending = false;
+        m_pendingFiles.clear();
+    }
+
+    bool loadAll = true;
+    wxArrayString files;
+    while(true) {
+        if(loadAll) {
+            PHPSymbolIndex index;
+            bool success = index.DoLoadAll(db);
+
+            wxMutexLocker locker(m_mutex);
+            if(!success) {
+                DoClear();
+                m_loaded = false;
+                m_loading = false;
+                m_reloadPending = false;
+                m_pendingFiles.clear();
+                return false;
+            }
+            DoSwap(index);
+            m_loaded = true;
+
+        } else {
+            DoReloadFiles(db, files);
+        }
+
+        wxMutexLocker locker(m_mutex);
+        if(m_reloadPending) {
+            m_reloadPending = false;
+            m_pendingFiles.clear();
+            loadAll = true;
+
+        } else if(!m_pendingFiles.empty()) {
+            // Files that were committed while we were loading
+            files.Clear();
+            std::set<wxString>::iterator iter = m_pendingFiles.begin();
+            for(; iter != m_pendingFiles.end(); ++iter) {
+                files.Add(iter->c_str());
+            }
+            m_pendingFiles.clear();
+            loadAll = false;
+
+        } else {
+            m_loading = false;
+            return true;
+        }
+    }
+}
+
+void PHPSymbolIndex::Reload(wxSQLite3Database& db)
+{
+    {
+        wxMutexLocker locker(m_mutex);
+        if(!m_loaded && !m_loading) return;
+    }
+    Load(db);
+}
+
+void PHPSymbolIndex::ReloadFiles(wxSQLite3Database& db, const wxArrayString& files)
+{
+    {
+        wxMutexLocker locker(m_mutex);
+        if(m_loading) {
+            // Load() will apply them when done
+            for(size_t i = 0; i < files.GetCount(); ++i) {
+                m_pendingFiles.insert(files.Item(i).c_str());
+            }
+            return;
+        }
+        if(!m_loaded) return;
+    }
+    DoReloadFiles(db, files);
+}
+
+void PHPSymbolIndex::Clear()
+{
+    wxMutexLocker locker(m_mutex);
+    DoClear();
+}
+
+bool PHPSymbolIndex::IsLoaded() const
+{
+    wxMutexLocker locker(m_mutex);
+    return m_loaded;
+}
+
+bool PHPSymbolIndex::DoMatch(size_t name, const wxString& hint, const wxString& lowerHint, eMatch match) const
+{
+    switch(match) {
+    case kMatchExact:
+        return m_names[name] == hint;
+    case kMatchStartsWith:
+        return m_lowerNames[name].StartsWith(lowerHint);
+    case kMatchContains:
+        return m_lowerNames[name].Contains(lowerHint);
+    default:
+        return true;
+    }
+}
+
+bool PHPSymbolIndex::FindByName(eTable table, const wxString& name, eMatch match, size_t limit, IdVec_t& ids) const
+{
+    wxMutexLocker locker(m_mutex);
+    if(!m_loaded) return false;
+
+    wxString lowerName = name.Lower();
+    std::vector<size_t>::const_iterator iter = m_sortedNames.begin();
+    std::vector<size_t>::const_iterator end = m_sortedNames.end();
+    std::vector<size_t> exactName;
+
+    if(match == kMatchExact) {
+        std::map<wxString, size_t>::const_iterator nameIter = m_nameIds.find(name);
+        if(nameIter == m_nameIds.end()) return true;
+        exactName.push_back(nameIter->second);
+        iter = exactName.begin();
+        end = exactName.end();
+
+    } else if(match == kMatchStartsWith) {
+        // All the candidates are adjacent
+        iter = std::lower_bound(m_sortedNames.begin(), m_sortedNames.end(), lowerName, LowerNameLess(m_lowerNames));
+    }
+
+    size_t count = 0;
+    for(; iter != end; ++iter) {
+        if(!DoMatch(*iter, name, lowerName, match)) {
+            if(match == kMatchStartsWith) break;
+            continue;
+        }
+
+        const std::vector<size_t>& entries = m_nameEntries[*iter];
+        for(size_t i = 0; i < entries.size(); ++i) {
+            const Entry& entry = m_entries[entries[i]];
+            if(entry.table != table) continue;
+            ids.push_back(entry.id);
+            if(limit && ++count >= limit) return true;
+        }
+    }
+    return true;
+}
+
+bool PHPSymbolIndex::FindChildren(eTable table,
+                                  wxLongLong parentId,
+                                  const wxString& name,
+                                  eMatch match,
+                                  size_t limit,
+                                  IdVec_t& ids) const
+{
+    wxMutexLocker locker(m_mutex);
+    if(!m_loaded) return false;
+
+    ChildrenMap_t::const_iterator iter = m_children[table].find(parentId);
+    if(iter == m_children[table].end()) return true;
+
+    wxString lowerName = name.Lower();
+    size_t count = 0;
+    const std::vector<size_t>& children = iter->second;
+    for(size_t i = 0; i < children.size(); ++i) {
+        const Entry& entry = m_entries[children[i]];
+        if(entry.isNamespace || !DoMatch(entry.name, name, lowerName, match)) continue;
+        ids.push_back(entry.id);
+        if(limit && ++count >= limit) break;
+    }
+    return true;
+}
+
+void PHPSymbolIndex::DoGetInheritance(wxLongLong id, IdVec_t& parents, std::set<wxLongLong>& visited) const
+{
+    parents.push_back(id);
+    visited.insert(id);
+
+    std::map<wxLongLong, ClassInfo>::const_iterator iter = m_classes.find(id);
+    if(iter == m_classes.end()) return;
+
+    const wxArrayString& inherits = iter->second.inherits;
+    for(size_t i = 0; i < inherits.GetCount(); ++i) {
+        // A class defined more than once is ambiguous: FindClass() does not return it either
+        std::map<wxString, std::set<wxLongLong> >::const_iterator parent = m_classIds.find(inherits.Item(i));
+        if(parent == m_classIds.end() || parent->second.size() != 1) continue;
+
+        wxLongLong parentId = *parent->second.begin();
+        if(!visited.count(parentId)) {
+            DoGetInheritance(parentId, parents, visited);
+        }
+    }
+}
+
+bool PHPSymbolIndex::GetInheritanceParentIDs(wxLongLong classId, IdVec_t& parents) const
+{
+    wxMutexLocker locker(m_mutex);
+    if(!m_loaded || !m_classes.count(classId)) return false;
+
+    std::map<wxLongLong, IdVec_t>::const_iterator iter = m_closures.find(classId);
+    if(iter == m_closures.end()) {
+        IdVec_t closure;
+        std::set<wxLongLong> visited;
+        DoGetInheritance(classId, closure, visited);
+        iter = m_closures.insert(std::make_pair(classId, closure)).first;
+    }
+    parents.insert(parents.end(), iter->second.begin(), iter->second.end());
+    return true;
+}
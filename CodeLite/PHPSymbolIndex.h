@@ -0,0 +1,185 @@
+#ifndef PHPSYMBOLINDEX_H
+#define PHPSYMBOLINDEX_H
+
+#include "codelite_exports.h"
+#include "wx/wxsqlite3.h"
+#include <wx/string.h>
+#include <wx/arrstr.h>
+#include <wx/filename.h>
+#include <wx/longlong.h>
+#include <wx/thread.h>
+#include <map>
+#include <set>
+#include <vector>
+#include <memory>
+
+/**
+ * @class PHPSymbolIndex
+ * @brief an in-memory index of the PHP symbols database.
+ * For every symbol the index keeps its database ID, its parent scope ID and its name. Names are interned and
+ * kept sorted (lower case) so prefix lookups are a binary search, "contains" lookups scan the unique names only.
+ * The index also keeps the children of every scope and the inheritance list of every class, so the inheritance
+ * closure of a class is computed (and cached) without accessing the database.
+ *
+ * There is one index per symbols database, shared by all the PHPLookupTable instances that open it: the parser
+ * thread keeps it in sync with what it commits while the code completion reads it.
+ * The index only returns IDs, the entities themselves are still loaded from the database
+ */
+class WXDLLIMPEXP_CL PHPSymbolIndex
+{
+public:
+    enum eTable {
+        kScopeTable = 0,
+        kFunctionTable,
+        kVariablesTable,
+        kTableCount,
+    };
+
+    enum eMatch {
+        kMatchAll,        // ignore the name
+        kMatchExact,      // case sensitive
+        kMatchStartsWith, // case insensitive
+        kMatchContains,   // case insensitive
+    };
+
+    typedef std::shared_ptr<PHPSymbolIndex> Ptr_t;
+    typedef std::vector<wxLongLong> IdVec_t;
+
+protected:
+    struct Entry {
+        wxLongLong id;
+        wxLongLong scopeId;
+        size_t name;
+        size_t file;
+        eTable table;
+        bool isNamespace;
+    };
+
+    struct Row {
+        Entry entry;
+        wxString name;
+        wxString file;
+        wxString fullname;      // classes only
+        wxArrayString inherits; // classes only: extends, implements and traits
+    };
+    typedef std::vector<Row> RowVec_t;
+
+    struct ClassInfo {
+        wxString fullname;
+        wxArrayString inherits;
+    };
+
+    typedef std::map<wxLongLong, std::vector<size_t> > ChildrenMap_t;
+
+    static wxMutex ms_registryLock;
+    static std::map<wxString, std::weak_ptr<PHPSymbolIndex> > ms_registry;
+
+    mutable wxMutex m_mutex;
+    bool m_loaded;  // the entries can be used for lookups
+    bool m_loading; // Load() is running
+    bool m_reloadPending;
+    std::set<wxString> m_pendingFiles;
+
+    std::vector<Entry> m_entries;
+    std::vector<size_t> m_freeEntries;
+
+    // interned names
+    std::vector<wxString> m_names;
+    std::vector<wxString> m_lowerNames;
+    std::map<wxString, size_t> m_nameIds;
+    std::vector<std::vector<size_t> > m_nameEntries;
+    std::vector<size_t> m_sortedNames; // name IDs, sorted by their lower case name
+    bool m_sortedNamesDirty;
+
+    // interned file names
+    std::map<wxString, size_t> m_fileIds;
+    std::vector<std::vector<size_t> > m_fileEntries;
+
+    ChildrenMap_t m_children[kTableCount];
+    std::set<wxLongLong> m_namespaces;
+    std::map<wxLongLong, ClassInfo> m_classes;
+    std::map<wxString, std::set<wxLongLong> > m_classIds; // class fullname -> the IDs of the classes with that name
+    mutable std::map<wxLongLong, IdVec_t> m_closures;     // cached inheritance closures
+
+protected:
+    static void DoReadRows(wxSQLite3Database& db, const wxString& filename, eTable table, RowVec_t& rows);
+    bool DoMatch(size_t name, const wxString& hint, const wxString& lowerHint, eMatch match) const;
+
+    size_t DoInternName(const wxString& name);
+    size_t DoInternFile(const wxString& filename);
+    void DoSortNames();
+    void DoAddRow(const Row& row);
+    void DoRemoveFile(const wxString& filename);
+    void DoSwap(PHPSymbolIndex& other);
+    void DoClear();
+    void DoGetInheritance(wxLongLong id, IdVec_t& parents, std::set<wxLongLong>& visited) const;
+    bool DoLoadAll(wxSQLite3Database& db);
+    void DoReloadFiles(wxSQLite3Database& db, const wxArrayString& files);
+
+public:
+    PHPSymbolIndex();
+    virtual ~PHPSymbolIndex();
+
+    /**
+     * @brief return the index of the symbols database 'dbfile'. The index is created (empty and not loaded) if
+     * no one is using it
+     */
+    static PHPSymbolIndex::Ptr_t Get(const wxFileName& dbfile);
+
+    /**
+     * @brief (re)load the index from the database. The index is built aside and swapped in when ready, so lookups
+     * are never blocked by the loading. Files reported with ReloadFiles() while loading are applied at the end
+     * @return true on success
+     */
+    bool Load(wxSQLite3Database& db);
+
+    /**
+     * @brief load the index again, but only if it is loaded (or being loaded)
+     */
+    void Reload(wxSQLite3Database& db);
+
+    /**
+     * @brief re-read the entries of 'files' from the database. Call it after the changes are committed.
+     * Does nothing when the index is not loaded
+     */
+    void ReloadFiles(wxSQLite3Database& db, const wxArrayString& files);
+
+    /**
+     * @brief remove all the entries (the database was cleared)
+     */
+    void Clear();
+
+    /**
+     * @brief is the index ready for lookups?
+     */
+    bool IsLoaded() const;
+
+    /**
+     * @brief find the IDs of entries from 'table' which match 'name'
+     * @param limit maximum number of IDs to return, 0 means no limit
+     * @return false if the index is not loaded
+     */
+    bool FindByName(eTable table, const wxString& name, eMatch match, size_t limit, IdVec_t& ids) const;
+
+    /**
+     * @brief find the IDs of entries from 'table' whose parent scope is 'parentId' and match 'name'.
+     * For kScopeTable only classes are returned
+     * @param limit maximum number of IDs to return, 0 means no limit
+     * @return false if the index is not loaded
+     */
+    bool FindChildren(eTable table,
+                      wxLongLong parentId,
+                      const wxString& name,
+                      eMatch match,
+                      size_t limit,
+                      IdVec_t& ids) const;
+
+    /**
+     * @brief return the inheritance closure of 'classId': the class itself followed by all its parents,
+     * interfaces and traits (depth first)
+     * @return false if the index is not loaded or does not know 'classId'
+     */
+    bool GetInheritanceParentIDs(wxLongLong classId, IdVec_t& parents) const;
+};
+
+#endif // PHPSYMBOLINDEX_H
@@ -113,12 +113,54 @@ static cJSON* cJSON_New_Item()
     return node;
 }
 
+/* Children index handling. The index makes size, item access and append O(1) for arrays and objects.
+   It is built on first use and dropped whenever the chain of children is changed in any other way */
+static void cJSON_DropIndex(cJSON* item)
+{
+    if(item->index)
+        cJSON_free(item->index);
+    item->index = 0;
+    item->indexSize = item->indexCapacity = 0;
+}
+static int cJSON_GrowIndex(cJSON* item, int capacity)
+{
+    cJSON** index = (cJSON**)cJSON_malloc(capacity * sizeof(cJSON*));
+    if(!index)
+        return 0;
+    if(item->index) {
+        memcpy(index, item->index, item->indexSize * sizeof(cJSON*));
+        cJSON_free(item->index);
+    }
+    item->index = index;
+    item->indexCapacity = capacity;
+    return 1;
+}
+static int cJSON_EnsureIndex(cJSON* item)
+{
+    cJSON* c;
+    int count = 0;
+    if(item->index)
+        return 1;
+    /* References share the children of another item, which may change behind their back */
+    if(item->type & cJSON_IsReference)
+        return 0;
+    for(c = item->child; c; c = c->next)
+        count++;
+    if(!cJSON_GrowIndex(item, count < 4 ? 4 : count))
+        return 0;
+    for(c = item->child; c; c = c->next)
+        item->index[item->indexSize++] = c;
+    return 1;
+}
+
 /* Delete a cJSON structure. */
 void cJSON_Delete(cJSON* c)
 {
     cJSON* next;
     while(c) {
         next = c->next;
+        if(c->index)
+            cJSON_free(c->index);
         if(!(c->type & cJSON_IsReference) && c->child)
             cJSON_Delete(c->child);
         if(!(c->type & cJSON_IsReference) && c->valuestring)
@@ -733,6 +775,8 @@ int cJSON_GetArraySize(cJSON* array)
 {
     cJSON* c = array->child;
     int i = 0;
+    if(cJSON_EnsureIndex(array))
+        return array->indexSize;
     while(c)
         i++, c = c->next;
     return i;
@@ -740,6 +784,8 @@ int cJSON_GetArraySize(cJSON* array)
 cJSON* cJSON_GetArrayItem(cJSON* array, int item)
 {
     cJSON* c = array->child;
+    if(cJSON_EnsureIndex(array))
+        return (item >= 0 && item < array->indexSize) ? array->index[item] : 0;
     while(c && item > 0)
         item--, c = c->next;
     return c;
@@ -768,6 +814,8 @@ static cJSON* create_reference(cJSON* item)
     ref->string = 0;
     ref->type |= cJSON_IsReference;
     ref->next = ref->prev = 0;
+    ref->index = 0;
+    ref->indexSize = ref->indexCapacity = 0;
     return ref;
 }
 
@@ -777,6 +825,17 @@ void cJSON_AddItemToArray(cJSON* array, cJSON* item)
     cJSON* c = array->child;
     if(!item)
         return;
+    /* Keep an existing index up to date, but do not build one: most arrays are only iterated */
+    if(array->index &&
+       (array->indexSize < array->indexCapacity || cJSON_GrowIndex(array, array->indexCapacity * 2))) {
+        if(array->indexSize)
+            suffix_object(array->index[array->indexSize - 1], item);
+        else
+            array->child = item;
+        array->index[array->indexSize++] = item;
+        return;
+    }
+    cJSON_DropIndex(array);
     if(!c) {
         array->child = item;
     } else {
@@ -810,6 +869,7 @@ cJSON* cJSON_DetachItemFromArray(cJSON* array, int which)
         c = c->next, which--;
     if(!c)
         return 0;
+    cJSON_DropIndex(array);
     if(c->prev)
         c->prev->next = c->next;
     if(c->next)
@@ -846,6 +906,7 @@ void cJSON_ReplaceItemInArray(cJSON* array, int which, cJSON* newitem)
         c = c->next, which--;
     if(!c)
         return;
+    cJSON_DropIndex(array);
     newitem->next = c->next;
     newitem->prev = c->prev;
     if(newitem->next)
@@ -79,6 +79,10 @@ typedef struct cJSON
 
     char*
     string; /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
+
+    struct cJSON** index; /* Array of the children pointers, built on demand by GetArraySize/GetArrayItem */
+    int indexSize;        /* Number of children in the index */
+    int indexCapacity;    /* Allocated slots of the index */
 } cJSON;
 
 typedef struct cJSON_Hooks
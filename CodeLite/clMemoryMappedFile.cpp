@@ -0,0 +1,102 @@
+#include "clMemoryMappedFile.h"
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#ifndef __WXMSW__
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Files smaller than this are read into memory, mapping them costs more than reading them
+#define MAPPED_FILE_MIN_SIZE (64 * 1024)
+
+clMemoryMappedFile::clMemoryMappedFile(const wxString& filename)
+    : m_data(NULL)
+    , m_size(0)
+    , m_ok(false)
+    , m_mapped(false)
+#ifdef __WXMSW__
+    , m_mapping(NULL)
+#endif
+{
+    m_ok = DoMap(filename) || DoRead(filename);
+}
+
+clMemoryMappedFile::~clMemoryMappedFile()
+{
+    if(!m_mapped) return;
+#ifdef __WXMSW__
+    ::UnmapViewOfFile(m_data);
+    ::CloseHandle(m_mapping);
+#else
+    ::munmap((void*)m_data, m_size);
+#endif
+}
+
+bool clMemoryMappedFile::DoMap(const wxString& filename)
+{
+    wxULongLong fileSize = wxFileName::GetSize(filename);
+    if(fileSize == wxInvalidSize || fileSize < MAPPED_FILE_MIN_SIZE) return false;
+    if(fileSize.GetValue() > (wxULongLong_t)((size_t)-1)) return false;
+    size_t size = (size_t)fileSize.GetValue();
+
+#ifdef __WXMSW__
+    HANDLE file = ::CreateFileW(filename.wc_str(),
+                                GENERIC_READ,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                NULL,
+                                OPEN_EXISTING,
+                                FILE_FLAG_SEQUENTIAL_SCAN,
+                                NULL);
+    if(file == INVALID_HANDLE_VALUE) return false;
+
+    // The mapping keeps a reference to the file, the file handle is no longer needed
+    HANDLE mapping = ::CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    ::CloseHandle(file);
+    if(!mapping) return false;
+
+    void* view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    if(!view) {
+        ::CloseHandle(mapping);
+        return false;
+    }
+    m_mapping = mapping;
+#else
+    int fd = ::open(filename.fn_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    void* view = ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(view == MAP_FAILED) return false;
+#ifdef MADV_SEQUENTIAL
+    ::madvise(view, size, MADV_SEQUENTIAL);
+#endif
+#endif
+
+    m_data = (const char*)view;
+    m_size = size;
+    m_mapped = true;
+    return true;
+}
+
+bool clMemoryMappedFile::DoRead(const wxString& filename)
+{
+    wxFFile fp(filename, "rb");
+    if(!fp.IsOpened()) return false;
+
+    wxFileOffset len = fp.Length();
+    if(len < 0) return false;
+
+    m_buffer.resize((size_t)len);
+    if(len && fp.Read(&m_buffer[0], (size_t)len) != (size_t)len) {
+        m_buffer.clear();
+        return false;
+    }
+    m_data = m_buffer.empty() ? NULL : m_buffer.c_str();
+    m_size = m_buffer.size();
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef CLMEMORYMAPPEDFILE_H
+#define CLMEMORYMAPPEDFILE_H
+
+#include "codelite_exports.h"
+#include <wx/string.h>
+#include <string>
+
+#ifdef __WXMSW__
+#include <wx/msw/wrapwin.h>
+#endif
+
+/**
+ * @class clMemoryMappedFile
+ * @brief a read-only view of a file content.
+ * Large files are mapped into memory, small files (or files that could not be mapped) are read into a buffer
+ */
+class WXDLLIMPEXP_CL clMemoryMappedFile
+{
+    const char* m_data;
+    size_t m_size;
+    bool m_ok;
+    bool m_mapped;
+    std::string m_buffer;
+#ifdef __WXMSW__
+    HANDLE m_mapping;
+#endif
+
+protected:
+    bool DoMap(const wxString& filename);
+    bool DoRead(const wxString& filename);
+
+public:
+    clMemoryMappedFile(const wxString& filename);
+    virtual ~clMemoryMappedFile();
+
+    bool IsOk() const { return m_ok; }
+    /**
+     * @brief the file content. Not NUL terminated. NULL for empty files
+     */
+    const char* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+};
+
+#endif // CLMEMORYMAPPEDFILE_H
@@ -0,0 +1,430 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 The CodeLite Team
+// file name            : clTaskExecutor.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "clTaskExecutor.h"
+#include "file_logger.h"
+#include <wx/tls.h>
+#include <wx/time.h>
+
+// The executor never uses less than this number of workers, even on a single core machine
+#define TASK_EXECUTOR_MIN_WORKERS 2
+
+clTaskExecutor* clTaskExecutor::ms_instance = NULL;
+
+//--------------------------------------------------------------------------------------
+// clCancellationToken
+//--------------------------------------------------------------------------------------
+clCancellationToken::clCancellationToken()
+    : m_cancelled(new std::atomic<bool>(false))
+{
+}
+
+clCancellationToken::~clCancellationToken() {}
+
+//--------------------------------------------------------------------------------------
+// clTask
+//--------------------------------------------------------------------------------------
+clTask::clTask(ePriority priority, const clCancellationToken& token)
+    : m_priority(priority)
+    , m_token(token)
+    , m_queue(NULL)
+    , m_queuedAt(0)
+{
+}
+
+clTask::~clTask() {}
+
+//--------------------------------------------------------------------------------------
+// clTaskExecutorWorker
+//--------------------------------------------------------------------------------------
+class clTaskExecutorWorker;
+// The worker running on the current thread, NULL for the other threads
+static wxTLS_TYPE(clTaskExecutorWorker*) s_currentWorker;
+
+class clTaskExecutorWorker : public wxThread
+{
+public:
+    clTaskExecutor* m_executor;
+    std::deque<clTask*> m_tasks; // tasks submitted by this worker, it takes from the back, thieves from the front
+    wxMutex m_mutex;
+
+public:
+    clTaskExecutorWorker(clTaskExecutor* executor)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_executor(executor)
+    {
+    }
+    virtual ~clTaskExecutorWorker() {}
+
+    clTask* TakeLocal()
+    {
+        wxMutexLocker locker(m_mutex);
+        if(m_tasks.empty()) return NULL;
+        clTask* task = m_tasks.back();
+        m_tasks.pop_back();
+        return task;
+    }
+
+    clTask* Steal()
+    {
+        wxMutexLocker locker(m_mutex);
+        if(m_tasks.empty()) return NULL;
+        clTask* task = m_tasks.front();
+        m_tasks.pop_front();
+        return task;
+    }
+
+    virtual void* Entry()
+    {
+        wxTLS_VALUE(s_currentWorker) = this;
+        while(true) {
+            clTask* task = m_executor->DoTakeTask(this);
+            if(task) {
+                m_executor->DoRunTask(task);
+                continue;
+            }
+
+            // Nothing to do: block until a task is submitted or the executor is stopped
+            wxMutexLocker locker(m_executor->m_mutex);
+            while(m_executor->m_pending == 0 && !m_executor->m_stopped) {
+                m_executor->m_cond.Wait();
+            }
+            if(m_executor->m_stopped) break;
+        }
+        wxTLS_VALUE(s_currentWorker) = NULL;
+        return NULL;
+    }
+};
+
+//--------------------------------------------------------------------------------------
+// clTaskQueue
+//--------------------------------------------------------------------------------------
+clTaskQueue::clTaskQueue(clTaskExecutor* executor, const wxString& name, bool serial)
+    : m_executor(executor)
+    , m_serial(serial)
+    , m_running(false)
+{
+    m_stats.name = name;
+}
+
+clTaskQueue::~clTaskQueue()
+{
+    while(!m_tasks.empty()) {
+        delete m_tasks.front();
+        m_tasks.pop_front();
+    }
+}
+
+void clTaskQueue::Submit(clTask* task)
+{
+    task->m_queue = this;
+    task->m_queuedAt = wxGetLocalTimeMillis();
+    {
+        wxMutexLocker locker(m_mutex);
+        ++m_stats.submitted;
+        ++m_stats.depth;
+        if(m_stats.depth > m_stats.maxDepth) {
+            m_stats.maxDepth = m_stats.depth;
+        }
+
+        if(m_serial) {
+            if(m_running) {
+                // Wait for the running task
+                m_tasks.push_back(task);
+                return;
+            }
+            m_running = true;
+        }
+    }
+
+    if(!m_executor->Schedule(task)) {
+        // The executor is stopped
+        OnTaskDone(task, true, 0);
+    }
+}
+
+void clTaskQueue::OnTaskDone(clTask* task, bool cancelled, const wxLongLong& latency)
+{
+    {
+        wxMutexLocker locker(m_mutex);
+        --m_stats.depth;
+        ++m_stats.completed;
+        if(cancelled) {
+            ++m_stats.cancelled;
+        }
+        m_stats.totalLatency += latency;
+        if(latency > m_stats.maxLatency) {
+            m_stats.maxLatency = latency;
+        }
+    }
+    delete task;
+
+    if(!m_serial) return;
+
+    // Schedule the next task of this queue. If the executor is stopped, discard the remaining tasks
+    while(true) {
+        clTask* next = NULL;
+        {
+            wxMutexLocker locker(m_mutex);
+            if(m_tasks.empty()) {
+                m_running = false;
+                return;
+            }
+            next = m_tasks.front();
+            m_tasks.pop_front();
+        }
+
+        if(m_executor->Schedule(next)) return;
+
+        wxMutexLocker locker(m_mutex);
+        --m_stats.depth;
+        ++m_stats.completed;
+        ++m_stats.cancelled;
+        delete next;
+    }
+}
+
+clTaskQueueStats clTaskQueue::GetStats()
+{
+    wxMutexLocker locker(m_mutex);
+    return m_stats;
+}
+
+//--------------------------------------------------------------------------------------
+// clTaskExecutor
+//--------------------------------------------------------------------------------------
+clTaskExecutor::clTaskExecutor()
+    : m_defaultQueue(NULL)
+    , m_pending(0)
+    , m_started(false)
+    , m_stopped(false)
+    , m_cond(m_mutex)
+{
+    m_defaultQueue = CreateQueue("Default", false);
+}
+
+clTaskExecutor::~clTaskExecutor()
+{
+    Stop();
+    for(size_t i = 0; i < m_queues.size(); ++i) {
+        delete m_queues.at(i);
+    }
+    m_queues.clear();
+}
+
+clTaskExecutor* clTaskExecutor::Get()
+{
+    if(ms_instance == NULL) {
+        ms_instance = new clTaskExecutor();
+    }
+    return ms_instance;
+}
+
+void clTaskExecutor::Release()
+{
+    wxDELETE(ms_instance);
+}
+
+void clTaskExecutor::DoStart()
+{
+    // Called with m_mutex locked
+    int cpus = wxThread::GetCPUCount();
+    size_t count = (cpus > TASK_EXECUTOR_MIN_WORKERS) ? (size_t)cpus : TASK_EXECUTOR_MIN_WORKERS;
+    for(size_t i = 0; i < count; ++i) {
+        clTaskExecutorWorker* worker = new clTaskExecutorWorker(this);
+        if(worker->Create() != wxTHREAD_NO_ERROR) {
+            delete worker;
+            break;
+        }
+        m_workers.push_back(worker);
+    }
+    m_started = true;
+
+    // The workers read m_workers without the lock (to steal tasks): run them only once it is complete
+    for(size_t i = 0; i < m_workers.size(); ++i) {
+        m_workers.at(i)->Run();
+    }
+}
+
+size_t clTaskExecutor::GetWorkersCount()
+{
+    wxMutexLocker locker(m_mutex);
+    if(m_stopped) return 0;
+    if(!m_started) {
+        DoStart();
+    }
+    return m_workers.size();
+}
+
+bool clTaskExecutor::Schedule(clTask* task)
+{
+    clTaskExecutorWorker* worker = wxTLS_VALUE(s_currentWorker);
+    if(worker && worker->m_executor == this && task->GetPriority() != clTask::kHigh) {
+        // Submitted by one of our workers: keep it local, the other workers will steal it if they are idle.
+        // Count it before it can be stolen (the worker lock is never held while taking m_mutex)
+        wxMutexLocker locker(m_mutex);
+        if(m_stopped) return false;
+        ++m_pending;
+        {
+            wxMutexLocker workerLocker(worker->m_mutex);
+            worker->m_tasks.push_back(task);
+        }
+        m_cond.Signal();
+        return true;
+    }
+
+    wxMutexLocker locker(m_mutex);
+    if(m_stopped) return false;
+    if(!m_started) {
+        DoStart();
+    }
+    m_tasks[task->GetPriority()].push_back(task);
+    ++m_pending;
+    m_cond.Signal();
+    return true;
+}
+
+clTask* clTaskExecutor::DoTakeTask(clTaskExecutorWorker* worker)
+{
+    clTask* task = NULL;
+    {
+        // High priority tasks first
+        wxMutexLocker locker(m_mutex);
+        if(m_stopped) return NULL;
+        if(!m_tasks[clTask::kHigh].empty()) {
+            task = m_tasks[clTask::kHigh].front();
+            m_tasks[clTask::kHigh].pop_front();
+            --m_pending;
+            return task;
+        }
+    }
+
+    // Our own tasks
+    task = worker->TakeLocal();
+    if(!task) {
+        // Tasks submitted from the other threads
+        wxMutexLocker locker(m_mutex);
+        for(size_t i = clTask::kNormal; i < clTask::kPriorityCount; ++i) {
+            if(!m_tasks[i].empty()) {
+                task = m_tasks[i].front();
+                m_tasks[i].pop_front();
+                --m_pending;
+                return task;
+            }
+        }
+    }
+
+    // Steal from the other workers
+    for(size_t i = 0; !task && i < m_workers.size(); ++i) {
+        if(m_workers.at(i) != worker) {
+            task = m_workers.at(i)->Steal();
+        }
+    }
+
+    if(task) {
+        wxMutexLocker locker(m_mutex);
+        --m_pending;
+    }
+    return task;
+}
+
+void clTaskExecutor::DoRunTask(clTask* task)
+{
+    wxLongLong latency = wxGetLocalTimeMillis() - task->m_queuedAt;
+    bool cancelled = task->IsCancelled();
+    if(!cancelled) {
+        task->Run();
+    }
+    task->m_queue->OnTaskDone(task, cancelled, latency);
+}
+
+void clTaskExecutor::Stop()
+{
+    {
+        wxMutexLocker locker(m_mutex);
+        if(m_stopped) return;
+        m_stopped = true;
+        m_cond.Broadcast();
+    }
+
+    // The running tasks can check wxThread::This()->TestDestroy() to exit early
+    std::vector<clTask*> discarded;
+    for(size_t i = 0; i < m_workers.size(); ++i) {
+        clTaskExecutorWorker* worker = m_workers.at(i);
+        if(worker->IsAlive()) {
+            worker->Delete(NULL, wxTHREAD_WAIT_BLOCK);
+
+        } else {
+            worker->Wait(wxTHREAD_WAIT_BLOCK);
+        }
+    }
+
+    // Discard the tasks that did not start
+    for(size_t i = 0; i < m_workers.size(); ++i) {
+        discarded.insert(discarded.end(), m_workers.at(i)->m_tasks.begin(), m_workers.at(i)->m_tasks.end());
+        delete m_workers.at(i);
+    }
+    m_workers.clear();
+
+    for(size_t i = 0; i < clTask::kPriorityCount; ++i) {
+        discarded.insert(discarded.end(), m_tasks[i].begin(), m_tasks[i].end());
+        m_tasks[i].clear();
+    }
+    m_pending = 0;
+
+    for(size_t i = 0; i < discarded.size(); ++i) {
+        discarded.at(i)->m_queue->OnTaskDone(discarded.at(i), true, 0);
+    }
+
+    std::vector<clTaskQueueStats> stats;
+    GetStats(stats);
+    for(size_t i = 0; i < stats.size(); ++i) {
+        const clTaskQueueStats& s = stats.at(i);
+        CL_DEBUG("Task queue '%s': %u tasks (%u cancelled), max depth %u, latency avg %s ms max %s ms",
+                 s.name,
+                 (unsigned int)s.submitted,
+                 (unsigned int)s.cancelled,
+                 (unsigned int)s.maxDepth,
+                 s.GetAverageLatency().ToString(),
+                 s.maxLatency.ToString());
+    }
+}
+
+clTaskQueue* clTaskExecutor::CreateQueue(const wxString& name, bool serial)
+{
+    clTaskQueue* queue = new clTaskQueue(this, name, serial);
+    wxMutexLocker locker(m_queuesMutex);
+    m_queues.push_back(queue);
+    return queue;
+}
+
+void clTaskExecutor::GetStats(std::vector<clTaskQueueStats>& stats)
+{
+    stats.clear();
+    wxMutexLocker locker(m_queuesMutex);
+    for(size_t i = 0; i < m_queues.size(); ++i) {
+        stats.push_back(m_queues.at(i)->GetStats());
+    }
+}
@@ -0,0 +1,225 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 The CodeLite Team
+// file name            : clTaskExecutor.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CLTASKEXECUTOR_H
+#define CLTASKEXECUTOR_H
+
+#include "codelite_exports.h"
+#include <wx/thread.h>
+#include <wx/string.h>
+#include <wx/longlong.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+/**
+ * @class clCancellationToken
+ * @brief a flag shared by the submitter of tasks and the tasks themselves.
+ * Copies of a token share the same flag. Cancelled tasks that did not start are not run,
+ * running tasks should check IsCancelled() and return early
+ */
+class WXDLLIMPEXP_CL clCancellationToken
+{
+    std::shared_ptr<std::atomic<bool> > m_cancelled;
+
+public:
+    clCancellationToken();
+    virtual ~clCancellationToken();
+
+    void Cancel() { m_cancelled->store(true); }
+    bool IsCancelled() const { return m_cancelled->load(); }
+};
+
+class clTaskQueue;
+/**
+ * @class clTask
+ * @brief a unit of work submitted to a clTaskQueue. Tasks are allocated on the heap and deleted
+ * by the executor once they were run (or discarded)
+ */
+class WXDLLIMPEXP_CL clTask
+{
+    friend class clTaskQueue;
+    friend class clTaskExecutor;
+
+public:
+    enum ePriority { kHigh = 0, kNormal, kLow, kPriorityCount };
+
+protected:
+    ePriority m_priority;
+    clCancellationToken m_token;
+    clTaskQueue* m_queue;
+    wxLongLong m_queuedAt;
+
+public:
+    clTask(ePriority priority = kNormal, const clCancellationToken& token = clCancellationToken());
+    virtual ~clTask();
+
+    /**
+     * @brief do the work. Called on one of the executor threads
+     */
+    virtual void Run() = 0;
+
+    ePriority GetPriority() const { return m_priority; }
+    const clCancellationToken& GetToken() const { return m_token; }
+    bool IsCancelled() const { return m_token.IsCancelled(); }
+};
+
+/**
+ * @class clTaskQueueStats
+ * @brief the metrics of a task queue
+ */
+struct WXDLLIMPEXP_CL clTaskQueueStats {
+    wxString name;
+    size_t depth;       // tasks submitted and not done yet
+    size_t maxDepth;
+    size_t submitted;
+    size_t completed;   // including the cancelled tasks
+    size_t cancelled;
+    wxLongLong totalLatency; // ms, from the submission until the task started
+    wxLongLong maxLatency;   // ms
+
+    clTaskQueueStats()
+        : depth(0)
+        , maxDepth(0)
+        , submitted(0)
+        , completed(0)
+        , cancelled(0)
+        , totalLatency(0)
+        , maxLatency(0)
+    {
+    }
+    wxLongLong GetAverageLatency() const { return completed ? totalLatency / (long)completed : wxLongLong(0); }
+};
+
+class clTaskExecutor;
+/**
+ * @class clTaskQueue
+ * @brief the entry point of a subsystem into the executor.
+ * A concurrent queue lets its tasks run in parallel (by priority), a serial queue runs its tasks
+ * one at a time, in the order they were submitted
+ */
+class WXDLLIMPEXP_CL clTaskQueue
+{
+    friend class clTaskExecutor;
+
+protected:
+    clTaskExecutor* m_executor;
+    bool m_serial;
+    bool m_running;               // serial queue: a task is scheduled on the executor
+    std::deque<clTask*> m_tasks; // serial queue: the tasks waiting for their turn
+    clTaskQueueStats m_stats;
+    wxMutex m_mutex;
+
+protected:
+    clTaskQueue(clTaskExecutor* executor, const wxString& name, bool serial);
+    virtual ~clTaskQueue();
+
+    /**
+     * @brief called by the executor once 'task' was run or discarded
+     */
+    void OnTaskDone(clTask* task, bool cancelled, const wxLongLong& latency);
+
+public:
+    /**
+     * @brief submit a task. The queue takes its ownership
+     */
+    void Submit(clTask* task);
+
+    bool IsSerial() const { return m_serial; }
+    clTaskQueueStats GetStats();
+};
+
+class clTaskExecutorWorker;
+/**
+ * @class clTaskExecutor
+ * @brief a pool of threads shared by all the subsystems (one per core).
+ * Every worker keeps a local deque: tasks submitted from a worker go to its own deque,
+ * idle workers take the tasks submitted from other threads (by priority) and then steal from the
+ * other workers deques. Idle workers block until there is work to do
+ */
+class WXDLLIMPEXP_CL clTaskExecutor
+{
+    friend class clTaskExecutorWorker;
+    friend class clTaskQueue;
+
+protected:
+    static clTaskExecutor* ms_instance;
+
+    std::vector<clTaskExecutorWorker*> m_workers;
+    std::deque<clTask*> m_tasks[clTask::kPriorityCount]; // tasks submitted from outside of the workers
+    std::vector<clTaskQueue*> m_queues;
+    clTaskQueue* m_defaultQueue;
+    size_t m_pending; // the number of tasks in all the deques
+    bool m_started;
+    bool m_stopped;
+    wxMutex m_mutex;
+    wxCondition m_cond;
+    wxMutex m_queuesMutex;
+
+protected:
+    clTaskExecutor();
+    virtual ~clTaskExecutor();
+
+    void DoStart();
+    /**
+     * @brief queue the task for the workers. Return false if the executor is stopped
+     */
+    bool Schedule(clTask* task);
+    clTask* DoTakeTask(clTaskExecutorWorker* worker);
+    void DoRunTask(clTask* task);
+
+public:
+    static clTaskExecutor* Get();
+    static void Release();
+
+    /**
+     * @brief stop the workers. Tasks that did not start are discarded and new tasks are
+     * discarded as well. Must be called before the code of the submitted tasks is unloaded
+     */
+    void Stop();
+
+    /**
+     * @brief create a new queue. The executor owns it
+     */
+    clTaskQueue* CreateQueue(const wxString& name, bool serial);
+
+    /**
+     * @brief submit a task to the default (concurrent) queue
+     */
+    void Submit(clTask* task) { m_defaultQueue->Submit(task); }
+
+    /**
+     * @brief return the number of worker threads, start them if needed. Return 0 once the executor is stopped
+     */
+    size_t GetWorkersCount();
+
+    /**
+     * @brief return the metrics of all the queues
+     */
+    void GetStats(std::vector<clTaskQueueStats>& stats);
+};
+
+#endif // CLTASKEXECUTOR_H
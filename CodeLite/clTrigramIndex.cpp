@@ -0,0 +1,391 @@
+#include "clTrigramIndex.h"
+#include "clMemoryMappedFile.h"
+#include "codelite_events.h"
+#include "event_notifier.h"
+#include "file_logger.h"
+#include <wx/wxsqlite3.h>
+#include <wx/filename.h>
+#include <algorithm>
+#include <deque>
+
+// Files larger than this are not indexed (they are always searched)
+#define TRIGRAM_INDEX_MAX_FILE_SIZE (8 * 1024 * 1024)
+
+// Number of files indexed in a single database transaction
+#define TRIGRAM_INDEX_BATCH_SIZE 200
+
+// Signature size in bits per distinct trigram. With a single hash the chance that a missing trigram
+// is reported as present is about 1 - e^(-1/2) ~ 40%, so a query with 5 trigrams keeps about 1% of the
+// files that do not contain it
+#define TRIGRAM_INDEX_BITS_PER_TRIGRAM 2
+
+clTrigramIndex* clTrigramIndex::ms_instance = NULL;
+
+static inline unsigned char TrigramToLower(unsigned char ch) { return (ch >= 'A' && ch <= 'Z') ? ch + 32 : ch; }
+
+//----------------------------------------------------------------------------------
+// clTrigramSignature
+//----------------------------------------------------------------------------------
+
+size_t clTrigramSignature::DoGetBit(wxUint32 trigram, size_t bitsCount)
+{
+    wxUint32 hash = trigram * 0x9E3779B1u;
+    hash ^= (hash >> 15);
+    return hash & (bitsCount - 1);
+}
+
+void clTrigramSignature::GetTrigrams(const char* data, size_t len, std::vector<wxUint32>& trigrams)
+{
+    trigrams.clear();
+    if(len < 3) return;
+
+    trigrams.reserve(len - 2);
+    const unsigned char* p = (const unsigned char*)data;
+    wxUint32 trigram = (TrigramToLower(p[0]) << 8) | TrigramToLower(p[1]);
+    for(size_t i = 2; i < len; ++i) {
+        trigram = ((trigram << 8) | TrigramToLower(p[i])) & 0xFFFFFF;
+        trigrams.push_back(trigram);
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+void clTrigramSignature::Compute(const char* data, size_t len)
+{
+    std::vector<wxUint32> trigrams;
+    GetTrigrams(data, len, trigrams);
+
+    // Use a power of 2 number of bits, at least 64
+    size_t bitsCount = 64;
+    while(bitsCount < trigrams.size() * TRIGRAM_INDEX_BITS_PER_TRIGRAM) {
+        bitsCount <<= 1;
+    }
+
+    m_bits.assign(bitsCount / 64, 0);
+    for(size_t i = 0; i < trigrams.size(); ++i) {
+        size_t bit = DoGetBit(trigrams[i], bitsCount);
+        m_bits[bit / 64] |= ((wxUint64)1 << (bit % 64));
+    }
+}
+
+bool clTrigramSignature::MayContain(const std::vector<wxUint32>& trigrams) const
+{
+    if(m_bits.empty()) return trigrams.empty();
+
+    size_t bitsCount = m_bits.size() * 64;
+    for(size_t i = 0; i < trigrams.size(); ++i) {
+        size_t bit = DoGetBit(trigrams[i], bitsCount);
+        if(!(m_bits[bit / 64] & ((wxUint64)1 << (bit % 64)))) return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------
+// clTrigramIndexThread
+//----------------------------------------------------------------------------------
+
+class clTrigramIndexThread : public wxThread
+{
+    clTrigramIndex* m_index;
+    wxString m_dbfile;
+    wxSQLite3Database m_db;
+    std::deque<wxString> m_queue;
+    wxMutex m_mutex;
+    wxCondition m_cond;
+
+protected:
+    void DoOpen()
+    {
+        try {
+            m_db.Open(m_dbfile);
+            m_db.SetBusyTimeout(10);
+            m_db.ExecuteUpdate("PRAGMA synchronous = OFF");
+            m_db.ExecuteUpdate("PRAGMA temp_store = MEMORY");
+            m_db.ExecuteUpdate("create table if not exists TRIGRAMS_FILES (FILE_NAME TEXT PRIMARY KEY, "
+                               "LAST_MODIFIED INTEGER, FILE_SIZE INTEGER, SIGNATURE BLOB)");
+
+            // Load the existing index, files will be checked against the disk when they are updated
+            wxSQLite3ResultSet res =
+                m_db.ExecuteQuery("select FILE_NAME, LAST_MODIFIED, FILE_SIZE, SIGNATURE from TRIGRAMS_FILES");
+            while(!TestDestroy() && res.NextRow()) {
+                clTrigramIndex::FileEntry entry;
+                entry.lastModified = (time_t)res.GetInt64(1).GetValue();
+                entry.size = (wxFileOffset)res.GetInt64(2).GetValue();
+
+                int len(0);
+                const unsigned char* blob = res.GetBlob(3, len);
+                if(blob && len > 0 && (len % sizeof(wxUint64)) == 0) {
+                    std::vector<wxUint64>& bits = entry.signature.GetBits();
+                    bits.resize(len / sizeof(wxUint64));
+                    memcpy(&bits[0], blob, len);
+                }
+                m_index->SetFileEntry(res.GetString(0), entry);
+            }
+
+        } catch(wxSQLite3Exception& e) {
+            CL_WARNING("Trigram index: failed to open '%s': %s", m_dbfile, e.GetMessage());
+        }
+    }
+
+    void DoDeleteFile(const wxString& filename)
+    {
+        m_index->DeleteFileEntry(filename);
+        wxSQLite3Statement st = m_db.PrepareStatement("delete from TRIGRAMS_FILES where FILE_NAME=?");
+        st.Bind(1, filename);
+        st.ExecuteUpdate();
+    }
+
+    void DoIndexFile(const wxString& filename)
+    {
+        wxStructStat buff;
+        if(wxStat(filename, &buff) != 0 || buff.st_size > TRIGRAM_INDEX_MAX_FILE_SIZE) {
+            // The file was deleted or is too big to be indexed
+            DoDeleteFile(filename);
+            return;
+        }
+
+        if(m_index->IsUpToDate(filename, buff.st_mtime, buff.st_size)) return;
+
+        clTrigramIndex::FileEntry entry;
+        entry.lastModified = buff.st_mtime;
+        entry.size = buff.st_size;
+
+        clMemoryMappedFile file(filename);
+        if(!file.IsOk()) return;
+        entry.signature.Compute(file.GetData(), file.GetSize());
+
+        const std::vector<wxUint64>& bits = entry.signature.GetBits();
+        wxSQLite3Statement st = m_db.PrepareStatement(
+            "replace into TRIGRAMS_FILES (FILE_NAME, LAST_MODIFIED, FILE_SIZE, SIGNATURE) values (?, ?, ?, ?)");
+        st.Bind(1, filename);
+        st.Bind(2, wxLongLong((wxLongLong_t)entry.lastModified));
+        st.Bind(3, wxLongLong((wxLongLong_t)entry.size));
+        st.Bind(4, (const unsigned char*)&bits[0], (int)(bits.size() * sizeof(wxUint64)));
+        st.ExecuteUpdate();
+
+        m_index->SetFileEntry(filename, entry);
+    }
+
+public:
+    clTrigramIndexThread(clTrigramIndex* index, const wxString& dbfile)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_index(index)
+        , m_dbfile(dbfile.c_str())
+        , m_cond(m_mutex)
+    {
+    }
+    virtual ~clTrigramIndexThread() {}
+
+    void Add(const wxArrayString& files)
+    {
+        wxMutexLocker locker(m_mutex);
+        for(size_t i = 0; i < files.GetCount(); ++i) {
+            m_queue.push_back(files.Item(i).c_str());
+        }
+        m_cond.Signal();
+    }
+
+    /**
+     * @brief stop the working thread
+     * this function shdould be called from the main thread only
+     */
+    void Stop()
+    {
+        if(IsAlive()) {
+            Delete(NULL, wxTHREAD_WAIT_BLOCK);
+
+        } else {
+            Wait(wxTHREAD_WAIT_BLOCK);
+        }
+    }
+
+    void* Entry()
+    {
+        DoOpen();
+        if(!m_db.IsOpen()) return NULL;
+
+        while(!TestDestroy()) {
+            wxArrayString files;
+            {
+                wxMutexLocker locker(m_mutex);
+                if(m_queue.empty()) m_cond.WaitTimeout(100);
+                while(!m_queue.empty() && files.GetCount() < TRIGRAM_INDEX_BATCH_SIZE) {
+                    files.Add(m_queue.front());
+                    m_queue.pop_front();
+                }
+            }
+            if(files.IsEmpty()) continue;
+
+            try {
+                m_db.Begin();
+                for(size_t i = 0; i < files.GetCount() && !TestDestroy(); ++i) {
+                    DoIndexFile(files.Item(i));
+                }
+                m_db.Commit();
+
+            } catch(wxSQLite3Exception& e) {
+                CL_WARNING("Trigram index: %s", e.GetMessage());
+                try {
+                    m_db.Rollback();
+                } catch(wxSQLite3Exception& e) {
+                    wxUnusedVar(e);
+                }
+            }
+        }
+        m_db.Close();
+        return NULL;
+    }
+};
+
+//----------------------------------------------------------------------------------
+// clTrigramIndex
+//----------------------------------------------------------------------------------
+
+clTrigramIndex::clTrigramIndex()
+    : m_thread(NULL)
+{
+    if(wxThread::IsMain()) {
+        EventNotifier::Get()->Bind(wxEVT_FILE_SAVED, &clTrigramIndex::OnFileSaved, this);
+        EventNotifier::Get()->Bind(wxEVT_FILE_RETAGGED, &clTrigramIndex::OnFileRetagged, this);
+        EventNotifier::Get()->Bind(wxEVT_WORKSPACE_CLOSED, &clTrigramIndex::OnWorkspaceClosed, this);
+    }
+}
+
+clTrigramIndex::~clTrigramIndex()
+{
+    if(wxThread::IsMain()) {
+        EventNotifier::Get()->Unbind(wxEVT_FILE_SAVED, &clTrigramIndex::OnFileSaved, this);
+        EventNotifier::Get()->Unbind(wxEVT_FILE_RETAGGED, &clTrigramIndex::OnFileRetagged, this);
+        EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_CLOSED, &clTrigramIndex::OnWorkspaceClosed, this);
+    }
+    Close();
+}
+
+clTrigramIndex& clTrigramIndex::Get()
+{
+    if(!ms_instance) {
+        ms_instance = new clTrigramIndex();
+    }
+    return *ms_instance;
+}
+
+void clTrigramIndex::Release() { wxDELETE(ms_instance); }
+
+void clTrigramIndex::Open(const wxString& dbfile, const wxArrayString& files)
+{
+    Close();
+    m_dbfile = dbfile;
+    m_thread = new clTrigramIndexThread(this, m_dbfile);
+    if(m_thread->Create() != wxTHREAD_NO_ERROR) {
+        CL_WARNING("Trigram index: failed to create the indexing thread");
+        wxDELETE(m_thread);
+        return;
+    }
+    m_thread->Add(files);
+    m_thread->Run();
+}
+
+void clTrigramIndex::Close()
+{
+    if(m_thread) {
+        m_thread->Stop();
+        wxDELETE(m_thread);
+    }
+
+    wxMutexLocker locker(m_mutex);
+    m_files.clear();
+    m_dbfile.Clear();
+}
+
+void clTrigramIndex::Update(const wxArrayString& files)
+{
+    if(m_thread) {
+        m_thread->Add(files);
+    }
+}
+
+bool clTrigramIndex::IsUpToDate(const wxString& filename, time_t lastModified, wxFileOffset size)
+{
+    wxMutexLocker locker(m_mutex);
+    FileEntryMap_t::const_iterator iter = m_files.find(filename);
+    return iter != m_files.end() && iter->second.lastModified == lastModified && iter->second.size == size;
+}
+
+void clTrigramIndex::SetFileEntry(const wxString& filename, const FileEntry& entry)
+{
+    wxMutexLocker locker(m_mutex);
+    m_files[filename] = entry;
+}
+
+void clTrigramIndex::DeleteFileEntry(const wxString& filename)
+{
+    wxMutexLocker locker(m_mutex);
+    m_files.erase(filename);
+}
+
+void clTrigramIndex::Filter(wxArrayString& files, const std::vector<std::string>& literals)
+{
+    std::vector<wxUint32> trigrams;
+    for(size_t i = 0; i < literals.size(); ++i) {
+        std::vector<wxUint32> literalTrigrams;
+        clTrigramSignature::GetTrigrams(literals.at(i).c_str(), literals.at(i).length(), literalTrigrams);
+        trigrams.insert(trigrams.end(), literalTrigrams.begin(), literalTrigrams.end());
+    }
+    if(trigrams.empty()) return;
+
+    // Check the files against the disk first, without holding the lock
+    std::vector<std::pair<time_t, wxFileOffset> > stats(files.GetCount(), std::make_pair((time_t)0, (wxFileOffset)-1));
+    for(size_t i = 0; i < files.GetCount(); ++i) {
+        wxStructStat buff;
+        if(wxStat(files.Item(i), &buff) == 0) {
+            stats[i] = std::make_pair((time_t)buff.st_mtime, (wxFileOffset)buff.st_size);
+        }
+    }
+
+    wxArrayString candidates;
+    candidates.Alloc(files.GetCount());
+    {
+        wxMutexLocker locker(m_mutex);
+        for(size_t i = 0; i < files.GetCount(); ++i) {
+            FileEntryMap_t::const_iterator iter = m_files.find(files.Item(i));
+            bool upToDate = (iter != m_files.end()) && (iter->second.lastModified == stats[i].first) &&
+                            (iter->second.size == stats[i].second);
+            if(!upToDate || iter->second.signature.MayContain(trigrams)) {
+                candidates.Add(files.Item(i));
+            }
+        }
+    }
+    CL_DEBUG("Trigram index: %u out of %u files are candidates",
+             (unsigned int)candidates.GetCount(),
+             (unsigned int)files.GetCount());
+    files = candidates;
+}
+
+void clTrigramIndex::OnFileSaved(clCommandEvent& e)
+{
+    e.Skip();
+    if(!IsOpen()) return;
+
+    wxArrayString files;
+    files.Add(e.GetFileName());
+    Update(files);
+}
+
+void clTrigramIndex::OnFileRetagged(wxCommandEvent& e)
+{
+    e.Skip();
+    std::vector<wxFileName>* retaggedFiles = (std::vector<wxFileName>*)e.GetClientData();
+    if(!IsOpen() || !retaggedFiles) return;
+
+    wxArrayString files;
+    for(size_t i = 0; i < retaggedFiles->size(); ++i) {
+        files.Add(retaggedFiles->at(i).GetFullPath());
+    }
+    Update(files);
+}
+
+void clTrigramIndex::OnWorkspaceClosed(wxCommandEvent& e)
+{
+    e.Skip();
+    Close();
+}
@@ -0,0 +1,120 @@
+#ifndef CLTRIGRAMINDEX_H
+#define CLTRIGRAMINDEX_H
+
+#include "codelite_exports.h"
+#include "cl_command_event.h"
+#include <wx/event.h>
+#include <wx/string.h>
+#include <wx/arrstr.h>
+#include <wx/thread.h>
+#include <wx/filefn.h>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @class clTrigramSignature
+ * @brief the trigrams of a file content, kept as a bit set (a bloom filter with a single hash).
+ * The trigrams are computed on the raw bytes of the file, ASCII letters are lower cased
+ */
+class WXDLLIMPEXP_CL clTrigramSignature
+{
+    std::vector<wxUint64> m_bits;
+
+protected:
+    static size_t DoGetBit(wxUint32 trigram, size_t bitsCount);
+
+public:
+    clTrigramSignature() {}
+    virtual ~clTrigramSignature() {}
+
+    /**
+     * @brief collect the (unique, sorted) trigrams of 'data'
+     */
+    static void GetTrigrams(const char* data, size_t len, std::vector<wxUint32>& trigrams);
+
+    /**
+     * @brief build the signature of 'data'
+     */
+    void Compute(const char* data, size_t len);
+
+    /**
+     * @brief return false if the content certainly does not contain all of the 'trigrams'
+     */
+    bool MayContain(const std::vector<wxUint32>& trigrams) const;
+
+    std::vector<wxUint64>& GetBits() { return m_bits; }
+    const std::vector<wxUint64>& GetBits() const { return m_bits; }
+};
+
+class clTrigramIndexThread;
+/**
+ * @class clTrigramIndex
+ * @brief a persistent index of the workspace files trigrams, used by the find in files to skip
+ * the files that can not contain the searched text.
+ * The index is built and updated by a background thread. Files are re-indexed when they are saved
+ * or retagged. Files that are not in the index (or changed since they were indexed) are never skipped
+ */
+class WXDLLIMPEXP_CL clTrigramIndex : public wxEvtHandler
+{
+    friend class clTrigramIndexThread;
+
+public:
+    struct FileEntry {
+        time_t lastModified;
+        wxFileOffset size;
+        clTrigramSignature signature;
+
+        FileEntry()
+            : lastModified(0)
+            , size(0)
+        {
+        }
+    };
+    typedef std::map<wxString, FileEntry> FileEntryMap_t;
+
+protected:
+    static clTrigramIndex* ms_instance;
+    wxString m_dbfile;
+    FileEntryMap_t m_files;
+    wxMutex m_mutex;
+    clTrigramIndexThread* m_thread;
+
+protected:
+    clTrigramIndex();
+    virtual ~clTrigramIndex();
+
+    void OnFileSaved(clCommandEvent& e);
+    void OnFileRetagged(wxCommandEvent& e);
+    void OnWorkspaceClosed(wxCommandEvent& e);
+
+    // Called by the index thread
+    bool IsUpToDate(const wxString& filename, time_t lastModified, wxFileOffset size);
+    void SetFileEntry(const wxString& filename, const FileEntry& entry);
+    void DeleteFileEntry(const wxString& filename);
+
+public:
+    static clTrigramIndex& Get();
+    static void Release();
+
+    /**
+     * @brief open (or create) the index stored in 'dbfile' and start indexing 'files'
+     */
+    void Open(const wxString& dbfile, const wxArrayString& files);
+    void Close();
+    bool IsOpen() const { return m_thread != NULL; }
+
+    /**
+     * @brief re-index 'files' in the background (only files that changed since they were indexed)
+     */
+    void Update(const wxArrayString& files);
+
+    /**
+     * @brief remove from 'files' the files that can not contain all of the 'literals' (UTF-8 strings).
+     * Literals shorter than 3 bytes do not filter anything.
+     * This function is thread safe
+     */
+    void Filter(wxArrayString& files, const std::vector<std::string>& literals);
+};
+
+#endif // CLTRIGRAMINDEX_H
@@ -43,84 +43,6 @@ void CppToken::append(wxChar ch) { name << ch; }
 
 void CppToken::print() { wxPrintf(wxT("%s | %ld\n"), name.c_str(), offset); }
 
-int CppToken::store(wxSQLite3Database* db, wxLongLong fileID) const
-{
-    try {
-
-        wxSQLite3Statement st = db->PrepareStatement(
-            "REPLACE INTO TOKENS_TABLE (ID, NAME, OFFSET, FILE_ID, LINE_NUMBER) VALUES(NULL, ?, ?, ?, ?)");
-        st.Bind(1, getName());
-        st.Bind(2, (int)getOffset());
-        st.Bind(3, fileID);
-        st.Bind(4, (int)getLineNumber());
-        st.ExecuteUpdate();
-        return db->GetLastRowId().ToLong();
-
-    } catch(wxSQLite3Exception& e) {
-        wxUnusedVar(e);
-    }
-    return wxNOT_FOUND;
-}
-
-CppToken::List_t CppToken::loadByNameAndFile(wxSQLite3Database* db, const wxString& name, wxLongLong fileID)
-{
-    CppToken::List_t matches;
-    try {
-        wxSQLite3Statement st = db->PrepareStatement("select * from TOKENS_TABLE where FILE_ID=? AND NAME=?");
-        st.Bind(1, fileID);
-        st.Bind(2, name);
-        wxSQLite3ResultSet res = st.ExecuteQuery();
-        while(res.NextRow()) {
-            CppToken token(res);
-            matches.push_back(token);
-        }
-
-    } catch(wxSQLite3Exception& e) {
-        wxUnusedVar(e);
-    }
-    return matches;
-}
-
-CppToken::CppToken(wxSQLite3ResultSet& res)
-{
-    setId(res.GetInt(0));
-    setName(res.GetString(1));
-    setOffset(res.GetInt(2));
-    setLineNumber(res.GetInt(4));
-}
-
-CppToken::List_t CppToken::loadByName(wxSQLite3Database* db, const wxString& name)
-{
-    CppToken::List_t matches;
-    std::map<wxLongLong, wxString> fileIdToFile;
-    try {
-        wxSQLite3Statement st = db->PrepareStatement("select * from TOKENS_TABLE where NAME=?");
-        st.Bind(1, name);
-        wxSQLite3ResultSet res = st.ExecuteQuery();
-        while(res.NextRow()) {
-            CppToken token(res);
-            wxLongLong fileID = res.GetInt64(3);
-            if(fileIdToFile.count(fileID)) {
-                token.setFilename(fileIdToFile.find(fileID)->second);
-            } else {
-                // load from the db
-                wxSQLite3Statement st1 = db->PrepareStatement("SELECT FILE_NAME FROM FILES WHERE ID=? LIMIT 1");
-                st1.Bind(1, fileID);
-                wxSQLite3ResultSet res1 = st1.ExecuteQuery();
-                if(res1.NextRow()) {
-                    token.setFilename(res1.GetString(0));
-                    fileIdToFile.insert(std::make_pair(fileID, token.getFilename()));
-                }
-            }
-            matches.push_back(token);
-        }
-
-    } catch(wxSQLite3Exception& e) {
-        wxUnusedVar(e);
-    }
-    return matches;
-}
-
 //-----------------------------------------------------------------
 // CppTokensMap
 //-----------------------------------------------------------------
@@ -92,35 +92,11 @@ public:
 
 public:
     CppToken();
-    CppToken(wxSQLite3ResultSet &res);
     ~CppToken();
 
     void reset();
     void append(wxChar ch);
     
-    /**
-     * @brief store the token into the datbase.
-     * @param db database pointer
-     * @param fileId the file ID for this token
-     */
-    int store(wxSQLite3Database* db, wxLongLong fileId) const;
-    
-    /**
-     * @brief load tokens from the cache by file/name
-     * @param db
-     * @param name
-     * @param file_name
-     * @return 
-     */
-    static CppToken::List_t loadByNameAndFile(wxSQLite3Database* db, const wxString& name, wxLongLong fileID);
-    /**
-     * @brief 
-     * @param db
-     * @param name
-     * @return 
-     */
-    static CppToken::List_t loadByName(wxSQLite3Database* db, const wxString& name);
-    
     void setName(const wxString& name) {
         this->name = name;
     }
@@ -30,6 +30,7 @@
 #include "stringaccessor.h"
 #include "dirsaver.h"
 #include "ctags_manager.h"
+#include <algorithm>
 
 CppWordScanner::CppWordScanner(const wxString& fileName)
     : m_filename(fileName)
@@ -356,14 +357,12 @@ void CppWordScanner::doInit()
 
 TextStatesPtr CppWordScanner::states()
 {
-    TextStatesPtr bitmap(new TextStates());
-    bitmap->states.resize(m_text.size());
-
-    if(bitmap->states.size() == 0) {
+    if(m_text.IsEmpty()) {
         return NULL;
     }
 
-    bitmap->text = m_text;
+    TextStatesPtr bitmap(new TextStates());
+    bitmap->SetText(m_text);
 
     int state(STATE_NORMAL);
     int depth(0);
@@ -482,26 +481,26 @@ TextStatesPtr CppWordScanner::states()
 int TextStates::FunctionEndPos(int position)
 {
     // Sanity
-    if(text.length() != states.size()) return wxNOT_FOUND;
+    if(!IsOk()) return wxNOT_FOUND;
 
     if(position < 0) return wxNOT_FOUND;
 
-    if(position >= (int)text.length()) return wxNOT_FOUND;
+    if(position >= (int)m_text.length()) return wxNOT_FOUND;
 
-    if(states[position].depth < 0) {
+    if(GetDepth(position) < 0) {
         // we are already at depth 0 (which means global scope)
         return wxNOT_FOUND;
     }
 
-    // Note that each call to 'Next' / 'Prev' updates the 'pos' member
-    int curdepth = states[position].depth;
+    // Note that each call to 'Next' / 'Prev' updates the 'm_pos' and 'm_posRun' members
+    int curdepth = GetDepth(position);
 
     // Step 1: search from this point downward until we find an opening brace (i.e. depth is equal to curdepth+1)
     SetPosition(position);
 
     wxChar ch = Next();
     while(ch) {
-        if(states[pos].depth == curdepth + 1) break;
+        if(m_runs[m_posRun].depth == curdepth + 1) break;
         ch = Next();
     }
 
@@ -510,12 +509,12 @@ int TextStates::FunctionEndPos(int position)
 
     ch = Next();
     while(ch) {
-        if(states[pos].depth == curdepth) break;
+        if(m_runs[m_posRun].depth == curdepth) break;
         ch = Next();
     }
 
-    if(pos > position) {
-        return pos;
+    if(m_pos > position) {
+        return m_pos;
     }
 
     return wxNOT_FOUND;
@@ -523,65 +522,153 @@ int TextStates::FunctionEndPos(int position)
 
 wxChar TextStates::Next()
 {
-    if(text.length() != states.size()) return 0;
+    if(!IsOk()) return 0;
 
-    if(pos == wxNOT_FOUND) return 0;
+    if(m_pos == wxNOT_FOUND) return 0;
 
     // reached end of text
-    pos++;
-    while(pos < (int)text.length()) {
-        int st = states[pos].state;
-        if(st == CppWordScanner::STATE_NORMAL) {
-            if(text.length() > (size_t)pos) return text.at(pos);
-            ;
-            return 0;
+    m_pos++;
+    while(m_pos < (int)m_text.length()) {
+        m_posRun = DoFindRun(m_pos, m_posRun);
+        if(m_runs[m_posRun].state == CppWordScanner::STATE_NORMAL) {
+            return (unsigned char)m_text[m_pos];
         }
-        pos++;
+        // skip the rest of the run
+        m_pos = (m_posRun + 1 < m_runs.size()) ? m_runs[m_posRun + 1].start : (int)m_text.length();
     }
     return 0;
 }
 
 wxChar TextStates::Previous()
 {
-    if(text.length() != states.size()) return 0;
+    if(!IsOk()) return 0;
 
-    if(pos == wxNOT_FOUND) return 0;
+    if(m_pos == wxNOT_FOUND) return 0;
 
     // reached start of text
-    if(pos == 0) return 0;
-
-    pos--;
-    while(pos) {
-        int st = states[pos].state;
-        if(st == CppWordScanner::STATE_NORMAL) {
-            if(text.length() > (size_t)pos) return text.at(pos);
-            return 0;
+    if(m_pos == 0) return 0;
+
+    m_pos--;
+    while(m_pos > 0) {
+        m_posRun = DoFindRun(m_pos, m_posRun);
+        if(m_runs[m_posRun].state == CppWordScanner::STATE_NORMAL) {
+            return (unsigned char)m_text[m_pos];
         }
-        pos--;
+        // skip the rest of the run (the first character is never checked)
+        m_pos = std::max(m_runs[m_posRun].start - 1, 0);
     }
     return 0;
 }
 
-void TextStates::SetPosition(int pos) { this->pos = pos; }
+void TextStates::SetPosition(int pos) { m_pos = pos; }
+
+void TextStates::SetText(const wxString& str)
+{
+    m_text.clear();
+    m_text.reserve(str.length());
+    for(wxString::const_iterator iter = str.begin(); iter != str.end(); ++iter) {
+        wxUint32 ch = (*iter).GetValue();
+        m_text.push_back(ch > 0xFF ? '?' : (char)ch);
+    }
+
+    m_runs.clear();
+    m_lineBreaks.clear();
+    m_lineToPos.clear();
+    m_length = 0;
+    m_pos = wxNOT_FOUND;
+    m_posRun = 0;
+}
 
 void TextStates::SetState(size_t where, int state, int depth, int lineNo)
 {
-    if(where < states.size()) {
-        states[where].depth = depth;
-        states[where].state = state;
-        states[where].lineNo = lineNo;
+    if(where < m_text.length() && where + 1 >= m_length) {
+        if(where + 1 == m_length) {
+            // Setting the last character again: take it out of its run first
+            if(m_runs.back().start == (int)where) {
+                m_runs.pop_back();
+            }
+
+        } else if(where > m_length && (m_runs.empty() || m_runs.back().state != 0 || m_runs.back().depth != 0)) {
+            // Characters that were skipped have the default state
+            Run gap = { (int)m_length, 0, 0 };
+            m_runs.push_back(gap);
+        }
+
+        if(m_runs.empty() || m_runs.back().state != state || m_runs.back().depth != depth) {
+            Run run = { (int)where, (short)state, (short)depth };
+            m_runs.push_back(run);
+        }
+        m_length = where + 1;
+    }
+
+    while((int)m_lineBreaks.size() < lineNo) {
+        m_lineBreaks.push_back(where);
     }
 
-    if(lineToPos.empty() || (int)lineToPos.size() - 1 < lineNo) {
-        lineToPos.push_back(where);
+    if(m_lineToPos.empty() || (int)m_lineToPos.size() - 1 < lineNo) {
+        m_lineToPos.push_back(where);
     }
 }
 
+size_t TextStates::DoFindRun(int where) const
+{
+    // the last run which starts at or before 'where'
+    size_t first = 0;
+    size_t count = m_runs.size();
+    while(count > 0) {
+        size_t step = count / 2;
+        if(m_runs[first + step].start <= where) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first ? first - 1 : 0;
+}
+
+size_t TextStates::DoFindRun(int where, size_t hint) const
+{
+    // Sequential access: 'where' is usually in the hinted run or in one of its neighbours
+    for(size_t i = (hint ? hint - 1 : 0); i < m_runs.size() && i <= hint + 1; ++i) {
+        if(m_runs[i].start <= where && (i + 1 == m_runs.size() || m_runs[i + 1].start > where)) {
+            return i;
+        }
+    }
+    return DoFindRun(where);
+}
+
+short TextStates::GetState(int where) const
+{
+    if(where < 0 || where >= (int)m_length) return CppWordScanner::STATE_NORMAL;
+    return m_runs[DoFindRun(where)].state;
+}
+
+short TextStates::GetDepth(int where) const
+{
+    if(where < 0 || where >= (int)m_length) return 0;
+    return m_runs[DoFindRun(where)].depth;
+}
+
+int TextStates::GetLineNo(int where) const
+{
+    if(where < 0 || where >= (int)m_length) return 0;
+    return std::upper_bound(m_lineBreaks.begin(), m_lineBreaks.end(), where) - m_lineBreaks.begin();
+}
+
+wxString TextStates::GetText(size_t from, size_t len) const
+{
+    if(from >= m_text.length()) return wxEmptyString;
+
+    len = std::min(len, m_text.length() - from);
+    return wxString(m_text.c_str() + from, wxConvISO8859_1, len);
+}
+
 int TextStates::LineToPos(int lineNo)
 {
     if(IsOk() == false) return wxNOT_FOUND;
 
-    if(lineToPos.empty() || (int)lineToPos.size() < lineNo || lineNo < 0) return wxNOT_FOUND;
+    if(m_lineToPos.empty() || (int)m_lineToPos.size() < lineNo || lineNo < 0) return wxNOT_FOUND;
 
-    return lineToPos.at(lineNo);
+    return m_lineToPos.at(lineNo);
 }
@@ -31,44 +31,93 @@
 #include "smart_ptr.h"
 #include "codelite_exports.h"
 #include <set>
-
-struct ByteState {
-    short state;   // Holds the current byte state (one of CppWordScanner::STATE_*)
-    short depth;   // The current char depth
-    short depthId; // The depth ID (there can be multiple blocks of the same depth in a given scope)
-    int   lineNo;  // the line number which holds this byte
-};
-
+#include <string>
+
+/**
+ * @class TextStates
+ * @brief the state (code, comment, string...) and the braces depth of every character of a scanned text.
+ * States are kept as runs: a new run starts only where the state or the depth changes, and line numbers are
+ * computed from the positions where a new line starts. The text is kept with one byte per character (the file is
+ * read as ISO-8859-1, so these are the file bytes as they are, UTF-8 included) which keeps the positions identical
+ * to the token offsets reported by the scanner
+ */
 class WXDLLIMPEXP_CL TextStates
 {
-public:
-    wxString            text;
-    std::vector<ByteState> states;
-    std::vector<int>       lineToPos;
-    int                    pos;
+protected:
+    struct Run {
+        int start;   // position of the first character of this run
+        short state; // one of CppWordScanner::STATE_*
+        short depth; // the braces depth
+    };
+
+    std::string m_text;
+    std::vector<Run> m_runs;
+    std::vector<int> m_lineBreaks; // the positions where the line number is increased
+    std::vector<int> m_lineToPos;
+    size_t m_length;             // the number of characters which have a state
+    int m_pos;
+    size_t m_posRun;             // the run that holds 'm_pos' (a hint, Next() / Previous() walk the runs in order)
+
+protected:
+    size_t DoFindRun(int where) const;
+    size_t DoFindRun(int where, size_t hint) const;
 
 public:
     TextStates()
-        : pos(wxNOT_FOUND) {
+        : m_length(0)
+        , m_pos(wxNOT_FOUND)
+        , m_posRun(0)
+    {
     }
 
-    virtual ~TextStates() {
-    }
+    virtual ~TextStates() {}
 
-    void   SetPosition(int pos);
+    void SetPosition(int pos);
     wxChar Previous();
     wxChar Next();
 
     /**
      * @brief return true if the current TextState is valid. The test is simple:
-     * if the vector size and the text size are equal
+     * every character of the text has a state
      */
-    bool   IsOk() const {
-        return states.size() == text.length();
-    }
+    bool IsOk() const { return m_length == m_text.length(); }
+
+    /**
+     * @brief set the text to scan. Characters which do not fit in a byte are kept as '?'
+     */
+    void SetText(const wxString& str);
 
+    /**
+     * @brief set the state of the character at 'where'. Characters must be set in order (setting the last
+     * character again is allowed)
+     */
     void SetState(size_t where, int state, int depth, int lineNo);
 
+    /**
+     * @brief return the number of characters in the text
+     */
+    size_t GetLength() const { return m_text.length(); }
+
+    /**
+     * @brief return 'len' characters of the text, starting at 'from'
+     */
+    wxString GetText(size_t from = 0, size_t len = std::string::npos) const;
+
+    /**
+     * @brief return the state of the character at 'where' (one of CppWordScanner::STATE_*)
+     */
+    short GetState(int where) const;
+
+    /**
+     * @brief return the braces depth of the character at 'where'
+     */
+    short GetDepth(int where) const;
+
+    /**
+     * @brief return the line number which holds the character at 'where'
+     */
+    int GetLineNo(int where) const;
+
     /**
      * @brief return the end of a given function
      * @param position function start position. This function searches for the first opening brace from position '{' and returns the position of the matching
@@ -64,6 +64,7 @@
 #include "cl_standard_paths.h"
 #include <algorithm>
 #include "CxxTemplateFunction.h"
+#include "fileutils.h"
 #include <wx/log.h>
 
 //#define __PERFORMANCE
@@ -75,6 +76,10 @@
 #define PIPE_NAME "/tmp/codelite_indexer.%s.sock"
 #endif
 
+// Maximum total size of the source files sent to the indexer in a single batched request. The reply must
+// fit the indexer protocol limit (64MB), which leaves room for tags larger than their source
+#define INDEXER_BATCH_MAX_SOURCE_SIZE (16 * 1024 * 1024)
+
 const wxEventType wxEVT_UPDATE_FILETREE_EVENT = XRCID("update_file_tree_event");
 const wxEventType wxEVT_TAGS_DB_UPGRADE = XRCID("tags_db_upgraded");
 const wxEventType wxEVT_TAGS_DB_UPGRADE_INTER = XRCID("tags_db_upgraded_now");
@@ -141,6 +146,7 @@ TagsManager::TagsManager()
     : wxEvtHandler()
     , m_codeliteIndexerPath(wxT("codelite_indexer"))
     , m_codeliteIndexerProcess(NULL)
+    , m_indexerRestartPending(false)
     , m_canRestartIndexer(true)
     , m_lang(NULL)
     , m_evtHandler(NULL)
@@ -163,6 +169,7 @@ TagsManager::TagsManager()
 
 TagsManager::~TagsManager()
 {
+    wxMutexLocker locker(m_indexerLock);
     if(m_codeliteIndexerProcess) {
 
         // Dont kill the indexer process, just terminate the
@@ -202,6 +209,7 @@ void TagsManager::OpenDatabase(const wxFileName& fileName)
     db->OpenDatabase(fileName);
     db->SetEnableCaseInsensitive(!(m_tagsOptions.GetFlags() & CC_IS_CASE_SENSITIVE));
     db->SetSingleSearchLimit(m_tagsOptions.GetCcNumberOfDisplayItems());
+    db->SetUseSymbolIndex(true);
 
     if(db->GetVersion() != db->GetSchemaVersion()) {
         db->RecreateDatabase();
@@ -293,6 +301,7 @@ void TagsManager::StartCodeLiteIndexer()
 {
     if(!m_canRestartIndexer) return;
 
+    wxMutexLocker locker(m_indexerLock);
     // Run ctags process
     wxString cmd;
     wxString ctagsCmd;
@@ -309,13 +318,23 @@ void TagsManager::StartCodeLiteIndexer()
 
     // concatenate the PID to identifies this channel to this instance of codelite
     cmd << wxT("\"") << m_codeliteIndexerPath.GetFullPath() << wxT("\" ") << uid << wxT(" --pid");
+
+    // Run a pool of indexer processes so the parallel parser workers are not serialised at the indexer
+    size_t workers = ParseThreadST::Get()->GetParserWorkers();
+    if(workers > 1) {
+        cmd << wxT(" --workers ") << (int)workers;
+    }
     m_codeliteIndexerProcess =
         CreateAsyncProcess(this, cmd, IProcessCreateDefault, clStandardPaths::Get().GetUserDataDir());
 }
 
 void TagsManager::RestartCodeLiteIndexer()
 {
-    if(m_codeliteIndexerProcess) {
+    // Called by the parser workers as well: several of them may fail at the same time, terminate
+    // the indexer only once and never while the main thread deletes it
+    wxMutexLocker locker(m_indexerLock);
+    if(m_codeliteIndexerProcess && !m_indexerRestartPending) {
+        m_indexerRestartPending = true;
         m_codeliteIndexerProcess->Terminate();
     }
 
@@ -328,14 +347,18 @@ void TagsManager::SetCodeLiteIndexerPath(const wxString& path) { m_codeliteIndex
 void TagsManager::OnIndexerTerminated(clProcessEvent& event)
 {
     wxUnusedVar(event);
-    wxDELETE(m_codeliteIndexerProcess);
+    {
+        wxMutexLocker locker(m_indexerLock);
+        wxDELETE(m_codeliteIndexerProcess);
+        m_indexerRestartPending = false;
+    }
     StartCodeLiteIndexer();
 }
 
 //---------------------------------------------------------------------
 // Parsing
 //---------------------------------------------------------------------
-void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
+bool TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
 {
     std::stringstream s;
     s << wxGetProcessId();
@@ -357,21 +380,18 @@ void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
     req.setFiles(files);
 
     // set ctags options to be used
-    wxString ctagsCmd;
-    ctagsCmd << wxT(" ") << m_tagsOptions.ToString()
-             << wxT(" --excmd=pattern --sort=no --fields=aKmSsnit --c-kinds=+p --C++-kinds=+p ");
-    req.setCtagOptions(ctagsCmd.mb_str(wxConvUTF8).data());
+    req.setCtagOptions(DoGetIndexerOptions().mb_str(wxConvUTF8).data());
 
     // connect to the indexer
     if(!client.connect()) {
         wxPrintf(wxT("Failed to connect to indexer ID %d!\n"), (int)wxGetProcessId());
-        return;
+        return false;
     }
 
     // send the request
     if(!clIndexerProtocol::SendRequest(&client, req)) {
         wxPrintf(wxT("Failed to send request to indexer ID [%d]\n"), (int)wxGetProcessId());
-        return;
+        return false;
     }
 
     // read the reply
@@ -379,23 +399,15 @@ void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
     try {
         if(!clIndexerProtocol::ReadReply(&client, reply)) {
             RestartCodeLiteIndexer();
-            return;
+            return false;
         }
     } catch(std::bad_alloc& ex) {
         tags.Clear();
-        return;
+        return false;
     }
 
     // convert the data into wxString
-    if(m_encoding == wxFONTENCODING_DEFAULT || m_encoding == wxFONTENCODING_SYSTEM)
-        tags = wxString(reply.getTags().c_str(), wxConvUTF8);
-    else
-        tags = wxString(reply.getTags().c_str(), wxCSConv(m_encoding));
-    if(tags.empty()) {
-        tags = wxString::From8BitData(reply.getTags().c_str());
-    }
-
-    AddEnumClassData(tags);
+    DoConvertIndexerTags(reply.getTags().c_str(), reply.getTags().length(), tags);
 
 #if 0
     wxFFile fff(clStandardPaths::Get().GetUserDataDir() + wxT("\\tmp_tags"), wxT("w+"));
@@ -403,6 +415,139 @@ void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
         fff.Write(tags);
     }
 #endif
+    return true;
+}
+
+bool TagsManager::SourcesToTags(const wxArrayString& sources, wxArrayString& tags)
+{
+    tags.Clear();
+    if(sources.IsEmpty()) return true;
+
+    // The reply carries the tags of all the files in the request. Split the files into requests whose
+    // total source size is capped, so a reply never exceeds the protocol limit
+    bool succeeded = true;
+    size_t first = 0;
+    while(first < sources.GetCount()) {
+        wxArrayString batch;
+        wxFileOffset batchSize = 0;
+        for(size_t i = first; i < sources.GetCount(); ++i) {
+            wxStructStat buff;
+            wxFileOffset size = (wxStat(sources.Item(i), &buff) == 0) ? (wxFileOffset)buff.st_size : 0;
+            if(!batch.IsEmpty() && (batchSize + size) > INDEXER_BATCH_MAX_SOURCE_SIZE) break;
+            batch.Add(sources.Item(i));
+            batchSize += size;
+        }
+        first += batch.GetCount();
+
+        wxArrayString batchTags;
+        if(!DoSourcesToTags(batch, batchTags)) {
+            succeeded = false;
+        }
+        // Make sure we always return an entry per file
+        for(size_t i = 0; i < batch.GetCount(); ++i) {
+            tags.Add(i < batchTags.GetCount() ? batchTags.Item(i) : wxString());
+        }
+    }
+    return succeeded;
+}
+
+bool TagsManager::DoSourcesToTags(const wxArrayString& sources, wxArrayString& tags)
+{
+    tags.Clear();
+
+    std::stringstream s;
+    s << wxGetProcessId();
+
+    char channel_name[1024];
+    memset(channel_name, 0, sizeof(channel_name));
+    sprintf(channel_name, PIPE_NAME, s.str().c_str());
+
+    clNamedPipeClient client(channel_name);
+
+    // Build a batched request: the indexer replies with a tags block per file
+    clIndexerRequest req;
+    req.setCmd(clIndexerRequest::CLI_PARSE_BATCH);
+
+    std::vector<std::string> files;
+    files.reserve(sources.GetCount());
+    for(size_t i = 0; i < sources.GetCount(); ++i) {
+        files.push_back(sources.Item(i).mb_str(wxConvUTF8).data());
+    }
+    req.setFiles(files);
+
+    // set ctags options to be used
+    req.setCtagOptions(DoGetIndexerOptions().mb_str(wxConvUTF8).data());
+
+    // connect to the indexer
+    if(!client.connect()) {
+        wxPrintf(wxT("Failed to connect to indexer ID %d!\n"), (int)wxGetProcessId());
+        return false;
+    }
+
+    // send the request
+    if(!clIndexerProtocol::SendRequest(&client, req)) {
+        wxPrintf(wxT("Failed to send request to indexer ID [%d]\n"), (int)wxGetProcessId());
+        return false;
+    }
+
+    // read the reply
+    clIndexerReply reply;
+    try {
+        if(!clIndexerProtocol::ReadReply(&client, reply)) {
+            RestartCodeLiteIndexer();
+            return false;
+        }
+    } catch(std::bad_alloc& ex) {
+        return false;
+    }
+
+    // The blocks are returned in the order of the request. Convert them directly from the
+    // reply buffer without copying them into intermediate strings
+    tags.Alloc(sources.GetCount());
+    size_t offset(0);
+    clIndexerReply::Block block;
+    while(tags.GetCount() < files.size() && reply.nextBlock(offset, block)) {
+        const std::string& expected = files.at(tags.GetCount());
+        if(expected.length() != block.fileNameLen || expected.compare(0, expected.length(), block.fileName, block.fileNameLen) != 0) {
+            CL_WARNING("SourcesToTags: unexpected block in indexer reply for file %s", sources.Item(tags.GetCount()));
+            break;
+        }
+
+        wxString fileTags;
+        DoConvertIndexerTags(block.tags, block.tagsLen, fileTags);
+        tags.Add(fileTags);
+    }
+
+    // Files without a block in the reply were not parsed
+    return tags.GetCount() == sources.GetCount();
+}
+
+wxString TagsManager::DoGetIndexerOptions() const
+{
+    wxString ctagsCmd;
+    ctagsCmd << wxT(" ") << m_tagsOptions.ToString()
+             << wxT(" --excmd=pattern --sort=no --fields=aKmSsnit --c-kinds=+p --C++-kinds=+p ");
+    return ctagsCmd;
+}
+
+wxString TagsManager::GetIndexerOptionsHash() const { return FileUtils::GetStringHash(DoGetIndexerOptions()); }
+
+void TagsManager::DoConvertIndexerTags(const char* data, size_t len, wxString& tags)
+{
+    if(len == 0) {
+        tags.Clear();
+        return;
+    }
+
+    if(m_encoding == wxFONTENCODING_DEFAULT || m_encoding == wxFONTENCODING_SYSTEM)
+        tags = wxString(data, wxConvUTF8, len);
+    else
+        tags = wxString(data, wxCSConv(m_encoding), len);
+    if(tags.empty()) {
+        tags = wxString::From8BitData(data, len);
+    }
+
+    AddEnumClassData(tags);
 }
 
 TagTreePtr TagsManager::TreeFromTags(const wxString& tags, int& count)
@@ -902,6 +1047,7 @@ void TagsManager::GetHoverTip(const wxFileName& fileName,
                               const wxString& text,
                               std::vector<wxString>& tips)
 {
+    CL_TRACE_FUNCTION("tags");
     wxString path;
     wxString typeName, typeScope, tmp;
     std::vector<TagEntryPtr> tmpCandidates, candidates;
@@ -966,6 +1112,7 @@ void TagsManager::FindImplDecl(const wxFileName& fileName,
                                bool imp,
                                bool workspaceOnly)
 {
+    CL_TRACE_FUNCTION("tags");
     // Don't attempt to parse non valid ctags file
     if(!IsValidCtagsFile(fileName)) {
         return;
@@ -1283,6 +1430,7 @@ void TagsManager::OpenType(std::vector<TagEntryPtr>& tags)
 
 void TagsManager::FindSymbol(const wxString& name, std::vector<TagEntryPtr>& tags)
 {
+    CL_TRACE_FUNCTION("tags");
     // since we dont get a scope, we better user a search that only uses the
     // name (GetTagsByScopeAndName) is optimized to search the global tags table
     GetDatabase()->GetTagsByName(name, tags, true);
@@ -1317,6 +1465,7 @@ void TagsManager::DeleteFilesTags(const std::vector<wxFileName>& projectFiles)
 
 void TagsManager::RetagFiles(const std::vector<wxFileName>& files, RetagType type, wxEvtHandler* cb)
 {
+    CL_TRACE_FUNCTION("tags");
     wxArrayString strFiles;
     // step 1: remove all non-tags files
     for(size_t i = 0; i < files.size(); i++) {
@@ -1350,8 +1499,10 @@ void TagsManager::RetagFiles(const std::vector<wxFileName>& files, RetagType typ
         return;
     }
 
-    // step 4: Remove tags belonging to these files
-    DeleteFilesTags(strFiles);
+    // step 4: Remove tags belonging to these files.
+    // The parser thread replaces the tags of each file it parses, so this is only needed
+    // for the "no scan" mode. Keeping the tags of unchanged files lets it skip them
+    if(type == Retag_Quick_No_Scan) DeleteFilesTags(strFiles);
 
     // step 5: build the database
     ParseRequest* req = new ParseRequest(ParseThreadST::Get()->GetNotifiedWindow());
@@ -2135,6 +2286,7 @@ void TagsManager::StripComments(const wxString& text, wxString& stippedText)
 
 void TagsManager::GetFunctions(std::vector<TagEntryPtr>& tags, const wxString& fileName, bool onlyWorkspace)
 {
+    CL_TRACE_FUNCTION("tags");
     wxArrayString kind;
     kind.Add(wxT("function"));
     kind.Add(wxT("prototype"));
@@ -2561,6 +2713,7 @@ void TagsManager::GetTagsByKindLimit(std::vector<TagEntryPtr>& tags,
                                      int limit,
                                      const wxString& partName)
 {
+    CL_TRACE_FUNCTION("tags");
     GetDatabase()->GetTagsByKindLimit(kind, wxEmptyString, ITagsStorage::OrderNone, limit, partName, tags);
 }
 
@@ -2789,7 +2942,7 @@ CppToken TagsManager::FindLocalVariable(const wxFileName& fileName,
     VariableList vars;
     std::map<std::string, std::string> ignoreMap;
 
-    get_variables(states->text.substr(from, to - from).mb_str().data(), vars, ignoreMap, false);
+    get_variables(states->GetText(from, to - from).mb_str().data(), vars, ignoreMap, false);
     VariableList::iterator iter = vars.begin();
     bool isLocalVar(false);
     for(; iter != vars.end(); iter++) {
@@ -144,6 +144,8 @@ public:
 private:
     wxFileName m_codeliteIndexerPath;
     IProcess* m_codeliteIndexerProcess;
+    wxMutex m_indexerLock;         // guards m_codeliteIndexerProcess against the parser workers
+    bool m_indexerRestartPending;  // the indexer was terminated, waiting for its termination event
     wxString m_ctagsCmd;
     wxStopWatch m_watch;
     TagsOptionsData m_tagsOptions;
@@ -555,8 +557,24 @@ public:
      * Pass a source file to ctags process, wait for it to process it and return the output.
      * @param source Source file name
      * @param tags String containing the ctags output
+     * @return false if the indexer failed to process the file
      */
-    void SourceToTags(const wxFileName& source, wxString& tags);
+    bool SourceToTags(const wxFileName& source, wxString& tags);
+
+    /**
+     * Pass a batch of source files to ctags process. The files are sent in as few requests as possible,
+     * the total size of the files in a request is capped so the reply fits the indexer protocol limit
+     * @param sources list of source files
+     * @param tags [output] the ctags output per file. tags.Item(i) holds the tags of sources.Item(i)
+     * @return false if any of the requests to the indexer failed
+     */
+    bool SourcesToTags(const wxArrayString& sources, wxArrayString& tags);
+
+    /**
+     * @brief return a hash of the options passed to the indexer. Cached indexer output is only valid
+     * for the options that were used to produce it
+     */
+    wxString GetIndexerOptionsHash() const;
 
     /**
      * return list of files from the database(s). The returned list is ordered
@@ -966,6 +984,9 @@ protected:
     wxString DoReplaceMacrosFromDatabase(const wxString& name);
     void DoSortByVisibility(TagEntryPtrVector_t& tags);
     void AddEnumClassData(wxString& tags);
+    void DoConvertIndexerTags(const char* data, size_t len, wxString& tags);
+    bool DoSourcesToTags(const wxArrayString& sources, wxArrayString& tags);
+    wxString DoGetIndexerOptions() const;
     void GetScopesByScopeName(const wxString& scopeName, wxArrayString& scopes);
 };
 
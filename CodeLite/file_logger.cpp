@@ -25,71 +25,393 @@
 
 #include "file_logger.h"
 #include <wx/filename.h>
+#include <wx/filefn.h>
 #include <wx/stdpaths.h>
 #include <sys/time.h>
 #include <wx/log.h>
 #include <wx/crt.h>
 #include "cl_standard_paths.h"
+#include <atomic>
+#include <algorithm>
+
+// Number of lines that can be queued for the writer thread (must be a power of 2)
+#define FILE_LOGGER_QUEUE_SIZE 4096
+// The writer thread writes its buffer to the file at least every FILE_LOGGER_FLUSH_INTERVAL ms
+// or when it reaches FILE_LOGGER_FLUSH_SIZE characters. Error lines are written immediately
+#define FILE_LOGGER_FLUSH_INTERVAL 500
+#define FILE_LOGGER_FLUSH_SIZE (64 * 1024)
+// When the log file exceeds this size it is renamed to <name>.1 and a new file is started
+#define FILE_LOGGER_MAX_FILE_SIZE (10 * 1024 * 1024)
 
 static FileLogger theLogger;
 static bool initialized = false;
 
+namespace
+{
+struct LogEntry {
+    wxString msg;
+    int verbosity;
+    time_t seconds;
+    int ms;
+};
+
+/**
+ * @brief a bounded queue with many producers (the threads that log) and a single consumer (the writer thread).
+ * Every slot carries a sequence number which tells whether it is free for the producer that reserved
+ * its position or ready for the consumer, so neither side takes a lock
+ */
+class LogQueue
+{
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogEntry entry;
+    };
+
+    Slot* m_slots;
+    std::atomic<size_t> m_head; // next position to reserve (producers)
+    size_t m_tail;              // next position to read (consumer only)
+
+public:
+    LogQueue()
+        : m_head(0)
+        , m_tail(0)
+    {
+        m_slots = new Slot[FILE_LOGGER_QUEUE_SIZE];
+        for(size_t i = 0; i < FILE_LOGGER_QUEUE_SIZE; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~LogQueue() { wxDELETEA(m_slots); }
+
+    /**
+     * @brief add an entry. Return false if the queue is full
+     */
+    bool Push(LogEntry& entry)
+    {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        Slot* slot = NULL;
+        while(true) {
+            slot = &m_slots[pos & (FILE_LOGGER_QUEUE_SIZE - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if(sequence == pos) {
+                // The slot is free, try to reserve it
+                if(m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+
+            } else if(sequence < pos) {
+                // The consumer did not read this slot yet
+                return false;
+
+            } else {
+                // Another producer reserved this position
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->entry.msg.swap(entry.msg);
+        slot->entry.verbosity = entry.verbosity;
+        slot->entry.seconds = entry.seconds;
+        slot->entry.ms = entry.ms;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief take the oldest entry. Return false if the queue is empty (or the oldest entry is not complete yet)
+     */
+    bool Pop(LogEntry& entry)
+    {
+        Slot& slot = m_slots[m_tail & (FILE_LOGGER_QUEUE_SIZE - 1)];
+        if(slot.sequence.load(std::memory_order_acquire) != m_tail + 1) return false;
+
+        entry.msg.swap(slot.entry.msg);
+        slot.entry.msg.Clear();
+        entry.verbosity = slot.entry.verbosity;
+        entry.seconds = slot.entry.seconds;
+        entry.ms = slot.entry.ms;
+        slot.sequence.store(m_tail + FILE_LOGGER_QUEUE_SIZE, std::memory_order_release);
+        ++m_tail;
+        return true;
+    }
+
+    /**
+     * @brief return true if Pop() would fail (consumer only)
+     */
+    bool IsEmpty() const
+    {
+        return m_slots[m_tail & (FILE_LOGGER_QUEUE_SIZE - 1)].sequence.load(std::memory_order_acquire) != m_tail + 1;
+    }
+};
+}
+
+//--------------------------------------------------------------------------------------
+// FileLoggerThread
+//--------------------------------------------------------------------------------------
+class FileLoggerThread : public wxThread
+{
+    FileLogger* m_logger;
+    LogQueue m_queue;
+    std::atomic<bool> m_running;
+    bool m_stopped;
+    wxMutex m_mutex;
+    wxCondition m_cond;
+    std::atomic<bool> m_sleeping; // the writer thread waits on m_cond
+    std::atomic<int> m_pushing;   // number of producers inside Push()
+
+protected:
+    /**
+     * @brief format all the queued lines into 'buffer'. 'urgent' is set to true if one of them is an error
+     * @return the number of lines
+     */
+    size_t DoDrain(wxString& buffer, bool& urgent)
+    {
+        size_t count(0);
+        LogEntry entry;
+        while(m_queue.Pop(entry)) {
+            m_logger->DoFormatLine(entry.msg, entry.verbosity, entry.seconds, entry.ms, buffer);
+            urgent = urgent || (entry.verbosity <= FileLogger::Error);
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * @brief wait until a line is queued, the thread is stopped or 'timeout' ms passed (-1 for no timeout)
+     */
+    void DoSleep(long timeout)
+    {
+        wxMutexLocker locker(m_mutex);
+        m_sleeping.store(true, std::memory_order_relaxed);
+        // Pairs with the fence in DoWakeUp(): either we see the new line, or the producer sees us sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_queue.IsEmpty() && m_running.load()) {
+            if(timeout < 0) {
+                m_cond.Wait();
+            } else {
+                m_cond.WaitTimeout(timeout);
+            }
+        }
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    void DoWakeUp()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_sleeping.load(std::memory_order_relaxed)) {
+            wxMutexLocker locker(m_mutex);
+            m_cond.Signal();
+        }
+    }
+
+public:
+    FileLoggerThread(FileLogger* logger)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_logger(logger)
+        , m_running(false)
+        , m_stopped(false)
+        , m_cond(m_mutex)
+        , m_sleeping(false)
+        , m_pushing(0)
+    {
+    }
+
+    virtual ~FileLoggerThread() {}
+
+    void Start()
+    {
+        Create();
+        m_running.store(true);
+        Run();
+    }
+
+    /**
+     * @brief stop the thread and write everything that was queued
+     */
+    void Stop()
+    {
+        if(m_stopped) return;
+        m_stopped = true;
+        m_running.store(false);
+        {
+            wxMutexLocker locker(m_mutex);
+            m_cond.Signal();
+        }
+        Wait(wxTHREAD_WAIT_BLOCK);
+
+        // Producers that saw the thread running may still be queueing their line
+        while(m_pushing.load() > 0) {
+            wxMilliSleep(1);
+        }
+
+        // The thread is gone: this is the only consumer now
+        wxString buffer;
+        bool urgent(false);
+        DoDrain(buffer, urgent);
+        if(!buffer.IsEmpty()) {
+            m_logger->DoWrite(buffer);
+        }
+    }
+
+    /**
+     * @brief queue a line. Return false if the thread is not running, in that case the caller
+     * should write the line itself
+     */
+    bool Push(LogEntry& entry)
+    {
+        bool pushed(false);
+        m_pushing.fetch_add(1);
+        while(m_running.load()) {
+            if(m_queue.Push(entry)) {
+                pushed = true;
+                break;
+            }
+            // The queue is full, give the writer thread a chance to catch up
+            DoWakeUp();
+            wxMilliSleep(1);
+        }
+        if(pushed) {
+            DoWakeUp();
+        }
+        m_pushing.fetch_sub(1);
+        return pushed;
+    }
+
+    virtual void* Entry()
+    {
+        wxString buffer;
+        wxStopWatch sw;
+        while(true) {
+            bool stop = !m_running.load();
+            bool urgent(false);
+            bool idle = (DoDrain(buffer, urgent) == 0);
+            if(!buffer.IsEmpty() &&
+               (stop || urgent || buffer.length() >= FILE_LOGGER_FLUSH_SIZE || sw.Time() >= FILE_LOGGER_FLUSH_INTERVAL)) {
+                m_logger->DoWrite(buffer);
+                buffer.Clear();
+                sw.Start();
+            }
+
+            if(stop) break;
+            if(idle) {
+                // The buffered lines must be written within FILE_LOGGER_FLUSH_INTERVAL ms
+                DoSleep(buffer.IsEmpty() ? -1 : std::max(FILE_LOGGER_FLUSH_INTERVAL - sw.Time(), 1L));
+            }
+        }
+        return NULL;
+    }
+};
+
+//--------------------------------------------------------------------------------------
+// FileLogger
+//--------------------------------------------------------------------------------------
 FileLogger::FileLogger()
     : m_verbosity(FileLogger::Error)
     , m_fp(NULL)
+    , m_fileSize(0)
+    , m_thread(NULL)
 {
 }
 
 FileLogger::~FileLogger()
 {
+    if(m_thread) {
+        m_thread->Stop();
+        wxDELETE(m_thread);
+    }
+
     if(m_fp) {
         fclose(m_fp);
         m_fp = NULL;
     }
 }
 
-void FileLogger::AddLogLine(const wxString& msg, int verbosity)
+void FileLogger::DoFormatLine(const wxString& msg, int verbosity, time_t seconds, int ms, wxString& buffer) const
 {
-    if(m_verbosity >= verbosity && m_fp) {
-        wxString formattedMsg;
+    wxString formattedMsg;
+    wxString msStr = wxString::Format(wxT("%03d"), ms);
 
-        timeval tim;
-        gettimeofday(&tim, NULL);
-        int ms = (int)tim.tv_usec / 1000.0;
+    formattedMsg << wxT("[ ") << wxDateTime(seconds).FormatISOTime() << wxT(":") << msStr;
 
-        wxString msStr = wxString::Format(wxT("%03d"), ms);
+    switch(verbosity) {
+    case System:
+        formattedMsg << wxT(" SYS ] ");
+        break;
 
-        formattedMsg << wxT("[ ") << wxDateTime::Now().FormatISOTime() << wxT(":") << msStr;
+    case Error:
+        formattedMsg << wxT(" ERR ] ");
+        break;
 
-        switch(verbosity) {
-        case System:
-            formattedMsg << wxT(" SYS ] ");
-            break;
+    case Warning:
+        formattedMsg << wxT(" WRN ] ");
+        break;
 
-        case Error:
-            formattedMsg << wxT(" ERR ] ");
-            break;
+    case Dbg:
+        formattedMsg << wxT(" DBG ] ");
+        break;
 
-        case Warning:
-            formattedMsg << wxT(" WRN ] ");
-            break;
+    case Developer:
+        formattedMsg << wxT(" DVL ] ");
+        break;
+    }
 
-        case Dbg:
-            formattedMsg << wxT(" DBG ] ");
-            break;
+    formattedMsg << msg;
+    formattedMsg.Trim().Trim(false);
+    formattedMsg << wxT("\n");
+    buffer << formattedMsg;
+}
 
-        case Developer:
-            formattedMsg << wxT(" DVL ] ");
-            break;
-        }
+void FileLogger::DoRotate()
+{
+    fclose(m_fp);
+    m_fp = NULL;
+
+    wxLogNull noLog;
+    wxString backup = m_logfile + wxT(".1");
+    if(wxFileExists(backup)) {
+        ::wxRemoveFile(backup);
+    }
+    ::wxRenameFile(m_logfile, backup);
+
+    m_fp = wxFopen(m_logfile, wxT("a+"));
+    m_fileSize = 0;
+}
 
-        formattedMsg << msg;
-        formattedMsg.Trim().Trim(false);
-        formattedMsg << wxT("\n");
+void FileLogger::DoWrite(const wxString& buffer)
+{
+    wxMutexLocker locker(m_writeLock);
+    if(!m_fp) return;
 
-        wxFprintf(m_fp, wxT("%s"), formattedMsg.c_str());
-        fflush(m_fp);
+    const wxCharBuffer cb = buffer.mb_str(wxConvUTF8);
+    if(!m_logfile.IsEmpty() && m_fileSize > 0 && (m_fileSize + (wxFileOffset)cb.length()) > FILE_LOGGER_MAX_FILE_SIZE) {
+        DoRotate();
+        if(!m_fp) return;
     }
+
+    fwrite(cb.data(), 1, cb.length(), m_fp);
+    fflush(m_fp);
+    m_fileSize += cb.length();
+}
+
+void FileLogger::AddLogLine(const wxString& msg, int verbosity)
+{
+    if(!CanLog(verbosity)) return;
+
+    timeval tim;
+    gettimeofday(&tim, NULL);
+
+    LogEntry entry;
+    // The string is used by the writer thread, make a copy of the content
+    entry.msg = msg.c_str();
+    entry.verbosity = verbosity;
+    entry.seconds = tim.tv_sec;
+    entry.ms = (int)tim.tv_usec / 1000.0;
+
+    if(m_thread && m_thread->Push(entry)) return;
+
+    // No writer thread, write the line directly
+    wxString buffer;
+    DoFormatLine(entry.msg, verbosity, entry.seconds, entry.ms, buffer);
+    DoWrite(buffer);
 }
 
 FileLogger* FileLogger::Get()
@@ -157,11 +479,25 @@ void FileLogger::OpenLog(const wxString& fullName, int verbosity)
         wxString filename;
         filename << clStandardPaths::Get().GetUserDataDir() << wxFileName::GetPathSeparator() << fullName;
         theLogger.m_fp = wxFopen(filename, wxT("a+"));
+        theLogger.m_logfile = filename;
         theLogger.m_verbosity = verbosity;
+        if(theLogger.m_fp) {
+            fseek(theLogger.m_fp, 0, SEEK_END);
+            theLogger.m_fileSize = ftell(theLogger.m_fp);
+            theLogger.m_thread = new FileLoggerThread(&theLogger);
+            theLogger.m_thread->Start();
+        }
         initialized = true;
     }
 }
 
+void FileLogger::CloseLog()
+{
+    if(theLogger.m_thread) {
+        theLogger.m_thread->Stop();
+    }
+}
+
 void FileLogger::AddLogLine(const wxArrayString& arr, int verbosity)
 {
     for(size_t i = 0; i < arr.GetCount(); ++i) {
@@ -29,15 +29,36 @@
 #include <wx/ffile.h>
 #include "codelite_exports.h"
 #include <wx/stopwatch.h>
+#include <wx/thread.h>
+#include <time.h>
 
+class FileLoggerThread;
+
+/**
+ * @class FileLogger
+ * @brief the codelite log file.
+ * Once the log is opened, the lines are queued and written to the file by a dedicated thread
+ * in batches, so logging does not block the caller on the disk. The file is rotated when it grows too big
+ */
 class WXDLLIMPEXP_CL FileLogger
 {
+    friend class FileLoggerThread;
+
 public:
     enum { System = -1, Error = 0, Warning = 1, Dbg = 2, Developer = 3 };
 
 protected:
     int m_verbosity;
     FILE* m_fp;
+    wxString m_logfile;
+    wxFileOffset m_fileSize;
+    FileLoggerThread* m_thread;
+    wxMutex m_writeLock;
+
+protected:
+    void DoFormatLine(const wxString& msg, int verbosity, time_t seconds, int ms, wxString& buffer) const;
+    void DoWrite(const wxString& buffer);
+    void DoRotate();
 
 public:
     FileLogger();
@@ -48,8 +69,20 @@ public:
      */
     static void OpenLog(const wxString& fullName, int verbosity);
 
+    /**
+     * @brief write all the queued lines and stop the writer thread. Lines logged
+     * afterwards are written directly to the file
+     */
+    static void CloseLog();
+
     static FileLogger* Get();
 
+    /**
+     * @brief return true if a line with this verbosity will be written to the log file.
+     * Used by the CL_* macros to avoid formatting messages that will be discarded
+     */
+    bool CanLog(int verbosity) const { return m_verbosity >= verbosity && m_fp; }
+
     void AddLogLine(const wxString& msg, int verbosity);
     /**
      * @brief print array into the log file
@@ -67,13 +100,21 @@ public:
     static int GetVerbosityAsNumber(const wxString& verbosity);
 };
 
-#define CL_SYSTEM(...) FileLogger::Get()->AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::System);
-#define CL_ERROR(...) FileLogger::Get()->AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::Error);
-#define CL_WARNING(...) FileLogger::Get()->AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::Warning);
-#define CL_DEBUG(...) FileLogger::Get()->AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::Dbg);
-#define CL_DEBUGS(s) FileLogger::Get()->AddLogLine(s, FileLogger::Dbg);
-#define CL_DEBUG1(...) FileLogger::Get()->AddLogLine(wxString::Format(__VA_ARGS__), FileLogger::Developer);
-#define CL_DEBUG_ARR(arr) FileLogger::Get()->AddLogLine(arr, FileLogger::Dbg);
-#define CL_DEBUG1_ARR(arr) FileLogger::Get()->AddLogLine(arr, FileLogger::Developer);
+// The arguments are evaluated (and formatted) only when the line is going to be logged
+#define CL_LOG_LINE(line, verbosity)                          \
+    do {                                                      \
+        if(FileLogger::Get()->CanLog(verbosity)) {            \
+            FileLogger::Get()->AddLogLine((line), verbosity); \
+        }                                                     \
+    } while(false)
+
+#define CL_SYSTEM(...) CL_LOG_LINE(wxString::Format(__VA_ARGS__), FileLogger::System);
+#define CL_ERROR(...) CL_LOG_LINE(wxString::Format(__VA_ARGS__), FileLogger::Error);
+#define CL_WARNING(...) CL_LOG_LINE(wxString::Format(__VA_ARGS__), FileLogger::Warning);
+#define CL_DEBUG(...) CL_LOG_LINE(wxString::Format(__VA_ARGS__), FileLogger::Dbg);
+#define CL_DEBUGS(s) CL_LOG_LINE(s, FileLogger::Dbg);
+#define CL_DEBUG1(...) CL_LOG_LINE(wxString::Format(__VA_ARGS__), FileLogger::Developer);
+#define CL_DEBUG_ARR(arr) CL_LOG_LINE(arr, FileLogger::Dbg);
+#define CL_DEBUG1_ARR(arr) CL_LOG_LINE(arr, FileLogger::Developer);
 
 #endif // FILELOGGER_H
@@ -60,4 +60,21 @@ public:
 };
 typedef SmartPtr<FileEntry> FileEntryPtr;
 
+/**
+ * @class FileHashEntry
+ * @brief the content hash, size and modification time of a file as they were when the file was last tagged
+ */
+struct FileHashEntry {
+	wxString file;
+	wxString hash;
+	long     size;
+	long     mtime;
+
+	FileHashEntry()
+		: size(-1)
+		, mtime(0)
+	{
+	}
+};
+
 #endif // __fileentry__
@@ -365,4 +365,52 @@ bool FileUtils::IsHidden(const wxFileName& filename)
 bool FileUtils::IsHidden(const wxString& filename)
 {
     return IsHidden(filename);
-}
+}
+
+#define FNV1A_64_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV1A_64_PRIME 0x100000001b3ULL
+
+static void FNV1a64Update(wxUint64& h, const unsigned char* data, size_t len)
+{
+    for(size_t i = 0; i < len; ++i) {
+        h ^= (wxUint64)data[i];
+        h *= FNV1A_64_PRIME;
+    }
+}
+
+static wxString FNV1a64ToString(wxUint64 h)
+{
+    return wxString::Format(wxT("%08x%08x"), (unsigned int)(h >> 32), (unsigned int)(h & 0xffffffff));
+}
+
+bool FileUtils::GetFileHash(const wxFileName& fn, wxString& hash, long& size)
+{
+    wxFFile file(fn.GetFullPath(), wxT("rb"));
+    if(file.IsOpened() == false) {
+        return false;
+    }
+
+    wxUint64 h = FNV1A_64_OFFSET_BASIS;
+    unsigned char buffer[64 * 1024];
+    size = 0;
+    while(!file.Eof()) {
+        size_t bytes = file.Read(buffer, sizeof(buffer));
+        if(bytes == 0) break;
+        FNV1a64Update(h, buffer, bytes);
+        size += (long)bytes;
+    }
+
+    if(file.Error()) {
+        return false;
+    }
+    hash = FNV1a64ToString(h);
+    return true;
+}
+
+wxString FileUtils::GetStringHash(const wxString& str)
+{
+    const wxCharBuffer cb = str.mb_str(wxConvUTF8);
+    wxUint64 h = FNV1A_64_OFFSET_BASIS;
+    FNV1a64Update(h, (const unsigned char*)cb.data(), cb.length());
+    return FNV1a64ToString(h);
+}
@@ -126,5 +126,19 @@ public:
      * @brief is the file or folder a hidden file?
      */
     static bool IsHidden(const wxString& path);
+
+    /**
+     * @brief compute a hash of the file content (64 bit FNV-1a, as a hex string)
+     * @param fn the file
+     * @param hash [output]
+     * @param size [output] the number of bytes hashed
+     * @return false if the file could not be read
+     */
+    static bool GetFileHash(const wxFileName& fn, wxString& hash, long& size);
+
+    /**
+     * @brief compute a hash of a string (64 bit FNV-1a over its UTF-8 representation, as a hex string)
+     */
+    static wxString GetStringHash(const wxString& str);
 };
 #endif // FILEUTILS_H
@@ -49,6 +49,7 @@ protected:
     int        m_maxWorkspaceTagToColour;
     bool       m_useCache;
     bool       m_enableCaseInsensitive;
+    bool       m_useSymbolIndex;
 public:
     enum {
         OrderNone,
@@ -62,6 +63,7 @@ public:
         , m_maxWorkspaceTagToColour(1000)
         , m_useCache(false)
         , m_enableCaseInsensitive(true)
+        , m_useSymbolIndex(false)
     {}
 
     virtual ~ITagsStorage() {};
@@ -76,6 +78,17 @@ public:
         return m_useCache;
     }
 
+    /**
+     * @brief serve the name lookups from a memory resident index of the database
+     */
+    virtual void SetUseSymbolIndex(bool useSymbolIndex) {
+        this->m_useSymbolIndex = useSymbolIndex;
+    }
+
+    virtual bool GetUseSymbolIndex() const {
+        return m_useSymbolIndex;
+    }
+
     /**
      * @brief clear the storage cache
      */
@@ -246,6 +259,42 @@ public:
      */
     virtual int UpdateFileEntry ( const wxString &filename , int timestamp ) = 0;
 
+    // -------------------------- Files Hash Table ---------------------------------------
+
+    /**
+     * @brief load the content hash entries of all the tagged files
+     * @param entries [output] map of file name -> hash entry
+     */
+    virtual void GetFilesHash(std::map<wxString, FileHashEntry> &entries) = 0;
+
+    /**
+     * @brief return the content hash entry of a file
+     * @return false if no entry exists for the file
+     */
+    virtual bool GetFileHash(const wxString &filename, FileHashEntry &entry) = 0;
+
+    /**
+     * @brief insert or replace the content hash entry of a file
+     */
+    virtual int StoreFileHash(const FileHashEntry &entry) = 0;
+
+    // -------------------------- Tags Cache Table ---------------------------------------
+
+    /**
+     * @brief fetch the cached indexer output for a given file content
+     * @param filename the file
+     * @param hash the file content hash
+     * @param optionsHash the hash of the ctags options used to produce the tags
+     * @param tags [output]
+     * @return true on cache hit
+     */
+    virtual bool GetCachedTags(const wxString &filename, const wxString &hash, const wxString &optionsHash, wxString &tags) = 0;
+
+    /**
+     * @brief cache the indexer output for a given file content
+     */
+    virtual void StoreCachedTags(const wxString &filename, const wxString &hash, const wxString &optionsHash, const wxString &tags) = 0;
+
     // -------------------------- TagEntry -------------------------------------------
     /**
      * Return a result set of tags according to file name.
@@ -329,6 +378,25 @@ public:
      */
     virtual void Store(TagTreePtr tree, const wxFileName& path, bool autoCommit = true) = 0;
 
+    /**
+     * @brief store a flat list of tags into the currently opened database
+     * @param tags the tags to store
+     * @param autoCommit handle the Store operation inside a transaction or let the user hadle it
+     */
+    virtual void Store(const TagEntryPtrVector_t& tags, bool autoCommit = true) = 0;
+
+    /**
+     * @brief prepare the database for storing a large number of tags (e.g. a full retag)
+     * @param deferIndexes when set and the database is empty, the search indexes are dropped
+     * and re-created in a single pass by EndBulkInsert()
+     */
+    virtual void BeginBulkInsert(bool deferIndexes) = 0;
+
+    /**
+     * @brief end the bulk insert started by BeginBulkInsert(). Must be called outside of a transaction
+     */
+    virtual void EndBulkInsert() = 0;
+
     /**
      * A very dengerous API call, which drops all tables from the database
      * and recreate the schema from fresh. It is used when upgrading database between different
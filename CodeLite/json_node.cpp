@@ -28,6 +28,7 @@
 #include <wx/filename.h>
 #include <wx/ffile.h>
 #include "clFontHelper.h"
+#include <vector>
 
 JSONRoot::JSONRoot(const wxString& text)
     : _json(NULL)
@@ -47,11 +48,26 @@ JSONRoot::JSONRoot(int type)
 JSONRoot::JSONRoot(const wxFileName& filename)
     : _json(NULL)
 {
-    wxString content;
+    // Parse the file bytes as-is: converting the content to wxString and back to UTF-8
+    // costs more than the parsing itself for large files (e.g. compile_commands.json)
     wxFFile fp(filename.GetFullPath(), wxT("rb"));
     if(fp.IsOpened()) {
-        if(fp.ReadAll(&content, wxConvUTF8)) {
-            _json = cJSON_Parse(content.mb_str(wxConvUTF8).data());
+        wxFileOffset len = fp.Length();
+        if(len >= 0) {
+            std::vector<char> content((size_t)len + 1, 0);
+            if(fp.Read(&content[0], (size_t)len) == (size_t)len) {
+                if(wxConvUTF8.ToWChar(NULL, 0, &content[0], (size_t)len) != wxCONV_FAILED) {
+                    _json = cJSON_Parse(&content[0]);
+
+                } else {
+                    // Not UTF-8: assume the local 8 bit encoding
+                    wxString text(&content[0], wxConvLocal, (size_t)len);
+                    if(text.IsEmpty()) {
+                        text = wxString(&content[0], wxConvISO8859_1, (size_t)len);
+                    }
+                    _json = cJSON_Parse(text.mb_str(wxConvUTF8).data());
+                }
+            }
         }
     }
 
@@ -419,7 +435,9 @@ wxArrayString JSONElement::toArrayString(const wxArrayString& defaultValue) cons
     }
 
     wxArrayString arr;
-    for(int i = 0; i < arraySize(); i++) {
+    int count = arraySize();
+    arr.Alloc(count);
+    for(int i = 0; i < count; i++) {
         arr.Add(arrayItem(i).toString());
     }
     return arr;
@@ -533,9 +551,11 @@ JSONElement::wxStringMap_t JSONElement::toStringMap() const
         return res;
     }
 
-    for(int i = 0; i < arraySize(); ++i) {
-        wxString key = arrayItem(i).namedObject("key").toString();
-        wxString val = arrayItem(i).namedObject("value").toString();
+    int count = arraySize();
+    for(int i = 0; i < count; ++i) {
+        JSONElement item = arrayItem(i);
+        wxString key = item.namedObject("key").toString();
+        wxString val = item.namedObject("value").toString();
         res.insert(std::make_pair(key, val));
     }
     return res;
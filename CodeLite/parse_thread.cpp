@@ -30,6 +30,8 @@
 #include <wx/tokenzr.h>
 #include "crawler_include.h"
 #include "parse_thread.h"
+#include "performance.h"
+#include "parse_thread_pipeline.h"
 #include "ctags_manager.h"
 #include "istorage.h"
 #include <wx/stopwatch.h>
@@ -39,6 +41,8 @@
 #include <set>
 #include "cl_command_event.h"
 #include <tags_options_data.h>
+#include <wx/filefn.h>
+#include "fileutils.h"
 
 #define DEBUG_MESSAGE(x) CL_DEBUG1(x.c_str())
 
@@ -72,8 +76,22 @@ const wxEventType wxEVT_PARSE_THREAD_READY = XRCID("wxEVT_PARSE_THREAD_READY");
 // Event type: clCommandEvent
 const wxEventType wxEVT_PARSE_THREAD_SUGGEST_COLOUR_TOKENS = XRCID("wxEVT_PARSE_THREAD_SUGGEST_COLOUR_TOKENS");
 
+// Number of parsed files the workers may queue ahead of the database writer
+#define PARSE_PIPELINE_QUEUE_SIZE 256
+
+// Number of files stored per transaction when the pipelined retag is used
+#define PARSE_PIPELINE_COMMIT_INTERVAL 500
+
+// Number of files sent to the indexer in a single batched request
+#define PARSE_INDEXER_BATCH_SIZE 100
+
+// Minimum number of files to parse before the search indexes are deferred to the end of the retag
+#define PARSE_BULK_INSERT_MIN_FILES 500
+
 ParseThread::ParseThread()
     : WorkerThread()
+    , m_crawlerEnabled(false)
+    , m_parserWorkers(wxThread::GetCPUCount() > 0 ? wxThread::GetCPUCount() : 1)
 {
 }
 
@@ -83,6 +101,7 @@ ParseThread::~ParseThread()
 
 void ParseThread::ProcessRequest(ThreadRequest* request)
 {
+    CL_TRACE_FUNCTION("parser");
     // request is delete by the parent WorkerThread after this method is completed
     ParseRequest* req = (ParseRequest*)request;
 
@@ -164,6 +183,18 @@ void ParseThread::SetSearchPaths(const wxArrayString& paths, const wxArrayString
     }
 }
 
+void ParseThread::SetParserWorkers(size_t workers)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    m_parserWorkers = workers;
+}
+
+size_t ParseThread::GetParserWorkers()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    return m_parserWorkers;
+}
+
 bool ParseThread::IsCrawlerEnabled()
 {
     wxCriticalSectionLocker locker(m_cs);
@@ -184,6 +215,7 @@ void ParseThread::GetSearchPaths(wxArrayString& paths, wxArrayString& excludePat
 
 void ParseThread::ProcessIncludes(ParseRequest* req)
 {
+    CL_TRACE_FUNCTION("parser");
     DEBUG_MESSAGE(wxString::Format(wxT("ProcessIncludes -> started")));
 
     std::set<wxString>* newSet = new std::set<wxString>();
@@ -208,6 +240,7 @@ void ParseThread::ProcessIncludes(ParseRequest* req)
 
 void ParseThread::ProcessSimple(ParseRequest* req)
 {
+    CL_TRACE_FUNCTION("parser");
     wxString dbfile = req->getDbfile();
     wxString file = req->getFile();
 
@@ -222,29 +255,55 @@ void ParseThread::ProcessSimple(ParseRequest* req)
     ITagsStoragePtr db(new TagsStorageSQLite());
     db->OpenDatabase(dbfile);
 
-    // convert the file content into tags
-    wxString tags;
-    wxString file_name(req->getFile());
-    tagmgr->SourceToTags(file_name, tags);
+    // If the file content did not change since it was last tagged (e.g. saved without modifications),
+    // there is nothing to re-tag
+    FileHashEntry stored, current;
+    current.file = file;
+    bool hasHash = DoGetFileHash(file, current);
+    if(hasHash && db->GetFileHash(file, stored) && stored.hash == current.hash) {
+        DEBUG_MESSAGE(wxString::Format(wxT("File %s content is unchanged, skipping it"), file.c_str()));
+        db->Begin();
+        db->StoreFileHash(current);
+        if(db->InsertFileEntry(file, (int)time(NULL)) == TagExist) {
+            db->UpdateFileEntry(file, (int)time(NULL));
+        }
+        db->Commit();
+
+    } else {
+        // convert the file content into tags. Use the cached indexer output if we have one
+        wxString tags;
+        wxString file_name(req->getFile());
+        wxString optionsHash = tagmgr->GetIndexerOptionsHash();
+        bool fromCache = hasHash && db->GetCachedTags(file_name, current.hash, optionsHash, tags);
+        bool parsed = fromCache || tagmgr->SourceToTags(file_name, tags);
+
+        int count;
+        DoStoreTags(tags, file_name, count, db);
+
+        db->Begin();
+        ///////////////////////////////////////////
+        // update the file retag timestamp
+        ///////////////////////////////////////////
+        db->InsertFileEntry(file, (int)time(NULL));
+
+        // If the indexer failed, dont remember the hash: the file must be parsed again next time
+        if(hasHash && parsed) {
+            db->StoreFileHash(current);
+            if(!fromCache) {
+                db->StoreCachedTags(file_name, current.hash, optionsHash, tags);
+            }
+        }
 
-    int count;
-    DoStoreTags(tags, file_name, count, db);
+        ////////////////////////////////////////////////
+        // Parse and store the macros found in this file
+        ////////////////////////////////////////////////
+        PPTable::Instance()->Clear();
+        PPScan(file, true);
+        db->StoreMacros(PPTable::Instance()->GetTable());
+        PPTable::Instance()->Clear();
 
-    db->Begin();
-    ///////////////////////////////////////////
-    // update the file retag timestamp
-    ///////////////////////////////////////////
-    db->InsertFileEntry(file, (int)time(NULL));
-
-    ////////////////////////////////////////////////
-    // Parse and store the macros found in this file
-    ////////////////////////////////////////////////
-    PPTable::Instance()->Clear();
-    PPScan(file, true);
-    db->StoreMacros(PPTable::Instance()->GetTable());
-    PPTable::Instance()->Clear();
-
-    db->Commit();
+        db->Commit();
+    }
 
     // Parse the saved file to get a list of files to include
     ParseIncludeFiles(req, file, db);
@@ -313,16 +372,23 @@ ParseThread::ParseAndStoreFiles(ParseRequest* req, const wxArrayString& arrFiles
     // Loop over the files and parse them
     int totalSymbols(0);
     DEBUG_MESSAGE(wxString::Format(wxT("Parsing and saving files to database....")));
-    for(size_t i = 0; i < arrFiles.GetCount(); i++) {
+    for(size_t i = 0; i < arrFiles.GetCount(); i += PARSE_INDEXER_BATCH_SIZE) {
 
         // give a shutdown request a chance
         TEST_DESTROY();
 
-        wxString tags; // output
-        TagsManagerST::Get()->SourceToTags(arrFiles.Item(i), tags);
+        // Send the files to the indexer in batches to save the round trip per file
+        wxArrayString batch;
+        for(size_t j = i; j < arrFiles.GetCount() && j < (i + PARSE_INDEXER_BATCH_SIZE); ++j) {
+            batch.Add(arrFiles.Item(j));
+        }
 
-        if(tags.IsEmpty() == false) {
-            DoStoreTags(tags, arrFiles.Item(i), totalSymbols, db);
+        wxArrayString tags; // output
+        TagsManagerST::Get()->SourcesToTags(batch, tags);
+        for(size_t j = 0; j < batch.GetCount() && j < tags.GetCount(); ++j) {
+            if(tags.Item(j).IsEmpty() == false) {
+                DoStoreTags(tags.Item(j), batch.Item(j), totalSymbols, db);
+            }
         }
     }
 
@@ -376,69 +442,186 @@ void ParseThread::ProcessDeleteTagsOfFiles(ParseRequest* req)
 
 void ParseThread::ProcessParseAndStore(ParseRequest* req)
 {
+    CL_TRACE_FUNCTION("parser");
     wxString dbfile = req->getDbfile();
-
-    // convert the file to tags
-    double maxVal = (double)req->_workspaceFiles.size();
-    if(maxVal == 0.0) {
+    if(req->_workspaceFiles.empty()) {
         return;
     }
 
-    // we report every 10%
-    double reportingPoint = maxVal / 100.0;
-    reportingPoint = ceil(reportingPoint);
-    if(reportingPoint == 0.0) {
-        reportingPoint = 1.0;
-    }
-
     ITagsStoragePtr db(new TagsStorageSQLite());
     db->OpenDatabase(dbfile);
 
-    // We commit every 10 files
+    m_watch.Start();
+    PPTable::Instance()->Clear();
     db->Begin();
-    int precent(0);
-    int lastPercentageReported(0);
 
+    // Files whose content did not change since they were last tagged are skipped. Files
+    // we have cached indexer output for are stored without going through the indexer
+    wxString optionsHash = TagsManagerST::Get()->GetIndexerOptionsHash();
+    std::vector<std::string> filesToParse;
+    size_t filesUnchanged(0);
+    size_t filesFromCache(0);
+    bool completed =
+        DoFilterUnchangedFiles(req->_workspaceFiles, optionsHash, db, filesToParse, filesUnchanged, filesFromCache);
+
+    // Large retags into an empty database (e.g. a full retag) build the search indexes once at the end
+    db->BeginBulkInsert(filesToParse.size() >= PARSE_BULK_INSERT_MIN_FILES);
+
+    size_t workers = GetParserWorkers();
+    if(completed) {
+        if(workers > 1 && filesToParse.size() > 1) {
+            completed = DoParseAndStorePipelined(req, filesToParse, optionsHash, db, workers);
+        } else {
+            workers = 1;
+            completed = DoParseAndStoreSerial(req, filesToParse, optionsHash, db);
+        }
+    }
+
+    if(!completed) {
+        // Shutdown was requested. Do an ordered shutdown:
+        // rollback any transaction and close the database
+        db->Rollback();
+        db->EndBulkInsert();
+        PPTable::Instance()->Clear();
+        return;
+    }
+
+    // Store the macros
+    db->StoreMacros(PPTable::Instance()->GetTable());
+
+    // Commit whats left
+    db->Commit();
+    db->EndBulkInsert();
+
+    // Clear the results
     PPTable::Instance()->Clear();
 
-    for(size_t i = 0; i < maxVal; i++) {
+    // Report the throughput so we can keep an eye on regressions
+    long elapsed = m_watch.Time();
+    size_t filesTotal = req->_workspaceFiles.size();
+    double filesPerSec = elapsed > 0 ? ((double)filesTotal * 1000.0 / (double)elapsed) : (double)filesTotal;
+    wxString message;
+    message << wxT("INFO: Retagged ") << filesTotal << wxT(" files (") << filesToParse.size() << wxT(" parsed, ")
+            << filesUnchanged << wxT(" unchanged, ") << filesFromCache << wxT(" from cache) using ") << workers
+            << wxT(" parser workers in ") << elapsed << wxT(" ms (") << wxString::Format(wxT("%.1f"), filesPerSec)
+            << wxT(" files/sec)");
+    CL_SYSTEM(message);
+
+    /// Send notification to the main window with our progress report
+    if(req->_evtHandler) {
+        wxCommandEvent e(wxEVT_PARSE_THREAD_MESSAGE);
+        e.SetClientData(new wxString(message.c_str()));
+        req->_evtHandler->AddPendingEvent(e);
+
+        wxCommandEvent retaggingCompletedEvent(wxEVT_PARSE_THREAD_RETAGGING_COMPLETED);
+        std::vector<std::string>* arrFiles = new std::vector<std::string>;
+        *arrFiles = req->_workspaceFiles;
+        retaggingCompletedEvent.SetClientData(arrFiles);
+        req->_evtHandler->AddPendingEvent(retaggingCompletedEvent);
+    }
+}
+
+bool ParseThread::DoFilterUnchangedFiles(const std::vector<std::string>& files,
+                                         const wxString& optionsHash,
+                                         ITagsStoragePtr db,
+                                         std::vector<std::string>& filesToParse,
+                                         size_t& filesUnchanged,
+                                         size_t& filesFromCache)
+{
+    std::map<wxString, FileHashEntry> hashes;
+    db->GetFilesHash(hashes);
+
+    for(size_t i = 0; i < files.size(); ++i) {
+        // give a shutdown request a chance
+        if(TestDestroy()) return false;
+
+        wxString filename(files.at(i).c_str(), wxConvUTF8);
+        std::map<wxString, FileHashEntry>::iterator iter = hashes.find(filename);
+        if(iter == hashes.end()) {
+            // Never tagged before
+            filesToParse.push_back(files.at(i));
+            continue;
+        }
+
+        // Same size and modification time: dont bother reading the file
+        FileHashEntry current;
+        current.file = filename;
+        if(DoGetFileStat(filename, current) && current.size == iter->second.size &&
+           current.mtime == iter->second.mtime) {
+            ++filesUnchanged;
+            continue;
+        }
+
+        if(!DoGetFileHash(filename, current)) {
+            filesToParse.push_back(files.at(i));
+            continue;
+        }
+
+        if(current.hash == iter->second.hash) {
+            // Only the timestamp changed (e.g. switching git branches back and forth)
+            db->StoreFileHash(current);
+            if(db->InsertFileEntry(filename, (int)time(NULL)) == TagExist) {
+                db->UpdateFileEntry(filename, (int)time(NULL));
+            }
+            ++filesUnchanged;
+            continue;
+        }
+
+        // The content changed, but we might have seen this version of the file before
+        wxString tags;
+        if(db->GetCachedTags(filename, current.hash, optionsHash, tags)) {
+            int count(0);
+            TagTreePtr tree = TagsManagerST::Get()->TreeFromTags(tags, count);
+            DoStoreParsedFile(wxFileName(filename), tree, db);
+            db->StoreFileHash(current);
+            ++filesFromCache;
+            continue;
+        }
+        filesToParse.push_back(files.at(i));
+    }
+    return true;
+}
+
+bool ParseThread::DoParseAndStoreSerial(ParseRequest* req,
+                                        const std::vector<std::string>& files,
+                                        const wxString& optionsHash,
+                                        ITagsStoragePtr db)
+{
+    double maxVal = (double)files.size();
+    int lastPercentageReported(0);
+
+    for(size_t i = 0; i < files.size(); i++) {
 
         // give a shutdown request a chance
         if(TestDestroy()) {
-            // Do an ordered shutdown:
-            // rollback any transaction
-            // and close the database
-            db->Rollback();
-            return;
+            return false;
         }
 
-        wxFileName curFile(wxString(req->_workspaceFiles.at(i).c_str(), wxConvUTF8));
+        wxFileName curFile(wxString(files.at(i).c_str(), wxConvUTF8));
 
         // Skip binary files
         if(TagsManagerST::Get()->IsBinaryFile(curFile.GetFullPath())) {
             DEBUG_MESSAGE(wxString::Format(wxT("Skipping binary file %s"), curFile.GetFullPath().c_str()));
+            db->DeleteByFileName(wxFileName(), curFile.GetFullPath(), false);
             continue;
         }
 
         // Send notification to the main window with our progress report
-        precent = (int)((i / maxVal) * 100);
+        DoReportRetagProgress(req, i, maxVal, lastPercentageReported);
 
-        if(req->_evtHandler && lastPercentageReported != precent) {
-            lastPercentageReported = precent;
-            wxCommandEvent retaggingProgressEvent(wxEVT_PARSE_THREAD_RETAGGING_PROGRESS);
-            retaggingProgressEvent.SetInt((int)precent);
-            req->_evtHandler->AddPendingEvent(retaggingProgressEvent);
+        wxString tags;
+        bool parsed = TagsManagerST::Get()->SourceToTags(curFile, tags);
 
-        } else if(lastPercentageReported != precent) {
-            wxPrintf(wxT("parsing: %%%d completed\n"), precent);
-        }
-
-        TagTreePtr tree = TagsManagerST::Get()->ParseSourceFile(curFile);
-        PPScan(curFile.GetFullPath(), false);
+        int count(0);
+        TagTreePtr tree = TagsManagerST::Get()->TreeFromTags(tags, count);
+        DoStoreParsedFile(curFile, tree, db);
 
-        db->Store(tree, wxFileName(), false);
-        if(db->InsertFileEntry(curFile.GetFullPath(), (int)time(NULL)) == TagExist) {
-            db->UpdateFileEntry(curFile.GetFullPath(), (int)time(NULL));
+        // If the indexer failed, dont remember the hash: the file must be parsed again on the next retag
+        FileHashEntry entry;
+        entry.file = curFile.GetFullPath();
+        if(parsed && DoGetFileHash(entry.file, entry)) {
+            db->StoreFileHash(entry);
+            db->StoreCachedTags(entry.file, entry.hash, optionsHash, tags);
         }
 
         if(i % 50 == 0) {
@@ -448,32 +631,119 @@ void ParseThread::ProcessParseAndStore(ParseRequest* req)
             db->Begin();
         }
     }
+    return true;
+}
 
-    // Process the macros
-    //PPTable::Instance()->Squeeze();
-    const std::map<wxString, PPToken>& table = PPTable::Instance()->GetTable();
+bool ParseThread::DoParseAndStorePipelined(ParseRequest* req,
+                                           const std::vector<std::string>& files,
+                                           const wxString& optionsHash,
+                                           ITagsStoragePtr db,
+                                           size_t workers)
+{
+    double maxVal = (double)files.size();
 
-    // Store the macros
-    db->StoreMacros(table);
+    // The workers only talk to the indexer and build the tags tree. This thread is the only
+    // writer: it runs the PP scanner (which is not thread safe) and stores the results
+    ParseThreadPipeline pipeline(files, workers, PARSE_PIPELINE_QUEUE_SIZE);
+    pipeline.Start();
 
-    // Commit whats left
-    db->Commit();
+    size_t filesDone(0);
+    size_t uncommitted(0);
+    int lastPercentageReported(0);
 
-    // Clear the results
-    PPTable::Instance()->Clear();
+    while(true) {
+        // give a shutdown request a chance
+        if(TestDestroy()) {
+            pipeline.Stop();
+            return false;
+        }
 
-    /// Send notification to the main window with our progress report
+        // Check whether the workers are done *before* we poll the queue: a worker always pushes
+        // its last result before it reports that it is done, so an empty queue after this point
+        // means that there is nothing left to store
+        bool workersDone = pipeline.IsDone();
+        ParsedFile* parsed = pipeline.Next(50);
+        if(!parsed) {
+            if(workersDone) break;
+            continue;
+        }
+
+        ++filesDone;
+        DoReportRetagProgress(req, filesDone, maxVal, lastPercentageReported);
+
+        if(parsed->skipped) {
+            DEBUG_MESSAGE(wxString::Format(wxT("Skipping binary file %s"), parsed->filename.c_str()));
+            db->DeleteByFileName(wxFileName(), parsed->filename, false);
+
+        } else {
+            DoStoreParsedFile(wxFileName(parsed->filename), parsed->tree, db);
+            // If the indexer failed, dont remember the hash: the file must be parsed again on the next retag
+            if(!parsed->failed && !parsed->hash.file.IsEmpty()) {
+                db->StoreFileHash(parsed->hash);
+                db->StoreCachedTags(parsed->filename, parsed->hash.hash, optionsHash, parsed->tags);
+            }
+
+            if(++uncommitted >= PARSE_PIPELINE_COMMIT_INTERVAL) {
+                // Commit what we got so far and start a new transaction
+                db->Commit();
+                db->Begin();
+                uncommitted = 0;
+            }
+        }
+        delete parsed;
+    }
+    pipeline.Stop();
+    return true;
+}
+
+void ParseThread::DoStoreParsedFile(const wxFileName& filename, TagTreePtr tree, ITagsStoragePtr db)
+{
+    CL_TRACE_FUNCTION("parser");
+    // PPScan collects the macros into the global PPTable, it must only be called from this thread
+    PPScan(filename.GetFullPath(), false);
+
+    db->DeleteByFileName(wxFileName(), filename.GetFullPath(), false);
+    db->Store(tree, wxFileName(), false);
+    if(db->InsertFileEntry(filename.GetFullPath(), (int)time(NULL)) == TagExist) {
+        db->UpdateFileEntry(filename.GetFullPath(), (int)time(NULL));
+    }
+}
+
+bool ParseThread::DoGetFileStat(const wxString& filename, FileHashEntry& entry)
+{
+    wxStructStat buff;
+    if(wxStat(filename, &buff) != 0) return false;
+    entry.size = (long)buff.st_size;
+    entry.mtime = (long)buff.st_mtime;
+    return true;
+}
+
+bool ParseThread::DoGetFileHash(const wxString& filename, FileHashEntry& entry)
+{
+    if(!DoGetFileStat(filename, entry)) return false;
+    long size(0);
+    return FileUtils::GetFileHash(filename, entry.hash, size);
+}
+
+void ParseThread::DoReportRetagProgress(ParseRequest* req, size_t filesDone, double maxVal, int& lastPercentageReported)
+{
+    int precent = (int)((filesDone / maxVal) * 100);
+    if(lastPercentageReported == precent) return;
+
+    lastPercentageReported = precent;
     if(req->_evtHandler) {
-        wxCommandEvent retaggingCompletedEvent(wxEVT_PARSE_THREAD_RETAGGING_COMPLETED);
-        std::vector<std::string>* arrFiles = new std::vector<std::string>;
-        *arrFiles = req->_workspaceFiles;
-        retaggingCompletedEvent.SetClientData(arrFiles);
-        req->_evtHandler->AddPendingEvent(retaggingCompletedEvent);
+        wxCommandEvent retaggingProgressEvent(wxEVT_PARSE_THREAD_RETAGGING_PROGRESS);
+        retaggingProgressEvent.SetInt((int)precent);
+        req->_evtHandler->AddPendingEvent(retaggingProgressEvent);
+
+    } else {
+        wxPrintf(wxT("parsing: %%%d completed\n"), precent);
     }
 }
 
 void ParseThread::FindIncludedFiles(ParseRequest* req, std::set<wxString>* newSet)
 {
+    CL_TRACE_FUNCTION("parser");
     wxArrayString searchPaths, excludePaths, filteredFileList;
     GetSearchPaths(searchPaths, excludePaths);
 
@@ -642,6 +912,7 @@ void ParseThread::DoNotifyReady(wxEvtHandler* caller, int requestType)
 
 void ParseThread::ProcessColourRequest(ParseRequest* req)
 {
+    CL_TRACE_FUNCTION("parser");
     CppScanner scanner;
     // read the file content
     wxFFile fp(req->getFile(), "rb");
@@ -151,10 +151,17 @@ class WXDLLIMPEXP_CL ParseThread : public WorkerThread
     wxArrayString m_searchPaths;
     wxArrayString m_excludePaths;
     bool m_crawlerEnabled;
+    size_t m_parserWorkers;
     wxCriticalSection m_cs;
     
 public:
     void SetCrawlerEnabeld(bool b);
+    /**
+     * @brief set the number of parallel parser workers used when retagging the workspace.
+     * A value of 1 (or less) disables the pipelined retag and parses the files serially
+     */
+    void SetParserWorkers(size_t workers);
+    size_t GetParserWorkers();
     void SetSearchPaths(const wxArrayString& paths, const wxArrayString& exlucdePaths);
     void GetSearchPaths(wxArrayString& paths, wxArrayString& excludePaths);
     bool IsCrawlerEnabled();
@@ -190,6 +197,35 @@ private:
     void ProcessSimple(ParseRequest* req);
     void ProcessIncludes(ParseRequest* req);
     void ProcessParseAndStore(ParseRequest* req);
+    /**
+     * @brief split 'files' into the files that need to be parsed and the ones that can be skipped.
+     * Unchanged files (same content hash) are skipped, files with cached indexer output are stored from the cache
+     * @return false if the thread was requested to stop
+     */
+    bool DoFilterUnchangedFiles(const std::vector<std::string>& files,
+                                const wxString& optionsHash,
+                                ITagsStoragePtr db,
+                                std::vector<std::string>& filesToParse,
+                                size_t& filesUnchanged,
+                                size_t& filesFromCache);
+    bool DoParseAndStoreSerial(ParseRequest* req,
+                               const std::vector<std::string>& files,
+                               const wxString& optionsHash,
+                               ITagsStoragePtr db);
+    /**
+     * @brief parse the files using 'workers' parser threads feeding this thread,
+     * which does the database writes in large transactions
+     * @return false if the thread was requested to stop
+     */
+    bool DoParseAndStorePipelined(ParseRequest* req,
+                                  const std::vector<std::string>& files,
+                                  const wxString& optionsHash,
+                                  ITagsStoragePtr db,
+                                  size_t workers);
+    void DoStoreParsedFile(const wxFileName& filename, TagTreePtr tree, ITagsStoragePtr db);
+    void DoReportRetagProgress(ParseRequest* req, size_t filesDone, double maxVal, int& lastPercentageReported);
+    bool DoGetFileStat(const wxString& filename, FileHashEntry& entry);
+    bool DoGetFileHash(const wxString& filename, FileHashEntry& entry);
     void ProcessDeleteTagsOfFiles(ParseRequest* req);
     void ProcessSimpleNoIncludes(ParseRequest* req);
     void ProcessIncludeStatements(ParseRequest* req);
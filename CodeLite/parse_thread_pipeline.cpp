@@ -0,0 +1,200 @@
+#include "parse_thread_pipeline.h"
+#include "ctags_manager.h"
+#include "file_logger.h"
+#include "fileutils.h"
+#include <wx/filefn.h>
+
+// Number of files a worker sends to the indexer in a single request
+#define PARSE_WORKER_BATCH_SIZE 16
+
+//--------------------------------------------------------------------------------------
+// ParsedFileQueue
+//--------------------------------------------------------------------------------------
+ParsedFileQueue::ParsedFileQueue(size_t capacity)
+    : m_capacity(capacity == 0 ? 1 : capacity)
+    , m_cancelled(false)
+    , m_notFull(m_mutex)
+    , m_notEmpty(m_mutex)
+{
+}
+
+ParsedFileQueue::~ParsedFileQueue() { Cancel(); }
+
+bool ParsedFileQueue::Push(ParsedFile* item)
+{
+    wxMutexLocker locker(m_mutex);
+    while(!m_cancelled && m_items.size() >= m_capacity) {
+        m_notFull.Wait();
+    }
+
+    if(m_cancelled) return false;
+    m_items.push_back(item);
+    m_notEmpty.Signal();
+    return true;
+}
+
+ParsedFile* ParsedFileQueue::Pop(long timeoutMs)
+{
+    wxMutexLocker locker(m_mutex);
+    if(m_items.empty() && !m_cancelled && timeoutMs > 0) {
+        m_notEmpty.WaitTimeout(timeoutMs);
+    }
+
+    if(m_items.empty()) return NULL;
+    ParsedFile* item = m_items.front();
+    m_items.pop_front();
+    m_notFull.Signal();
+    return item;
+}
+
+void ParsedFileQueue::Cancel()
+{
+    wxMutexLocker locker(m_mutex);
+    m_cancelled = true;
+    while(!m_items.empty()) {
+        delete m_items.front();
+        m_items.pop_front();
+    }
+    m_notFull.Broadcast();
+    m_notEmpty.Broadcast();
+}
+
+//--------------------------------------------------------------------------------------
+// ParseWorkerThread
+//--------------------------------------------------------------------------------------
+ParseWorkerThread::ParseWorkerThread(ParseThreadPipeline* pipeline)
+    : wxThread(wxTHREAD_JOINABLE)
+    , m_pipeline(pipeline)
+{
+}
+
+ParseWorkerThread::~ParseWorkerThread() {}
+
+void* ParseWorkerThread::Entry()
+{
+    wxArrayString files;
+    bool cancelled(false);
+    while(!cancelled && m_pipeline->NextFiles(files, PARSE_WORKER_BATCH_SIZE)) {
+        std::vector<ParsedFile*> results;
+        wxArrayString sources;
+        for(size_t i = 0; i < files.GetCount(); ++i) {
+            ParsedFile* result = new ParsedFile();
+            result->filename = files.Item(i);
+            result->skipped = TagsManagerST::Get()->IsBinaryFile(files.Item(i));
+            if(!result->skipped) {
+                sources.Add(files.Item(i));
+            }
+            results.push_back(result);
+        }
+
+        // The indexer accepts a connection per request, so the workers can talk to it concurrently.
+        // Each request carries a batch of files to save the round trip per file
+        wxArrayString tags;
+        bool failed = !TagsManagerST::Get()->SourcesToTags(sources, tags);
+
+        size_t tagsIndex(0);
+        for(size_t i = 0; i < results.size(); ++i) {
+            ParsedFile* result = results.at(i);
+            if(!result->skipped) {
+                int count(0);
+                result->tags = tagsIndex < tags.GetCount() ? tags.Item(tagsIndex) : wxString();
+                result->failed = failed;
+                result->tree = TagsManagerST::Get()->TreeFromTags(result->tags, count);
+                ++tagsIndex;
+
+                // Hashing the file is done here as well, to keep the writer thread free
+                wxStructStat buff;
+                long size(0);
+                if(wxStat(result->filename, &buff) == 0 &&
+                   FileUtils::GetFileHash(result->filename, result->hash.hash, size)) {
+                    result->hash.file = result->filename;
+                    result->hash.size = (long)buff.st_size;
+                    result->hash.mtime = (long)buff.st_mtime;
+                }
+            }
+
+            // From this point on, the result belongs to the queue. Do not keep any reference
+            // to the tree (its reference count is not thread safe)
+            if(cancelled || !m_pipeline->m_queue.Push(result)) {
+                // Pipeline was cancelled
+                delete result;
+                cancelled = true;
+            }
+        }
+    }
+    m_pipeline->WorkerDone();
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------
+// ParseThreadPipeline
+//--------------------------------------------------------------------------------------
+ParseThreadPipeline::ParseThreadPipeline(const std::vector<std::string>& files, size_t workers, size_t queueCapacity)
+    : m_files(files)
+    , m_nextFile(0)
+    , m_activeWorkers(0)
+    , m_workersCount(workers == 0 ? 1 : workers)
+    , m_queue(queueCapacity)
+{
+}
+
+ParseThreadPipeline::~ParseThreadPipeline() { Stop(); }
+
+void ParseThreadPipeline::Start()
+{
+    for(size_t i = 0; i < m_workersCount; ++i) {
+        ParseWorkerThread* worker = new ParseWorkerThread(this);
+        if(worker->Create() != wxTHREAD_NO_ERROR) {
+            CL_WARNING("ParseThreadPipeline: failed to create parser worker thread");
+            delete worker;
+            continue;
+        }
+
+        {
+            wxMutexLocker locker(m_mutex);
+            ++m_activeWorkers;
+        }
+        m_workers.push_back(worker);
+        worker->Run();
+    }
+}
+
+void ParseThreadPipeline::Stop()
+{
+    // Prevent the workers from picking new files and release anyone blocked on the queue
+    {
+        wxMutexLocker locker(m_mutex);
+        m_nextFile = m_files.size();
+    }
+    m_queue.Cancel();
+
+    for(size_t i = 0; i < m_workers.size(); ++i) {
+        // Joinable threads must always be waited for
+        m_workers.at(i)->Wait();
+        delete m_workers.at(i);
+    }
+    m_workers.clear();
+}
+
+bool ParseThreadPipeline::NextFiles(wxArrayString& files, size_t count)
+{
+    files.Clear();
+    wxMutexLocker locker(m_mutex);
+    while(m_nextFile < m_files.size() && files.GetCount() < count) {
+        files.Add(wxString(m_files.at(m_nextFile).c_str(), wxConvUTF8));
+        ++m_nextFile;
+    }
+    return !files.IsEmpty();
+}
+
+void ParseThreadPipeline::WorkerDone()
+{
+    wxMutexLocker locker(m_mutex);
+    if(m_activeWorkers) --m_activeWorkers;
+}
+
+bool ParseThreadPipeline::IsDone()
+{
+    wxMutexLocker locker(m_mutex);
+    return m_activeWorkers == 0;
+}
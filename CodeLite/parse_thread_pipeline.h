@@ -0,0 +1,138 @@
+#ifndef PARSE_THREAD_PIPELINE_H
+#define PARSE_THREAD_PIPELINE_H
+
+#include "codelite_exports.h"
+#include "tag_tree.h"
+#include "fileentry.h"
+#include <wx/thread.h>
+#include <wx/string.h>
+#include <wx/arrstr.h>
+#include <deque>
+#include <vector>
+#include <string>
+
+/**
+ * @class ParsedFile
+ * @brief the result of parsing a single file by one of the pipeline workers
+ */
+struct WXDLLIMPEXP_CL ParsedFile {
+    wxString filename;
+    TagTreePtr tree;
+    wxString tags;      // the indexer output, kept for the tags cache
+    FileHashEntry hash; // the file content hash, 'hash.file' is empty if the file could not be hashed
+    bool skipped;       // binary file, nothing to store
+    bool failed;        // the indexer failed, 'tags' can not be trusted and must not be cached
+
+    ParsedFile()
+        : skipped(false)
+        , failed(false)
+    {
+    }
+};
+
+/**
+ * @class ParsedFileQueue
+ * @brief a bounded, blocking queue between the parser workers and the database writer
+ * Producers block when the queue is full so the workers can not run away from the writer
+ */
+class WXDLLIMPEXP_CL ParsedFileQueue
+{
+    std::deque<ParsedFile*> m_items;
+    size_t m_capacity;
+    bool m_cancelled;
+    wxMutex m_mutex;
+    wxCondition m_notFull;
+    wxCondition m_notEmpty;
+
+public:
+    ParsedFileQueue(size_t capacity);
+    virtual ~ParsedFileQueue();
+
+    /**
+     * @brief add an item to the queue, blocks while the queue is full.
+     * On success the queue takes ownership of the item
+     * @return false if the queue was cancelled (the caller still owns 'item')
+     */
+    bool Push(ParsedFile* item);
+
+    /**
+     * @brief pop an item from the queue. Wait up to 'timeoutMs' for an item to arrive
+     * @return the item (caller takes ownership) or NULL on timeout
+     */
+    ParsedFile* Pop(long timeoutMs);
+
+    /**
+     * @brief cancel the queue: wake all blocked producers and discard the queued items
+     */
+    void Cancel();
+};
+
+class ParseThreadPipeline;
+/**
+ * @class ParseWorkerThread
+ * @brief a worker thread that converts source files into tag trees
+ */
+class WXDLLIMPEXP_CL ParseWorkerThread : public wxThread
+{
+    ParseThreadPipeline* m_pipeline;
+
+public:
+    ParseWorkerThread(ParseThreadPipeline* pipeline);
+    virtual ~ParseWorkerThread();
+    virtual void* Entry();
+};
+
+/**
+ * @class ParseThreadPipeline
+ * @brief run 'N' parser workers feeding a single consumer (the database writer).
+ * The workers only do the work that is safe to run in parallel (talking to the indexer
+ * and building the tags tree). Everything that touches global state (the PP scanner, the
+ * database) is left to the consumer thread
+ */
+class WXDLLIMPEXP_CL ParseThreadPipeline
+{
+    friend class ParseWorkerThread;
+
+    std::vector<std::string> m_files;
+    size_t m_nextFile;
+    size_t m_activeWorkers;
+    size_t m_workersCount;
+    wxMutex m_mutex;
+    ParsedFileQueue m_queue;
+    std::vector<ParseWorkerThread*> m_workers;
+
+protected:
+    /**
+     * @brief fetch up to 'count' files to parse. Return false when there are no more files
+     */
+    bool NextFiles(wxArrayString& files, size_t count);
+    void WorkerDone();
+
+public:
+    ParseThreadPipeline(const std::vector<std::string>& files, size_t workers, size_t queueCapacity);
+    virtual ~ParseThreadPipeline();
+
+    /**
+     * @brief start the workers. If no worker could be started, IsDone() returns true immediately
+     */
+    void Start();
+
+    /**
+     * @brief stop the pipeline. Wake and join all the workers.
+     * Pending results are discarded
+     */
+    void Stop();
+
+    /**
+     * @brief return the next parsed file, waiting up to 'timeoutMs' for it
+     * @return the parsed file (caller takes ownership) or NULL if nothing is available yet
+     */
+    ParsedFile* Next(long timeoutMs) { return m_queue.Pop(timeoutMs); }
+
+    /**
+     * @brief return true when all the workers exited (the queue might still hold results)
+     */
+    bool IsDone();
+};
+
+#endif // PARSE_THREAD_PIPELINE_H
@@ -23,57 +23,220 @@
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 
-#define __PERFORMANCE 
 #include "performance.h"
-
-#ifdef __WXMSW__
-
+#include <wx/thread.h>
+#include <wx/tls.h>
+#include <wx/ffile.h>
+#include <wx/utils.h>
+#include <chrono>
 #include <vector>
-#include <string>
+#include <utility>
 #include <stdio.h>
-#include <windows.h>
-#include <assert.h>
 
-static FILE * dbgFile(NULL);
-static std::string output = "";
-static std::vector<std::pair<DWORD, DWORD> > tickCounts;
+// Spans recorded per thread before the newest spans are dropped
+#define TRACE_MAX_SPANS_PER_THREAD (1024 * 1024)
+
+std::atomic<bool> clTracer::ms_enabled(false);
+
+namespace
+{
+struct TraceSpan {
+    const char* category;
+    const char* name;
+    wxUint64 start;
+    wxUint64 duration;
+};
+
+struct TraceBuffer {
+    unsigned long threadId;
+    bool isMain;
+    std::vector<TraceSpan> spans;
+    std::vector<std::pair<const char*, wxUint64> > open; // PERF_START without PERF_END yet
+    size_t dropped;
+    wxMutex mutex; // the owner thread appends, Export() reads
 
-void PERF_OUTPUT(const char *path) {
-	output = path;
+    TraceBuffer()
+        : threadId(0)
+        , isMain(false)
+        , dropped(0)
+    {
+    }
+};
+
+// The buffers are kept until the process exits: their threads may still be recording
+wxMutex& GetBuffersMutex()
+{
+    static wxMutex mutex;
+    return mutex;
 }
 
-void PERF_START(const char* func_name) {
-	if (!dbgFile) {
-        dbgFile = fopen(output.c_str(), "w+");
-        assert(dbgFile != 0);
+std::vector<TraceBuffer*>& GetBuffers()
+{
+    static std::vector<TraceBuffer*> buffers;
+    return buffers;
+}
+
+wxString& GetOutputFileName()
+{
+    static wxString filename;
+    return filename;
+}
+
+wxTLS_TYPE(TraceBuffer*) s_threadBuffer;
+
+TraceBuffer* GetThreadBuffer()
+{
+    TraceBuffer* buffer = wxTLS_VALUE(s_threadBuffer);
+    if(!buffer) {
+        buffer = new TraceBuffer();
+        buffer->threadId = (unsigned long)wxThread::GetCurrentId();
+        buffer->isMain = wxThread::IsMain();
+        wxTLS_VALUE(s_threadBuffer) = buffer;
+
+        wxMutexLocker locker(GetBuffersMutex());
+        GetBuffers().push_back(buffer);
     }
-	fprintf(dbgFile, "%*c<block name=\"%s\">\n", 4*tickCounts.size(), ' ', func_name);
-    fflush(dbgFile);	
-	tickCounts.push_back(std::make_pair(DWORD(GetTickCount()), DWORD(0)));    
+    return buffer;
+}
+
+void WriteEscaped(FILE* fp, const char* str)
+{
+    for(const char* p = str; p && *p; ++p) {
+        if(*p == '"' || *p == '\\') {
+            fputc('\\', fp);
+            fputc(*p, fp);
+        } else if((unsigned char)*p < 0x20) {
+            fputc(' ', fp);
+        } else {
+            fputc(*p, fp);
+        }
+    }
+}
+}
+
+void clTracer::Enable(bool enable) { ms_enabled.store(enable); }
+
+void clTracer::SetOutputFile(const wxString& filename) { GetOutputFileName() = filename; }
+
+const wxString& clTracer::GetOutputFile() { return GetOutputFileName(); }
+
+wxUint64 clTracer::Now()
+{
+    return (wxUint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-void PERF_END() {
-	assert(dbgFile != 0);
-    if (tickCounts.empty())
+void clTracer::AddSpan(const char* category, const char* name, wxUint64 start, wxUint64 end)
+{
+    TraceBuffer* buffer = GetThreadBuffer();
+    wxMutexLocker locker(buffer->mutex);
+    if(buffer->spans.size() >= TRACE_MAX_SPANS_PER_THREAD) {
+        ++buffer->dropped;
         return;
+    }
+
+    TraceSpan span;
+    span.category = category;
+    span.name = name;
+    span.start = start;
+    span.duration = end - start;
+    buffer->spans.push_back(span);
+}
+
+void clTracer::Begin(const char* name)
+{
+    if(!IsEnabled()) return;
+    TraceBuffer* buffer = GetThreadBuffer();
+    wxMutexLocker locker(buffer->mutex);
+    buffer->open.push_back(std::make_pair(name, Now()));
+}
 
-	DWORD tickCount   = GetTickCount();
-    DWORD elapsed     = tickCount - tickCounts.back().first;
-    DWORD unaccounted = elapsed   - tickCounts.back().second;
-    
-    fprintf(dbgFile, "%*c<elapsed time=\"%ld\"", 4*tickCounts.size(), ' ', elapsed);
-    if (0 < unaccounted && unaccounted < elapsed) {
-        fprintf(dbgFile, " unaccounted=\"%ld\"", unaccounted);
+void clTracer::End()
+{
+    // Spans opened while recording are closed even if recording was stopped in the meantime
+    TraceBuffer* buffer = wxTLS_VALUE(s_threadBuffer);
+    if(!buffer) return;
+
+    std::pair<const char*, wxUint64> span;
+    {
+        wxMutexLocker locker(buffer->mutex);
+        if(buffer->open.empty()) return;
+        span = buffer->open.back();
+        buffer->open.pop_back();
     }
-    fprintf(dbgFile, "/>\n");
+    AddSpan("perf", span.first, span.second, Now());
+}
 
-    tickCounts.pop_back();
-    if (!tickCounts.empty()) {
-        tickCounts.back().second += elapsed;
+bool clTracer::Export(const wxString& filename)
+{
+    wxFFile fp(filename, "wb");
+    if(!fp.IsOpened()) return false;
+
+    // The timestamps are exported in microseconds, relative to the earliest span
+    std::vector<TraceBuffer*> buffers;
+    {
+        wxMutexLocker locker(GetBuffersMutex());
+        buffers = GetBuffers();
+    }
+
+    wxUint64 base = 0;
+    for(size_t i = 0; i < buffers.size(); ++i) {
+        wxMutexLocker locker(buffers.at(i)->mutex);
+        const std::vector<TraceSpan>& spans = buffers.at(i)->spans;
+        for(size_t j = 0; j < spans.size(); ++j) {
+            if(base == 0 || spans.at(j).start < base) {
+                base = spans.at(j).start;
+            }
+        }
     }
-    
-    fprintf(dbgFile, "%*c</block>\n", 4*tickCounts.size(), ' ');
-	fflush(dbgFile);	
+
+    FILE* f = fp.fp();
+    unsigned long pid = ::wxGetProcessId();
+    bool first = true;
+    fprintf(f, "{\"traceEvents\":[\n");
+    for(size_t i = 0; i < buffers.size(); ++i) {
+        TraceBuffer* buffer = buffers.at(i);
+        wxMutexLocker locker(buffer->mutex);
+
+        fprintf(f,
+                "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n",
+                pid,
+                buffer->threadId,
+                buffer->isMain ? "Main" : "Worker");
+        first = false;
+
+        for(size_t j = 0; j < buffer->spans.size(); ++j) {
+            const TraceSpan& span = buffer->spans.at(j);
+            // Spans recorded after the base was computed can not start before it
+            wxUint64 start = span.start > base ? span.start - base : 0;
+            fprintf(f, ",\n{\"name\":\"");
+            WriteEscaped(f, span.name);
+            fprintf(f, "\",\"cat\":\"");
+            WriteEscaped(f, span.category);
+            fprintf(f,
+                    "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%lu}",
+                    start / 1000.0,
+                    span.duration / 1000.0,
+                    pid,
+                    buffer->threadId);
+        }
+
+        if(buffer->dropped) {
+            fprintf(f,
+                    ",\n{\"name\":\"dropped spans\",\"ph\":\"i\",\"s\":\"t\",\"ts\":0,\"pid\":%lu,\"tid\":%lu,"
+                    "\"args\":{\"count\":%lu}}",
+                    pid,
+                    buffer->threadId,
+                    (unsigned long)buffer->dropped);
+        }
+    }
+    fprintf(f, "\n]}\n");
+    return fp.Close();
 }
 
-#endif
+bool clTracer::ExportToFile()
+{
+    if(GetOutputFileName().IsEmpty()) return false;
+    return Export(GetOutputFileName());
+}
@@ -26,16 +26,20 @@
 #ifndef __PERFORMANCE_H__
 #define __PERFORMANCE_H__
 
-// Usage: in your file that you want to profile, first do this:
-//     #define __PERFORMANCE
-//     #include "performance.h"
-// (Just comment out the #define __PERFORMANCE when you're done.)
+// A lightweight tracer. Spans are recorded in per thread buffers and exported in the Chrome
+// trace event format (load the file in chrome://tracing or https://ui.perfetto.dev).
+// Recording is off by default: start codelite with the environment variable CODELITE_TRACE set
+// to the output file name. While recording is off, a span costs a single flag check.
 //
-// Then use any of these forms in functions that you want to profile:
+// Use any of these forms in functions that you want to profile:
 //
-//     PERF_FUNCTION();  -- put this at the very top of any function to profile the whole function.
+//     CL_TRACE_FUNCTION("category");  -- put this at the very top of any function to profile the whole function.
 //
-//     PERF_BLOCK("Your Comment Here") {    -- put this around parts of a function you want to profile 
+//     CL_TRACE_SCOPE("category", "name");  -- profile the rest of the enclosing scope
+//
+//     PERF_FUNCTION();  -- same as CL_TRACE_FUNCTION("perf")
+//
+//     PERF_BLOCK("Your Comment Here") {    -- put this around parts of a function you want to profile
 //         [your code here]
 //     }
 //
@@ -43,60 +47,96 @@
 //    [your code here]
 //    PERF_END();
 //
-// Output is sent to file "codelite.perf" in the startup directory.  The file is opened automatically for you.  It is
-// overwritten on each run.
-//
-// Output format is XML, so you can use xml tools, or view the file in a folding editor.  Looks like this:
-//     <block name="Function Signature|Your Comment">
-//        <block ...>
-//           ...
-//       </block>
-//       ...
-//       <elapsed .../>
-//    </block>
-//
-// The <elapsed> element shows the time spent for the entire block it is in, and includes an optional "unaccounted"
-// attribute for any ticks not counted by inner blocks (so you know how much time you're missing from profiled
-//  subfunctions).
+// The names and categories must be string literals (they are kept by pointer)
 
 #include "codelite_exports.h"
+#include <wx/string.h>
+#include <atomic>
+
+class WXDLLIMPEXP_CL clTracer
+{
+    static std::atomic<bool> ms_enabled;
+
+public:
+    static bool IsEnabled() { return ms_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief start / stop recording
+     */
+    static void Enable(bool enable);
+
+    /**
+     * @brief the file used by ExportToFile()
+     */
+    static void SetOutputFile(const wxString& filename);
+    static const wxString& GetOutputFile();
+
+    /**
+     * @brief write all the recorded spans to 'filename' in the Chrome trace event (JSON) format
+     */
+    static bool Export(const wxString& filename);
+
+    /**
+     * @brief export to the output file (if one was set)
+     */
+    static bool ExportToFile();
+
+    /**
+     * @brief a monotonic timestamp, in nanoseconds
+     */
+    static wxUint64 Now();
+
+    /**
+     * @brief record a complete span on the calling thread buffer
+     */
+    static void AddSpan(const char* category, const char* name, wxUint64 start, wxUint64 end);
+
+    /**
+     * @brief open / close a span on the calling thread (PERF_START / PERF_END)
+     */
+    static void Begin(const char* name);
+    static void End();
+};
+
+/**
+ * @class clTraceSpan
+ * @brief records the span between its construction and its destruction
+ */
+class clTraceSpan
+{
+    const char* m_category;
+    const char* m_name;
+    wxUint64 m_start;
+
+public:
+    int count;
+
+public:
+    clTraceSpan(const char* category, const char* name)
+        : m_category(category)
+        , m_name(name)
+        , m_start(clTracer::IsEnabled() ? clTracer::Now() : 0)
+        , count(0)
+    {
+    }
+    ~clTraceSpan()
+    {
+        if(m_start) {
+            clTracer::AddSpan(m_category, m_name, m_start, clTracer::Now());
+        }
+    }
+};
+
+#define CL_TRACE_CONCAT2(a, b) a##b
+#define CL_TRACE_CONCAT(a, b) CL_TRACE_CONCAT2(a, b)
+#define CL_TRACE_SCOPE(category, name) clTraceSpan CL_TRACE_CONCAT(clTraceSpan_, __LINE__)(category, name)
+#define CL_TRACE_FUNCTION(category) CL_TRACE_SCOPE(category, __FUNCTION__)
 
-#ifdef __PERFORMANCE
-    #ifdef __WXMSW__ 
-        //Uncomment this to globally disable all profiling
-        //#undef __PERFORMANCE
-    #else
-        // Don't change this
-        #undef __PERFORMANCE
-    #endif
-#endif
-
-#ifdef __PERFORMANCE
-
-    extern WXDLLIMPEXP_CL void PERF_START(const char* func_name);
-    extern WXDLLIMPEXP_CL void PERF_END();
-	extern WXDLLIMPEXP_CL void PERF_OUTPUT(const char* path);
-	
-    struct WXDLLIMPEXP_CL PERF_CLASS {
-        PERF_CLASS(const char *name) : count(0) { PERF_START(name); }
-        ~PERF_CLASS()                           { PERF_END();       }
-            
-        int count;
-    };
-
-    #define PERF_FUNCTION()   PERF_CLASS PERF_OBJ(__PRETTY_FUNCTION__)
-    #define PERF_REPEAT(nm,n) for (PERF_CLASS PERF_OBJ(nm); PERF_OBJ.count < (n); PERF_OBJ.count++)
-    #define PERF_BLOCK(nm)    PERF_REPEAT(nm,1)
-
-#else 
-
-	#define PERF_START(func_name)
-	#define PERF_END()
-	#define PERF_OUTPUT(path)
-	#define PERF_FUNCTION()
-    #define PERF_REPEAT(nm,n)
-    #define PERF_BLOCK(nm)
-    
-#endif
+#define PERF_START(func_name) clTracer::Begin(func_name)
+#define PERF_END() clTracer::End()
+#define PERF_OUTPUT(path) clTracer::SetOutputFile(path)
+#define PERF_FUNCTION() CL_TRACE_FUNCTION("perf")
+#define PERF_REPEAT(nm, n) for(clTraceSpan PERF_OBJ("perf", nm); PERF_OBJ.count < (n); PERF_OBJ.count++)
+#define PERF_BLOCK(nm) PERF_REPEAT(nm, 1)
 
 #endif // __PERFORMANCE_H__
@@ -28,14 +28,288 @@
 #include "entry.h"
 #include "ctags_manager.h"
 #include "fileextmanager.h"
-#include <wx/progdlg.h>
-#include <wx/sizer.h>
-#include "progress_dialog.h"
+#include <wx/stopwatch.h>
 #include "refactoring_storage.h"
+#include "clTaskExecutor.h"
+#include "event_notifier.h"
+#include <deque>
+#include <map>
 
 const wxEventType wxEVT_REFACTORING_ENGINE_CACHE_INITIALIZING = wxNewEventType();
+wxDEFINE_EVENT(wxEVT_REFACTORING_ENGINE_MATCHES, clRefactoringEvent);
+wxDEFINE_EVENT(wxEVT_REFACTORING_ENGINE_DONE, clRefactoringEvent);
+
+// The main thread resolves the tokens in slices of this many ms, so the UI remains responsive
+#define REFACTORING_TIME_SLICE 50
+
+//----------------------------------------------------------------------------------
+// clRefactoringEvent
+//----------------------------------------------------------------------------------
+clRefactoringEvent::clRefactoringEvent(wxEventType commandType, int winid)
+    : clCommandEvent(commandType, winid)
+    , m_searchId(0)
+    , m_progress(0)
+    , m_cancelled(false)
+{
+}
+
+clRefactoringEvent::clRefactoringEvent(const clRefactoringEvent& event) { *this = event; }
+
+clRefactoringEvent::~clRefactoringEvent() {}
+
+clRefactoringEvent& clRefactoringEvent::operator=(const clRefactoringEvent& src)
+{
+    clCommandEvent::operator=(src);
+    m_searchId = src.m_searchId;
+    m_matches = src.m_matches;
+    m_possibleMatches = src.m_possibleMatches;
+    m_progress = src.m_progress;
+    m_cancelled = src.m_cancelled;
+    return *this;
+}
+
+//----------------------------------------------------------------------------------
+// RefactoringSearch
+//----------------------------------------------------------------------------------
+
+/**
+ * @class RefactoringSearch
+ * @brief the part of a references search which is shared with the tasks.
+ * The "collect" task brings the tokens cache up to date and loads the occurrences of the symbol, then it
+ * submits one task per file which prepares the file text states. The prepared files are queued here and
+ * the main thread is notified to resolve their tokens (the resolver is not thread safe)
+ */
+class RefactoringSearch
+{
+    size_t m_id;
+    clCancellationToken m_token;
+    wxMutex m_mutex;
+    std::deque<RefactoringEngine::FileResult> m_files;
+    size_t m_filesCount;
+    size_t m_filesPending;
+    bool m_collected;
+    bool m_notified;
+
+protected:
+    void DoNotify()
+    {
+        // called with the lock held. Notify once until the main thread takes the files
+        if(!m_notified) {
+            m_notified = true;
+            RefactoringEngine::Instance()->CallAfter(&RefactoringEngine::OnSearchProgress, m_id);
+        }
+    }
+
+public:
+    RefactoringSearch(size_t id)
+        : m_id(id)
+        , m_filesCount(0)
+        , m_filesPending(0)
+        , m_collected(false)
+        , m_notified(false)
+    {
+    }
+    virtual ~RefactoringSearch() {}
+
+    size_t GetId() const { return m_id; }
+    const clCancellationToken& GetToken() const { return m_token; }
+    void Cancel() { m_token.Cancel(); }
+
+    /**
+     * @brief the collect task found 'count' files with candidates. Called before the files tasks are submitted
+     */
+    void SetFilesCount(size_t count)
+    {
+        wxMutexLocker locker(m_mutex);
+        m_filesCount = count;
+        m_filesPending = count;
+    }
+
+    size_t GetFilesCount()
+    {
+        wxMutexLocker locker(m_mutex);
+        return m_filesCount;
+    }
+
+    /**
+     * @brief the collect task is done (or was discarded)
+     */
+    void CollectDone()
+    {
+        wxMutexLocker locker(m_mutex);
+        m_collected = true;
+        DoNotify();
+    }
+
+    /**
+     * @brief a file task is done (or was discarded). 'file' is moved into the queue
+     */
+    void AddFile(RefactoringEngine::FileResult& file)
+    {
+        wxMutexLocker locker(m_mutex);
+        // Swap the strings and tokens in: a wxString copy would share its buffer with the task thread
+        m_files.push_back(RefactoringEngine::FileResult());
+        RefactoringEngine::FileResult& result = m_files.back();
+        result.filename.swap(file.filename);
+        result.tokens.swap(file.tokens);
+
+        // The reference counting of SmartPtr is not thread safe: copy and release it while holding the lock
+        result.states = file.states;
+        file.states = TextStatesPtr(NULL);
+        if(m_filesPending) --m_filesPending;
+        DoNotify();
+    }
+
+    /**
+     * @brief take the next prepared file (main thread)
+     * @param finished set to true when there are no more files to expect
+     */
+    bool Take(RefactoringEngine::FileResult& file, bool& finished)
+    {
+        wxMutexLocker locker(m_mutex);
+        m_notified = false;
+        if(m_files.empty()) {
+            finished = m_collected && (m_filesPending == 0);
+            return false;
+        }
+        RefactoringEngine::FileResult& front = m_files.front();
+        file.filename.swap(front.filename);
+        file.tokens.swap(front.tokens);
+        file.states = front.states;
+        front.states = TextStatesPtr(NULL);
+        m_files.pop_front();
+        return true;
+    }
+};
+
+namespace
+{
+struct CppTokenOffsetLess {
+    bool operator()(const CppToken& a, const CppToken& b) const { return a.getOffset() < b.getOffset(); }
+};
+
+/**
+ * @class RefactoringStatesTask
+ * @brief prepare the text states of a file with candidates
+ */
+class RefactoringStatesTask : public clTask
+{
+    std::shared_ptr<RefactoringSearch> m_search;
+    RefactoringEngine::FileResult m_file;
+
+public:
+    RefactoringStatesTask(std::shared_ptr<RefactoringSearch> search, const wxString& filename, const CppToken::List_t& tokens)
+        : clTask(kNormal, search->GetToken())
+        , m_search(search)
+    {
+        // The strings are used by another thread, make a copy of the content
+        m_file.filename = filename.c_str();
+        CppToken::List_t::const_iterator iter = tokens.begin();
+        for(; iter != tokens.end(); ++iter) {
+            CppToken token = *iter;
+            token.setName(iter->getName().c_str());
+            token.setFilename(iter->getFilename().c_str());
+            m_file.tokens.push_back(token);
+        }
+    }
+
+    virtual ~RefactoringStatesTask() { m_search->AddFile(m_file); }
+
+    virtual void Run()
+    {
+        if(IsCancelled()) return;
+        CppWordScanner scanner(m_file.filename);
+        m_file.states = scanner.states();
+    }
+};
+
+/**
+ * @class RefactoringCollectTask
+ * @brief update the tokens cache of the modified files, load the occurrences of the searched symbol and
+ * submit a RefactoringStatesTask per file
+ */
+class RefactoringCollectTask : public clTask
+{
+    std::shared_ptr<RefactoringSearch> m_search;
+    clTaskQueue* m_queue;
+    wxString m_workspaceFile;
+    wxString m_word;
+    wxFileList_t m_files;
+
+public:
+    RefactoringCollectTask(std::shared_ptr<RefactoringSearch> search,
+                           clTaskQueue* queue,
+                           const wxString& workspaceFile,
+                           const wxString& word,
+                           const wxFileList_t& files)
+        : clTask(kNormal, search->GetToken())
+        , m_search(search)
+        , m_queue(queue)
+        , m_workspaceFile(workspaceFile.c_str())
+        , m_word(word.c_str())
+    {
+        // The strings are used by another thread, make a copy of the content
+        m_files.reserve(files.size());
+        for(size_t i = 0; i < files.size(); ++i) {
+            m_files.push_back(wxFileName(files.at(i).GetFullPath().c_str()));
+        }
+    }
+
+    virtual ~RefactoringCollectTask() { m_search->CollectDone(); }
+
+    virtual void Run()
+    {
+        if(IsCancelled()) return;
+
+        RefactoringStorage storage;
+        storage.OpenCache(m_workspaceFile);
+
+        // Update the cache of the modified files
+        wxFileList_t modifiedFilesList = storage.FilterUpToDateFiles(m_files);
+        for(size_t i = 0; i < modifiedFilesList.size(); ++i) {
+            if(IsCancelled()) return;
+
+            // Scan only valid C / C++ files
+            const wxFileName& curfile = modifiedFilesList.at(i);
+            switch(FileExtManager::GetType(curfile.GetFullName())) {
+            case FileExtManager::TypeHeader:
+            case FileExtManager::TypeSourceC:
+            case FileExtManager::TypeSourceCpp:
+                storage.UpdateFile(curfile.GetFullPath());
+                break;
+            default:
+                break;
+            }
+        }
+
+        // Group the tokens by file
+        CppToken::List_t tokens = storage.GetTokens(m_word, m_files);
+        std::map<wxString, CppToken::List_t> files;
+        CppToken::List_t::const_iterator iter = tokens.begin();
+        for(; iter != tokens.end(); ++iter) {
+            files[iter->getFilename()].push_back(*iter);
+        }
 
+        m_search->SetFilesCount(files.size());
+        std::map<wxString, CppToken::List_t>::iterator fileIter = files.begin();
+        for(; fileIter != files.end(); ++fileIter) {
+            // keep the matches of every file ordered by their offset (the renaming depends on it)
+            fileIter->second.sort(CppTokenOffsetLess());
+            m_queue->Submit(new RefactoringStatesTask(m_search, fileIter->first, fileIter->second));
+        }
+    }
+};
+}
+
+//----------------------------------------------------------------------------------
+// RefactoringEngine
+//----------------------------------------------------------------------------------
 RefactoringEngine::RefactoringEngine()
+    : m_evtHandler(NULL)
+    , m_searchId(0)
+    , m_onlyDefiniteMatches(false)
+    , m_searchFileActive(false)
+    , m_searchFilesDone(0)
 {
 }
 
@@ -56,14 +330,15 @@ void RefactoringEngine::Clear()
     m_candidates.clear();
 }
 
-void RefactoringEngine::RenameGlobalSymbol(const wxString& symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files)
+size_t RefactoringEngine::RenameGlobalSymbol(const wxString& symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files)
 {
-    DoFindReferences(symname, fn, line, pos, files, false);
+    return DoFindReferences(symname, fn, line, pos, files, false);
 }
 
 void RefactoringEngine::RenameLocalSymbol(const wxString& symname, const wxFileName& fn, int line, int pos)
 {
     // Clear previous results
+    CancelSearch();
     Clear();
 
     // Load the file and get a state map + the text from the scanner
@@ -121,12 +396,12 @@ bool RefactoringEngine::DoResolveWord(TextStatesPtr states, const wxFileName& fn
     wxString expr = GetExpression(pos, states);
 
     // sanity
-    if(states->text.length() < (size_t)pos + 1)
+    if(states->GetLength() < (size_t)pos + 1)
         return false;
 
     // get the scope
     // Optimize the text for large files
-    wxString text(states->text.substr(0, pos + 1));
+    wxString text(states->GetText(0, pos + 1));
 
     // we simply collect declarations & implementations
 
@@ -303,150 +578,160 @@ wxString RefactoringEngine::GetExpression(int pos, TextStatesPtr states)
     return expression;
 }
 
-clProgressDlg* RefactoringEngine::CreateProgressDialog(const wxString& title, int maxValue)
-{
-    clProgressDlg* prgDlg = NULL;
-    // Create a progress dialog
-    prgDlg = new clProgressDlg (NULL, title, wxT(""), maxValue);
-    return prgDlg;
-}
-
-void RefactoringEngine::FindReferences(const wxString& symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files)
+size_t RefactoringEngine::FindReferences(const wxString& symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files)
 {
-    DoFindReferences(symname, fn, line, pos, files, true);
+    return DoFindReferences(symname, fn, line, pos, files, true);
 }
 
-void RefactoringEngine::DoFindReferences(const wxString& symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files, bool onlyDefiniteMatches)
+size_t RefactoringEngine::DoFindReferences(const wxString& symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files, bool onlyDefiniteMatches)
 {
-    // Clear previous results
+    // Cancel the previous search and clear its results
+    CancelSearch();
     Clear();
-    
+
+    std::shared_ptr<RefactoringSearch> search(new RefactoringSearch(++m_searchId));
+    m_search = search;
+    m_searchWord = symname;
+    m_searchSource.Reset();
+    m_onlyDefiniteMatches = onlyDefiniteMatches;
+    m_searchFile = FileResult();
+    m_searchFileActive = false;
+    m_searchFilesDone = 0;
+
     if ( ! m_storage.IsCacheReady() ) {
         m_storage.InitializeCache( files );
-        return;
+        search->CollectDone();
+        return m_searchId;
     }
-    
-    // Container for the results found in the 'files'
-    CppTokensMap tokensMap;
 
     // Load the file and get a state map + the text from the scanner
     CppWordScanner scanner(fn.GetFullPath());
 
     // get the current file states
     TextStatesPtr states = scanner.states();
-    if(!states)
-        return;
 
     // Attempt to understand the expression that the caret is currently located at (using line:pos:file)
-    RefactorSource rs;
-    if(!DoResolveWord(states, fn, pos + symname.Len(), line, symname, &rs))
-        return;
+    if(!states || !DoResolveWord(states, fn, pos + symname.Len(), line, symname, &m_searchSource)) {
+        search->CollectDone();
+        return m_searchId;
+    }
 
-    wxFileList_t modifiedFilesList = m_storage.FilterUpToDateFiles( files );
-    clProgressDlg* prgDlg = NULL;
-    if ( !modifiedFilesList.empty() ) {
-        prgDlg = CreateProgressDialog(_("Updating cache..."), files.size());
-        // Search the provided input files for the symbol to rename and prepare
-        // a CppTokensMap
-        for (size_t i=0; i<modifiedFilesList.size(); i++) {
-            wxFileName curfile = modifiedFilesList.at(i);
-
-            wxString msg;
-            msg << _("Caching file: ") << curfile.GetFullName();
-            // update the progress bar
-            if (!prgDlg->Update(i, msg)) {
-                prgDlg->Destroy();
-                Clear();
-                return;
-            }
+    // Bring the cache up to date and load the tokens in the background
+    static clTaskQueue* tasksQueue = clTaskExecutor::Get()->CreateQueue("Refactoring", false);
+    tasksQueue->Submit(new RefactoringCollectTask(search, tasksQueue, m_storage.GetWorkspaceFile(), symname, files));
+    return m_searchId;
+}
 
-            // Scan only valid C / C++ files
-            switch(FileExtManager::GetType(curfile.GetFullName())) {
-            case FileExtManager::TypeHeader:
-            case FileExtManager::TypeSourceC:
-            case FileExtManager::TypeSourceCpp: {
-                // load matches for a give symbol
-                m_storage.Match(symname, curfile.GetFullPath(), tokensMap);
-            }
-            break;
-            default:
-                break;
-            }
-        }
-        prgDlg->Destroy();
-    }
-    // load all tokens, first we need to parse the workspace files...
-    CppToken::List_t tokens = m_storage.GetTokens(symname, files);
-    if (tokens.empty())
-        return;
+void RefactoringEngine::CancelSearch()
+{
+    if(!m_search) return;
 
-    // sort the tokens
-    tokens.sort();
+    m_search->Cancel();
+    m_search.reset();
+    m_searchFile = FileResult();
+    m_searchFileActive = false;
 
+    clRefactoringEvent event(wxEVT_REFACTORING_ENGINE_DONE);
+    event.SetSearchId(m_searchId);
+    event.SetCancelled(true);
+    EventNotifier::Get()->ProcessEvent(event);
+}
+
+void RefactoringEngine::DoCheckCandidate(CppToken& token, CppToken::List_t& matches, CppToken::List_t& possibleMatches)
+{
+    TextStatesPtr states = m_searchFile.states;
     RefactorSource target;
-    std::list<CppToken>::iterator iter = tokens.begin();
-    int counter(0);
+    if (DoResolveWord(states, wxFileName( token.getFilename() ), token.getOffset(), token.getLineNumber(), m_searchWord, &target)) {
 
-    TextStatesPtr statesPtr(NULL);
-    wxString      statesPtrFileName;
-    prgDlg = CreateProgressDialog(_("Stage 2/2: Parsing matches..."), (int) tokens.size());
+        // set the line number
+        if(states->GetLength() > token.getOffset())
+            token.setLineNumber( states->GetLineNo(token.getOffset()) );
 
-    for (; iter != tokens.end(); ++iter) {
+        if (target.name == m_searchSource.name && target.scope == m_searchSource.scope) {
+            // full match
+            matches.push_back( token );
 
-        // TODO :: send an event here to report our progress
-        wxFileName f( iter->getFilename() );
-        wxString   msg;
-        msg << _("Parsing expression ") << counter << wxT("/") << tokens.size() << _(" in file: ") << f.GetFullName();
-        if ( !prgDlg->Update(counter, msg) ) {
-            // user clicked 'Cancel'
-            Clear();
-            prgDlg->Destroy();
-            return;
-        }
+        } else if (target.name == m_searchSource.scope && !m_searchSource.isClass) {
+            // source is function, and target is class
+            matches.push_back( token );
 
-        counter++;
-        // reset the result
-        target.Reset();
+        } else if (target.name == m_searchSource.name && m_searchSource.isClass) {
+            // source is class, and target is ctor
+            matches.push_back( token );
 
-        if(!statesPtr || statesPtrFileName != iter->getFilename() ) {
-            // Create new statesPtr
-            CppWordScanner sc(iter->getFilename());
-            statesPtr         = sc.states();
-            statesPtrFileName = iter->getFilename();
+        } else if (!m_onlyDefiniteMatches) {
+            // add it to the possible match list
+            possibleMatches.push_back( token );
         }
+    } else if( !m_onlyDefiniteMatches) {
+        // resolved word failed, add it to the possible list
+        possibleMatches.push_back( token );
+    }
+}
 
-        if(!statesPtr)
-            continue;
+void RefactoringEngine::OnSearchProgress(size_t searchId)
+{
+    // a notification from a previous search?
+    if(!m_search || m_search->GetId() != searchId) return;
+
+    // Resolve the tokens as long as we are within the time slice, then yield to the UI
+    wxStopWatch sw;
+    bool finished(false);
+    bool timeout(false);
+    CppToken::List_t matches, possibleMatches;
+    while(!finished && !timeout) {
+        if(!m_searchFileActive) {
+            m_searchFile = FileResult();
+            if(!m_search->Take(m_searchFile, finished)) break;
+            m_searchToken = m_searchFile.tokens.begin();
+            m_searchFileActive = true;
+        }
 
-        if (DoResolveWord(statesPtr, wxFileName( iter->getFilename() ), iter->getOffset(), iter->getLineNumber(), symname, &target)) {
+        if(!m_searchFile.states) {
+            // the file could not be read
+            m_searchToken = m_searchFile.tokens.end();
+        }
 
-            // set the line number
-            if(statesPtr->states.size() > iter->getOffset())
-                iter->setLineNumber( statesPtr->states[iter->getOffset()].lineNo );
+        for(; m_searchToken != m_searchFile.tokens.end() && !timeout; ++m_searchToken) {
+            DoCheckCandidate(*m_searchToken, matches, possibleMatches);
+            timeout = (sw.Time() >= REFACTORING_TIME_SLICE);
+        }
 
-            if (target.name == rs.name && target.scope == rs.scope) {
-                // full match
-                m_candidates.push_back( *iter );
+        if(m_searchToken == m_searchFile.tokens.end()) {
+            m_searchFile = FileResult();
+            m_searchFileActive = false;
+            ++m_searchFilesDone;
+        }
+    }
 
-            } else if (target.name == rs.scope && !rs.isClass) {
-                // source is function, and target is class
-                m_candidates.push_back( *iter );
+    if(!matches.empty() || !possibleMatches.empty()) {
+        m_candidates.insert(m_candidates.end(), matches.begin(), matches.end());
+        m_possibleCandidates.insert(m_possibleCandidates.end(), possibleMatches.begin(), possibleMatches.end());
 
-            } else if (target.name == rs.name && rs.isClass) {
-                // source is class, and target is ctor
-                m_candidates.push_back( *iter );
+        size_t filesCount = m_search->GetFilesCount();
+        clRefactoringEvent event(wxEVT_REFACTORING_ENGINE_MATCHES);
+        event.SetSearchId(searchId);
+        event.SetMatches(matches);
+        event.SetPossibleMatches(possibleMatches);
+        event.SetProgress(filesCount ? (int)((m_searchFilesDone * 100) / filesCount) : 0);
+        EventNotifier::Get()->ProcessEvent(event);
 
-            } else if (!onlyDefiniteMatches) {
-                // add it to the possible match list
-                m_possibleCandidates.push_back( *iter );
-            }
-        } else if( !onlyDefiniteMatches) {
-            // resolved word failed, add it to the possible list
-            m_possibleCandidates.push_back( *iter );
-        }
+        // a handler might have started another search
+        if(!m_search || m_search->GetId() != searchId) return;
     }
 
-    prgDlg->Destroy();
+    if(finished) {
+        m_search.reset();
+        clRefactoringEvent event(wxEVT_REFACTORING_ENGINE_DONE);
+        event.SetSearchId(searchId);
+        event.SetProgress(100);
+        EventNotifier::Get()->ProcessEvent(event);
+
+    } else if(timeout) {
+        // there is more work, continue after the pending UI events were processed
+        CallAfter(&RefactoringEngine::OnSearchProgress, searchId);
+    }
+    // else: wait for the tasks to notify us
 }
 
 TagEntryPtr RefactoringEngine::SyncSignature(const wxFileName& fn,
@@ -485,8 +770,8 @@ TagEntryPtr RefactoringEngine::SyncSignature(const wxFileName& fn,
     tag->SetSignature(signature);
     return tag;
 }
-
+
 bool RefactoringEngine::IsCacheInitialized() const
-{
+{
     return m_storage.IsCacheReady();
 }
@@ -30,13 +30,13 @@
 #include <wx/filename.h>
 #include <vector>
 #include <list>
+#include <memory>
 #include "entry.h"
 #include "cppwordscanner.h"
 #include "cpptoken.h"
 #include "codelite_exports.h"
 #include "refactoring_storage.h"
-
-class clProgressDlg;
+#include "cl_command_event.h"
 
 //----------------------------------------------------------------------------------
 
@@ -56,21 +56,93 @@ struct RefactorSource {
 };
 
 //-----------------------------------------------------------------------------------
+
+/**
+ * @class clRefactoringEvent
+ * @brief reports the progress of a references search (see RefactoringEngine::FindReferences)
+ */
+class WXDLLIMPEXP_CL clRefactoringEvent : public clCommandEvent
+{
+    size_t m_searchId;
+    CppToken::List_t m_matches;
+    CppToken::List_t m_possibleMatches;
+    int m_progress;
+    bool m_cancelled;
+
+public:
+    clRefactoringEvent(wxEventType commandType = wxEVT_NULL, int winid = 0);
+    clRefactoringEvent(const clRefactoringEvent& event);
+    clRefactoringEvent& operator=(const clRefactoringEvent& src);
+    virtual ~clRefactoringEvent();
+    virtual wxEvent* Clone() const { return new clRefactoringEvent(*this); };
+
+    void SetSearchId(size_t searchId) { this->m_searchId = searchId; }
+    size_t GetSearchId() const { return m_searchId; }
+    void SetMatches(const CppToken::List_t& matches) { this->m_matches = matches; }
+    const CppToken::List_t& GetMatches() const { return m_matches; }
+    void SetPossibleMatches(const CppToken::List_t& possibleMatches) { this->m_possibleMatches = possibleMatches; }
+    const CppToken::List_t& GetPossibleMatches() const { return m_possibleMatches; }
+    void SetProgress(int progress) { this->m_progress = progress; }
+    int GetProgress() const { return m_progress; }
+    void SetCancelled(bool cancelled) { this->m_cancelled = cancelled; }
+    bool IsCancelled() const { return m_cancelled; }
+};
+
+typedef void (wxEvtHandler::*clRefactoringEventFunction)(clRefactoringEvent&);
+#define clRefactoringEventHandler(func) wxEVENT_HANDLER_CAST(clRefactoringEventFunction, func)
+
 extern WXDLLIMPEXP_CL const wxEventType wxEVT_REFACTORING_ENGINE_CACHE_INITIALIZING;
 
-class WXDLLIMPEXP_CL RefactoringEngine
+// A references search confirmed new matches. GetProgress() is the percentage of the files processed so far
+wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxEVT_REFACTORING_ENGINE_MATCHES, clRefactoringEvent);
+
+// A references search is over (see IsCancelled()). The matches of the search are available with
+// RefactoringEngine::GetCandidates() and RefactoringEngine::GetPossibleCandidates()
+wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxEVT_REFACTORING_ENGINE_DONE, clRefactoringEvent);
+
+class RefactoringSearch;
+class WXDLLIMPEXP_CL RefactoringEngine : public wxEvtHandler
 {
+    friend class RefactoringSearch;
+
+public:
+    /**
+     * @brief the text states of a file and the occurrences of the searched symbol in it
+     */
+    struct FileResult {
+        wxString filename;
+        CppToken::List_t tokens;
+        TextStatesPtr states;
+    };
+
+protected:
     std::list<CppToken> m_candidates;
     std::list<CppToken> m_possibleCandidates;
     wxEvtHandler *      m_evtHandler;
     RefactoringStorage  m_storage;
-    
+
+    // The running references search. The tasks prepare the files, the main thread resolves the tokens
+    std::shared_ptr<RefactoringSearch> m_search;
+    size_t m_searchId;
+    wxString m_searchWord;
+    RefactorSource m_searchSource;
+    bool m_onlyDefiniteMatches;
+    FileResult m_searchFile;                   // the file being resolved
+    CppToken::List_t::iterator m_searchToken;  // the next token to resolve in m_searchFile
+    bool m_searchFileActive;
+    size_t m_searchFilesDone;
+
 public:
     static RefactoringEngine* Instance();
-    
+
 protected:
-    clProgressDlg *CreateProgressDialog(const wxString &title, int maxValue);
-    void DoFindReferences(const wxString &symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files, bool onlyDefiniteMatches);
+    size_t DoFindReferences(const wxString &symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files, bool onlyDefiniteMatches);
+    void DoCheckCandidate(CppToken& token, CppToken::List_t& matches, CppToken::List_t& possibleMatches);
+
+    /**
+     * @brief resolve the tokens prepared by the search tasks, for a limited amount of time
+     */
+    void OnSearchProgress(size_t searchId);
 
 private:
     RefactoringEngine();
@@ -118,8 +190,9 @@ public:
      * @param line the symbol is loacted in this file
      * @param pos at that position
      * @param files perform the refactoring on these files
+     * @return the search ID. The candidates are found in the background, see FindReferences()
      */
-    void RenameGlobalSymbol(const wxString &symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files);
+    size_t RenameGlobalSymbol(const wxString &symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files);
 
     /**
      * @param rename local variable
@@ -137,8 +210,21 @@ public:
      * @param line the line where the symbol exists
      * @param pos the position of the symbol (this should be pointing to the *start* of the symbol)
      * @param files list of files to search in
+     * @return the search ID. The search runs in the background: the matches are reported with
+     * wxEVT_REFACTORING_ENGINE_MATCHES events as they are confirmed, then wxEVT_REFACTORING_ENGINE_DONE is sent.
+     * Starting a search cancels the previous one
+     */
+    size_t FindReferences(const wxString &symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files);
+
+    /**
+     * @brief cancel the running references search (if any). wxEVT_REFACTORING_ENGINE_DONE is sent
+     */
+    void CancelSearch();
+
+    /**
+     * @brief is there a references search running?
      */
-    void FindReferences(const wxString &symname, const wxFileName& fn, int line, int pos, const wxFileList_t& files);
+    bool IsSearchRunning() const { return m_search != NULL; }
 
     /**
      * @brief given a location (file:line:pos) use the current location function signature
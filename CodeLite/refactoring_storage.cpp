@@ -34,6 +34,201 @@
 #include "codelite_events.h"
 #include "file_logger.h"
 #include "fileextmanager.h"
+#include "clTaskExecutor.h"
+#include <algorithm>
+#include <deque>
+#include <set>
+
+namespace
+{
+void AppendVarint(std::string& data, size_t value)
+{
+    while(value >= 0x80) {
+        data.push_back((char)((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    data.push_back((char)value);
+}
+
+bool ReadVarint(const unsigned char*& p, const unsigned char* end, size_t& value)
+{
+    value = 0;
+    for(size_t shift = 0; p < end && shift < sizeof(size_t) * 8; shift += 7) {
+        unsigned char byte = *p++;
+        value |= (size_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+/**
+ * @class RefactoringIndexQueue
+ * @brief hand out the files to the indexing tasks and collect their postings for the database writer.
+ * The tasks stop indexing ahead when too many files are waiting for the writer
+ */
+class RefactoringIndexQueue
+{
+    const wxFileList_t& m_files;
+    size_t m_nextFile;
+    size_t m_workers;
+    bool m_stopped;
+    std::deque<RefactoringStorage::FileIndex*> m_indexed;
+    wxMutex m_mutex;
+    wxCondition m_cond;
+
+public:
+    enum { kMaxPending = 256 };
+
+    RefactoringIndexQueue(const wxFileList_t& files)
+        : m_files(files)
+        , m_nextFile(0)
+        , m_workers(0)
+        , m_stopped(false)
+        , m_cond(m_mutex)
+    {
+    }
+
+    ~RefactoringIndexQueue()
+    {
+        for(size_t i = 0; i < m_indexed.size(); ++i) {
+            wxDELETE(m_indexed.at(i));
+        }
+    }
+
+    /**
+     * @brief return the next file to index. Return false when there are no more files
+     */
+    bool Next(wxString& filename)
+    {
+        wxMutexLocker locker(m_mutex);
+        if(m_stopped || m_nextFile >= m_files.size()) return false;
+        // The files list is shared, make a copy of the content
+        filename = m_files.at(m_nextFile++).GetFullPath().c_str();
+        return true;
+    }
+
+    void AddWorker()
+    {
+        wxMutexLocker locker(m_mutex);
+        ++m_workers;
+    }
+
+    /**
+     * @brief a worker is gone: it indexed all the files it could get or it was discarded
+     */
+    void WorkerDone()
+    {
+        wxMutexLocker locker(m_mutex);
+        --m_workers;
+        m_cond.Broadcast();
+    }
+
+    /**
+     * @brief a file was indexed. The queue takes the ownership of 'index'
+     */
+    void Done(RefactoringStorage::FileIndex* index)
+    {
+        wxMutexLocker locker(m_mutex);
+        while(!m_stopped && m_indexed.size() >= kMaxPending) {
+            m_cond.Wait();
+        }
+
+        if(m_stopped) {
+            wxDELETE(index);
+        } else {
+            m_indexed.push_back(index);
+        }
+        m_cond.Broadcast();
+    }
+
+    /**
+     * @brief wait up to 'timeoutMs' for indexed files and move them into 'indexed'
+     * @return false once all the workers are gone and everything was taken
+     */
+    bool Take(std::vector<RefactoringStorage::FileIndex*>& indexed, long timeoutMs)
+    {
+        wxMutexLocker locker(m_mutex);
+        if(m_indexed.empty() && m_workers) {
+            m_cond.WaitTimeout(timeoutMs);
+        }
+
+        indexed.insert(indexed.end(), m_indexed.begin(), m_indexed.end());
+        m_indexed.clear();
+        m_cond.Broadcast();
+        return !indexed.empty() || m_workers;
+    }
+
+    /**
+     * @brief stop handing out files and wait for all the workers to be gone
+     */
+    void Stop()
+    {
+        wxMutexLocker locker(m_mutex);
+        m_stopped = true;
+        m_cond.Broadcast();
+        while(m_workers > 0) {
+            m_cond.Wait();
+        }
+    }
+};
+
+class RefactoringIndexTask : public clTask
+{
+    RefactoringIndexQueue* m_queue;
+
+public:
+    RefactoringIndexTask(RefactoringIndexQueue* queue)
+        : clTask(clTask::kLow)
+        , m_queue(queue)
+    {
+        m_queue->AddWorker();
+    }
+    // The task is deleted once it ran, or when the executor discards it
+    virtual ~RefactoringIndexTask() { m_queue->WorkerDone(); }
+
+    virtual void Run()
+    {
+        wxString filename;
+        while(m_queue->Next(filename)) {
+            RefactoringStorage::FileIndex* index = new RefactoringStorage::FileIndex();
+            RefactoringStorage::IndexFile(filename, *index);
+            m_queue->Done(index);
+        }
+    }
+};
+}
+
+/**
+ * @class RefactoringUpdateFileTask
+ * @brief index a saved file again
+ */
+class RefactoringUpdateFileTask : public clTask
+{
+    wxString m_workspaceFile;
+    wxString m_filename;
+
+public:
+    RefactoringUpdateFileTask(const wxString& workspaceFile, const wxString& filename)
+        : clTask(clTask::kLow)
+        , m_workspaceFile(workspaceFile.c_str())
+        , m_filename(filename.c_str())
+    {
+    }
+    virtual ~RefactoringUpdateFileTask() {}
+
+    virtual void Run()
+    {
+        RefactoringStorage storage;
+        storage.OpenCache(m_workspaceFile);
+
+        // Files that were never indexed are indexed when they are searched
+        if(storage.GetFileID(m_filename) == wxNOT_FOUND) return;
+
+        RefactoringStorage::FileIndex index;
+        RefactoringStorage::IndexFile(m_filename, index);
+        storage.StoreIndex(index, true);
+    }
+};
 
 class CppTokenCacheMakerThread : public wxThread
 {
@@ -78,52 +273,38 @@ public:
         evtStatus1.SetString(m_workspaceFile);
         EventNotifier::Get()->AddPendingEvent(evtStatus1);
 
-        size_t count = 0;
-
-        storage.Begin();
-        wxFileList_t::const_iterator iter = m_files.begin();
-        for(; iter != m_files.end(); ++iter) {
-
-            if(TestDestroy()) {
-                // we requested to stop
-                storage.Commit();
-                wxCommandEvent evtStatus2(wxEVT_REFACTORING_ENGINE_CACHE_INITIALIZING);
-                evtStatus2.SetInt(100);
-                evtStatus2.SetString(m_workspaceFile);
-                EventNotifier::Get()->AddPendingEvent(evtStatus2);
-                return NULL;
-            }
-
-            if(!TagsManagerST::Get()->IsValidCtagsFile((*iter))) {
-                continue;
-            }
+        // Index only the files that were modified since they were indexed
+        wxFileList_t files = storage.FilterUpToDateFiles(m_files);
 
-            ++count;
-            if(count % 100 == 0) {
-                storage.Commit();
-                storage.Begin();
-            }
+        // Tokenize the files in parallel, this thread is the only database writer
+        static clTaskQueue* tasksQueue = clTaskExecutor::Get()->CreateQueue("Refactoring Indexer", false);
+        RefactoringIndexQueue queue(files);
+        // GetWorkersCount() starts the executor threads if needed
+        size_t workers = std::min(clTaskExecutor::Get()->GetWorkersCount(), files.size());
+        for(size_t i = 0; i < workers; ++i) {
+            tasksQueue->Submit(new RefactoringIndexTask(&queue));
+        }
 
-            wxString fullpath = iter->GetFullPath();
-            if(!storage.IsFileUpToDate(fullpath)) {
-                CppWordScanner scanner(fullpath);
-                CppToken::List_t tokens = scanner.tokenize();
-
-                if(false) {
-                    CppToken::List_t::iterator tokIter = tokens.begin();
-                    for(; tokIter != tokens.end(); ++tokIter) {
-                        wxPrintf("%s | %s | %d\n",
-                                 tokIter->getFilename().c_str(),
-                                 tokIter->getName().c_str(),
-                                 (int)tokIter->getOffset());
-                    }
+        size_t count = 0;
+        std::vector<RefactoringStorage::FileIndex*> indexed;
+        storage.Begin();
+        while(!TestDestroy() && queue.Take(indexed, 100)) {
+            for(size_t i = 0; i < indexed.size(); ++i) {
+                storage.StoreIndex(*indexed.at(i), false);
+                wxDELETE(indexed.at(i));
+
+                if(++count % 100 == 0) {
+                    storage.Commit();
+                    storage.Begin();
                 }
-
-                storage.StoreTokens(fullpath, tokens, false);
             }
+            indexed.clear();
         }
 
+        // If we requested to stop, the files that were not indexed yet are dropped
+        queue.Stop();
         storage.Commit();
+
         wxCommandEvent evtStatus2(wxEVT_REFACTORING_ENGINE_CACHE_INITIALIZING);
         evtStatus2.SetInt(100);
         evtStatus2.SetString(m_workspaceFile);
@@ -145,6 +326,8 @@ RefactoringStorage::RefactoringStorage()
                                       wxCommandEventHandler(RefactoringStorage::OnThreadStatus),
                                       NULL,
                                       this);
+        EventNotifier::Get()->Connect(
+            wxEVT_FILE_SAVED, clCommandEventHandler(RefactoringStorage::OnFileSaved), NULL, this);
     }
 }
 
@@ -159,34 +342,81 @@ RefactoringStorage::~RefactoringStorage()
                                          wxCommandEventHandler(RefactoringStorage::OnThreadStatus),
                                          NULL,
                                          this);
+        EventNotifier::Get()->Disconnect(
+            wxEVT_FILE_SAVED, clCommandEventHandler(RefactoringStorage::OnFileSaved), NULL, this);
 
         JoinWorkerThread();
     }
 }
 
+void RefactoringStorage::Postings::Add(size_t offset, size_t line)
+{
+    // Tokens come ordered by their offset so the deltas are small. Unsigned arithmetic wraps around,
+    // so an occurrence out of order is still decoded correctly (it just takes more bytes)
+    AppendVarint(data, offset - lastOffset);
+    AppendVarint(data, line - lastLine);
+    lastOffset = offset;
+    lastLine = line;
+}
+
+void RefactoringStorage::IndexTokens(const CppToken::List_t& tokens, FileIndex& index)
+{
+    CppToken::List_t::const_iterator iter = tokens.begin();
+    for(; iter != tokens.end(); ++iter) {
+        index.words[iter->getName()].Add(iter->getOffset(), iter->getLineNumber());
+    }
+}
+
+void RefactoringStorage::IndexFile(const wxString& filename, FileIndex& index)
+{
+    // The index is stored by another thread, make a copy of the content
+    index.filename = filename.c_str();
+    CppWordScanner scanner(filename);
+    IndexTokens(scanner.tokenize(), index);
+}
+
 void RefactoringStorage::StoreTokens(const wxString& filename, const CppToken::List_t& tokens, bool startTx)
+{
+    FileIndex index;
+    index.filename = filename;
+    IndexTokens(tokens, index);
+    StoreIndex(index, startTx);
+}
+
+void RefactoringStorage::StoreIndex(const FileIndex& index, bool startTx)
 {
     if(!IsCacheReady() || !m_db.IsOpen()) {
         return;
     }
 
-    if(!m_db.IsOpen()) return;
-
     try {
         if(startTx) {
             Begin();
         }
-        
-        wxLongLong fileId = GetFileID(filename);
+
+        wxLongLong fileId = GetFileID(index.filename);
         if(fileId != wxNOT_FOUND) {
             DoDeleteFile(fileId);
-        } 
-        
+        }
+
         // Insert a match to the FILES table
-        fileId = DoUpdateFileTimestamp(filename);
-        CppToken::List_t::const_iterator iter = tokens.begin();
-        for(; iter != tokens.end(); ++iter) {
-            iter->store(&m_db, fileId);
+        fileId = DoUpdateFileTimestamp(index.filename);
+        if(fileId != wxNOT_FOUND) {
+            // One row per word: all its occurrences in this file
+            wxSQLite3Statement st =
+                m_db.PrepareStatement("REPLACE INTO POSTINGS (WORD_ID, FILE_ID, DATA) VALUES(?, ?, ?)");
+            std::map<wxString, Postings>::const_iterator iter = index.words.begin();
+            for(; iter != index.words.end(); ++iter) {
+                wxLongLong wordId = DoGetWordID(iter->first, true);
+                if(wordId == wxNOT_FOUND) continue;
+
+                const std::string& data = iter->second.data;
+                st.Bind(1, wordId);
+                st.Bind(2, fileId);
+                st.Bind(3, (const unsigned char*)data.c_str(), (int)data.length());
+                st.ExecuteUpdate();
+                st.Reset();
+            }
         }
 
         if(startTx) {
@@ -211,16 +441,22 @@ void RefactoringStorage::Open(const wxString& workspacePath)
         m_db.Close();
     }
 
-    static const wxString CURR_SCHEMA = "1.0.0";
+    static const wxString CURR_SCHEMA = "2.0.0";
+    m_wordIds.clear();
     m_db.Open(fnWorkspace.GetFullPath());
+    // The cache is shared by the main thread and the indexing threads
+    m_db.SetBusyTimeout(1000);
     if(GetSchemaVersion() != CURR_SCHEMA) {
         // Drop the tables and recreate the schema
         try {
             m_db.ExecuteUpdate("drop table if exists REFACTORING_SCHEMA");
             m_db.ExecuteUpdate("drop table if exists TOKENS_TABLE");
+            m_db.ExecuteUpdate("drop table if exists WORDS");
+            m_db.ExecuteUpdate("drop table if exists POSTINGS");
             m_db.ExecuteUpdate("drop table if exists FILES");
             m_db.ExecuteUpdate("drop index if exists TOKENS_TABLE_IDX1");
             m_db.ExecuteUpdate("drop index if exists TOKENS_TABLE_IDX2");
+            m_db.ExecuteUpdate("drop index if exists POSTINGS_IDX1");
             m_db.ExecuteUpdate("drop index if exists FILES_IDX1");
         } catch(wxSQLite3Exception& e) {
             wxUnusedVar(e);
@@ -237,13 +473,15 @@ void RefactoringStorage::Open(const wxString& workspacePath)
         m_db.ExecuteUpdate("PRAGMA temp_store = MEMORY");
         m_db.ExecuteUpdate("create table if not exists REFACTORING_SCHEMA (VERSION string primary key)");
 
-        m_db.ExecuteUpdate("create table if not exists TOKENS_TABLE(ID INTEGER PRIMARY KEY AUTOINCREMENT,"
-                           "                                        NAME VARCHAR(128),"
-                           "                                        OFFSET INTEGER,"
-                           "                                        FILE_ID INTEGER,"
-                           "                                        LINE_NUMBER INTEGER)");
-        m_db.ExecuteUpdate("create index if not exists TOKENS_TABLE_IDX1 on TOKENS_TABLE(NAME)");
-        m_db.ExecuteUpdate("create index if not exists TOKENS_TABLE_IDX2 on TOKENS_TABLE(FILE_ID)");
+        m_db.ExecuteUpdate("create table if not exists WORDS (ID INTEGER PRIMARY KEY AUTOINCREMENT, NAME "
+                           "VARCHAR(128) UNIQUE)");
+
+        // A word lookup is a single range scan of the primary key index
+        m_db.ExecuteUpdate("create table if not exists POSTINGS(WORD_ID INTEGER,"
+                           "                                    FILE_ID INTEGER,"
+                           "                                    DATA BLOB,"
+                           "                                    PRIMARY KEY(WORD_ID, FILE_ID))");
+        m_db.ExecuteUpdate("create index if not exists POSTINGS_IDX1 on POSTINGS(FILE_ID)");
 
         m_db.ExecuteUpdate("create table if not exists FILES (ID INTEGER PRIMARY KEY AUTOINCREMENT, FILE_NAME "
                            "VARCHAR(256), LAST_UPDATED INTEGER)");
@@ -301,9 +539,9 @@ void RefactoringStorage::DoDeleteFile(wxLongLong fileID)
             st.ExecuteUpdate();
         }
 
-        // remove all tokens for the given file
+        // remove all postings for the given file
         {
-            wxSQLite3Statement st = m_db.PrepareStatement("delete from TOKENS_TABLE where FILE_ID=?");
+            wxSQLite3Statement st = m_db.PrepareStatement("delete from POSTINGS where FILE_ID=?");
             st.Bind(1, fileID);
             st.ExecuteUpdate();
         }
@@ -318,17 +556,51 @@ void RefactoringStorage::Match(const wxString& symname, const wxString& filename
         return;
     }
 
+    UpdateFile(filename);
+
+    wxLongLong fileID = GetFileID(filename);
+    if(fileID == wxNOT_FOUND) return;
+
+    CppToken::List_t list;
+    try {
+        wxLongLong wordID = DoGetWordID(symname, false);
+        if(wordID == wxNOT_FOUND) return;
+
+        wxSQLite3Statement st = m_db.PrepareStatement("SELECT DATA FROM POSTINGS WHERE WORD_ID=? AND FILE_ID=?");
+        st.Bind(1, wordID);
+        st.Bind(2, fileID);
+        wxSQLite3ResultSet res = st.ExecuteQuery();
+        if(res.NextRow()) {
+            int len = 0;
+            const unsigned char* data = res.GetBlob(0, len);
+            DoDecodePostings(symname, filename, data, len, list);
+        }
+
+    } catch(wxSQLite3Exception& e) {
+        wxUnusedVar(e);
+    }
+    matches.addToken(symname, list);
+}
+
+void RefactoringStorage::UpdateFile(const wxString& filename)
+{
+    if(!IsCacheReady() || !m_db.IsOpen()) {
+        return;
+    }
+
     if(!IsFileUpToDate(filename)) {
         // update the cache
         CppWordScanner tmpScanner(filename);
         CppToken::List_t tokens_list = tmpScanner.tokenize();
         StoreTokens(filename, tokens_list, true);
     }
-    
-    wxLongLong fileID = GetFileID(filename);
-    if(fileID == wxNOT_FOUND) return;
-    CppToken::List_t list = CppToken::loadByNameAndFile(&m_db, symname, fileID);
-    matches.addToken(symname, list);
+}
+
+void RefactoringStorage::OpenCache(const wxString& workspaceFile)
+{
+    m_workspaceFile = workspaceFile;
+    Open(m_workspaceFile);
+    m_cacheStatus = CACHE_READY;
 }
 
 bool RefactoringStorage::IsFileUpToDate(const wxString& filename)
@@ -373,10 +645,19 @@ wxFileList_t RefactoringStorage::FilterUpToDateFiles(const wxFileList_t& files)
     if(!IsCacheReady() || !m_db.IsOpen()) {
         return files;
     }
+    // Load the timestamps with a single query
+    std::map<wxString, time_t> timestamps;
+    DoLoadTimestamps(timestamps);
+
     wxFileList_t res;
     wxFileList_t::const_iterator iter = files.begin();
     for(; iter != files.end(); ++iter) {
-        if(TagsManagerST::Get()->IsValidCtagsFile((*iter)) && !IsFileUpToDate(iter->GetFullPath())) {
+        if(!TagsManagerST::Get()->IsValidCtagsFile((*iter)) || !iter->FileExists()) {
+            continue;
+        }
+
+        std::map<wxString, time_t>::const_iterator tsIter = timestamps.find(iter->GetFullPath());
+        if(tsIter == timestamps.end() || tsIter->second < iter->GetModificationTime().GetTicks()) {
             res.push_back(*iter);
         }
     }
@@ -389,19 +670,142 @@ CppToken::List_t RefactoringStorage::GetTokens(const wxString& symname, const wx
         return CppToken::List_t();
     }
 
-    CppToken::List_t tokens = CppToken::loadByName(&m_db, symname);
-
     // Include only tokens which belongs to the current list of files
     // unless the filelist is empty and in this case, we ignore this filter
-    if(filelist.empty()) {
-        return tokens;
+    std::set<wxString> files;
+    wxFileList_t::const_iterator fileIter = filelist.begin();
+    for(; fileIter != filelist.end(); ++fileIter) {
+        files.insert(fileIter->GetFullPath());
     }
 
-    CppToken::List_t::iterator iter = std::remove_if(tokens.begin(), tokens.end(), CppToken::RemoveIfNotIn(filelist));
-    tokens.resize(std::distance(tokens.begin(), iter));
+    CppToken::List_t tokens;
+    try {
+        wxLongLong wordID = DoGetWordID(symname, false);
+        if(wordID == wxNOT_FOUND) {
+            return tokens;
+        }
+
+        wxSQLite3Statement stFile = m_db.PrepareStatement("SELECT FILE_NAME FROM FILES WHERE ID=? LIMIT 1");
+        wxSQLite3Statement st = m_db.PrepareStatement("SELECT FILE_ID, DATA FROM POSTINGS WHERE WORD_ID=?");
+        st.Bind(1, wordID);
+        wxSQLite3ResultSet res = st.ExecuteQuery();
+        while(res.NextRow()) {
+            wxString filename;
+            stFile.Bind(1, res.GetInt64(0));
+            wxSQLite3ResultSet resFile = stFile.ExecuteQuery();
+            if(resFile.NextRow()) {
+                filename = resFile.GetString(0);
+            }
+            stFile.Reset();
+
+            if(filename.IsEmpty() || (!files.empty() && files.count(filename) == 0)) {
+                continue;
+            }
+
+            int len = 0;
+            const unsigned char* data = res.GetBlob(1, len);
+            DoDecodePostings(symname, filename, data, len, tokens);
+        }
+
+    } catch(wxSQLite3Exception& e) {
+        wxUnusedVar(e);
+    }
     return tokens;
 }
 
+void RefactoringStorage::DoDecodePostings(const wxString& word,
+                                          const wxString& filename,
+                                          const unsigned char* data,
+                                          int len,
+                                          CppToken::List_t& tokens)
+{
+    if(!data || len <= 0) return;
+
+    const unsigned char* p = data;
+    const unsigned char* end = data + len;
+    size_t offset = 0;
+    size_t line = 0;
+    size_t delta = 0;
+    while(p < end) {
+        if(!ReadVarint(p, end, delta)) break;
+        offset += delta;
+        if(!ReadVarint(p, end, delta)) break;
+        line += delta;
+
+        CppToken token;
+        token.setName(word);
+        token.setFilename(filename);
+        token.setOffset(offset);
+        token.setLineNumber(line);
+        tokens.push_back(token);
+    }
+}
+
+wxLongLong RefactoringStorage::DoGetWordID(const wxString& word, bool create)
+{
+    std::map<wxString, wxLongLong>::const_iterator iter = m_wordIds.find(word);
+    if(iter != m_wordIds.end()) {
+        return iter->second;
+    }
+
+    try {
+        if(create) {
+            // Another connection might add the same word, so never fail on it
+            wxSQLite3Statement st = m_db.PrepareStatement("INSERT OR IGNORE INTO WORDS (ID, NAME) VALUES (NULL, ?)");
+            st.Bind(1, word);
+            st.ExecuteUpdate();
+        }
+
+        wxSQLite3Statement st = m_db.PrepareStatement("SELECT ID FROM WORDS WHERE NAME=? LIMIT 1");
+        st.Bind(1, word);
+        wxSQLite3ResultSet res = st.ExecuteQuery();
+        if(res.NextRow()) {
+            wxLongLong wordId = res.GetInt64(0);
+            m_wordIds.insert(std::make_pair(word, wordId));
+            return wordId;
+        }
+
+    } catch(wxSQLite3Exception& e) {
+        wxUnusedVar(e);
+    }
+    return wxNOT_FOUND;
+}
+
+void RefactoringStorage::DoLoadTimestamps(std::map<wxString, time_t>& timestamps)
+{
+    try {
+        wxSQLite3ResultSet res = m_db.ExecuteQuery("SELECT FILE_NAME, LAST_UPDATED FROM FILES");
+        while(res.NextRow()) {
+            timestamps[res.GetString(0)] = res.GetInt(1);
+        }
+
+    } catch(wxSQLite3Exception& e) {
+        wxUnusedVar(e);
+    }
+}
+
+void RefactoringStorage::OnFileSaved(clCommandEvent& e)
+{
+    e.Skip();
+    if(!IsCacheReady() || m_workspaceFile.IsEmpty()) {
+        return;
+    }
+
+    // Index only C / C++ files
+    switch(FileExtManager::GetType(e.GetFileName())) {
+    case FileExtManager::TypeHeader:
+    case FileExtManager::TypeSourceC:
+    case FileExtManager::TypeSourceCpp:
+        break;
+    default:
+        return;
+    }
+
+    // Update the index in the background, one file at a time
+    static clTaskQueue* tasksQueue = clTaskExecutor::Get()->CreateQueue("Refactoring Updater", true);
+    tasksQueue->Submit(new RefactoringUpdateFileTask(m_workspaceFile, e.GetFileName()));
+}
+
 void RefactoringStorage::OnWorkspaceClosed(wxCommandEvent& e)
 {
     e.Skip();
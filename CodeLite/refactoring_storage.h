@@ -33,21 +33,59 @@
 #include <wx/thread.h>
 #include <wx/filename.h>
 #include <vector>
+#include <string>
+#include <map>
+#include "cl_command_event.h"
 
 class CppTokenCacheMakerThread;
+/**
+ * @class RefactoringStorage
+ * @brief the persistent occurrence index of the workspace words.
+ * For every word and every file it appears in, the index keeps a postings list: the offset and line of each
+ * occurrence, delta encoded as varints in a single blob. Finding the occurrences of a word is a lookup of its ID
+ * followed by a range lookup of its postings
+ */
 class WXDLLIMPEXP_CL RefactoringStorage : public wxEvtHandler
 {
 public:
     enum CacheStatus { CACHE_NOT_READY, CACHE_IN_PROGRESS, CACHE_READY };
 
+    /**
+     * @class Postings
+     * @brief the occurrences of a word in a file
+     */
+    struct Postings {
+        std::string data; // (offset delta, line delta) varint pairs
+        size_t lastOffset;
+        size_t lastLine;
+
+        Postings()
+            : lastOffset(0)
+            , lastLine(0)
+        {
+        }
+        void Add(size_t offset, size_t line);
+    };
+
+    /**
+     * @class FileIndex
+     * @brief the postings of every word of a file
+     */
+    struct FileIndex {
+        wxString filename;
+        std::map<wxString, Postings> words;
+    };
+
 protected:
     wxSQLite3Database m_db;
     wxString m_cacheDb;
     CacheStatus m_cacheStatus;
     wxString m_workspaceFile;
     CppTokenCacheMakerThread* m_thread;
+    std::map<wxString, wxLongLong> m_wordIds; // cache of the WORDS table
 
     friend class CppTokenCacheMakerThread;
+    friend class RefactoringUpdateFileTask;
 
 public:
     RefactoringStorage();
@@ -57,9 +95,26 @@ protected:
     wxLongLong DoUpdateFileTimestamp(const wxString& filename);
     void DoDeleteFile(wxLongLong fileID);
     bool IsFileUpToDate(const wxString& filename);
+    /**
+     * @brief return the ID of 'word', add it to the WORDS table if 'create' is true
+     */
+    wxLongLong DoGetWordID(const wxString& word, bool create);
+    /**
+     * @brief load the indexing time of all the files with a single query
+     */
+    void DoLoadTimestamps(std::map<wxString, time_t>& timestamps);
+    /**
+     * @brief decode the occurrences of 'word' in 'filename' from a postings blob
+     */
+    static void DoDecodePostings(const wxString& word,
+                                 const wxString& filename,
+                                 const unsigned char* data,
+                                 int len,
+                                 CppToken::List_t& tokens);
 
     void OnWorkspaceLoaded(wxCommandEvent& e);
     void OnWorkspaceClosed(wxCommandEvent& e);
+    void OnFileSaved(clCommandEvent& e);
     void OnThreadStatus(wxCommandEvent& e);
     void Open(const wxString& workspacePath);
     void Begin();
@@ -79,6 +134,33 @@ protected:
     
 public:
     bool IsCacheReady() const { return m_cacheStatus == CACHE_READY; }
+    const wxString& GetWorkspaceFile() const { return m_workspaceFile; }
+
+    /**
+     * @brief open a private connection to the (ready) cache of 'workspaceFile'.
+     * This is how worker threads access the cache
+     */
+    void OpenCache(const wxString& workspaceFile);
+
+    /**
+     * @brief tokenize 'filename' again if it was modified since it was cached
+     */
+    void UpdateFile(const wxString& filename);
+
+    /**
+     * @brief tokenize 'filename' and build its postings. Does not access the database
+     */
+    static void IndexFile(const wxString& filename, FileIndex& index);
+
+    /**
+     * @brief build the postings of a list of tokens
+     */
+    static void IndexTokens(const CppToken::List_t& tokens, FileIndex& index);
+
+    /**
+     * @brief replace the postings of a file in the database
+     */
+    void StoreIndex(const FileIndex& index, bool startTx);
     void StoreTokens(const wxString& filename, const CppToken::List_t& tokens, bool startTx);
     void Match(const wxString& symname, const wxString& filename, CppTokensMap& matches);
     void InitializeCache(const wxFileList_t& files);
@@ -27,12 +27,22 @@
 #include <wx/longlong.h>
 #include "tags_storage_sqlite3.h"
 #include <wx/tokenzr.h>
+#include <wx/stopwatch.h>
+#include <algorithm>
 
 //-------------------------------------------------
 // Tags database class implementation
 //-------------------------------------------------
+// Cache size (in KB) used while bulk inserting tags
+#define BULK_INSERT_CACHE_SIZE_KB 65536
+// Number of IDs fetched by a single "ID in (...)" query
+#define FETCH_IDS_CHUNK ((size_t)500)
+
 TagsStorageSQLite::TagsStorageSQLite()
     : ITagsStorage()
+    , m_bulkInsert(false)
+    , m_indexesDeferred(false)
+    , m_bulkCacheSize(0)
 {
     m_db = new clSqliteDB();
     SetUseCache(true);
@@ -40,6 +50,7 @@ TagsStorageSQLite::TagsStorageSQLite()
 
 TagsStorageSQLite::~TagsStorageSQLite()
 {
+    m_symbolIndex.Close();
     if(m_db) {
         m_db->Close();
         delete m_db;
@@ -65,15 +76,18 @@ void TagsStorageSQLite::OpenDatabase(const wxFileName& fileName)
             m_db->SetBusyTimeout(10);
             CreateSchema();
             m_fileName = fileName;
+            if(GetUseSymbolIndex()) m_symbolIndex.Open(m_fileName.GetFullPath());
 
         } else {
             // We have both fileName & m_fileName and they
             // are different, Close previous db
             m_db->Close();
+            m_changedFiles.clear();
             m_db->Open(fileName.GetFullPath());
             m_db->SetBusyTimeout(10);
             CreateSchema();
             m_fileName = fileName;
+            if(GetUseSymbolIndex()) m_symbolIndex.Open(m_fileName.GetFullPath());
         }
 
     } catch(wxSQLite3Exception& e) {
@@ -111,6 +125,20 @@ void TagsStorageSQLite::CreateSchema()
                   "integer);");
         m_db->ExecuteUpdate(sql);
 
+        // The content hash of each file when it was last tagged. Files with the same hash are not re-tagged
+        sql = wxT("create  table if not exists FILES_HASH (file string primary key, size integer, mtime integer, hash "
+                  "string);");
+        m_db->ExecuteUpdate(sql);
+
+        // The indexer output keyed by file, content hash and ctags options. Switching back and forth between
+        // versions of a file (e.g. git branches) does not require the indexer
+        sql = wxT("create  table if not exists TAGS_CACHE (ID INTEGER PRIMARY KEY AUTOINCREMENT, file string, hash "
+                  "string, options string, last_used integer, tags string);");
+        m_db->ExecuteUpdate(sql);
+
+        sql = wxT("CREATE UNIQUE INDEX IF NOT EXISTS TAGS_CACHE_UNIQ on TAGS_CACHE(file, hash, options);");
+        m_db->ExecuteUpdate(sql);
+
         sql = wxT("create  table if not exists MACROS (ID INTEGER PRIMARY KEY AUTOINCREMENT, file string, line "
                   "integer, name string, is_function_like int, replacement string, signature string);");
         m_db->ExecuteUpdate(sql);
@@ -140,36 +168,17 @@ void TagsStorageSQLite::CreateSchema()
         sql = wxT("CREATE UNIQUE INDEX IF NOT EXISTS TAGS_UNIQ on tags(kind, path, signature, typeref);");
         m_db->ExecuteUpdate(sql);
 
-        sql = wxT("CREATE INDEX IF NOT EXISTS KIND_IDX on tags(kind);");
-        m_db->ExecuteUpdate(sql);
-
         sql = wxT("CREATE INDEX IF NOT EXISTS FILE_IDX on tags(file);");
         m_db->ExecuteUpdate(sql);
 
         sql = wxT("CREATE UNIQUE INDEX IF NOT EXISTS MACROS_UNIQ on MACROS(name);");
         m_db->ExecuteUpdate(sql);
 
-        sql = wxT("CREATE INDEX IF NOT EXISTS global_tags_idx_1 on global_tags(name);");
-        m_db->ExecuteUpdate(sql);
-
         sql = wxT("CREATE INDEX IF NOT EXISTS global_tags_idx_2 on global_tags(tag_id);");
         m_db->ExecuteUpdate(sql);
 
         // Create search indexes
-        sql = wxT("CREATE INDEX IF NOT EXISTS TAGS_NAME on tags(name);");
-        m_db->ExecuteUpdate(sql);
-
-        sql = wxT("CREATE INDEX IF NOT EXISTS TAGS_SCOPE on tags(scope);");
-        m_db->ExecuteUpdate(sql);
-
-        sql = wxT("CREATE INDEX IF NOT EXISTS TAGS_PATH on tags(path);");
-        m_db->ExecuteUpdate(sql);
-
-        sql = wxT("CREATE INDEX IF NOT EXISTS TAGS_PARENT on tags(parent);");
-        m_db->ExecuteUpdate(sql);
-
-        sql = wxT("CREATE INDEX IF NOT EXISTS TAGS_TYPEREF on tags(typeref);");
-        m_db->ExecuteUpdate(sql);
+        DoCreateSearchIndexes();
 
         sql = wxT("CREATE INDEX IF NOT EXISTS MACROS_NAME on MACROS(name);");
         m_db->ExecuteUpdate(sql);
@@ -215,6 +224,8 @@ void TagsStorageSQLite::RecreateDatabase()
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS MACROS"));
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS SIMPLE_MACROS"));
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS GLOBAL_TAGS"));
+            m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS FILES_HASH"));
+            m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS TAGS_CACHE"));
 
             // drop indexes
             m_db->ExecuteUpdate(wxT("DROP INDEX IF EXISTS FILES_NAME"));
@@ -231,6 +242,7 @@ void TagsStorageSQLite::RecreateDatabase()
             m_db->ExecuteUpdate(wxT("DROP INDEX IF EXISTS SIMPLE_MACROS_FILE"));
             m_db->ExecuteUpdate(wxT("DROP INDEX IF EXISTS GLOBAL_TAGS_IDX_1"));
             m_db->ExecuteUpdate(wxT("DROP INDEX IF EXISTS GLOBAL_TAGS_IDX_2"));
+            m_db->ExecuteUpdate(wxT("DROP INDEX IF EXISTS TAGS_CACHE_UNIQ"));
 
             // Recreate the schema
             CreateSchema();
@@ -241,6 +253,10 @@ void TagsStorageSQLite::RecreateDatabase()
             m_fileName.Clear();
             OpenDatabase(filename);
         }
+        // The symbol index opened above is only loaded on the first lookup: together with the reset, this is a
+        // single load
+        TagsLiveSymbolIndex::NotifyDatabaseReset(m_fileName.GetFullPath());
+
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
     }
@@ -279,6 +295,7 @@ void TagsStorageSQLite::Store(TagTreePtr tree, const wxFileName& path, bool auto
     try {
         // Create the statements before the execution
         std::vector<TagEntry> updateList;
+        std::set<wxString> files;
 
         // AddChild entries to database
         if(autoCommit) m_db->Begin();
@@ -287,10 +304,13 @@ void TagsStorageSQLite::Store(TagTreePtr tree, const wxFileName& path, bool auto
             // Skip root node
             if(walker.GetNode() == tree->GetRoot()) continue;
 
-            DoInsertTagEntry(walker.GetNode()->GetData());
+            const TagEntry& tag = walker.GetNode()->GetData();
+            DoInsertTagEntry(tag);
+            files.insert(tag.GetFile());
         }
 
         if(autoCommit) m_db->Commit();
+        DoFilesChanged(files);
 
     } catch(wxSQLite3Exception& e) {
         try {
@@ -301,6 +321,117 @@ void TagsStorageSQLite::Store(TagTreePtr tree, const wxFileName& path, bool auto
     }
 }
 
+void TagsStorageSQLite::Store(const TagEntryPtrVector_t& tags, bool autoCommit)
+{
+    if(!m_fileName.IsOk() || tags.empty()) return;
+
+    // Clear the cache once, not per tag
+    bool useCache = GetUseCache();
+    if(useCache) {
+        ClearCache();
+        SetUseCache(false);
+    }
+
+    try {
+        std::set<wxString> files;
+        if(autoCommit) m_db->Begin();
+
+        for(size_t i = 0; i < tags.size(); ++i) {
+            DoInsertTagEntry(*tags.at(i));
+            files.insert(tags.at(i)->GetFile());
+        }
+
+        if(autoCommit) m_db->Commit();
+        DoFilesChanged(files);
+
+    } catch(wxSQLite3Exception& e) {
+        try {
+            if(autoCommit) m_db->Rollback();
+        } catch(wxSQLite3Exception& WXUNUSED(e1)) {
+            wxUnusedVar(e);
+        }
+    }
+    SetUseCache(useCache);
+}
+
+void TagsStorageSQLite::BeginBulkInsert(bool deferIndexes)
+{
+    if(m_bulkInsert) return;
+    m_bulkInsert = true;
+    m_indexesDeferred = false;
+
+    try {
+        // journal_mode and synchronous are already OFF for this connection (see CreateSchema),
+        // give the bulk insert a larger page cache
+        wxSQLite3ResultSet rs = m_db->ExecuteQuery(wxT("PRAGMA cache_size"));
+        m_bulkCacheSize = rs.NextRow() ? rs.GetInt(0) : 0;
+        rs.Finalize();
+        m_db->ExecuteUpdate(wxString::Format(wxT("PRAGMA cache_size = -%d;"), BULK_INSERT_CACHE_SIZE_KB));
+
+        if(deferIndexes) {
+            // Only drop the indexes when there is nothing to search yet, otherwise the readers
+            // would lose their indexes for the duration of the retag
+            wxSQLite3ResultSet tagsRs = m_db->ExecuteQuery(wxT("select ID from tags limit 1"));
+            bool isEmpty = !tagsRs.NextRow();
+            tagsRs.Finalize();
+            if(isEmpty) {
+                DoDropSearchIndexes();
+                m_indexesDeferred = true;
+            }
+        }
+    } catch(wxSQLite3Exception& e) {
+        CL_WARNING("TagsStorageSQLite::BeginBulkInsert: %s", e.GetMessage());
+    }
+}
+
+void TagsStorageSQLite::EndBulkInsert()
+{
+    if(!m_bulkInsert) return;
+    m_bulkInsert = false;
+
+    try {
+        if(m_indexesDeferred) {
+            // Build the indexes in a single pass over the table
+            wxStopWatch sw;
+            DoCreateSearchIndexes();
+            CL_DEBUG("TagsStorageSQLite: search indexes re-created in %ld ms", sw.Time());
+        }
+
+        if(m_bulkCacheSize != 0) {
+            m_db->ExecuteUpdate(wxString::Format(wxT("PRAGMA cache_size = %ld;"), m_bulkCacheSize));
+        }
+    } catch(wxSQLite3Exception& e) {
+        CL_WARNING("TagsStorageSQLite::EndBulkInsert: %s", e.GetMessage());
+    }
+    m_indexesDeferred = false;
+}
+
+// The indexes used for searching the tags. Storing tags does not need them (deleting
+// tags by file uses FILE_IDX and the unique index defines the "insert or replace" semantics)
+static const wxChar* s_searchIndexes[][2] = {
+    { wxT("KIND_IDX"), wxT("CREATE INDEX IF NOT EXISTS KIND_IDX on tags(kind);") },
+    { wxT("global_tags_idx_1"), wxT("CREATE INDEX IF NOT EXISTS global_tags_idx_1 on global_tags(name);") },
+    { wxT("TAGS_NAME"), wxT("CREATE INDEX IF NOT EXISTS TAGS_NAME on tags(name);") },
+    { wxT("TAGS_SCOPE"), wxT("CREATE INDEX IF NOT EXISTS TAGS_SCOPE on tags(scope);") },
+    { wxT("TAGS_PATH"), wxT("CREATE INDEX IF NOT EXISTS TAGS_PATH on tags(path);") },
+    { wxT("TAGS_PARENT"), wxT("CREATE INDEX IF NOT EXISTS TAGS_PARENT on tags(parent);") },
+    { wxT("TAGS_TYPEREF"), wxT("CREATE INDEX IF NOT EXISTS TAGS_TYPEREF on tags(typeref);") },
+};
+
+void TagsStorageSQLite::DoCreateSearchIndexes()
+{
+    for(size_t i = 0; i < sizeof(s_searchIndexes) / sizeof(s_searchIndexes[0]); ++i) {
+        m_db->ExecuteUpdate(s_searchIndexes[i][1]);
+    }
+}
+
+void TagsStorageSQLite::DoDropSearchIndexes()
+{
+    for(size_t i = 0; i < sizeof(s_searchIndexes) / sizeof(s_searchIndexes[0]); ++i) {
+        m_db->ExecuteUpdate(wxString() << wxT("DROP INDEX IF EXISTS ") << s_searchIndexes[i][0]);
+    }
+}
+
 void TagsStorageSQLite::SelectTagsByFile(const wxString& file, std::vector<TagEntryPtr>& tags, const wxFileName& path)
 {
     // Incase empty file path is provided, use the current file name
@@ -335,7 +466,15 @@ void TagsStorageSQLite::DeleteByFileName(const wxFileName& path, const wxString&
         CL_DEBUG("TagsStorageSQLite: DeleteByFileName: '%s'", sql);
         m_db->ExecuteUpdate(sql);
 
+        // The file has no tags anymore, make sure it is not skipped as "unchanged" on the next retag
+        sql = wxString::Format(wxT("Delete from FILES_HASH where file='%s'"), fileName.GetData());
+        m_db->ExecuteUpdate(sql);
+
         if(autoCommit) m_db->Commit();
+
+        std::set<wxString> files;
+        files.insert(fileName);
+        DoFilesChanged(files);
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
         if(autoCommit) m_db->Rollback();
@@ -460,6 +599,9 @@ void TagsStorageSQLite::DeleteByFilePrefix(const wxFileName& dbpath, const wxStr
         sql << wxT("delete from tags where file like '") << name << wxT("%%' ESCAPE '^' ");
         m_db->ExecuteUpdate(sql);
 
+        // We dont know which files were affected
+        TagsLiveSymbolIndex::NotifyDatabaseReset(m_fileName.GetFullPath());
+
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
     }
@@ -492,19 +634,24 @@ void TagsStorageSQLite::DeleteFromFiles(const wxArrayString& files)
         return;
     }
 
-    wxString query;
-    query << wxT("delete from FILES where file in (");
-
+    wxString filesList;
     for(size_t i = 0; i < files.GetCount(); i++) {
-        query << wxT("'") << files.Item(i) << wxT("',");
+        filesList << wxT("'") << files.Item(i) << wxT("',");
     }
 
     // remove last ','
-    query.RemoveLast();
-    query << wxT(")");
+    filesList.RemoveLast();
+
+    wxString query;
+    query << wxT("delete from FILES where file in (") << filesList << wxT(")");
+
+    // The content hash goes together with the file entry
+    wxString hashQuery;
+    hashQuery << wxT("delete from FILES_HASH where file in (") << filesList << wxT(")");
 
     try {
         m_db->ExecuteQuery(query);
+        m_db->ExecuteUpdate(hashQuery);
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
     }
@@ -523,6 +670,10 @@ void TagsStorageSQLite::DeleteFromFilesByPrefix(const wxFileName& dbpath, const
         sql << wxT("delete from FILES where file like '") << name << wxT("%%' ESCAPE '^' ");
         m_db->ExecuteUpdate(sql);
 
+        sql.Clear();
+        sql << wxT("delete from FILES_HASH where file like '") << name << wxT("%%' ESCAPE '^' ");
+        m_db->ExecuteUpdate(sql);
+
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
     }
@@ -647,6 +798,20 @@ void TagsStorageSQLite::GetTagsByScopeAndName(const wxString& scope,
 {
     if(name.IsEmpty()) return;
 
+    TagsSymbolIndex* index = DoGetSymbolIndex();
+    if(index) {
+        std::vector<int> ids;
+        index->Find(name,
+                    partialNameAllowed,
+                    !m_enableCaseInsensitive,
+                    scope.IsEmpty() ? wxString(wxT("<global>")) : scope,
+                    wxArrayString(),
+                    GetSingleSearchLimit(),
+                    ids);
+        DoFetchTagsByIds(ids, tags);
+        return;
+    }
+
     wxString sql;
     sql << wxT("select * from tags where ");
 
@@ -833,6 +998,10 @@ int TagsStorageSQLite::DeleteFileEntry(const wxString& filename)
         statement.Bind(1, filename);
         statement.ExecuteUpdate();
 
+        wxSQLite3Statement hashStatement = m_db->GetPrepareStatement(wxT("DELETE FROM FILES_HASH WHERE FILE=?"));
+        hashStatement.Bind(1, filename);
+        hashStatement.ExecuteUpdate();
+
     } catch(wxSQLite3Exception& exc) {
         if(exc.ErrorCodeAsString(exc.GetErrorCode()) == wxT("SQLITE_CONSTRAINT")) return TagExist;
         return TagError;
@@ -870,6 +1039,124 @@ int TagsStorageSQLite::UpdateFileEntry(const wxString& filename, int timestamp)
     return TagOk;
 }
 
+void TagsStorageSQLite::GetFilesHash(std::map<wxString, FileHashEntry>& entries)
+{
+    try {
+        wxSQLite3ResultSet res = m_db->ExecuteQuery(wxT("select file, size, mtime, hash from FILES_HASH"));
+        while(res.NextRow()) {
+            FileHashEntry entry;
+            entry.file = res.GetString(0);
+            entry.size = res.GetInt(1);
+            entry.mtime = res.GetInt(2);
+            entry.hash = res.GetString(3);
+            entries.insert(std::make_pair(entry.file, entry));
+        }
+
+    } catch(wxSQLite3Exception& e) {
+        wxUnusedVar(e);
+    }
+}
+
+bool TagsStorageSQLite::GetFileHash(const wxString& filename, FileHashEntry& entry)
+{
+    try {
+        wxSQLite3Statement statement =
+            m_db->GetPrepareStatement(wxT("select file, size, mtime, hash from FILES_HASH where file=?"));
+        statement.Bind(1, filename);
+        wxSQLite3ResultSet res = statement.ExecuteQuery();
+        if(res.NextRow()) {
+            entry.file = res.GetString(0);
+            entry.size = res.GetInt(1);
+            entry.mtime = res.GetInt(2);
+            entry.hash = res.GetString(3);
+            return true;
+        }
+
+    } catch(wxSQLite3Exception& e) {
+        wxUnusedVar(e);
+    }
+    return false;
+}
+
+int TagsStorageSQLite::StoreFileHash(const FileHashEntry& entry)
+{
+    try {
+        wxSQLite3Statement statement =
+            m_db->GetPrepareStatement(wxT("INSERT OR REPLACE INTO FILES_HASH VALUES(?, ?, ?, ?)"));
+        statement.Bind(1, entry.file);
+        statement.Bind(2, (int)entry.size);
+        statement.Bind(3, (int)entry.mtime);
+        statement.Bind(4, entry.hash);
+        statement.ExecuteUpdate();
+
+    } catch(wxSQLite3Exception& exc) {
+        return TagError;
+    }
+    return TagOk;
+}
+
+bool TagsStorageSQLite::GetCachedTags(const wxString& filename,
+                                      const wxString& hash,
+                                      const wxString& optionsHash,
+                                      wxString& tags)
+{
+    try {
+        wxSQLite3Statement statement = m_db->GetPrepareStatement(
+            wxT("select ID, tags from TAGS_CACHE where file=? and hash=? and options=?"));
+        statement.Bind(1, filename);
+        statement.Bind(2, hash);
+        statement.Bind(3, optionsHash);
+        wxSQLite3ResultSet res = statement.ExecuteQuery();
+        if(!res.NextRow()) return false;
+
+        int id = res.GetInt(0);
+        tags = res.GetString(1);
+
+        // Mark the entry as recently used so it wont be pruned
+        wxSQLite3Statement touch = m_db->GetPrepareStatement(wxT("update TAGS_CACHE set last_used=? where ID=?"));
+        touch.Bind(1, (int)time(NULL));
+        touch.Bind(2, id);
+        touch.ExecuteUpdate();
+        return true;
+
+    } catch(wxSQLite3Exception& e) {
+        wxUnusedVar(e);
+    }
+    return false;
+}
+
+// Number of versions of the same file we keep in the tags cache
+#define TAGS_CACHE_VERSIONS_PER_FILE 4
+
+void TagsStorageSQLite::StoreCachedTags(const wxString& filename,
+                                        const wxString& hash,
+                                        const wxString& optionsHash,
+                                        const wxString& tags)
+{
+    try {
+        wxSQLite3Statement statement =
+            m_db->GetPrepareStatement(wxT("INSERT OR REPLACE INTO TAGS_CACHE VALUES(NULL, ?, ?, ?, ?, ?)"));
+        statement.Bind(1, filename);
+        statement.Bind(2, hash);
+        statement.Bind(3, optionsHash);
+        statement.Bind(4, (int)time(NULL));
+        statement.Bind(5, tags);
+        statement.ExecuteUpdate();
+
+        // Keep only the most recent versions of this file
+        wxSQLite3Statement prune = m_db->GetPrepareStatement(
+            wxT("delete from TAGS_CACHE where file=? and ID not in (select ID from TAGS_CACHE where file=? order by "
+                "last_used desc, ID desc limit ?)"));
+        prune.Bind(1, filename);
+        prune.Bind(2, filename);
+        prune.Bind(3, TAGS_CACHE_VERSIONS_PER_FILE);
+        prune.ExecuteUpdate();
+
+    } catch(wxSQLite3Exception& e) {
+        wxUnusedVar(e);
+    }
+}
+
 int TagsStorageSQLite::DoInsertTagEntry(const TagEntry& tag)
 {
     // If this node is a dummy, (IsOk() == false) we dont insert it to database
@@ -881,7 +1168,7 @@ int TagsStorageSQLite::DoInsertTagEntry(const TagEntry& tag)
     }
 
     try {
-        wxSQLite3Statement statement = m_db->GetPrepareStatement(
+        wxSQLite3Statement& statement = m_db->GetCachedStatement(
             wxT("INSERT OR REPLACE INTO TAGS VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
         statement.Bind(1, tag.GetName());
         statement.Bind(2, tag.GetFile());
@@ -1207,6 +1494,18 @@ void TagsStorageSQLite::GetTagsByScopeAndName(const wxArrayString& scope,
     }
 
     if(scopes.IsEmpty() == false) {
+        TagsSymbolIndex* index = DoGetSymbolIndex();
+        if(index) {
+            size_t limit = tags.size() >= (size_t)GetSingleSearchLimit() ? 1 : GetSingleSearchLimit() - tags.size();
+            std::vector<int> ids;
+            for(size_t i = 0; i < scopes.GetCount() && ids.size() < limit; i++) {
+                index->Find(
+                    name, partialNameAllowed, !m_enableCaseInsensitive, scopes.Item(i), wxArrayString(), limit - ids.size(), ids);
+            }
+            DoFetchTagsByIds(ids, tags);
+            return;
+        }
+
         wxString sql;
         sql << wxT("select * from tags where scope in(");
 
@@ -1310,6 +1609,14 @@ void TagsStorageSQLite::GetTagsByKindLimit(const wxArrayString& kinds,
                                            const wxString& partName,
                                            std::vector<TagEntryPtr>& tags)
 {
+    TagsSymbolIndex* index = orderingColumn.IsEmpty() ? DoGetSymbolIndex() : NULL;
+    if(index) {
+        std::vector<int> ids;
+        index->Find(partName, true, !m_enableCaseInsensitive, wxEmptyString, kinds, limit > 0 ? (size_t)limit : (size_t)-1, ids);
+        DoFetchTagsByIds(ids, tags);
+        return;
+    }
+
     wxString sql;
     sql << wxT("select * from tags where kind in (");
     for(size_t i = 0; i < kinds.GetCount(); i++) {
@@ -1438,6 +1745,79 @@ void TagsStorageSQLite::ClearCache() { m_cache.Clear(); }
 
 void TagsStorageSQLite::SetUseCache(bool useCache) { ITagsStorage::SetUseCache(useCache); }
 
+void TagsStorageSQLite::SetUseSymbolIndex(bool useSymbolIndex)
+{
+    ITagsStorage::SetUseSymbolIndex(useSymbolIndex);
+    if(!useSymbolIndex) {
+        m_symbolIndex.Close();
+
+    } else if(!m_symbolIndex.IsOpen() && m_fileName.IsOk()) {
+        m_symbolIndex.Open(m_fileName.GetFullPath());
+    }
+}
+
+TagsSymbolIndex* TagsStorageSQLite::DoGetSymbolIndex()
+{
+    if(!GetUseSymbolIndex()) return NULL;
+    return m_symbolIndex.Get();
+}
+
+void TagsStorageSQLite::DoFetchTagsByIds(const std::vector<int>& ids, std::vector<TagEntryPtr>& tags)
+{
+    if(ids.empty()) return;
+
+    // Keep each statement well below the maximum SQL statement length
+    std::vector<TagEntryPtr> fetched;
+    for(size_t first = 0; first < ids.size(); first += FETCH_IDS_CHUNK) {
+        size_t last = std::min(first + FETCH_IDS_CHUNK, ids.size());
+        wxString sql;
+        sql << wxT("select * from tags where ID in (");
+        for(size_t i = first; i < last; ++i) {
+            sql << ids.at(i) << wxT(",");
+        }
+        sql.RemoveLast();
+        sql << wxT(")");
+
+        std::vector<TagEntryPtr> chunk;
+        DoFetchTags(sql, chunk);
+        fetched.insert(fetched.end(), chunk.begin(), chunk.end());
+    }
+
+    // The database returns them by ID, the index returns them by name
+    std::map<int, TagEntryPtr> byId;
+    for(size_t i = 0; i < fetched.size(); ++i) {
+        byId.insert(std::make_pair(fetched.at(i)->GetId(), fetched.at(i)));
+    }
+
+    tags.reserve(tags.size() + fetched.size());
+    for(size_t i = 0; i < ids.size(); ++i) {
+        std::map<int, TagEntryPtr>::iterator iter = byId.find(ids.at(i));
+        if(iter != byId.end()) {
+            tags.push_back(iter->second);
+        }
+    }
+}
+
+void TagsStorageSQLite::DoFilesChanged(const std::set<wxString>& files)
+{
+    if(files.empty()) return;
+
+    if(m_db->GetAutoCommit()) {
+        // Not inside a transaction, the changes are already committed
+        TagsLiveSymbolIndex::NotifyFilesChanged(m_fileName.GetFullPath(), files);
+
+    } else {
+        m_changedFiles.insert(files.begin(), files.end());
+    }
+}
+
+void TagsStorageSQLite::DoNotifyChangedFiles()
+{
+    if(m_changedFiles.empty()) return;
+    TagsLiveSymbolIndex::NotifyFilesChanged(m_fileName.GetFullPath(), m_changedFiles);
+    m_changedFiles.clear();
+}
+
 PPToken TagsStorageSQLite::GetMacro(const wxString& name)
 {
     PPToken token;
@@ -1459,10 +1839,10 @@ PPToken TagsStorageSQLite::GetMacro(const wxString& name)
 void TagsStorageSQLite::StoreMacros(const std::map<wxString, PPToken>& table)
 {
     try {
-        wxSQLite3Statement stmntCC =
-            m_db->GetPrepareStatement(wxT("insert or replace into MACROS values(NULL, ?, ?, ?, ?, ?, ?)"));
-        wxSQLite3Statement stmntSimple =
-            m_db->GetPrepareStatement(wxT("insert or replace into SIMPLE_MACROS values(NULL, ?, ?)"));
+        wxSQLite3Statement& stmntCC =
+            m_db->GetCachedStatement(wxT("insert or replace into MACROS values(NULL, ?, ?, ?, ?, ?, ?)"));
+        wxSQLite3Statement& stmntSimple =
+            m_db->GetCachedStatement(wxT("insert or replace into SIMPLE_MACROS values(NULL, ?, ?)"));
 
         std::map<wxString, PPToken>::const_iterator iter = table.begin();
         for(; iter != table.end(); iter++) {
@@ -1548,6 +1928,15 @@ void TagsStorageSQLite::GetTagsByName(const wxString& prefix, std::vector<TagEnt
     try {
         if(prefix.IsEmpty()) return;
 
+        TagsSymbolIndex* index = DoGetSymbolIndex();
+        if(index) {
+            size_t limit = tags.size() >= (size_t)GetSingleSearchLimit() ? 1 : GetSingleSearchLimit() - tags.size();
+            std::vector<int> ids;
+            index->Find(prefix, !exactMatch, !m_enableCaseInsensitive, wxEmptyString, wxArrayString(), limit, ids);
+            DoFetchTagsByIds(ids, tags);
+            return;
+        }
+
         wxString sql;
         sql << wxT("select * from tags where ");
         DoAddNamePartToQuery(sql, prefix, !exactMatch, false);
@@ -1606,6 +1995,14 @@ TagEntryPtr TagsStorageSQLite::GetTagsByNameLimitOne(const wxString& name)
         if(name.IsEmpty()) return NULL;
 
         std::vector<TagEntryPtr> tags;
+        TagsSymbolIndex* index = DoGetSymbolIndex();
+        if(index) {
+            std::vector<int> ids;
+            index->Find(name, false, true, wxEmptyString, wxArrayString(), 1, ids);
+            DoFetchTagsByIds(ids, tags);
+            return tags.size() == 1 ? tags.at(0) : TagEntryPtr(NULL);
+        }
+
         wxString sql;
         sql << wxT("select * from tags where ");
         DoAddNamePartToQuery(sql, name, false, false);
@@ -1628,6 +2025,15 @@ void TagsStorageSQLite::GetTagsByPartName(const wxString& partname, std::vector<
     try {
         if(partname.IsEmpty()) return;
 
+        TagsSymbolIndex* index = DoGetSymbolIndex();
+        if(index) {
+            size_t limit = tags.size() >= (size_t)GetSingleSearchLimit() ? 1 : GetSingleSearchLimit() - tags.size();
+            std::vector<int> ids;
+            index->FindContaining(partname, limit, ids);
+            DoFetchTagsByIds(ids, tags);
+            return;
+        }
+
         wxString tmpName(partname);
         tmpName.Replace(wxT("_"), wxT("^_"));
 
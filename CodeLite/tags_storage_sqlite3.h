@@ -30,6 +30,7 @@
 #include <wx/filename.h>
 #include "fileentry.h"
 #include "istorage.h"
+#include "tags_symbol_index.h"
 #include <wx/wxsqlite3.h>
 #include "codelite_exports.h"
 
@@ -115,21 +116,47 @@ public:
     }
 
     void Close() {
+        // The cached statements must be finalized before the database is closed
+        m_statements.clear();
+
         if (IsOpen())
             wxSQLite3Database::Close();
-
-        m_statements.clear();
     }
 
     wxSQLite3Statement GetPrepareStatement(const wxString& sql) {
         return wxSQLite3Database::PrepareStatement(sql);
     }
+
+    /**
+     * @brief return a prepared statement for 'sql' which is prepared once and kept by the database.
+     * The returned statement is reset and its bindings are cleared. Only use it for statements
+     * that are executed with ExecuteUpdate() (a result set would keep the statement busy)
+     */
+    wxSQLite3Statement& GetCachedStatement(const wxString& sql) {
+        std::map<wxString, wxSQLite3Statement>::iterator iter = m_statements.find(sql);
+        if (iter == m_statements.end()) {
+            // Prepare it before adding it to the map: PrepareStatement() throws on error.
+            // wxSQLite3Statement hands over the ownership on assignment
+            wxSQLite3Statement statement = wxSQLite3Database::PrepareStatement(sql);
+            wxSQLite3Statement& cached = m_statements[sql];
+            cached = statement;
+            return cached;
+        }
+        iter->second.Reset();
+        iter->second.ClearBindings();
+        return iter->second;
+    }
 };
 
 class WXDLLIMPEXP_CL TagsStorageSQLite : public ITagsStorage
 {
     clSqliteDB             *m_db;
     TagsStorageSQLiteCache  m_cache;
+    TagsLiveSymbolIndex     m_symbolIndex;
+    std::set<wxString>      m_changedFiles; // files changed by the current transaction
+    bool                    m_bulkInsert;
+    bool                    m_indexesDeferred;
+    long                    m_bulkCacheSize;
 
 private:
     /**
@@ -149,6 +176,23 @@ private:
     void DoAddNamePartToQuery(wxString &sql, const wxString &name, bool partial, bool prependAnd);
     void DoAddLimitPartToQuery(wxString &sql, const std::vector<TagEntryPtr> &tags);
     int  DoInsertTagEntry( const TagEntry &tag );
+    void DoCreateSearchIndexes();
+    void DoDropSearchIndexes();
+
+    /**
+     * @brief return the symbol index if it is enabled and ready
+     */
+    TagsSymbolIndex* DoGetSymbolIndex();
+    /**
+     * @brief fetch the tags with the given IDs, keeping the order of 'ids'
+     */
+    void DoFetchTagsByIds(const std::vector<int>& ids, std::vector<TagEntryPtr>& tags);
+    /**
+     * @brief record that the tags of 'files' were changed. Live symbol indexes are notified once
+     * the change is committed
+     */
+    void DoFilesChanged(const std::set<wxString>& files);
+    void DoNotifyChangedFiles();
 
 public:
     static TagEntry *FromSQLite3ResultSet(wxSQLite3ResultSet &rs);
@@ -177,6 +221,8 @@ public:
 
     virtual void SetUseCache(bool useCache);
 
+    virtual void SetUseSymbolIndex(bool useSymbolIndex);
+
     /**
      * Return the currently opened database.
      * @return Currently open database
@@ -205,6 +251,21 @@ public:
      */
     void Store(TagTreePtr tree, const wxFileName& path, bool autoCommit = true);
 
+    /**
+     * @copydoc ITagsStorage::Store
+     */
+    virtual void Store(const TagEntryPtrVector_t& tags, bool autoCommit = true);
+
+    /**
+     * @copydoc ITagsStorage::BeginBulkInsert
+     */
+    virtual void BeginBulkInsert(bool deferIndexes);
+
+    /**
+     * @copydoc ITagsStorage::EndBulkInsert
+     */
+    virtual void EndBulkInsert();
+
     /**
      * Return a result set of tags according to file name.
      * @param file Source file name
@@ -272,6 +333,7 @@ public:
     void Commit() {
         try {
             m_db->Commit();
+            DoNotifyChangedFiles();
         } catch (wxSQLite3Exception &e) {
             wxUnusedVar(e);
         }
@@ -281,6 +343,7 @@ public:
      * Rollback transaction.
      */
     void Rollback() {
+        m_changedFiles.clear();
         return m_db->Rollback();
     }
 
@@ -498,6 +561,12 @@ public:
     */
     virtual int UpdateFileEntry ( const wxString &filename , int timestamp );
 
+    virtual void GetFilesHash(std::map<wxString, FileHashEntry> &entries);
+    virtual bool GetFileHash(const wxString &filename, FileHashEntry &entry);
+    virtual int  StoreFileHash(const FileHashEntry &entry);
+    virtual bool GetCachedTags(const wxString &filename, const wxString &hash, const wxString &optionsHash, wxString &tags);
+    virtual void StoreCachedTags(const wxString &filename, const wxString &hash, const wxString &optionsHash, const wxString &tags);
+
     /**
      * @brief return true if type exist under a given scope.
      * Incase it exist but under the <global> scope, 'scope' will be modified
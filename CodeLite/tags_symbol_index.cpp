@@ -0,0 +1,774 @@
+#include "tags_symbol_index.h"
+#include "file_logger.h"
+#include <wx/wxsqlite3.h>
+#include <wx/stopwatch.h>
+#include <algorithm>
+
+// Number of rows read by the loader per query. Keep it small so the loader
+// never holds the database lock for long (the parser thread writes to it)
+#define SYMBOL_INDEX_LOAD_CHUNK 10000
+
+// Scopes with at most this number of symbols are scanned directly instead of walking the names trie
+#define SYMBOL_INDEX_SCOPE_SCAN_MAX 4096
+
+// Reading more changed files than this is slower than rebuilding the index
+#define SYMBOL_INDEX_MAX_REFRESH_FILES 2000
+
+// How many times the loader retries a query on a busy database, and how long it waits between the attempts (ms)
+#define SYMBOL_INDEX_BUSY_RETRIES 20
+#define SYMBOL_INDEX_BUSY_SLEEP 50
+
+// After a failed load, wait this long (ms) before trying again on a lookup
+#define SYMBOL_INDEX_RETRY_DELAY 5000
+
+//--------------------------------------------------------------------------------------
+// TagsStringTable
+//--------------------------------------------------------------------------------------
+int TagsStringTable::Intern(const wxString& str)
+{
+    std::map<wxString, int>::iterator iter = m_ids.find(str);
+    if(iter != m_ids.end()) return iter->second;
+
+    int id = (int)m_strings.size();
+    m_strings.push_back(str);
+    m_ids.insert(std::make_pair(str, id));
+    return id;
+}
+
+int TagsStringTable::Find(const wxString& str) const
+{
+    std::map<wxString, int>::const_iterator iter = m_ids.find(str);
+    return iter == m_ids.end() ? wxNOT_FOUND : iter->second;
+}
+
+//--------------------------------------------------------------------------------------
+// TagsSymbolTrie
+//--------------------------------------------------------------------------------------
+TagsSymbolTrie::Node::~Node()
+{
+    for(size_t i = 0; i < children.size(); ++i) {
+        delete children.at(i);
+    }
+    children.clear();
+}
+
+void TagsSymbolTrie::Insert(const wxString& key, int value)
+{
+    Node* node = &m_root;
+    size_t pos = 0;
+    while(true) {
+        if(pos == key.length()) {
+            node->values.push_back(value);
+            return;
+        }
+
+        wxChar ch = key.GetChar(pos);
+        size_t where = DoFindChild(node->children, ch);
+        if(where == node->children.size() || node->children.at(where)->label.GetChar(0) != ch) {
+            // No child shares a prefix with the key
+            Node* leaf = new Node();
+            leaf->label = key.Mid(pos);
+            leaf->values.push_back(value);
+            node->children.insert(node->children.begin() + where, leaf);
+            return;
+        }
+
+        Node* child = node->children.at(where);
+        size_t common = 0;
+        while(common < child->label.length() && (pos + common) < key.length() &&
+              child->label.GetChar(common) == key.GetChar(pos + common)) {
+            ++common;
+        }
+
+        if(common < child->label.length()) {
+            // Split the child edge at the end of the common part
+            Node* middle = new Node();
+            middle->label = child->label.Left(common);
+            child->label = child->label.Mid(common);
+            middle->children.push_back(child);
+            node->children.at(where) = middle;
+            child = middle;
+        }
+        node = child;
+        pos += common;
+    }
+}
+
+void TagsSymbolTrie::ForEachPrefix(const wxString& prefix, Visitor& visitor) const
+{
+    const Node* node = &m_root;
+    size_t pos = 0;
+    while(pos < prefix.length()) {
+        wxChar ch = prefix.GetChar(pos);
+        size_t where = DoFindChild(node->children, ch);
+        if(where == node->children.size() || node->children.at(where)->label.GetChar(0) != ch) return;
+
+        // The prefix may end in the middle of the edge
+        const Node* child = node->children.at(where);
+        size_t count = std::min(child->label.length(), prefix.length() - pos);
+        for(size_t i = 1; i < count; ++i) {
+            if(child->label.GetChar(i) != prefix.GetChar(pos + i)) return;
+        }
+        node = child;
+        pos += count;
+    }
+    DoVisit(node, visitor);
+}
+
+bool TagsSymbolTrie::DoVisit(const Node* node, Visitor& visitor) const
+{
+    for(size_t i = 0; i < node->values.size(); ++i) {
+        if(!visitor.OnValue(node->values.at(i))) return false;
+    }
+
+    for(size_t i = 0; i < node->children.size(); ++i) {
+        if(!DoVisit(node->children.at(i), visitor)) return false;
+    }
+    return true;
+}
+
+size_t TagsSymbolTrie::DoFindChild(const std::vector<Node*>& children, wxChar ch)
+{
+    // lower bound on the first char of the labels
+    size_t first = 0;
+    size_t count = children.size();
+    while(count > 0) {
+        size_t step = count / 2;
+        if(children.at(first + step)->label.GetChar(0) < ch) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+//--------------------------------------------------------------------------------------
+// TagsSymbolIndex
+//--------------------------------------------------------------------------------------
+
+/**
+ * @class TagsSymbolIndexCollector
+ * @brief collect the symbols of the names found in the trie
+ */
+class TagsSymbolIndexCollector : public TagsSymbolTrie::Visitor
+{
+    const TagsSymbolIndex* m_index;
+    const wxString& m_prefix;
+    bool m_caseSensitive;
+    int m_scope;
+    const std::set<int>& m_kinds;
+    size_t m_limit;
+    size_t m_added;
+    std::vector<int>& m_ids;
+
+public:
+    TagsSymbolIndexCollector(const TagsSymbolIndex* index,
+                             const wxString& prefix,
+                             bool caseSensitive,
+                             int scope,
+                             const std::set<int>& kinds,
+                             size_t limit,
+                             std::vector<int>& ids)
+        : m_index(index)
+        , m_prefix(prefix)
+        , m_caseSensitive(caseSensitive)
+        , m_scope(scope)
+        , m_kinds(kinds)
+        , m_limit(limit)
+        , m_added(0)
+        , m_ids(ids)
+    {
+    }
+
+    virtual bool OnValue(int nameId)
+    {
+        // The trie is keyed by the lower case names
+        if(m_caseSensitive && !m_index->m_names.Get(nameId).StartsWith(m_prefix)) return true;
+
+        const TagsSymbolIndex::Postings_t& postings = m_index->m_byName.at(nameId);
+        for(size_t i = 0; i < postings.size(); ++i) {
+            const TagsSymbolIndex::Symbol& symbol = m_index->m_symbols.at(postings.at(i));
+            if(!m_index->DoMatch(symbol, m_scope, m_kinds)) continue;
+
+            m_ids.push_back(symbol.id);
+            if(++m_added >= m_limit) return false;
+        }
+        return true;
+    }
+};
+
+TagsSymbolIndex::TagsSymbolIndex()
+    : m_removedSymbols(0)
+{
+}
+
+TagsSymbolIndex::~TagsSymbolIndex() {}
+
+void TagsSymbolIndex::Add(int id, const wxString& name, const wxString& scope, const wxString& kind, const wxString& file)
+{
+    Symbol symbol;
+    symbol.id = id;
+
+    size_t namesCount = m_names.GetCount();
+    symbol.name = m_names.Intern(name);
+    if((size_t)symbol.name == namesCount) {
+        // A new name
+        m_trie.Insert(name.Lower(), symbol.name);
+        m_byName.push_back(Postings_t());
+    }
+
+    symbol.scope = m_scopes.Intern(scope);
+    if((size_t)symbol.scope == m_byScope.size()) {
+        m_byScope.push_back(Postings_t());
+    }
+
+    symbol.kind = m_kinds.Intern(kind);
+
+    symbol.file = m_files.Intern(file);
+    if((size_t)symbol.file == m_byFile.size()) {
+        m_byFile.push_back(Postings_t());
+    }
+
+    int index = (int)m_symbols.size();
+    m_symbols.push_back(symbol);
+    m_byName.at(symbol.name).push_back(index);
+    m_byScope.at(symbol.scope).push_back(index);
+    m_byFile.at(symbol.file).push_back(index);
+}
+
+void TagsSymbolIndex::RemoveFile(const wxString& file)
+{
+    int fileId = m_files.Find(file);
+    if(fileId == wxNOT_FOUND) return;
+
+    // Symbols are only marked as removed, the name and scope postings skip them
+    // until the next compaction
+    Postings_t& postings = m_byFile.at(fileId);
+    for(size_t i = 0; i < postings.size(); ++i) {
+        Symbol& symbol = m_symbols.at(postings.at(i));
+        if(symbol.id != wxNOT_FOUND) {
+            symbol.id = wxNOT_FOUND;
+            ++m_removedSymbols;
+        }
+    }
+    postings.clear();
+
+    if(m_removedSymbols > SYMBOL_INDEX_LOAD_CHUNK && m_removedSymbols > (m_symbols.size() / 2)) {
+        DoCompact();
+    }
+}
+
+void TagsSymbolIndex::DoCompact()
+{
+    std::vector<Symbol> symbols;
+    symbols.reserve(m_symbols.size() - m_removedSymbols);
+    for(size_t i = 0; i < m_byName.size(); ++i) {
+        m_byName.at(i).clear();
+    }
+    for(size_t i = 0; i < m_byScope.size(); ++i) {
+        m_byScope.at(i).clear();
+    }
+    for(size_t i = 0; i < m_byFile.size(); ++i) {
+        m_byFile.at(i).clear();
+    }
+
+    for(size_t i = 0; i < m_symbols.size(); ++i) {
+        const Symbol& symbol = m_symbols.at(i);
+        if(symbol.id == wxNOT_FOUND) continue;
+
+        int index = (int)symbols.size();
+        symbols.push_back(symbol);
+        m_byName.at(symbol.name).push_back(index);
+        m_byScope.at(symbol.scope).push_back(index);
+        m_byFile.at(symbol.file).push_back(index);
+    }
+    m_symbols.swap(symbols);
+    m_removedSymbols = 0;
+}
+
+void TagsSymbolIndex::DoGetKindIds(const wxArrayString& kinds, std::set<int>& kindIds) const
+{
+    for(size_t i = 0; i < kinds.GetCount(); ++i) {
+        int kindId = m_kinds.Find(kinds.Item(i));
+        if(kindId != wxNOT_FOUND) {
+            kindIds.insert(kindId);
+        }
+    }
+}
+
+bool TagsSymbolIndex::DoMatch(const Symbol& symbol, int scope, const std::set<int>& kinds) const
+{
+    if(symbol.id == wxNOT_FOUND) return false;
+    if(scope != wxNOT_FOUND && symbol.scope != scope) return false;
+    if(!kinds.empty() && kinds.count(symbol.kind) == 0) return false;
+    return true;
+}
+
+void TagsSymbolIndex::Find(const wxString& name,
+                           bool partial,
+                           bool caseSensitive,
+                           const wxString& scope,
+                           const wxArrayString& kinds,
+                           size_t limit,
+                           std::vector<int>& ids) const
+{
+    if(limit == 0) return;
+    if(name.IsEmpty() && !partial) return;
+
+    int scopeId = wxNOT_FOUND;
+    if(!scope.IsEmpty()) {
+        scopeId = m_scopes.Find(scope);
+        if(scopeId == wxNOT_FOUND) return;
+    }
+
+    std::set<int> kindIds;
+    if(!kinds.IsEmpty()) {
+        DoGetKindIds(kinds, kindIds);
+        if(kindIds.empty()) return;
+    }
+
+    size_t added = 0;
+    if(!partial) {
+        int nameId = m_names.Find(name);
+        if(nameId == wxNOT_FOUND) return;
+
+        const Postings_t& postings = m_byName.at(nameId);
+        for(size_t i = 0; i < postings.size() && added < limit; ++i) {
+            const Symbol& symbol = m_symbols.at(postings.at(i));
+            if(DoMatch(symbol, scopeId, kindIds)) {
+                ids.push_back(symbol.id);
+                ++added;
+            }
+        }
+        return;
+    }
+
+    if(scopeId != wxNOT_FOUND && m_byScope.at(scopeId).size() <= SYMBOL_INDEX_SCOPE_SCAN_MAX) {
+        // Small scope (e.g. a class members): scanning it is cheaper than walking the names
+        wxString lowerName = name.Lower();
+        const Postings_t& postings = m_byScope.at(scopeId);
+        for(size_t i = 0; i < postings.size() && added < limit; ++i) {
+            const Symbol& symbol = m_symbols.at(postings.at(i));
+            if(!DoMatch(symbol, scopeId, kindIds)) continue;
+
+            const wxString& symbolName = m_names.Get(symbol.name);
+            bool match = caseSensitive ? symbolName.StartsWith(name) : symbolName.Lower().StartsWith(lowerName);
+            if(match) {
+                ids.push_back(symbol.id);
+                ++added;
+            }
+        }
+        return;
+    }
+
+    TagsSymbolIndexCollector collector(this, name, caseSensitive, scopeId, kindIds, limit, ids);
+    m_trie.ForEachPrefix(name.Lower(), collector);
+}
+
+void TagsSymbolIndex::FindContaining(const wxString& part, size_t limit, std::vector<int>& ids) const
+{
+    if(limit == 0 || part.IsEmpty()) return;
+
+    // Scan the distinct names, not the symbols
+    wxString lowerPart = part.Lower();
+    size_t added = 0;
+    for(size_t nameId = 0; nameId < m_names.GetCount(); ++nameId) {
+        if(m_names.Get(nameId).Lower().Find(lowerPart) == wxNOT_FOUND) continue;
+
+        const Postings_t& postings = m_byName.at(nameId);
+        for(size_t i = 0; i < postings.size(); ++i) {
+            const Symbol& symbol = m_symbols.at(postings.at(i));
+            if(symbol.id == wxNOT_FOUND) continue;
+
+            ids.push_back(symbol.id);
+            if(++added >= limit) return;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// TagsSymbolIndexUpdate
+//--------------------------------------------------------------------------------------
+
+/**
+ * @class TagsSymbolIndexUpdate
+ * @brief the symbols of a set of files, as read from the database by the loader thread
+ */
+class TagsSymbolIndexUpdate
+{
+public:
+    struct Row {
+        int id;
+        wxString name;
+        wxString scope;
+        wxString kind;
+        wxString file;
+    };
+    std::set<wxString> files;
+    std::vector<Row> rows;
+
+public:
+    TagsSymbolIndexUpdate() {}
+    virtual ~TagsSymbolIndexUpdate() {}
+
+    /**
+     * @brief replace the symbols of the files in 'index'
+     */
+    void Apply(TagsSymbolIndex* index) const
+    {
+        std::set<wxString>::const_iterator iter = files.begin();
+        for(; iter != files.end(); ++iter) {
+            index->RemoveFile(*iter);
+        }
+        for(size_t i = 0; i < rows.size(); ++i) {
+            const Row& row = rows.at(i);
+            index->Add(row.id, row.name, row.scope, row.kind, row.file);
+        }
+    }
+};
+
+//--------------------------------------------------------------------------------------
+// TagsSymbolIndexLoader
+//--------------------------------------------------------------------------------------
+
+/**
+ * @class TagsSymbolIndexLoader
+ * @brief build a TagsSymbolIndex from the database, or read the symbols of the changed files, using a separate
+ * connection
+ */
+class TagsSymbolIndexLoader : public wxThread
+{
+    TagsLiveSymbolIndex* m_owner;
+    wxString m_dbfile;
+    TagsSymbolIndexUpdate* m_update; // the files to read, NULL when loading the whole index
+    TagsSymbolIndex* m_index;
+    bool m_failed;
+
+protected:
+    /**
+     * @brief the parser thread holds the database lock while it commits: wait for it a little before giving up
+     * @return true if the query should be executed again
+     */
+    bool DoRetry(wxSQLite3Exception& e, int& retries)
+    {
+        wxString code = wxSQLite3Exception::ErrorCodeAsString(e.GetErrorCode());
+        if(code != wxT("SQLITE_BUSY") && code != wxT("SQLITE_LOCKED")) return false;
+        if(++retries > SYMBOL_INDEX_BUSY_RETRIES) return false;
+
+        wxThread::Sleep(SYMBOL_INDEX_BUSY_SLEEP);
+        return true;
+    }
+
+    void DoLoadAll(wxSQLite3Database& db)
+    {
+        // Read the table in chunks, each chunk is a separate (short) read transaction.
+        // lastId is advanced row by row, so a retried chunk continues from where it was interrupted
+        int lastId = 0;
+        int retries = 0;
+        bool more = true;
+        while(more && !TestDestroy()) {
+            try {
+                wxSQLite3Statement statement = db.PrepareStatement(
+                    wxT("select ID, name, scope, kind, file from tags where ID > ? order by ID limit ?"));
+                statement.Bind(1, lastId);
+                statement.Bind(2, SYMBOL_INDEX_LOAD_CHUNK);
+
+                int rows = 0;
+                wxSQLite3ResultSet rs = statement.ExecuteQuery();
+                while(rs.NextRow()) {
+                    lastId = rs.GetInt(0);
+                    m_index->Add(lastId, rs.GetString(1), rs.GetString(2), rs.GetString(3), rs.GetString(4));
+                    ++rows;
+                }
+                rs.Finalize();
+                statement.Finalize();
+                more = (rows == SYMBOL_INDEX_LOAD_CHUNK);
+                retries = 0;
+
+            } catch(wxSQLite3Exception& e) {
+                if(!DoRetry(e, retries)) throw;
+            }
+        }
+    }
+
+    void DoLoadFiles(wxSQLite3Database& db)
+    {
+        int retries = 0;
+        std::set<wxString>::const_iterator iter = m_update->files.begin();
+        while(iter != m_update->files.end() && !TestDestroy()) {
+            size_t count = m_update->rows.size();
+            try {
+                wxSQLite3Statement statement =
+                    db.PrepareStatement(wxT("select ID, name, scope, kind from tags where file=?"));
+                statement.Bind(1, *iter);
+                wxSQLite3ResultSet rs = statement.ExecuteQuery();
+                while(rs.NextRow()) {
+                    TagsSymbolIndexUpdate::Row row;
+                    row.id = rs.GetInt(0);
+                    row.name = rs.GetString(1);
+                    row.scope = rs.GetString(2);
+                    row.kind = rs.GetString(3);
+                    row.file = *iter;
+                    m_update->rows.push_back(row);
+                }
+                rs.Finalize();
+                statement.Finalize();
+                ++iter;
+                retries = 0;
+
+            } catch(wxSQLite3Exception& e) {
+                // Read the file again from the start
+                m_update->rows.erase(m_update->rows.begin() + count, m_update->rows.end());
+                if(!DoRetry(e, retries)) throw;
+            }
+        }
+    }
+
+public:
+    TagsSymbolIndexLoader(TagsLiveSymbolIndex* owner, const wxString& dbfile, TagsSymbolIndexUpdate* update)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_owner(owner)
+        , m_dbfile(dbfile.c_str())
+        , m_update(update)
+        , m_index(NULL)
+        , m_failed(false)
+    {
+    }
+
+    virtual ~TagsSymbolIndexLoader()
+    {
+        wxDELETE(m_update);
+        wxDELETE(m_index);
+    }
+
+    bool IsFailed() const { return m_failed; }
+    TagsSymbolIndexUpdate* GetUpdate() const { return m_update; }
+
+    /**
+     * @brief return the loaded index, the caller takes ownership
+     */
+    TagsSymbolIndex* TakeIndex()
+    {
+        TagsSymbolIndex* index = m_index;
+        m_index = NULL;
+        return index;
+    }
+
+    virtual void* Entry()
+    {
+        wxStopWatch sw;
+        try {
+            wxSQLite3Database db;
+            db.Open(m_dbfile);
+            db.SetBusyTimeout(10);
+            if(m_update) {
+                DoLoadFiles(db);
+            } else {
+                m_index = new TagsSymbolIndex();
+                DoLoadAll(db);
+            }
+            db.Close();
+
+        } catch(wxSQLite3Exception& e) {
+            CL_WARNING("TagsSymbolIndexLoader: %s", e.GetMessage());
+            m_failed = true;
+        }
+
+        // Stopped by the owner, which discards the results
+        if(TestDestroy()) return NULL;
+
+        if(m_index && !m_failed) {
+            CL_DEBUG("TagsSymbolIndexLoader: indexed %u symbols in %ld ms",
+                     (unsigned int)m_index->GetCount(),
+                     sw.Time());
+        }
+        m_owner->DoLoaderDone();
+        return NULL;
+    }
+};
+
+//--------------------------------------------------------------------------------------
+// TagsLiveSymbolIndex
+//--------------------------------------------------------------------------------------
+static wxMutex& GetLiveIndexesLock()
+{
+    static wxMutex lock;
+    return lock;
+}
+
+static std::set<TagsLiveSymbolIndex*>& GetLiveIndexes()
+{
+    static std::set<TagsLiveSymbolIndex*> indexes;
+    return indexes;
+}
+
+TagsLiveSymbolIndex::TagsLiveSymbolIndex()
+    : m_index(NULL)
+    , m_loader(NULL)
+    , m_nextLoad(0)
+    , m_loaderDone(false)
+    , m_reset(false)
+{
+}
+
+TagsLiveSymbolIndex::~TagsLiveSymbolIndex() { Close(); }
+
+void TagsLiveSymbolIndex::Open(const wxString& dbfile)
+{
+    Close();
+    m_dbfile = dbfile;
+    m_nextLoad = 0;
+    wxMutexLocker locker(GetLiveIndexesLock());
+    GetLiveIndexes().insert(this);
+}
+
+void TagsLiveSymbolIndex::Close()
+{
+    if(!IsOpen()) return;
+    {
+        wxMutexLocker locker(GetLiveIndexesLock());
+        GetLiveIndexes().erase(this);
+        m_changedFiles.clear();
+        m_reset = false;
+    }
+    DoStopLoader();
+    wxDELETE(m_index);
+    m_dbfile.Clear();
+}
+
+void TagsLiveSymbolIndex::DoStartLoader(TagsSymbolIndexUpdate* update)
+{
+    DoStopLoader();
+    if(!update) {
+        // The loader reads everything that was committed so far
+        wxMutexLocker locker(GetLiveIndexesLock());
+        m_changedFiles.clear();
+    }
+
+    m_loader = new TagsSymbolIndexLoader(this, m_dbfile, update);
+    if(m_loader->Create() != wxTHREAD_NO_ERROR) {
+        CL_WARNING("TagsLiveSymbolIndex: failed to create the loader thread");
+        wxDELETE(m_loader);
+        m_nextLoad = wxGetLocalTimeMillis() + SYMBOL_INDEX_RETRY_DELAY;
+        return;
+    }
+    m_loader->Run();
+}
+
+void TagsLiveSymbolIndex::DoStopLoader()
+{
+    if(m_loader) {
+        // Delete() asks the thread to stop and waits for it. Must not be called while holding the lock:
+        // the loader takes it when it is done
+        m_loader->Delete();
+        wxDELETE(m_loader);
+    }
+
+    wxMutexLocker locker(GetLiveIndexesLock());
+    m_loaderDone = false;
+}
+
+void TagsLiveSymbolIndex::DoLoaderDone()
+{
+    wxMutexLocker locker(GetLiveIndexesLock());
+    m_loaderDone = true;
+}
+
+TagsSymbolIndex* TagsLiveSymbolIndex::Get()
+{
+    if(!IsOpen()) return NULL;
+
+    bool loaderDone = false;
+    bool reset = false;
+    {
+        wxMutexLocker locker(GetLiveIndexesLock());
+        loaderDone = m_loaderDone;
+        m_loaderDone = false;
+        reset = m_reset;
+        m_reset = false;
+    }
+
+    if(loaderDone && m_loader) {
+        m_loader->Wait();
+        TagsSymbolIndexUpdate* update = m_loader->GetUpdate();
+        if(reset) {
+            // The results are outdated
+
+        } else if(m_loader->IsFailed()) {
+            // e.g. the database remained locked. Try again on a later lookup
+            m_nextLoad = wxGetLocalTimeMillis() + SYMBOL_INDEX_RETRY_DELAY;
+            if(update) {
+                wxMutexLocker locker(GetLiveIndexesLock());
+                m_changedFiles.insert(update->files.begin(), update->files.end());
+            }
+
+        } else if(update) {
+            if(m_index) update->Apply(m_index);
+
+        } else {
+            wxDELETE(m_index);
+            m_index = m_loader->TakeIndex();
+        }
+        wxDELETE(m_loader);
+    }
+
+    if(reset) {
+        // The current index refers to tags that no longer exist
+        wxDELETE(m_index);
+        m_nextLoad = 0;
+        DoStartLoader(NULL);
+        return NULL;
+    }
+
+    if(m_loader || wxGetLocalTimeMillis() < m_nextLoad) return m_index;
+
+    if(!m_index) {
+        DoStartLoader(NULL);
+        return NULL;
+    }
+
+    TagsSymbolIndexUpdate* update = new TagsSymbolIndexUpdate();
+    {
+        wxMutexLocker locker(GetLiveIndexesLock());
+        update->files.swap(m_changedFiles);
+    }
+
+    if(update->files.empty()) {
+        wxDELETE(update);
+
+    } else if(update->files.size() > SYMBOL_INDEX_MAX_REFRESH_FILES) {
+        // Rebuild it in the background, keep serving the current index meanwhile
+        wxDELETE(update);
+        DoStartLoader(NULL);
+
+    } else {
+        DoStartLoader(update);
+    }
+    return m_index;
+}
+
+void TagsLiveSymbolIndex::NotifyFilesChanged(const wxString& dbfile, const std::set<wxString>& files)
+{
+    if(files.empty()) return;
+
+    wxMutexLocker locker(GetLiveIndexesLock());
+    std::set<TagsLiveSymbolIndex*>::iterator iter = GetLiveIndexes().begin();
+    for(; iter != GetLiveIndexes().end(); ++iter) {
+        if((*iter)->m_dbfile == dbfile) {
+            (*iter)->m_changedFiles.insert(files.begin(), files.end());
+        }
+    }
+}
+
+void TagsLiveSymbolIndex::NotifyDatabaseReset(const wxString& dbfile)
+{
+    wxMutexLocker locker(GetLiveIndexesLock());
+    std::set<TagsLiveSymbolIndex*>::iterator iter = GetLiveIndexes().begin();
+    for(; iter != GetLiveIndexes().end(); ++iter) {
+        if((*iter)->m_dbfile == dbfile) {
+            (*iter)->m_reset = true;
+        }
+    }
+}
@@ -0,0 +1,214 @@
+#ifndef TAGS_SYMBOL_INDEX_H
+#define TAGS_SYMBOL_INDEX_H
+
+#include "codelite_exports.h"
+#include <wx/string.h>
+#include <wx/arrstr.h>
+#include <wx/thread.h>
+#include <wx/longlong.h>
+#include <map>
+#include <set>
+#include <vector>
+
+/**
+ * @class TagsStringTable
+ * @brief an interned strings table: each distinct string is kept once and referred to by its ID
+ */
+class WXDLLIMPEXP_CL TagsStringTable
+{
+    std::vector<wxString> m_strings;
+    std::map<wxString, int> m_ids;
+
+public:
+    TagsStringTable() {}
+    virtual ~TagsStringTable() {}
+
+    /**
+     * @brief return the ID of 'str', add it to the table if needed
+     */
+    int Intern(const wxString& str);
+    /**
+     * @brief return the ID of 'str' or wxNOT_FOUND
+     */
+    int Find(const wxString& str) const;
+    const wxString& Get(int id) const { return m_strings.at(id); }
+    size_t GetCount() const { return m_strings.size(); }
+};
+
+/**
+ * @class TagsSymbolTrie
+ * @brief a compressed prefix trie (radix tree) mapping keys to integer values
+ */
+class WXDLLIMPEXP_CL TagsSymbolTrie
+{
+public:
+    /**
+     * @brief called for every value found by ForEachPrefix(). Return false to stop the traversal
+     */
+    class Visitor
+    {
+    public:
+        virtual ~Visitor() {}
+        virtual bool OnValue(int value) = 0;
+    };
+
+protected:
+    struct Node {
+        wxString label;
+        std::vector<int> values;
+        std::vector<Node*> children; // sorted by the first char of their label
+
+        ~Node();
+    };
+    Node m_root;
+
+    static size_t DoFindChild(const std::vector<Node*>& children, wxChar ch);
+    bool DoVisit(const Node* node, Visitor& visitor) const;
+
+public:
+    TagsSymbolTrie() {}
+    virtual ~TagsSymbolTrie() {}
+
+    void Insert(const wxString& key, int value);
+    /**
+     * @brief visit all the values whose key starts with 'prefix' in key order
+     */
+    void ForEachPrefix(const wxString& prefix, Visitor& visitor) const;
+};
+
+/**
+ * @class TagsSymbolIndex
+ * @brief a memory resident index of the tags database.
+ * Only the fields needed for finding symbols are kept (name, scope, kind and file), each of them interned.
+ * Names are kept in a prefix trie, symbols are reachable by name, by scope and by file.
+ * Lookups return the database IDs of the matching tags, the tags themselves are read from the database
+ */
+class WXDLLIMPEXP_CL TagsSymbolIndex
+{
+    struct Symbol {
+        int id; // database ID, wxNOT_FOUND for removed symbols
+        int name;
+        int scope;
+        int kind;
+        int file;
+    };
+    typedef std::vector<int> Postings_t;
+
+    TagsStringTable m_names;
+    TagsStringTable m_scopes;
+    TagsStringTable m_kinds;
+    TagsStringTable m_files;
+    TagsSymbolTrie m_trie;
+    std::vector<Symbol> m_symbols;
+    std::vector<Postings_t> m_byName;
+    std::vector<Postings_t> m_byScope;
+    std::vector<Postings_t> m_byFile;
+    size_t m_removedSymbols;
+
+protected:
+    void DoCompact();
+    void DoGetKindIds(const wxArrayString& kinds, std::set<int>& kindIds) const;
+    bool DoMatch(const Symbol& symbol, int scope, const std::set<int>& kinds) const;
+    friend class TagsSymbolIndexCollector;
+
+public:
+    TagsSymbolIndex();
+    virtual ~TagsSymbolIndex();
+
+    /**
+     * @brief add a single symbol
+     */
+    void Add(int id, const wxString& name, const wxString& scope, const wxString& kind, const wxString& file);
+
+    /**
+     * @brief remove all the symbols of 'file'
+     */
+    void RemoveFile(const wxString& file);
+
+    /**
+     * @brief find symbols by name
+     * @param name the name (or prefix) to search
+     * @param partial match all the symbols starting with 'name'
+     * @param caseSensitive when not set, prefix matching ignores the case. Exact matches are always case sensitive
+     * @param scope restrict the search to a scope, an empty string means any scope
+     * @param kinds restrict the search to these kinds, empty array means any kind
+     * @param limit maximum number of IDs to add
+     * @param ids [output] the database IDs of the matching tags (appended)
+     */
+    void Find(const wxString& name,
+              bool partial,
+              bool caseSensitive,
+              const wxString& scope,
+              const wxArrayString& kinds,
+              size_t limit,
+              std::vector<int>& ids) const;
+
+    /**
+     * @brief find symbols whose name contains 'part' (case insensitive)
+     */
+    void FindContaining(const wxString& part, size_t limit, std::vector<int>& ids) const;
+
+    size_t GetCount() const { return m_symbols.size() - m_removedSymbols; }
+};
+
+class TagsSymbolIndexLoader;
+class TagsSymbolIndexUpdate;
+/**
+ * @class TagsLiveSymbolIndex
+ * @brief keep a TagsSymbolIndex in sync with a tags database.
+ * The index is built by a background thread on the first lookup. Writers (e.g. the parser thread) report the
+ * files they changed when they commit, the background thread reads their symbols and the index is updated on
+ * a later lookup. Until then, lookups are served by the current index
+ */
+class WXDLLIMPEXP_CL TagsLiveSymbolIndex
+{
+    friend class TagsSymbolIndexLoader;
+
+    wxString m_dbfile;
+    TagsSymbolIndex* m_index;
+    TagsSymbolIndexLoader* m_loader;
+    wxLongLong m_nextLoad; // do not start the loader before this time (after a failure)
+
+    // Members below are protected by the registry lock
+    bool m_loaderDone;
+    bool m_reset;
+    std::set<wxString> m_changedFiles;
+
+protected:
+    /**
+     * @brief start the loader thread
+     * @param update the files to read, NULL to load the whole index
+     */
+    void DoStartLoader(TagsSymbolIndexUpdate* update);
+    void DoStopLoader();
+    void DoLoaderDone();
+
+public:
+    TagsLiveSymbolIndex();
+    virtual ~TagsLiveSymbolIndex();
+
+    /**
+     * @brief start indexing 'dbfile'. The index is loaded on the first lookup
+     */
+    void Open(const wxString& dbfile);
+    void Close();
+    bool IsOpen() const { return !m_dbfile.IsEmpty(); }
+
+    /**
+     * @brief apply the changes read by the loader so far and return the index. Never reads the database
+     * @return the index or NULL if it is not ready yet (the caller should query the database)
+     */
+    TagsSymbolIndex* Get();
+
+    /**
+     * @brief notify all the live indexes of 'dbfile' that the tags of 'files' were changed (and committed)
+     */
+    static void NotifyFilesChanged(const wxString& dbfile, const std::set<wxString>& files);
+
+    /**
+     * @brief notify all the live indexes of 'dbfile' that they need to be rebuilt
+     */
+    static void NotifyDatabaseReset(const wxString& dbfile);
+};
+
+#endif // TAGS_SYMBOL_INDEX_H
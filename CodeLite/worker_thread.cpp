@@ -27,6 +27,7 @@
 WorkerThread::WorkerThread()
     : wxThread(wxTHREAD_JOINABLE)
     , m_notifiedWindow(NULL)
+    , m_stopRequested(false)
 {
 }
 
@@ -40,7 +41,12 @@ void* WorkerThread::Entry()
         // Did we get a request to terminate?
         if(TestDestroy()) break;
         ThreadRequest* request = NULL;
-        if(m_queue.ReceiveTimeout(50, request) == wxMSGQUEUE_NO_ERROR) {
+        // Block until there is a request, Stop() wakes the thread up with a NULL request
+        if(m_queue.Receive(request) == wxMSGQUEUE_NO_ERROR) {
+            if(request == NULL) {
+                if(m_stopRequested) break;
+                continue;
+            }
             // Call user's implementation for processing request
             ProcessRequest(request);
             wxDELETE(request);
@@ -58,6 +64,8 @@ void WorkerThread::Stop()
 {
     // Notify the thread to exit and
     // wait for it
+    m_stopRequested = true;
+    m_queue.Post(NULL);
     if(IsAlive()) {
         Delete(NULL, wxTHREAD_WAIT_BLOCK);
 
@@ -68,6 +76,7 @@ void WorkerThread::Stop()
 
 void WorkerThread::Start(int priority)
 {
+    m_stopRequested = false;
     Create();
     SetPriority(priority);
     Run();
@@ -50,6 +50,7 @@ class WXDLLIMPEXP_CL WorkerThread : public wxThread
 protected:
     wxEvtHandler* m_notifiedWindow;
     wxMessageQueue<ThreadRequest*> m_queue;
+    bool m_stopRequested;
 
 public:
     /**
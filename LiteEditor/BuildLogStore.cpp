@@ -0,0 +1,153 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 The CodeLite Team
+// file name            : BuildLogStore.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "BuildLogStore.h"
+#include "new_build_tab.h"
+#include "file_logger.h"
+#include <wx/filename.h>
+#include <wx/filefn.h>
+#include <wx/log.h>
+#include <algorithm>
+
+namespace
+{
+struct LineInfoLess {
+    bool operator()(const std::pair<size_t, BuildLineInfo*>& info, size_t line) const { return info.first < line; }
+};
+}
+
+BuildLogStore::BuildLogStore()
+    : m_spilled(0)
+    , m_maxMemory(0)
+    , m_spillEnabled(false)
+{
+}
+
+BuildLogStore::~BuildLogStore() { Clear(); }
+
+void BuildLogStore::EnableSpill(bool enable, size_t maxMemory)
+{
+    m_spillEnabled = enable;
+    m_maxMemory = maxMemory;
+}
+
+size_t BuildLogStore::Append(const wxString& line, int flags, BuildLineInfo* info)
+{
+    size_t index = m_offsets.size();
+    m_offsets.push_back(m_spilled + (wxFileOffset)m_text.length());
+    m_flags.push_back((unsigned char)flags);
+    if(info) {
+        m_infos.push_back(std::make_pair(index, info));
+    }
+
+    const wxCharBuffer cb = line.mb_str(wxConvUTF8);
+    m_text.append(cb.data(), cb.length());
+
+    if(m_spillEnabled && m_maxMemory && m_text.length() > m_maxMemory) {
+        DoSpill();
+    }
+    return index;
+}
+
+void BuildLogStore::DoSpill()
+{
+    if(!m_spillFile.IsOpened()) {
+        m_spillFileName = wxFileName::CreateTempFileName("clbuild");
+        if(m_spillFileName.IsEmpty() || !m_spillFile.Open(m_spillFileName, "w+b")) {
+            CL_WARNING("Build log: could not create a temporary file, keeping the build output in memory");
+            m_spillEnabled = false;
+            return;
+        }
+    }
+
+    // Keep the newest half in memory: these are the lines that the user is most likely to look at
+    size_t bytes = m_text.length() - (m_maxMemory / 2);
+    if(!m_spillFile.SeekEnd() || m_spillFile.Write(m_text.c_str(), bytes) != bytes) {
+        CL_WARNING("Build log: failed to write to %s, keeping the build output in memory", m_spillFileName);
+        m_spillEnabled = false;
+        return;
+    }
+    m_text.erase(0, bytes);
+    m_spilled += bytes;
+}
+
+void BuildLogStore::DoRead(wxFileOffset start, wxFileOffset end, std::string& bytes) const
+{
+    // The part which is in the spill file
+    if(start < m_spilled) {
+        wxFileOffset fileEnd = std::min(end, m_spilled);
+        std::vector<char> buffer(fileEnd - start);
+        if(!buffer.empty() && m_spillFile.Seek(start) && m_spillFile.Read(&buffer[0], buffer.size()) == buffer.size()) {
+            bytes.append(&buffer[0], buffer.size());
+        }
+        start = fileEnd;
+    }
+
+    // And the part which is in memory
+    if(start < end) {
+        bytes.append(m_text, start - m_spilled, end - start);
+    }
+}
+
+wxString BuildLogStore::GetLine(size_t line) const
+{
+    if(line >= m_offsets.size()) return wxEmptyString;
+
+    wxFileOffset start = m_offsets.at(line);
+    wxFileOffset end = (line + 1 < m_offsets.size()) ? m_offsets.at(line + 1) : m_spilled + m_text.length();
+
+    std::string bytes;
+    DoRead(start, end, bytes);
+    return wxString(bytes.c_str(), wxConvUTF8, bytes.length());
+}
+
+BuildLineInfo* BuildLogStore::GetInfo(size_t line) const
+{
+    std::vector<LineInfo_t>::const_iterator iter =
+        std::lower_bound(m_infos.begin(), m_infos.end(), line, LineInfoLess());
+    if(iter == m_infos.end() || iter->first != line) return NULL;
+    return iter->second;
+}
+
+void BuildLogStore::Clear()
+{
+    for(size_t i = 0; i < m_infos.size(); ++i) {
+        wxDELETE(m_infos.at(i).second);
+    }
+    m_infos.clear();
+
+    // release the memory as well
+    std::string().swap(m_text);
+    std::vector<wxFileOffset>().swap(m_offsets);
+    std::vector<unsigned char>().swap(m_flags);
+    m_spilled = 0;
+
+    if(m_spillFile.IsOpened()) {
+        m_spillFile.Close();
+        wxLogNull noLog;
+        ::wxRemoveFile(m_spillFileName);
+    }
+    m_spillFileName.Clear();
+}
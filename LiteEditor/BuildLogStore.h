@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 The CodeLite Team
+// file name            : BuildLogStore.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BUILDLOGSTORE_H
+#define BUILDLOGSTORE_H
+
+#include <wx/string.h>
+#include <wx/ffile.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+class BuildLineInfo;
+
+/**
+ * @class BuildLogStore
+ * @brief an append only store for the build output lines.
+ * The text of all the lines is kept in a single UTF-8 buffer, with the start offset and a few flag bits
+ * (severity, summary) per line. Only the lines that are errors, warnings or refer to a file have a BuildLineInfo.
+ * When spilling is enabled, the oldest text is moved to a temporary file once the buffer grows
+ * beyond the memory limit
+ */
+class BuildLogStore
+{
+public:
+    enum {
+        kSeverityMask = 0x03, // LINE_SEVERITY
+        kSummary = 0x04,
+    };
+
+protected:
+    typedef std::pair<size_t, BuildLineInfo*> LineInfo_t;
+
+    std::string m_text;                   // the text which is still in memory
+    wxFileOffset m_spilled;               // the number of bytes moved to the spill file
+    std::vector<wxFileOffset> m_offsets;  // start offset of every line
+    std::vector<unsigned char> m_flags;   // flags of every line
+    std::vector<LineInfo_t> m_infos;      // sorted by line
+    size_t m_maxMemory;
+    bool m_spillEnabled;
+    wxString m_spillFileName;
+    mutable wxFFile m_spillFile;
+
+protected:
+    void DoSpill();
+    void DoRead(wxFileOffset start, wxFileOffset end, std::string& bytes) const;
+
+public:
+    BuildLogStore();
+    virtual ~BuildLogStore();
+
+    /**
+     * @brief move the oldest text to a temporary file when more than 'maxMemory' bytes are kept in memory
+     */
+    void EnableSpill(bool enable, size_t maxMemory);
+
+    /**
+     * @brief append a line
+     * @param flags the line severity (LINE_SEVERITY) optionally with kSummary
+     * @param info line information, can be NULL. The store takes its ownership
+     * @return the line index
+     */
+    size_t Append(const wxString& line, int flags, BuildLineInfo* info);
+
+    /**
+     * @brief delete all the lines and their information
+     */
+    void Clear();
+
+    size_t GetCount() const { return m_offsets.size(); }
+    bool IsEmpty() const { return m_offsets.empty(); }
+    wxString GetLine(size_t line) const;
+    int GetFlags(size_t line) const { return m_flags.at(line); }
+    /**
+     * @brief return the information of 'line', or NULL
+     */
+    BuildLineInfo* GetInfo(size_t line) const;
+};
+
+#endif // BUILDLOGSTORE_H
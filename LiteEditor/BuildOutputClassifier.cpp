@@ -0,0 +1,182 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 The CodeLite Team
+// file name            : BuildOutputClassifier.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "BuildOutputClassifier.h"
+#include "macros.h"
+#include "performance.h"
+
+wxDEFINE_EVENT(wxEVT_BUILD_OUTPUT_CLASSIFIED, wxCommandEvent);
+
+//--------------------------------------------------------------------------------------
+// BuildOutputClassifier
+//--------------------------------------------------------------------------------------
+BuildOutputClassifier::BuildOutputClassifier() {}
+
+BuildOutputClassifier::~BuildOutputClassifier() {}
+
+void BuildOutputClassifier::Clear()
+{
+    m_patterns.errorsPatterns.clear();
+    m_patterns.warningPatterns.clear();
+    m_directories.Clear();
+}
+
+void BuildOutputClassifier::DoSearchForDirectory(const wxString& line)
+{
+    // Check for makefile directory changes lines
+    if(line.Contains(wxT("Entering directory `"))) {
+        wxString currentDir = line.AfterFirst(wxT('`'));
+        currentDir = currentDir.BeforeLast(wxT('\''));
+
+        // Collect the m_baseDir
+        m_directories.Add(currentDir);
+    }
+}
+
+bool BuildOutputClassifier::DoMatch(const std::vector<CmpPatternPtr>& patterns,
+                                    const wxString& line,
+                                    BuildLineInfo* buildLineInfo)
+{
+    for(size_t i = 0; i < patterns.size(); ++i) {
+        // Do not copy the pointer: the reference counting of SmartPtr is not thread safe
+        BuildLineInfo bli;
+        if(patterns.at(i)->Matches(line, bli)) {
+            buildLineInfo->SetFilename(bli.GetFilename());
+            buildLineInfo->SetSeverity(bli.GetSeverity());
+            buildLineInfo->SetLineNumber(bli.GetLineNumber());
+            buildLineInfo->NormalizeFilename(m_directories, m_cygwinRoot);
+            buildLineInfo->SetRegexLineMatch(bli.GetRegexLineMatch());
+            buildLineInfo->SetColumn(bli.GetColumn());
+            return true;
+        }
+    }
+    return false;
+}
+
+BuildLineInfo* BuildOutputClassifier::Classify(const wxString& line)
+{
+    // If this is a line similar to 'Entering directory `'
+    // add the path in the directories array
+    DoSearchForDirectory(line);
+
+    // Find *warnings* first. If it is not a warning, maybe it's an error
+    BuildLineInfo* buildLineInfo = new BuildLineInfo();
+    if(!DoMatch(m_patterns.warningPatterns, line, buildLineInfo)) {
+        DoMatch(m_patterns.errorsPatterns, line, buildLineInfo);
+    }
+    return buildLineInfo;
+}
+
+//--------------------------------------------------------------------------------------
+// BuildOutputClassifierThread
+//--------------------------------------------------------------------------------------
+BuildOutputClassifierThread::BuildOutputClassifierThread(BuildOutputClassifier* classifier)
+    : m_classifier(classifier)
+    , m_notified(false)
+{
+}
+
+BuildOutputClassifierThread::~BuildOutputClassifierThread()
+{
+    // Requests that were not processed
+    ThreadRequest* request = NULL;
+    while(m_queue.ReceiveTimeout(0, request) == wxMSGQUEUE_NO_ERROR) {
+        wxDELETE(request);
+    }
+
+    // Results that were not taken
+    for(size_t i = 0; i < m_results.size(); ++i) {
+        wxDELETE(m_results.at(i).buildLineInfo);
+    }
+    m_results.clear();
+}
+
+void BuildOutputClassifierThread::ProcessRequest(ThreadRequest* request)
+{
+    CL_TRACE_FUNCTION("build");
+    FlushRequest* flush = dynamic_cast<FlushRequest*>(request);
+    if(flush) {
+        flush->done->Post();
+        return;
+    }
+
+    LinesRequest* req = dynamic_cast<LinesRequest*>(request);
+    CHECK_PTR_RET(req);
+
+    ResultVec_t results;
+    results.reserve(req->lines.GetCount());
+    for(size_t i = 0; i < req->lines.GetCount(); ++i) {
+        if(TestDestroy()) break;
+        Result result;
+        result.line = req->lines.Item(i);
+        result.buildLineInfo = m_classifier->Classify(result.line);
+        results.push_back(result);
+    }
+
+    bool notify(false);
+    {
+        wxMutexLocker locker(m_mutex);
+        m_results.insert(m_results.end(), results.begin(), results.end());
+        notify = !m_notified;
+        m_notified = true;
+    }
+
+    if(notify && m_notifiedWindow) {
+        wxCommandEvent event(wxEVT_BUILD_OUTPUT_CLASSIFIED);
+        m_notifiedWindow->AddPendingEvent(event);
+    }
+}
+
+void BuildOutputClassifierThread::AddLines(const wxArrayString& lines)
+{
+    if(lines.IsEmpty()) return;
+
+    LinesRequest* req = new LinesRequest();
+    req->lines.Alloc(lines.GetCount());
+    for(size_t i = 0; i < lines.GetCount(); ++i) {
+        // The strings are used by another thread, make a copy of the content
+        req->lines.Add(lines.Item(i).c_str());
+    }
+    Add(req);
+}
+
+void BuildOutputClassifierThread::Flush()
+{
+    if(!IsAlive()) return;
+
+    wxSemaphore done;
+    FlushRequest* req = new FlushRequest();
+    req->done = &done;
+    Add(req);
+    done.Wait();
+}
+
+void BuildOutputClassifierThread::TakeResults(ResultVec_t& results)
+{
+    results.clear();
+    wxMutexLocker locker(m_mutex);
+    m_results.swap(results);
+    m_notified = false;
+}
@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 The CodeLite Team
+// file name            : BuildOutputClassifier.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BUILDOUTPUTCLASSIFIER_H
+#define BUILDOUTPUTCLASSIFIER_H
+
+#include "worker_thread.h" // Base class: WorkerThread
+#include "new_build_tab.h"
+#include <wx/arrstr.h>
+#include <wx/event.h>
+#include <vector>
+
+/**
+ * @class BuildOutputClassifier
+ * @brief classify the build output lines (error, warning or plain output) with the patterns of the build compiler
+ */
+class BuildOutputClassifier
+{
+    CmpPatterns m_patterns;
+    wxArrayString m_directories;
+    wxString m_cygwinRoot;
+
+protected:
+    bool DoMatch(const std::vector<CmpPatternPtr>& patterns, const wxString& line, BuildLineInfo* buildLineInfo);
+    void DoSearchForDirectory(const wxString& line);
+
+public:
+    BuildOutputClassifier();
+    virtual ~BuildOutputClassifier();
+
+    /**
+     * @brief use 'patterns' for the lines classified from now on
+     */
+    void SetPatterns(const CmpPatterns& patterns) { this->m_patterns = patterns; }
+    void SetCygwinRoot(const wxString& cygwinRoot) { this->m_cygwinRoot = cygwinRoot; }
+
+    /**
+     * @brief forget the patterns and the directories collected so far
+     */
+    void Clear();
+
+    /**
+     * @brief classify a single build output line. "Entering directory" lines are collected and used
+     * for resolving the relative file names of the following lines
+     */
+    BuildLineInfo* Classify(const wxString& line);
+};
+
+wxDECLARE_EVENT(wxEVT_BUILD_OUTPUT_CLASSIFIED, wxCommandEvent);
+
+/**
+ * @class BuildOutputClassifierThread
+ * @brief classify the build output lines in the background.
+ * The results are collected until the notified window takes them. The window is notified with
+ * wxEVT_BUILD_OUTPUT_CLASSIFIED when results are ready (once, until it takes them)
+ */
+class BuildOutputClassifierThread : public WorkerThread
+{
+public:
+    struct Result {
+        wxString line;
+        BuildLineInfo* buildLineInfo;
+    };
+    typedef std::vector<Result> ResultVec_t;
+
+protected:
+    struct LinesRequest : public ThreadRequest {
+        wxArrayString lines;
+    };
+    struct FlushRequest : public ThreadRequest {
+        wxSemaphore* done;
+    };
+
+    BuildOutputClassifier* m_classifier;
+    wxMutex m_mutex;
+    ResultVec_t m_results;
+    bool m_notified;
+
+public:
+    BuildOutputClassifierThread(BuildOutputClassifier* classifier);
+    virtual ~BuildOutputClassifierThread();
+
+    virtual void ProcessRequest(ThreadRequest* request);
+
+    /**
+     * @brief queue complete lines for classification
+     */
+    void AddLines(const wxArrayString& lines);
+
+    /**
+     * @brief wait until all the lines queued so far are classified
+     */
+    void Flush();
+
+    /**
+     * @brief move the results collected so far into 'results'
+     */
+    void TakeResults(ResultVec_t& results);
+};
+
+#endif // BUILDOUTPUTCLASSIFIER_H
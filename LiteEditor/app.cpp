@@ -529,8 +529,12 @@ bool CodeLiteApp::OnInit()
     // keep the startup directory
     ManagerST::Get()->SetStartupDirectory(::wxGetCwd());
 
-    // set the performance output file name
-    PERF_OUTPUT(wxString::Format(wxT("%s/codelite.perf"), wxGetCwd().c_str()).mb_str(wxConvUTF8));
+    // record traces when CODELITE_TRACE is set to the output file name
+    wxString traceFile;
+    if(::wxGetEnv("CODELITE_TRACE", &traceFile) && !traceFile.IsEmpty()) {
+        PERF_OUTPUT(traceFile);
+        clTracer::Enable(true);
+    }
 
     // Initialize the configuration file locater
     ConfFileLocator::Instance()->Initialize(ManagerST::Get()->GetInstallDir(), ManagerST::Get()->GetStartupDirectory());
@@ -737,6 +741,13 @@ bool CodeLiteApp::OnInit()
 int CodeLiteApp::OnExit()
 {
     CL_DEBUG(wxT("Bye"));
+    if(clTracer::IsEnabled()) {
+        clTracer::Enable(false);
+        if(!clTracer::ExportToFile()) {
+            CL_WARNING("Failed to write the trace file %s", clTracer::GetOutputFile());
+        }
+    }
+    FileLogger::CloseLog();
     EditorConfigST::Free();
     ConfFileLocator::Release();
     return 0;
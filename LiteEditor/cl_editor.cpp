@@ -75,6 +75,7 @@
 #include "cc_box_tip_window.h"
 #include "clSTCLineKeeper.h"
 #include "clEditorStateLocker.h"
+#include "clSTCReplacer.h"
 #include <wx/dcmemory.h>
 #include <wx/dataobj.h>
 #include <wx/regex.h>
@@ -2659,70 +2660,41 @@ void LEditor::FindPrevMarker()
 
 bool LEditor::ReplaceAll()
 {
-    int offset(0);
-
     wxString findWhat = m_findReplaceDlg->GetData().GetFindString();
     wxString replaceWith = m_findReplaceDlg->GetData().GetReplaceString();
     size_t flags = SearchFlags(m_findReplaceDlg->GetData());
 
-    int pos(0);
-    int match_len(0);
-    int posInChars(0);
-    int match_lenInChars(0);
-
-    wxString txt;
-    if(m_findReplaceDlg->GetData().GetFlags() & wxFRD_SELECTIONONLY) {
-        txt = GetSelectedText();
-    } else {
-        txt = GetText();
-    }
-
     bool replaceInSelectionOnly = m_findReplaceDlg->GetData().GetFlags() & wxFRD_SELECTIONONLY;
 
-    BeginUndoAction();
     m_findReplaceDlg->ResetReplacedCount();
 
     long savedPos = GetCurrentPos();
-    while(StringFindReplacer::Search(
-        txt.wc_str(), offset, findWhat.wc_str(), flags, pos, match_len, posInChars, match_lenInChars)) {
-        // Manipulate the buffer
-        txt.Remove(posInChars, match_lenInChars);
-        txt.insert(posInChars, replaceWith);
-
-        // When not in 'selection only' update the editor buffer as well
-        if(!replaceInSelectionOnly) {
-            SetSelectionStart(pos);
-            SetSelectionEnd(pos + match_len);
-            ReplaceSelection(replaceWith);
-        }
+    int selStart = GetSelectionStart();
+    int selEnd = GetSelectionEnd();
+    int lengthBefore = GetLength();
 
-        m_findReplaceDlg->IncReplacedCount();
-        offset = pos + clUTF8Length(replaceWith.wc_str(), replaceWith.length()); // match_len;
+    // Find all the matches at once and replace them as a single undo action
+    size_t count = 0;
+    if(replaceInSelectionOnly) {
+        count = clSTCReplacer::ReplaceAll(this, findWhat, replaceWith, flags, selStart, selEnd);
+    } else {
+        count = clSTCReplacer::ReplaceAll(this, findWhat, replaceWith, flags);
     }
+    m_findReplaceDlg->AddReplacedCount(count);
 
     if(replaceInSelectionOnly) {
-
-        // Prepare the next selection
-        int selStart = GetSelectionStart();
-        int selEnd = selStart + txt.Len();
-
-        // replace the selection
-        ReplaceSelection(txt);
-
         // Keep the selection
         SetSelectionStart(selStart);
-        SetSelectionEnd(selEnd);
+        SetSelectionEnd(selEnd + GetLength() - lengthBefore);
 
         // place the caret at the end of the selection
         EnsureCaretVisible();
 
     } else {
-        // The editor buffer was already updated
         // Restore the caret
         SetCaretAt(savedPos);
     }
 
-    EndUndoAction();
     m_findReplaceDlg->SetReplacementsMessage();
     return m_findReplaceDlg->GetReplacedCount() > 0;
 }
@@ -4529,34 +4501,11 @@ void LEditor::DoUpdateOptions()
 
 bool LEditor::ReplaceAllExactMatch(const wxString& what, const wxString& replaceWith)
 {
-    int offset(0);
-    wxString findWhat = what;
-    size_t flags = wxSD_MATCHWHOLEWORD | wxSD_MATCHCASE;
-
-    int pos(0);
-    int match_len(0);
-    int posInChars(0);
-    int match_lenInChars(0);
-    int matchCount(0);
-    wxString txt = GetText();
-
-    while(StringFindReplacer::Search(
-        txt.wc_str(), offset, findWhat.wc_str(), flags, pos, match_len, posInChars, match_lenInChars)) {
-        txt.Remove(posInChars, match_lenInChars);
-        txt.insert(posInChars, replaceWith);
-        matchCount++;
-        offset = pos + clUTF8Length(replaceWith.wc_str(), replaceWith.length()); // match_len;
-    }
-
-    // replace the buffer
-    BeginUndoAction();
     long savedPos = GetCurrentPos();
+    size_t matchCount = clSTCReplacer::ReplaceAll(this, what, replaceWith, wxSD_MATCHWHOLEWORD | wxSD_MATCHCASE);
 
-    SetText(txt);
     // Restore the caret
     SetCaretAt(savedPos);
-
-    EndUndoAction();
     return (matchCount > 0);
 }
 
@@ -41,6 +41,7 @@
 #include "compiler_command_line_parser.h"
 #include "language.h"
 #include "code_completion_api.h"
+#include "CxxPreProcessorSharedCache.h"
 
 static CodeCompletionManager* ms_CodeCompletionManager = NULL;
 
@@ -371,6 +372,8 @@ void CodeCompletionManager::GotoDecl(LEditor* editor)
 void CodeCompletionManager::OnBuildEnded(clBuildEvent& e)
 {
     e.Skip();
+    // the build may have generated header files
+    CxxPreProcessorSharedCache::Get().ClearIncludes();
     DoUpdateCompilationDatabase();
     m_buildInProgress = false;
 }
@@ -435,6 +438,7 @@ void CodeCompletionManager::OnParseThreadCollectedMacros(const wxArrayString& de
 void CodeCompletionManager::OnFileSaved(clCommandEvent& event)
 {
     event.Skip();
+    CxxPreProcessorSharedCache::Get().FileSaved(event.GetFileName());
     if(TagsManagerST::Get()->GetCtagsOptions().GetCcColourFlags() & CC_COLOUR_MACRO_BLOCKS) {
         ProcessMacros(clMainFrame::Get()->GetMainBook()->FindEditor(event.GetFileName()));
     }
@@ -598,6 +602,7 @@ void CodeCompletionManager::OnWorkspaceClosed(wxCommandEvent& event)
     event.Skip();
     LanguageST::Get()->ClearAdditionalScopesCache();
     Project::ClearBacktickCache();
+    CxxPreProcessorSharedCache::Get().Clear();
 }
 
 void CodeCompletionManager::OnEnvironmentVariablesModified(clCommandEvent& event)
@@ -168,17 +168,20 @@ END_EVENT_TABLE()
 ContextCpp::ContextCpp(LEditor* container)
     : ContextBase(container)
     , m_rclickMenu(NULL)
+    , m_renameSearchId(0)
 {
     Initialize();
     SetName("c++");
     EventNotifier::Get()->Connect(
         wxEVT_CC_SHOW_QUICK_NAV_MENU, clCodeCompletionEventHandler(ContextCpp::OnShowCodeNavMenu), NULL, this);
     EventNotifier::Get()->Bind(wxEVT_CCBOX_SELECTION_MADE, &ContextCpp::OnCodeCompleteFiles, this);
+    EventNotifier::Get()->Bind(wxEVT_REFACTORING_ENGINE_DONE, &ContextCpp::OnRefactoringDone, this);
 }
 
 ContextCpp::ContextCpp()
     : ContextBase(wxT("c++"))
     , m_rclickMenu(NULL)
+    , m_renameSearchId(0)
 {
     EventNotifier::Get()->Connect(
         wxEVT_CC_SHOW_QUICK_NAV_MENU, clCodeCompletionEventHandler(ContextCpp::OnShowCodeNavMenu), NULL, this);
@@ -189,6 +192,7 @@ ContextCpp::~ContextCpp()
 {
     EventNotifier::Get()->Disconnect(
         wxEVT_CC_SHOW_QUICK_NAV_MENU, clCodeCompletionEventHandler(ContextCpp::OnShowCodeNavMenu), NULL, this);
+    EventNotifier::Get()->Unbind(wxEVT_REFACTORING_ENGINE_DONE, &ContextCpp::OnRefactoringDone, this);
     wxDELETE(m_rclickMenu);
 }
 
@@ -2303,22 +2307,35 @@ void ContextCpp::OnRenameGlobalSymbol(wxCommandEvent& e)
         return;
     }
 
-    RefactoringEngine::Instance()->RenameGlobalSymbol(
+    // The candidates are collected in the background, the rename dialog is shown once they are all known
+    m_renameWord = word;
+    m_renameSearchId = RefactoringEngine::Instance()->RenameGlobalSymbol(
         word, rCtrl.GetFileName(), rCtrl.LineFromPosition(pos + 1), word_start, files);
+    clMainFrame::Get()->GetStatusBar()->SetMessage(wxString::Format(_("Looking for references of '%s'..."), word));
+}
+
+void ContextCpp::OnRefactoringDone(clRefactoringEvent& event)
+{
+    event.Skip();
+    if(!m_renameSearchId || event.GetSearchId() != m_renameSearchId) return;
+    m_renameSearchId = 0;
+    clMainFrame::Get()->GetStatusBar()->SetMessage(wxEmptyString);
 
+    if(event.IsCancelled()) return;
     if(RefactoringEngine::Instance()->GetCandidates().empty() &&
        RefactoringEngine::Instance()->GetPossibleCandidates().empty())
         return;
 
     // display the refactor dialog
+    LEditor& rCtrl = GetCtrl();
     RenameSymbol dlg(&rCtrl,
                      RefactoringEngine::Instance()->GetCandidates(),
                      RefactoringEngine::Instance()->GetPossibleCandidates(),
-                     word);
+                     m_renameWord);
     if(dlg.ShowModal() == wxID_OK) {
         CppToken::List_t matches;
         dlg.GetMatches(matches);
-        if(!matches.empty() && dlg.GetWord() != word) {
+        if(!matches.empty() && dlg.GetWord() != m_renameWord) {
             ReplaceInFiles(dlg.GetWord(), matches);
         }
     }
@@ -3009,13 +3026,10 @@ void ContextCpp::OnFindReferences(wxCommandEvent& e)
     wxFileList_t files;
     ManagerST::Get()->GetWorkspaceFiles(files, true);
 
-    // Invoke the RefactorEngine
-    RefactoringEngine::Instance()->FindReferences(
+    // Invoke the RefactorEngine, the results are shown as they are found
+    size_t searchId = RefactoringEngine::Instance()->FindReferences(
         word, rCtrl.GetFileName(), rCtrl.LineFromPosition(pos + 1), word_start, files);
-
-    // Show the results
-    clMainFrame::Get()->GetOutputPane()->GetShowUsageTab()->ShowUsage(RefactoringEngine::Instance()->GetCandidates(),
-                                                                      word);
+    clMainFrame::Get()->GetOutputPane()->GetShowUsageTab()->StartUsage(searchId, word);
 }
 
 bool ContextCpp::IsDefaultContext() const { return false; }
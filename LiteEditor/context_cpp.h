@@ -31,6 +31,7 @@
 #include <map>
 #include "entry.h"
 #include "cl_command_event.h"
+#include "refactorengine.h"
 
 class RefactorSource;
 
@@ -38,6 +39,8 @@ class ContextCpp : public ContextBase
 {
     std::map<wxString, int> m_propertyInt;
     wxMenu* m_rclickMenu;
+    size_t m_renameSearchId; // the references search of "Rename Symbol"
+    wxString m_renameWord;
 
     static wxBitmap m_cppFileBmp;
     static wxBitmap m_hFileBmp;
@@ -45,6 +48,7 @@ class ContextCpp : public ContextBase
 protected:
     void OnShowCodeNavMenu(clCodeCompletionEvent& e);
     void OnCodeCompleteFiles(clCodeCompletionEvent& event);
+    void OnRefactoringDone(clRefactoringEvent& event);
 
 private:
     bool TryOpenFile(const wxFileName& fileName, bool lookInEntireWorkspace = true);
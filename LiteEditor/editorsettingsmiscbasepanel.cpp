@@ -112,6 +112,12 @@ EditorSettingsMiscBasePanel::EditorSettingsMiscBasePanel(wxWindow* parent, wxWin
     
     staticBoxSizer4->Add(m_checkBoxRestoreSession, 0, wxALL, 5);
     
+    m_checkBoxFindInFilesIndex = new wxCheckBox(m_panel1, wxID_ANY, _("Index the workspace files for Find In Files"), wxDefaultPosition, wxSize(-1,-1), 0);
+    m_checkBoxFindInFilesIndex->SetValue(false);
+    m_checkBoxFindInFilesIndex->SetToolTip(_("Keep an index of the workspace files content, so Find In Files only searches the files that may contain the searched text. Takes effect when a workspace is loaded"));
+    
+    staticBoxSizer4->Add(m_checkBoxFindInFilesIndex, 0, wxALL, 5);
+    
     m_panel23 = new wxPanel(m_notebook2, wxID_ANY, wxDefaultPosition, wxSize(-1,-1), wxTAB_TRAVERSAL);
     m_notebook2->AddPage(m_panel23, _("Frame Title"), false);
     
@@ -45,6 +45,7 @@ protected:
     wxCheckBox* m_singleAppInstance;
     wxCheckBox* m_versionCheckOnStartup;
     wxCheckBox* m_checkBoxRestoreSession;
+    wxCheckBox* m_checkBoxFindInFilesIndex;
     wxPanel* m_panel23;
     wxBannerWindow* m_banner27;
     wxStaticText* m_staticText31;
@@ -102,6 +103,7 @@ public:
     wxCheckBox* GetSingleAppInstance() { return m_singleAppInstance; }
     wxCheckBox* GetVersionCheckOnStartup() { return m_versionCheckOnStartup; }
     wxCheckBox* GetCheckBoxRestoreSession() { return m_checkBoxRestoreSession; }
+    wxCheckBox* GetCheckBoxFindInFilesIndex() { return m_checkBoxFindInFilesIndex; }
     wxPanel* GetPanel1() { return m_panel1; }
     wxBannerWindow* GetBanner27() { return m_banner27; }
     wxStaticText* GetStaticText31() { return m_staticText31; }
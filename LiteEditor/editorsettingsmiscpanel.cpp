@@ -35,6 +35,7 @@
 #include "ctags_manager.h"
 #include "globals.h"
 #include "cl_config.h"
+#include "clTrigramIndex.h"
 
 #ifdef __WXMSW__
 #include <wx/msw/uxtheme.h>
@@ -99,6 +100,7 @@ EditorSettingsMiscPanel::EditorSettingsMiscPanel(wxWindow* parent)
     m_choice4->SetStringSelection(
         FileLogger::GetVerbosityAsString(clConfig::Get().Read(kConfigLogVerbosity, FileLogger::Error)));
     m_checkBoxRestoreSession->SetValue(clConfig::Get().Read(kConfigRestoreLastSession, true));
+    m_checkBoxFindInFilesIndex->SetValue(options->IsFindInFilesIndex());
     m_textCtrlPattern->ChangeValue(clConfig::Get().Read(kConfigFrameTitlePattern, wxString("$workspace $fullpath")));
 
     bool showSplash = info.GetFlags() & CL_SHOW_SPLASH ? true : false;
@@ -130,6 +132,12 @@ void EditorSettingsMiscPanel::Save(OptionsConfigPtr options)
         m_restartRequired = true;
     }
 
+    // The index is started when a workspace is loaded
+    options->SetFindInFilesIndex(m_checkBoxFindInFilesIndex->IsChecked());
+    if(!m_checkBoxFindInFilesIndex->IsChecked()) {
+        clTrigramIndex::Get().Close();
+    }
+
     clConfig::Get().Write(kConfigSingleInstance, m_singleAppInstance->IsChecked());
     clConfig::Get().Write(kConfigCheckForNewVersion, m_versionCheckOnStartup->IsChecked());
     clConfig::Get().Write(kConfigMaxItemsInFindReplaceDialog, ::wxStringToInt(m_maxItemsFindReplace->GetValue(), 15));
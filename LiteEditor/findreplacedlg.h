@@ -183,6 +183,7 @@ public:
     void SetReplacementsMessage(enum frd_showzero showzero = frd_showzeros);
     unsigned int GetReplacedCount() { return m_replacedCount; }
     void IncReplacedCount() { ++m_replacedCount; }
+    void AddReplacedCount(unsigned int count) { m_replacedCount += count; }
     void ResetReplacedCount() { m_replacedCount = 0; }
     void ResetSelectionOnlyFlag();
     void SetFindReplaceData(FindReplaceData& data, bool focus);
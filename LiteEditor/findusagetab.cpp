@@ -37,6 +37,7 @@
 
 FindUsageTab::FindUsageTab(wxWindow* parent, const wxString& name)
     : OutputTabWindow(parent, wxID_ANY, name)
+    , m_searchId(0)
 {
     FindResultsTab::SetStyles(m_sci);
     m_sci->HideSelection(true);
@@ -45,12 +46,16 @@ FindUsageTab::FindUsageTab(wxWindow* parent, const wxString& name)
     m_tb->Realize();
     EventNotifier::Get()->Connect(
         wxEVT_CL_THEME_CHANGED, wxCommandEventHandler(FindUsageTab::OnThemeChanged), NULL, this);
+    EventNotifier::Get()->Bind(wxEVT_REFACTORING_ENGINE_MATCHES, &FindUsageTab::OnRefactoringMatches, this);
+    EventNotifier::Get()->Bind(wxEVT_REFACTORING_ENGINE_DONE, &FindUsageTab::OnRefactoringDone, this);
 }
 
 FindUsageTab::~FindUsageTab()
 {
     EventNotifier::Get()->Disconnect(
         wxEVT_CL_THEME_CHANGED, wxCommandEventHandler(FindUsageTab::OnThemeChanged), NULL, this);
+    EventNotifier::Get()->Unbind(wxEVT_REFACTORING_ENGINE_MATCHES, &FindUsageTab::OnRefactoringMatches, this);
+    EventNotifier::Get()->Unbind(wxEVT_REFACTORING_ENGINE_DONE, &FindUsageTab::OnRefactoringDone, this);
 }
 
 void FindUsageTab::OnStyleNeeded(wxStyledTextEvent& e)
@@ -63,10 +68,19 @@ void FindUsageTab::OnStyleNeeded(wxStyledTextEvent& e)
 void FindUsageTab::Clear()
 {
     m_matches.clear();
+    m_curfile.Clear();
+    m_curfileLines.Clear();
     OutputTabWindow::Clear();
 }
 
-void FindUsageTab::OnClearAll(wxCommandEvent& e) { Clear(); }
+void FindUsageTab::OnClearAll(wxCommandEvent& e)
+{
+    // Clearing the output stops the search as well
+    if(m_searchId && RefactoringEngine::Instance()->IsSearchRunning()) {
+        RefactoringEngine::Instance()->CancelSearch();
+    }
+    Clear();
+}
 
 void FindUsageTab::OnMouseDClick(wxStyledTextEvent& e)
 {
@@ -83,24 +97,33 @@ void FindUsageTab::OnMouseDClick(wxStyledTextEvent& e)
 void FindUsageTab::OnClearAllUI(wxUpdateUIEvent& e) { e.Enable(m_sci && m_sci->GetLength()); }
 
 void FindUsageTab::ShowUsage(const std::list<CppToken>& matches, const wxString& searchWhat)
+{
+    StartUsage(0, searchWhat);
+    DoAppendMatches(matches);
+    AppendText(wxString::Format(_("===== Found total of %u matches =====\n"), (unsigned int)m_matches.size()));
+}
+
+void FindUsageTab::StartUsage(size_t searchId, const wxString& searchWhat)
 {
     Clear();
-    int lineNumber(0);
-    wxString text;
-    wxString curfile;
-    wxString curfileContent;
-    wxArrayString lines;
+    m_searchId = searchId;
+    AppendText(wxString::Format(_("===== Finding references of '%s' =====\n"), searchWhat.c_str()));
+}
 
-    text = wxString::Format(_("===== Finding references of '%s' =====\n"), searchWhat.c_str());
-    lineNumber++;
+void FindUsageTab::DoAppendMatches(const std::list<CppToken>& matches)
+{
+    // The output line of the first match
+    int lineNumber = m_sci->GetLineCount() - 1;
+    wxString text;
 
     std::list<CppToken>::const_iterator iter = matches.begin();
     for(; iter != matches.end(); iter++) {
 
         // Print the line number
         wxString file_name(iter->getFilename());
-        if(curfile != file_name) {
-            curfile = file_name;
+        if(m_curfile != file_name) {
+            m_curfile = file_name;
+            m_curfileLines.Clear();
             wxFileName fn(file_name);
             fn.MakeRelativeTo();
 
@@ -111,17 +134,12 @@ void FindUsageTab::ShowUsage(const std::list<CppToken>& matches, const wxString&
             wxLogNull nolog;
             wxFFile thefile(file_name, wxT("rb"));
             if(thefile.IsOpened()) {
-
-                wxFileOffset size = thefile.Length();
-                wxString fileData;
-                fileData.Alloc(size);
-                curfileContent.Clear();
-
+                wxString curfileContent;
                 wxCSConv fontEncConv(wxFONTENCODING_ISO8859_1);
                 thefile.ReadAll(&curfileContent, fontEncConv);
 
                 // break the current file into lines, a line can be an empty string
-                lines = wxStringTokenize(curfileContent, wxT("\n"), wxTOKEN_RET_EMPTY_ALL);
+                m_curfileLines = wxStringTokenize(curfileContent, wxT("\n"), wxTOKEN_RET_EMPTY_ALL);
             }
         }
 
@@ -137,15 +155,39 @@ void FindUsageTab::ShowUsage(const std::list<CppToken>& matches, const wxString&
         }
 
         text << linenum << wxT("[ ") << scopeName << wxT(" ] ");
-        if(lines.GetCount() > iter->getLineNumber()) {
-            text << lines.Item(iter->getLineNumber()).Trim().Trim(false);
+        if(m_curfileLines.GetCount() > iter->getLineNumber()) {
+            text << m_curfileLines.Item(iter->getLineNumber()).Trim().Trim(false);
         }
 
         text << wxT("\n");
         lineNumber++;
     }
-    text << wxString::Format(_("===== Found total of %u matches =====\n"), (unsigned int)m_matches.size());
-    AppendText(text);
+
+    if(!text.IsEmpty()) {
+        AppendText(text);
+    }
+}
+
+void FindUsageTab::OnRefactoringMatches(clRefactoringEvent& e)
+{
+    e.Skip();
+    if(!m_searchId || e.GetSearchId() != m_searchId) return;
+    DoAppendMatches(e.GetMatches());
+    clMainFrame::Get()->GetStatusBar()->SetMessage(wxString::Format(_("Finding references: %d%%"), e.GetProgress()));
+}
+
+void FindUsageTab::OnRefactoringDone(clRefactoringEvent& e)
+{
+    e.Skip();
+    if(!m_searchId || e.GetSearchId() != m_searchId) return;
+    m_searchId = 0;
+
+    if(e.IsCancelled()) {
+        AppendText(_("===== Search cancelled =====\n"));
+    } else {
+        AppendText(wxString::Format(_("===== Found total of %u matches =====\n"), (unsigned int)m_matches.size()));
+    }
+    clMainFrame::Get()->GetStatusBar()->SetMessage(wxEmptyString);
 }
 
 void FindUsageTab::DoOpenResult(const CppToken& token)
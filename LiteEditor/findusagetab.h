@@ -28,14 +28,22 @@
 
 #include "outputtabwindow.h" // Base class OutputTabWindow
 #include "cpptoken.h"
+#include "refactorengine.h"
 
 typedef std::map<int, CppToken> UsageResultsMap;
 
 class FindUsageTab : public OutputTabWindow
 {
     UsageResultsMap m_matches;
+    size_t m_searchId; // the references search whose matches are shown
+    wxString m_curfile;
+    wxArrayString m_curfileLines;
+
 protected:
     void DoOpenResult(const CppToken& token);
+    void DoAppendMatches(const std::list<CppToken>& matches);
+    void OnRefactoringMatches(clRefactoringEvent& e);
+    void OnRefactoringDone(clRefactoringEvent& e);
 
 public:
     FindUsageTab(wxWindow* parent, const wxString &name);
@@ -52,6 +60,11 @@ public:
 public:
     void ShowUsage(const std::list<CppToken> &matches, const wxString &searchWhat);
 
+    /**
+     * @brief show the matches of the references search 'searchId' as they are reported by the RefactoringEngine
+     */
+    void StartUsage(size_t searchId, const wxString& searchWhat);
+
 };
 
 #endif // FINDUSAGETAB_H
@@ -51,6 +51,7 @@
 #include "bookmark_manager.h"
 #include <wx/richmsgdlg.h>
 #include "code_completion_manager.h"
+#include "clTrigramIndex.h"
 #include "clang_compilation_db_thread.h"
 #include "cl_unredo.h"
 #include "NewProjectWizard.h"
@@ -810,6 +811,9 @@ clMainFrame::~clMainFrame(void)
     // Free the code completion manager
     CodeCompletionManager::Release();
 
+    // Stop the find in files index
+    clTrigramIndex::Release();
+
 // this will make sure that the main menu bar's member m_widget is freed before the we enter wxMenuBar destructor
 // see this wxWidgets bug report for more details:
 //  http://trac.wxwidgets.org/ticket/14292
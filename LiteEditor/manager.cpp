@@ -53,6 +53,8 @@
 #include <wx/regex.h>
 
 #include "jobqueue.h"
+#include "clTaskExecutor.h"
+#include "performance.h"
 #include "parse_thread.h"
 #include "search_thread.h"
 #include "pluginmanager.h"
@@ -103,6 +105,7 @@
 #include "clKeyboardManager.h"
 #include "wxCodeCompletionBoxManager.h"
 #include "localworkspace.h"
+#include "clTrigramIndex.h"
 
 #ifndef __WXMSW__
 #include <sys/wait.h>
@@ -237,6 +240,8 @@ Manager::~Manager(void)
     {
         // wxLogNull noLog;
         JobQueueSingleton::Instance()->Stop();
+        // Plugins submit tasks too, stop the executor before they are unloaded
+        clTaskExecutor::Get()->Stop();
         ParseThreadST::Get()->Stop();
         SearchThreadST::Get()->Stop();
         ClangCompilationDbThreadST::Get()->Stop();
@@ -249,6 +254,7 @@ Manager::~Manager(void)
     ClangCompilationDbThreadST::Free();
     DebuggerMgr::Free();
     JobQueueSingleton::Release();
+    clTaskExecutor::Release();
     ParseThreadST::Free(); // since the parser is making use of the TagsManager,
     TagsManagerST::Free(); // it is important to release it *before* the TagsManager
     LanguageST::Free();
@@ -340,6 +346,7 @@ void Manager::ReloadWorkspace()
 
 void Manager::DoSetupWorkspace(const wxString& path)
 {
+    CL_TRACE_FUNCTION("workspace");
     wxString errMsg;
     wxBusyCursor cursor;
     AddToRecentlyOpenedWorkspaces(path);
@@ -358,6 +365,18 @@ void Manager::DoSetupWorkspace(const wxString& path)
     // Initialize the cache
     RefactoringEngine::Instance()->InitializeCache(allfiles);
 
+    // Start the find in files index, it is kept next to the tags database
+    if(EditorConfigST::Get()->GetOptions()->IsFindInFilesIndex() && TagsManagerST::Get()->GetDatabase()) {
+        wxFileName indexFile = TagsManagerST::Get()->GetDatabase()->GetDatabaseFileName();
+        indexFile.SetExt("trigrams");
+
+        wxArrayString files;
+        for(size_t i = 0; i < allfiles.size(); ++i) {
+            files.Add(allfiles.at(i).GetFullPath());
+        }
+        clTrigramIndex::Get().Open(indexFile.GetFullPath(), files);
+    }
+
     {
         SessionEntry session;
         if(SessionManager::Get().GetSession(path, session)) {
@@ -907,6 +926,7 @@ wxFileName Manager::FindFile(const wxArrayString& files, const wxFileName& fn)
 
 void Manager::RetagWorkspace(TagsManager::RetagType type)
 {
+    CL_TRACE_FUNCTION("workspace");
     SetRetagInProgress(true);
 
     // in the case of re-tagging the entire workspace and full re-tagging is enabled
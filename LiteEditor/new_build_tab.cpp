@@ -49,6 +49,10 @@
 #include <wx/fdrepdlg.h>
 #include "buildtabsettingsdata.h"
 #include "cl_command_event.h"
+#include "BuildOutputClassifier.h"
+#include "BuildLogStore.h"
+#include "performance.h"
+#include "stringsearcher.h"
 
 static size_t BUILD_PANE_WIDTH = 10000;
 
@@ -59,7 +63,7 @@ static const wxChar* SUMMARY_MARKER_WARNING = wxT("@@SUMMARY_WARNING@@");
 static const wxChar* SUMMARY_MARKER_SUCCESS = wxT("@@SUMMARY_SUCCESS@@");
 static const wxChar* SUMMARY_MARKER = wxT("@@SUMMARY@@");
 
-#define IS_VALID_LINE(lineNumber) ((lineNumber >= 0 && lineNumber < m_listctrl->GetItemCount()))
+#define IS_VALID_LINE(lineNumber) ((lineNumber >= 0 && lineNumber < (int)m_buildLog.GetCount()))
 #ifdef __WXMSW__
 #define IS_WINDOWS true
 #else
@@ -76,22 +80,65 @@ void SetActive(LEditor* editor)
     wxPostEvent(clMainFrame::Get(), event);
 }
 
-static void StripBuildMarkders(wxString& s)
+// Build output kept in memory before the oldest lines are moved to a temporary file
+#define BUILD_LOG_MAX_MEMORY (64 * 1024 * 1024)
+
+// A virtual list model: the rows are read from the build log store only when they are displayed
+class BuildLogModel : public wxDataViewVirtualListModel
 {
-    s.StartsWith(WARNING_MARKER, &s);
-    s.StartsWith(ERROR_MARKER, &s);
-    s.StartsWith(SUMMARY_MARKER, &s);
-    s.StartsWith(SUMMARY_MARKER_ERROR, &s);
-    s.StartsWith(SUMMARY_MARKER_SUCCESS, &s);
-    s.StartsWith(SUMMARY_MARKER_WARNING, &s);
-}
+    const BuildLogStore* m_store;
+
+public:
+    BuildLogModel(const BuildLogStore* store)
+        : wxDataViewVirtualListModel(0)
+        , m_store(store)
+    {
+    }
+    virtual ~BuildLogModel() {}
+
+    virtual unsigned int GetColumnCount() const { return 2; }
+    virtual wxString GetColumnType(unsigned int col) const { return "string"; }
+    virtual bool SetValueByRow(const wxVariant& variant, unsigned int row, unsigned int col) { return false; }
+
+    virtual void GetValueByRow(wxVariant& variant, unsigned int row, unsigned int col) const
+    {
+        if(col != 0 || row >= m_store->GetCount()) {
+            variant = wxString();
+            return;
+        }
+
+        // Add the markers used by the renderer
+        wxString text = m_store->GetLine(row);
+        int flags = m_store->GetFlags(row);
+        int severity = flags & BuildLogStore::kSeverityMask;
+        if(flags & BuildLogStore::kSummary) {
+            if(severity == SV_ERROR) {
+                text.Prepend(SUMMARY_MARKER_ERROR);
+
+            } else if(severity == SV_WARNING) {
+                text.Prepend(SUMMARY_MARKER_WARNING);
+
+            } else {
+                text.Prepend(SUMMARY_MARKER_SUCCESS);
+            }
+            text.Prepend(SUMMARY_MARKER);
+
+        } else if(severity == SV_ERROR) {
+            text.Prepend(ERROR_MARKER);
+
+        } else if(severity == SV_WARNING) {
+            text.Prepend(WARNING_MARKER);
+        }
+        variant = text;
+    }
+};
 
 // A renderer for drawing the text
 class MyTextRenderer : public wxDataViewCustomRenderer
 {
     wxFont m_font;
     wxColour m_greyColor;
-    wxDataViewListCtrl* m_listctrl;
+    wxDataViewCtrl* m_listctrl;
     wxColour m_warnFgColor;
     wxColour m_errFgColor;
     wxVariant m_value;
@@ -101,7 +148,7 @@ class MyTextRenderer : public wxDataViewCustomRenderer
     int m_charWidth;
 
 public:
-    MyTextRenderer(wxDataViewListCtrl* listctrl)
+    MyTextRenderer(wxDataViewCtrl* listctrl)
         : m_listctrl(listctrl)
         , m_charWidth(12)
     {
@@ -243,6 +290,8 @@ NewBuildTab::NewBuildTab(wxWindow* parent)
     , m_skipWarnings(false)
     , m_buildpaneScrollTo(ScrollToFirstError)
     , m_buildInProgress(false)
+    , m_classifier(new BuildOutputClassifier())
+    , m_classifierThread(NULL)
 {
     m_curError = m_errorsAndWarningsList.end();
     wxBoxSizer* bs = new wxBoxSizer(wxHORIZONTAL);
@@ -257,7 +306,11 @@ NewBuildTab::NewBuildTab(wxWindow* parent)
     memDc.GetTextExtent(wxT("Tp"), &xx, &yy, NULL, NULL, &fnt);
     int style = wxDV_NO_HEADER | wxDV_MULTIPLE;
 
-    m_listctrl = new wxDataViewListCtrl(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, style);
+    m_listctrl = new wxDataViewCtrl(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, style);
+    m_buildLog.EnableSpill(true, BUILD_LOG_MAX_MEMORY);
+    m_model = new BuildLogModel(&m_buildLog);
+    m_listctrl->AssociateModel(m_model);
+    m_model->DecRef(); // the control owns the model now
     m_listctrl->Connect(
         wxEVT_COMMAND_DATAVIEW_ITEM_CONTEXT_MENU, wxContextMenuEventHandler(NewBuildTab::OnMenu), NULL, this);
 
@@ -294,7 +347,7 @@ NewBuildTab::NewBuildTab(wxWindow* parent)
 
     m_listctrl->AppendColumn(new wxDataViewColumn(_("Message"), m_textRenderer, 0, screenWidth, wxALIGN_LEFT));
 #ifdef __WXMSW__
-    m_listctrl->AppendTextColumn("");
+    m_listctrl->AppendTextColumn("", 1);
 #endif
 
     EventNotifier::Get()->Connect(
@@ -324,10 +377,15 @@ NewBuildTab::NewBuildTab(wxWindow* parent)
 
     m_listctrl->Connect(
         wxEVT_COMMAND_DATAVIEW_ITEM_ACTIVATED, wxDataViewEventHandler(NewBuildTab::OnLineSelected), NULL, this);
+    Connect(wxEVT_BUILD_OUTPUT_CLASSIFIED, wxCommandEventHandler(NewBuildTab::OnBuildOutputClassified), NULL, this);
 }
 
 NewBuildTab::~NewBuildTab()
 {
+    DoStopClassifier(true);
+    wxDELETE(m_classifier);
+    Disconnect(wxEVT_BUILD_OUTPUT_CLASSIFIED, wxCommandEventHandler(NewBuildTab::OnBuildOutputClassified), NULL, this);
+
     m_listctrl->Disconnect(
         wxEVT_COMMAND_DATAVIEW_ITEM_CONTEXT_MENU, wxContextMenuEventHandler(NewBuildTab::OnMenu), NULL, this);
 
@@ -353,12 +411,16 @@ NewBuildTab::~NewBuildTab()
 
 void NewBuildTab::OnBuildEnded(clCommandEvent& e)
 {
+    CL_TRACE_FUNCTION("build");
     e.Skip();
     CL_DEBUG("Build Ended!");
     m_buildInProgress = false;
 
     DoProcessOutput(true, false);
 
+    // The summary needs all the lines to be classified
+    DoStopClassifier(false);
+
     std::vector<LEditor*> editors;
     clMainFrame::Get()->GetMainBook()->GetAllEditors(editors, MainBook::kGetAll_Default);
     for(size_t i = 0; i < editors.size(); i++) {
@@ -404,8 +466,10 @@ void NewBuildTab::OnBuildEnded(clCommandEvent& e)
 void NewBuildTab::OnBuildStarted(clCommandEvent& e)
 {
     e.Skip();
+    DoStopClassifier(false);
+
     if(IS_WINDOWS) {
-        m_cygwinRoot.Clear();
+        wxString cygwinRoot;
         EnvSetter es;
         wxString cmd;
         cmd << "cygpath -w /";
@@ -413,8 +477,9 @@ void NewBuildTab::OnBuildStarted(clCommandEvent& e)
         ProcUtils::SafeExecuteCommand(cmd, arrOut);
 
         if(arrOut.IsEmpty() == false) {
-            m_cygwinRoot = arrOut.Item(0);
+            cygwinRoot = arrOut.Item(0);
         }
+        m_classifier->SetCygwinRoot(cygwinRoot);
     }
 
     m_buildInProgress = true;
@@ -467,10 +532,19 @@ void NewBuildTab::OnBuildStarted(clCommandEvent& e)
         buildEvent.SetConfigurationName(bed->GetConfiguration());
         EventNotifier::Get()->AddPendingEvent(buildEvent);
     }
+
+    // Pick the patterns of the build compiler once, and classify the output in the background
+    CmpPatterns cmpPatterns;
+    if(m_cmp) {
+        DoGetCompilerPatterns(m_cmp->GetName(), cmpPatterns);
+    }
+    m_classifier->SetPatterns(cmpPatterns);
+    DoStartClassifier();
 }
 
 void NewBuildTab::OnBuildAddLine(clCommandEvent& e)
 {
+    CL_TRACE_FUNCTION("build");
     e.Skip(); // Allways call skip..
     m_output << e.GetString();
     DoProcessOutput(false, false);
@@ -478,74 +552,21 @@ void NewBuildTab::OnBuildAddLine(clCommandEvent& e)
 
 BuildLineInfo* NewBuildTab::DoProcessLine(const wxString& line, bool isSummaryLine)
 {
-    BuildLineInfo* buildLineInfo = new BuildLineInfo();
-
-    if(isSummaryLine) {
-        // Set the severity
-        if(m_errorCount == 0 && m_warnCount == 0) {
-            buildLineInfo->SetSeverity(SV_SUCCESS);
-
-        } else if(m_errorCount) {
-            buildLineInfo->SetSeverity(SV_ERROR);
+    if(!isSummaryLine) {
+        return m_classifier->Classify(line);
+    }
 
-        } else {
+    // Set the severity
+    BuildLineInfo* buildLineInfo = new BuildLineInfo();
+    if(m_errorCount == 0 && m_warnCount == 0) {
+        buildLineInfo->SetSeverity(SV_SUCCESS);
 
-            buildLineInfo->SetSeverity(SV_WARNING);
-        }
+    } else if(m_errorCount) {
+        buildLineInfo->SetSeverity(SV_ERROR);
 
     } else {
 
-        // Find *warnings* first
-        bool isWarning = false;
-
-        if(!m_cmp) {
-            return buildLineInfo;
-        }
-
-        CmpPatterns cmpPatterns;
-        if(!DoGetCompilerPatterns(m_cmp->GetName(), cmpPatterns)) {
-            return buildLineInfo;
-        }
-
-        // If it is not an error, maybe it's a warning
-        for(size_t i = 0; i < cmpPatterns.warningPatterns.size(); i++) {
-            CmpPatternPtr cmpPatterPtr = cmpPatterns.warningPatterns.at(i);
-            BuildLineInfo bli;
-            if(cmpPatterPtr->Matches(line, bli)) {
-                buildLineInfo->SetFilename(bli.GetFilename());
-                buildLineInfo->SetSeverity(bli.GetSeverity());
-                buildLineInfo->SetLineNumber(bli.GetLineNumber());
-                buildLineInfo->NormalizeFilename(m_directories, m_cygwinRoot);
-                buildLineInfo->SetRegexLineMatch(bli.GetRegexLineMatch());
-                buildLineInfo->SetColumn(bli.GetColumn());
-                // keep this info in the errors+warnings list only
-                m_errorsAndWarningsList.push_back(buildLineInfo);
-
-                m_warnCount++;
-                isWarning = true;
-                break;
-            }
-        }
-        if(!isWarning) {
-            for(size_t i = 0; i < cmpPatterns.errorsPatterns.size(); i++) {
-                BuildLineInfo bli;
-                CmpPatternPtr cmpPatterPtr = cmpPatterns.errorsPatterns.at(i);
-                if(cmpPatterPtr->Matches(line, bli)) {
-                    buildLineInfo->SetFilename(bli.GetFilename());
-                    buildLineInfo->SetSeverity(bli.GetSeverity());
-                    buildLineInfo->SetLineNumber(bli.GetLineNumber());
-                    buildLineInfo->NormalizeFilename(m_directories, m_cygwinRoot);
-                    buildLineInfo->SetRegexLineMatch(bli.GetRegexLineMatch());
-                    buildLineInfo->SetColumn(bli.GetColumn());
-
-                    // keep this info in both lists (errors+warnings AND errors)
-                    m_errorsAndWarningsList.push_back(buildLineInfo);
-                    m_errorsList.push_back(buildLineInfo);
-                    m_errorCount++;
-                    break;
-                }
-            }
-        }
+        buildLineInfo->SetSeverity(SV_WARNING);
     }
     return buildLineInfo;
 }
@@ -567,6 +588,10 @@ void NewBuildTab::DoCacheRegexes()
             CmpPatternPtr compiledPatternPtr(new CmpPattern(
                 new wxRegEx(iter->pattern), iter->fileNameIndex, iter->lineNumberIndex, iter->columnIndex, SV_ERROR));
             if(compiledPatternPtr->GetRegex()->IsValid()) {
+                // The literals every match requires: lines without them skip the regex
+                wxArrayString literals;
+                StringFindReplacer::GetRegexLiterals(iter->pattern, literals);
+                compiledPatternPtr->SetLiterals(literals);
                 cmpPatterns.errorsPatterns.push_back(compiledPatternPtr);
             }
         }
@@ -576,6 +601,9 @@ void NewBuildTab::DoCacheRegexes()
             CmpPatternPtr compiledPatternPtr(new CmpPattern(
                 new wxRegEx(iter->pattern), iter->fileNameIndex, iter->lineNumberIndex, iter->columnIndex, SV_WARNING));
             if(compiledPatternPtr->GetRegex()->IsValid()) {
+                wxArrayString literals;
+                StringFindReplacer::GetRegexLiterals(iter->pattern, literals);
+                compiledPatternPtr->SetLiterals(literals);
                 cmpPatterns.warningPatterns.push_back(compiledPatternPtr);
             }
         }
@@ -600,8 +628,10 @@ void NewBuildTab::DoClear()
     wxFont font = DoGetFont();
     m_textRenderer->SetFont(font);
 
+    DoStopClassifier(true);
+    m_classifier->Clear();
+
     m_buildInterrupted = false;
-    m_directories.Clear();
     m_buildInfoPerFile.clear();
     m_warnCount = 0;
     m_errorCount = 0;
@@ -609,18 +639,9 @@ void NewBuildTab::DoClear()
     m_errorsList.clear();
     m_cmpPatterns.clear();
 
-    // Delete all the user data
-    int count = m_listctrl->GetItemCount();
-    for(int i = 0; i < count; i++) {
-        wxDataViewItem item = m_listctrl->GetStore()->GetItem(i);
-        if(item.IsOk()) {
-            BuildLineInfo* bli = (BuildLineInfo*)m_listctrl->GetItemData(item);
-            if(bli) {
-                delete bli;
-            }
-        }
-    }
-    m_listctrl->DeleteAllItems();
+    // Delete all the lines and their information
+    m_buildLog.Clear();
+    m_model->Reset(0);
 
     // Clear all markers from open editors
     std::vector<LEditor*> editors;
@@ -666,10 +687,7 @@ void NewBuildTab::MarkEditor(LEditor* editor)
 
     for(; iter.first != iter.second; ++iter.first) {
         BuildLineInfo* bli = iter.first->second;
-        wxString text = m_listctrl->GetTextValue(bli->GetLineInBuildTab(), 0).Trim().Trim(false);
-
-        // strip any build markers
-        StripBuildMarkders(text);
+        wxString text = m_buildLog.GetLine(bli->GetLineInBuildTab()).Trim().Trim(false);
 
         // remove the line part from the text
         text = text.Mid(bli->GetRegexLineMatch());
@@ -714,18 +732,6 @@ void NewBuildTab::MarkEditor(LEditor* editor)
     editor->Refresh();
 }
 
-void NewBuildTab::DoSearchForDirectory(const wxString& line)
-{
-    // Check for makefile directory changes lines
-    if(line.Contains(wxT("Entering directory `"))) {
-        wxString currentDir = line.AfterFirst(wxT('`'));
-        currentDir = currentDir.BeforeLast(wxT('\''));
-
-        // Collect the m_baseDir
-        m_directories.Add(currentDir);
-    }
-}
-
 void NewBuildTab::OnLineSelected(wxDataViewEvent& e)
 {
     if(e.GetItem().IsOk()) {
@@ -756,67 +762,117 @@ void NewBuildTab::DoProcessOutput(bool compilationEnded, bool isSummaryLine)
     m_output.Clear();
 
     // Process only completed lines (i.e. a line that ends with '\n')
+    if(!compilationEnded && !lines.IsEmpty() && !lines.Last().EndsWith(wxT("\n"))) {
+        m_output << lines.Last();
+        lines.RemoveAt(lines.GetCount() - 1);
+    }
+
+    if(m_classifierThread && !isSummaryLine) {
+        // The lines are added to the view once they are classified
+        m_classifierThread->AddLines(lines);
+        return;
+    }
+
     for(size_t i = 0; i < lines.GetCount(); i++) {
-        if(!compilationEnded && !lines.Item(i).EndsWith(wxT("\n"))) {
-            m_output << lines.Item(i);
-            return;
+        wxString buildLine = lines.Item(i); //.Trim().Trim(false);
+        DoAppendLine(buildLine, DoProcessLine(buildLine, isSummaryLine), isSummaryLine);
+    }
+    DoAutoScroll();
+}
+
+void NewBuildTab::DoAppendLine(wxString buildLine, BuildLineInfo* buildLineInfo, bool isSummaryLine)
+{
+    if(!isSummaryLine) {
+        if(buildLineInfo->GetSeverity() == SV_WARNING) {
+            // keep this info in the errors+warnings list only
+            m_errorsAndWarningsList.push_back(buildLineInfo);
+            m_warnCount++;
+
+        } else if(buildLineInfo->GetSeverity() == SV_ERROR) {
+            // keep this info in both lists (errors+warnings AND errors)
+            m_errorsAndWarningsList.push_back(buildLineInfo);
+            m_errorsList.push_back(buildLineInfo);
+            m_errorCount++;
         }
+    }
 
-        wxString buildLine = lines.Item(i); //.Trim().Trim(false);
-        // If this is a line similar to 'Entering directory `'
-        // add the path in the directories array
-        DoSearchForDirectory(buildLine);
-        BuildLineInfo* buildLineInfo = DoProcessLine(buildLine, isSummaryLine);
+    int flags = buildLineInfo->GetSeverity();
+    if(isSummaryLine) {
+        flags |= BuildLogStore::kSummary;
+    }
 
-        // keep the line info
+    // Only the lines that can be navigated to or opened keep their information,
+    // for all the other lines the severity stored in the flags is enough
+    bool keepInfo = !isSummaryLine && (buildLineInfo->GetSeverity() == SV_ERROR ||
+                                       buildLineInfo->GetSeverity() == SV_WARNING ||
+                                       !buildLineInfo->GetFilename().IsEmpty());
+    if(keepInfo) {
+        // Keep the line number in the build tab
+        buildLineInfo->SetLineInBuildTab(m_buildLog.GetCount());
         if(buildLineInfo->GetFilename().IsEmpty() == false) {
             m_buildInfoPerFile.insert(std::make_pair(buildLineInfo->GetFilename(), buildLineInfo));
         }
+    } else {
+        wxDELETE(buildLineInfo);
+    }
 
-        // Append the line content
-
-        if(buildLineInfo->GetSeverity() == SV_ERROR) {
-            if(!isSummaryLine) {
-                buildLine.Prepend(ERROR_MARKER);
-            }
+    // Append the line content. The markers used by the renderer are added by the model
+    m_buildLog.Append(buildLine, flags, buildLineInfo);
+    m_model->RowAppended();
+}
 
-        } else if(buildLineInfo->GetSeverity() == SV_WARNING) {
-            if(!isSummaryLine) {
-                buildLine.Prepend(WARNING_MARKER);
-            }
+void NewBuildTab::DoAutoScroll()
+{
+    if(clConfig::Get().Read(kConfigBuildAutoScroll, true)) {
+        size_t count = m_buildLog.GetCount();
+        if(count) {
+            wxDataViewItem lastItem = m_model->GetItem(count - 1);
+            m_listctrl->EnsureVisible(lastItem);
         }
+    }
+}
 
-        if(isSummaryLine) {
-
-            // Add a marker for drawing the bitmap
-            if(m_errorCount) {
-                buildLine.Prepend(SUMMARY_MARKER_ERROR);
+void NewBuildTab::DoStartClassifier()
+{
+    if(m_classifierThread) return;
+    m_classifierThread = new BuildOutputClassifierThread(m_classifier);
+    m_classifierThread->SetNotifyWindow(this);
+    m_classifierThread->Start();
+}
 
-            } else if(m_warnCount) {
-                buildLine.Prepend(SUMMARY_MARKER_WARNING);
+void NewBuildTab::DoStopClassifier(bool discard)
+{
+    if(!m_classifierThread) return;
 
-            } else {
-                buildLine.Prepend(SUMMARY_MARKER_SUCCESS);
-            }
-            buildLine.Prepend(SUMMARY_MARKER);
-        }
+    if(!discard) {
+        m_classifierThread->Flush();
+        DoProcessClassifiedLines();
+    }
+    m_classifierThread->Stop();
+    wxDELETE(m_classifierThread);
+}
 
-        wxVector<wxVariant> data;
-        data.push_back(wxVariant(buildLine));
-#ifdef __WXMSW__
-        data.push_back(wxString());
-#endif
+void NewBuildTab::DoProcessClassifiedLines()
+{
+    CL_TRACE_FUNCTION("build");
+    if(!m_classifierThread) return;
 
-        // Keep the line number in the build tab
-        buildLineInfo->SetLineInBuildTab(m_listctrl->GetItemCount());
-        m_listctrl->AppendItem(data, (wxUIntPtr)buildLineInfo);
+    BuildOutputClassifierThread::ResultVec_t results;
+    m_classifierThread->TakeResults(results);
+    if(results.empty()) return;
 
-        if(clConfig::Get().Read(kConfigBuildAutoScroll, true)) {
-            unsigned int count = m_listctrl->GetStore()->GetItemCount();
-            wxDataViewItem lastItem = m_listctrl->GetStore()->GetItem(count - 1);
-            m_listctrl->EnsureVisible(lastItem);
-        }
+    m_listctrl->Freeze();
+    for(size_t i = 0; i < results.size(); ++i) {
+        DoAppendLine(results.at(i).line, results.at(i).buildLineInfo, false);
     }
+    m_listctrl->Thaw();
+    DoAutoScroll();
+}
+
+void NewBuildTab::OnBuildOutputClassified(wxCommandEvent& e)
+{
+    wxUnusedVar(e);
+    DoProcessClassifiedLines();
 }
 
 void NewBuildTab::DoToggleWindow()
@@ -844,7 +900,7 @@ void NewBuildTab::DoToggleWindow()
                     int line = bli->GetLineInBuildTab();
                     if(IS_VALID_LINE(line)) {
                         // scroll to line of the build tab
-                        wxDataViewItem item = m_listctrl->GetStore()->GetItem(line);
+                        wxDataViewItem item = m_model->GetItem(line);
                         if(item.IsOk()) {
                             m_listctrl->EnsureVisible(item);
                             m_listctrl->Select(item);
@@ -886,7 +942,7 @@ void NewBuildTab::OnNextBuildError(wxCommandEvent& e)
                 // get the wxDataViewItem
                 int line = (*m_curError)->GetLineInBuildTab();
                 if(IS_VALID_LINE(line)) {
-                    wxDataViewItem item = m_listctrl->GetStore()->GetItem(line);
+                    wxDataViewItem item = m_model->GetItem(line);
                     DoSelectAndOpen(item);
                     ++m_curError;
                     return;
@@ -901,7 +957,7 @@ void NewBuildTab::OnNextBuildError(wxCommandEvent& e)
     } else {
         int line = (*m_curError)->GetLineInBuildTab();
         if(IS_VALID_LINE(line)) {
-            wxDataViewItem item = m_listctrl->GetStore()->GetItem(line);
+            wxDataViewItem item = m_model->GetItem(line);
             DoSelectAndOpen(item);
             ++m_curError;
         }
@@ -921,7 +977,7 @@ bool NewBuildTab::DoSelectAndOpen(const wxDataViewItem& item)
     m_listctrl->EnsureVisible(item);
     m_listctrl->Select(item);
 
-    BuildLineInfo* bli = (BuildLineInfo*)m_listctrl->GetItemData(item);
+    BuildLineInfo* bli = m_buildLog.GetInfo(m_model->GetRow(item));
     if(bli) {
         wxFileName fn(bli->GetFilename());
 
@@ -1018,9 +1074,8 @@ bool NewBuildTab::DoSelectAndOpen(const wxDataViewItem& item)
 wxString NewBuildTab::GetBuildContent() const
 {
     wxString output;
-    for(int i = 0; i < m_listctrl->GetItemCount(); ++i) {
-        wxString curline = m_listctrl->GetTextValue(i, 0);
-        StripBuildMarkders(curline);
+    for(size_t i = 0; i < m_buildLog.GetCount(); ++i) {
+        wxString curline = m_buildLog.GetLine(i);
         curline.Trim();
         output << curline << wxT("\n");
     }
@@ -1064,7 +1119,7 @@ void NewBuildTab::OnCopy(wxCommandEvent& e)
     ::CopyToClipboard(content);
 }
 
-void NewBuildTab::OnCopyUI(wxUpdateUIEvent& e) { e.Enable(!m_buildInProgress && m_listctrl->GetItemCount()); }
+void NewBuildTab::OnCopyUI(wxUpdateUIEvent& e) { e.Enable(!m_buildInProgress && !IsEmpty()); }
 
 void NewBuildTab::OnOpenInEditor(wxCommandEvent& e)
 {
@@ -1075,7 +1130,7 @@ void NewBuildTab::OnOpenInEditor(wxCommandEvent& e)
     }
 }
 
-void NewBuildTab::OnOpenInEditorUI(wxUpdateUIEvent& e) { e.Enable(!m_buildInProgress && m_listctrl->GetItemCount()); }
+void NewBuildTab::OnOpenInEditorUI(wxUpdateUIEvent& e) { e.Enable(!m_buildInProgress && !IsEmpty()); }
 
 void NewBuildTab::OnClear(wxCommandEvent& e) { Clear(); }
 
@@ -1089,8 +1144,7 @@ void NewBuildTab::OnCopySelection(wxCommandEvent& e)
     wxString text;
     for(size_t i = 0; i < items.GetCount(); ++i) {
         wxString line;
-        line << m_listctrl->GetTextValue(m_listctrl->GetStore()->GetRow(items.Item(i)), 0).Trim().Trim(false);
-        StripBuildMarkders(line);
+        line << m_buildLog.GetLine(m_model->GetRow(items.Item(i))).Trim().Trim(false);
         text << line << "\n";
     }
 
@@ -1107,9 +1161,8 @@ void NewBuildTab::OnCopySelectionUI(wxUpdateUIEvent& e)
 
 void NewBuildTab::ScrollToBottom()
 {
-    if(m_listctrl->GetItemCount()) {
-        int lastLine = m_listctrl->GetItemCount() - 1;
-        wxDataViewItem item = m_listctrl->RowToItem(lastLine);
+    if(!m_buildLog.IsEmpty()) {
+        wxDataViewItem item = m_model->GetItem(m_buildLog.GetCount() - 1);
         if(item.IsOk()) {
             m_listctrl->EnsureVisible(item);
         }
@@ -1131,6 +1184,7 @@ bool CmpPattern::Matches(const wxString& line, BuildLineInfo& lineInfo)
     if(!m_fileIndex.ToLong(&fidx) || !m_lineIndex.ToLong(&lidx)) return false;
 
     if(!m_regex || !m_regex->IsValid()) return false;
+    if(!StringFindReplacer::ContainsLiterals(line, m_literals, true)) return false;
     if(!m_regex->Matches(line)) return false;
 
     long colIndex;
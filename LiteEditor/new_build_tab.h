@@ -38,8 +38,12 @@
 #include <map>
 #include <wx/regex.h>
 #include "cl_command_event.h"
+#include "BuildLogStore.h"
 
-class wxDataViewListCtrl;
+class wxDataViewCtrl;
+class BuildLogModel;
+class BuildOutputClassifier;
+class BuildOutputClassifierThread;
 
 ///////////////////////////////
 // Holds the information about
@@ -96,6 +100,7 @@ protected:
     wxString m_lineIndex;
     wxString m_colIndex;
     LINE_SEVERITY m_severity;
+    wxArrayString m_literals;
 
 public:
     CmpPattern(wxRegEx* re, const wxString& file, const wxString& line, const wxString& column, LINE_SEVERITY severity)
@@ -110,7 +115,8 @@ public:
     ~CmpPattern() { wxDELETE(m_regex); }
 
     /**
-     * @brief return true if "line" matches this pattern
+     * @brief return true if "line" matches this pattern. The regex is tried only if the line
+     * contains all the literals (see SetLiterals())
      * @param lineInfo [output]
      */
     bool Matches(const wxString& line, BuildLineInfo& lineInfo);
@@ -125,6 +131,11 @@ public:
     const wxString& GetColIndex() const { return m_colIndex; }
     wxRegEx* GetRegex() { return m_regex; }
     LINE_SEVERITY GetSeverity() const { return m_severity; }
+    /**
+     * @brief set the literals that every match of the regex contains
+     */
+    void SetLiterals(const wxArrayString& literals) { this->m_literals = literals; }
+    const wxArrayString& GetLiterals() const { return m_literals; }
 };
 typedef SmartPtr<CmpPattern> CmpPatternPtr;
 
@@ -147,7 +158,9 @@ class NewBuildTab : public wxPanel
     typedef std::list<BuildLineInfo*> BuildInfoList_t;
 
     wxString m_output;
-    wxDataViewListCtrl* m_listctrl;
+    wxDataViewCtrl* m_listctrl;
+    BuildLogStore m_buildLog;
+    BuildLogModel* m_model;
     CompilerPtr m_cmp;
     MapCmpPatterns_t m_cmpPatterns;
     int m_warnCount;
@@ -159,21 +172,29 @@ class NewBuildTab : public wxPanel
     BuildTabSettingsData::ShowBuildPane m_showMe;
     wxStopWatch m_sw;
     MultimapBuildInfo_t m_buildInfoPerFile;
-    wxArrayString m_directories;
     bool m_skipWarnings;
     BuildpaneScrollTo m_buildpaneScrollTo;
     BuildInfoList_t m_errorsAndWarningsList;
     BuildInfoList_t m_errorsList;
     BuildInfoList_t::iterator m_curError;
     bool m_buildInProgress;
-    wxString m_cygwinRoot;
+    BuildOutputClassifier* m_classifier;
+    BuildOutputClassifierThread* m_classifierThread;
 
 protected:
     void DoCacheRegexes();
     BuildLineInfo* DoProcessLine(const wxString& line, bool isSummaryLine);
     void DoProcessOutput(bool compilationEnded, bool isSummaryLine);
-    void DoSearchForDirectory(const wxString& line);
+    void DoAppendLine(wxString buildLine, BuildLineInfo* buildLineInfo, bool isSummaryLine);
+    void DoAutoScroll();
     bool DoGetCompilerPatterns(const wxString& compilerName, CmpPatterns& patterns);
+    void DoStartClassifier();
+    /**
+     * @brief stop the background classification. When 'discard' is false, the lines
+     * queued so far are classified and added to the view first
+     */
+    void DoStopClassifier(bool discard);
+    void DoProcessClassifiedLines();
     void DoClear();
     void MarkEditor(LEditor* editor);
     void DoToggleWindow();
@@ -188,7 +209,7 @@ public:
     bool GetBuildEndedSuccessfully() const { return m_errorCount == 0 && !m_buildInterrupted; }
     void SetBuildInterrupted(bool b) { m_buildInterrupted = b; }
 
-    bool IsEmpty() const { return m_listctrl->GetItemCount() == 0; }
+    bool IsEmpty() const { return m_buildLog.IsEmpty(); }
 
     bool IsBuildInProgress() const { return m_buildInProgress; }
 
@@ -201,6 +222,7 @@ protected:
     void OnBuildStarted(clCommandEvent& e);
     void OnBuildEnded(clCommandEvent& e);
     void OnBuildAddLine(clCommandEvent& e);
+    void OnBuildOutputClassified(wxCommandEvent& e);
     void OnLineSelected(wxDataViewEvent& e);
     void OnWorkspaceClosed(wxCommandEvent& e);
     void OnWorkspaceLoaded(wxCommandEvent& e);
@@ -34,6 +34,7 @@
 #include "replaceinfilespanel.h"
 #include "clFileSystemEvent.h"
 #include "event_notifier.h"
+#include "clSTCReplacer.h"
 
 BEGIN_EVENT_TABLE(ReplaceInFilesPanel, FindResultsTab)
 EVT_BUTTON(XRCID("unmark_all"), ReplaceInFilesPanel::OnUnmarkAll)
@@ -223,8 +224,11 @@ void ReplaceInFilesPanel::OnReplace(wxCommandEvent& e)
     }
 
     // Step 1: apply selected replacements
+    // The replacements of a file are collected (as positions in the unmodified file) and applied at once
 
     wxStyledTextCtrl* sci = NULL; // file that is being altered by replacements
+    clSTCReplacer::RangeVec_t ranges;
+    wxString replaceWith = m_replaceWith->GetValue();
 
     wxString lastFile; // track offsets of pending substitutions caused by previous substitutions
     long lastLine = 0;
@@ -244,6 +248,8 @@ void ReplaceInFilesPanel::OnReplace(wxCommandEvent& e)
 
         if(i->second.GetFileName() != lastFile) {
             // about to start a different file, save current results
+            clSTCReplacer::Replace(sci, ranges, replaceWith);
+            ranges.clear();
             DoSaveResults(sci, firstInFile, i);
             firstInFile = i;
             lastFile = i->second.GetFileName();
@@ -263,7 +269,7 @@ void ReplaceInFilesPanel::OnReplace(wxCommandEvent& e)
 
         // extract originally matched text for safety check later
         wxString text = i->second.GetPattern().Mid(i->second.GetColumn() - delta, i->second.GetLen());
-        if(text == m_replaceWith->GetValue()) continue; // no change needed
+        if(text == replaceWith) continue; // no change needed
 
         // need an editor for this file (try only once per file though)
         if(!sci && lastLine == 0) {
@@ -282,23 +288,25 @@ void ReplaceInFilesPanel::OnReplace(wxCommandEvent& e)
             m_sci->MarkerAdd(i->first, 0x8);
             continue;
         }
-        pos += i->second.GetColumn();
+        // the file is not modified yet: use the original column
+        pos += i->second.GetColumn() - delta;
 
-        sci->SetSelection(pos, pos + i->second.GetLen());
-        if(sci->GetSelectedText() != text) {
+        if(sci->GetTextRange(pos, pos + i->second.GetLen()) != text ||
+           (!ranges.empty() && pos < ranges.back().first + ranges.back().second)) {
             // couldn't locate the original match (file may have been modified)
             m_sci->MarkerAdd(i->first, 0x8);
             continue;
         }
-        sci->ReplaceSelection(m_replaceWith->GetValue());
+        ranges.push_back(std::make_pair((int)pos, (int)i->second.GetLen()));
 
-        delta += m_replaceWith->GetValue().Length() - i->second.GetLen();
+        delta += replaceWith.Length() - i->second.GetLen();
         lastLine = i->second.GetLineNumber();
 
         i->second.SetPattern(m_sci->GetLine(i->first)); // includes prior updates to same line
-        i->second.SetLen(m_replaceWith->GetValue().Length());
+        i->second.SetLen(replaceWith.Length());
     }
     m_progress->SetValue(0);
+    clSTCReplacer::Replace(sci, ranges, replaceWith);
     DoSaveResults(sci, firstInFile, m_matchInfo.end());
 
     // Disable the 'buffer limit' feature during replace
@@ -0,0 +1,124 @@
+#include "clSTCReplacer.h"
+#include "stringsearcher.h"
+#include "globals.h"
+#include <string>
+#include <string.h>
+#include <algorithm>
+
+/**
+ * @brief can 'line' be replaced as part of a larger edit? Scintilla moves the markers of the lines removed by an edit
+ * to the line where the edit starts, and the folding state of these lines is lost
+ */
+static bool IsPlainLine(wxStyledTextCtrl* stc, int line)
+{
+    return stc->MarkerGet(line) == 0 && stc->GetFoldExpanded(line);
+}
+
+void clSTCReplacer::DoReplaceRun(wxStyledTextCtrl* stc,
+                                 const RangeVec_t& ranges,
+                                 size_t first,
+                                 size_t last,
+                                 const wxCharBuffer& replace)
+{
+    // Build the new text between the first and the last range and replace it at once
+    int spanStart = ranges.at(first).first;
+    int spanEnd = ranges.at(last - 1).first + ranges.at(last - 1).second;
+    wxCharBuffer span = stc->GetTextRangeRaw(spanStart, spanEnd);
+    const char* text = span.data();
+    size_t replaceLen = replace.data() ? strlen(replace.data()) : 0;
+
+    std::string output;
+    output.reserve((spanEnd - spanStart) + (last - first) * replaceLen);
+    int pos = spanStart;
+    for(size_t i = first; i < last; ++i) {
+        output.append(text + (pos - spanStart), ranges.at(i).first - pos);
+        output.append(replace.data(), replaceLen);
+        pos = ranges.at(i).first + ranges.at(i).second;
+    }
+
+    stc->SetTargetStart(spanStart);
+    stc->SetTargetEnd(spanEnd);
+    stc->ReplaceTarget(wxString::FromUTF8(output.c_str(), output.length()));
+}
+
+size_t clSTCReplacer::Replace(wxStyledTextCtrl* stc, const RangeVec_t& ranges, const wxString& replaceWith)
+{
+    if(!stc || ranges.empty()) {
+        return 0;
+    }
+
+    stc->BeginUndoAction();
+    if(ranges.size() <= kMaxSeparateEdits) {
+        // Keep the edits as small as possible (markers, folding)
+        for(RangeVec_t::const_reverse_iterator iter = ranges.rbegin(); iter != ranges.rend(); ++iter) {
+            stc->SetTargetStart(iter->first);
+            stc->SetTargetEnd(iter->first + iter->second);
+            stc->ReplaceTarget(replaceWith);
+        }
+
+    } else {
+        // Split the ranges into runs that can be replaced at once: a run does not extend over a line with
+        // markers (breakpoints, bookmarks...) or a folded line, unless a single range does
+        std::vector<std::pair<size_t, size_t> > runs; // [first, last) indexes into 'ranges'
+        size_t first = 0;
+        int lastLine = stc->LineFromPosition(ranges.front().first); // the run can cover the lines up to here
+        for(size_t i = 0; i < ranges.size(); ++i) {
+            int endLine = stc->LineFromPosition(ranges.at(i).first + ranges.at(i).second);
+            while(lastLine < endLine && IsPlainLine(stc, lastLine + 1)) {
+                ++lastLine;
+            }
+
+            if(lastLine < endLine && i > first) {
+                runs.push_back(std::make_pair(first, i));
+                first = i;
+                lastLine = stc->LineFromPosition(ranges.at(i).first);
+                while(lastLine < endLine && IsPlainLine(stc, lastLine + 1)) {
+                    ++lastLine;
+                }
+            }
+            lastLine = std::max(lastLine, endLine);
+        }
+        runs.push_back(std::make_pair(first, ranges.size()));
+
+        // Start from the last run so the positions of the other runs stay valid
+        wxCharBuffer replace = replaceWith.mb_str(wxConvUTF8);
+        for(size_t i = runs.size(); i > 0; --i) {
+            DoReplaceRun(stc, ranges, runs.at(i - 1).first, runs.at(i - 1).second, replace);
+        }
+    }
+    stc->EndUndoAction();
+    return ranges.size();
+}
+
+size_t clSTCReplacer::ReplaceAll(wxStyledTextCtrl* stc,
+                                 const wxString& findWhat,
+                                 const wxString& replaceWith,
+                                 size_t flags,
+                                 int from,
+                                 int to)
+{
+    if(!stc) return 0;
+    if(to == wxNOT_FOUND) {
+        to = stc->GetLength();
+    }
+
+    wxString text = stc->GetTextRange(from, to);
+    RangeVec_t matches;
+    if(!StringFindReplacer::SearchAll(text, findWhat, flags, matches)) {
+        return 0;
+    }
+
+    // Convert the matches from chars to bytes, walking the text once
+    const wchar_t* ptext = text.wc_str();
+    int lastChar = 0;
+    int lastByte = from;
+    for(RangeVec_t::iterator iter = matches.begin(); iter != matches.end(); ++iter) {
+        lastByte += clUTF8Length(ptext + lastChar, iter->first - lastChar);
+        lastChar = iter->first;
+
+        int len = clUTF8Length(ptext + iter->first, iter->second);
+        iter->first = lastByte;
+        iter->second = len;
+    }
+    return Replace(stc, matches, replaceWith);
+}
@@ -0,0 +1,53 @@
+#ifndef CLSTCREPLACER_H
+#define CLSTCREPLACER_H
+
+#include <wx/stc/stc.h>
+#include "codelite_exports.h"
+#include <vector>
+#include <utility>
+
+/**
+ * @class clSTCReplacer
+ * @brief replace many ranges of a wxStyledTextCtrl as a single undo action.
+ * Few replacements are applied one by one, starting from the last one so the other ranges stay valid.
+ * Many replacements are grouped into runs, each run is applied as a single edit of the text between its first and
+ * last range. A run ends before a line with markers or a folded line, so these are kept in place
+ */
+class WXDLLIMPEXP_SDK clSTCReplacer
+{
+public:
+    typedef std::vector<std::pair<int, int> > RangeVec_t; // (position, length) pairs
+
+    enum { kMaxSeparateEdits = 100 };
+
+protected:
+    /**
+     * @brief replace ranges [first, last) with a single edit
+     */
+    static void DoReplaceRun(wxStyledTextCtrl* stc,
+                             const RangeVec_t& ranges,
+                             size_t first,
+                             size_t last,
+                             const wxCharBuffer& replace);
+
+public:
+    /**
+     * @brief replace 'ranges' (in bytes, ordered and not overlapping) with 'replaceWith'
+     * @return the number of replacements
+     */
+    static size_t Replace(wxStyledTextCtrl* stc, const RangeVec_t& ranges, const wxString& replaceWith);
+
+    /**
+     * @brief replace all the matches of 'findWhat' in the text between 'from' and 'to' (bytes, -1 for the end
+     * of the text). 'flags' are the StringFindReplacer search flags
+     * @return the number of replacements
+     */
+    static size_t ReplaceAll(wxStyledTextCtrl* stc,
+                             const wxString& findWhat,
+                             const wxString& replaceWith,
+                             size_t flags,
+                             int from = 0,
+                             int to = wxNOT_FOUND);
+};
+
+#endif // CLSTCREPLACER_H
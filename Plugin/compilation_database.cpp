@@ -36,9 +36,57 @@
 #include <wx/dir.h>
 #include <algorithm>
 #include "file_logger.h"
+#include "fileutils.h"
+#include "compile_commands_reader.h"
+#include <wx/filefn.h>
 
 const wxString DB_VERSION = "2.0";
 
+// Number of compile_commands.json entries inserted per transaction
+#define COMPILATION_DB_BATCH_SIZE 1000
+
+/**
+ * @class CompilationDatabaseInserter
+ * @brief insert the entries reported by the CompileCommandsReader, committing every COMPILATION_DB_BATCH_SIZE entries
+ */
+class CompilationDatabaseInserter : public CompileCommandsReader::Listener
+{
+    wxSQLite3Database* m_db;
+    wxSQLite3Statement m_st;
+    size_t m_count;
+
+public:
+    CompilationDatabaseInserter(wxSQLite3Database* db)
+        : m_db(db)
+        , m_count(0)
+    {
+        m_st = m_db->PrepareStatement(
+            "REPLACE INTO COMPILATION_TABLE (FILE_NAME, FILE_PATH, CWD, COMPILE_FLAGS) VALUES(?, ?, ?, ?)");
+    }
+    virtual ~CompilationDatabaseInserter() {}
+
+    virtual bool OnEntry(const CompileCommandsReader::Entry& entry)
+    {
+        wxFileName fn(entry.file);
+        wxString cwd = wxFileName(entry.directory, "").GetPath();
+
+        m_st.Bind(1, fn.GetFullPath());
+        m_st.Bind(2, fn.GetPath());
+        m_st.Bind(3, cwd);
+        m_st.Bind(4, entry.command);
+        m_st.ExecuteUpdate();
+
+        ++m_count;
+        if((m_count % COMPILATION_DB_BATCH_SIZE) == 0) {
+            m_db->ExecuteUpdate("COMMIT");
+            m_db->ExecuteUpdate("BEGIN");
+        }
+        return true;
+    }
+
+    size_t GetCount() const { return m_count; }
+};
+
 struct wxFileNameSorter {
     bool operator()(const wxFileName& one, const wxFileName& two) const
     {
@@ -171,8 +219,19 @@ void CompilationDatabase::Initialize()
     // Sort the files by modification time
     std::sort(files.begin(), files.end(), wxFileNameSorter());
 
+    std::vector<long> mtimes;
     for(size_t i = 0; i < files.size(); ++i) {
-        ProcessCMakeCompilationDatabase(files.at(i));
+        wxStructStat buff;
+        mtimes.push_back(wxStat(files.at(i).GetFullPath(), &buff) == 0 ? (long)buff.st_mtime : 0);
+    }
+
+    // The entries of a file replace the ones of the files processed before it. Once a file is imported,
+    // the files that follow it are imported again, even if they did not change, so they keep their precedence
+    bool force = false;
+    for(size_t i = 0; i < files.size(); ++i) {
+        if(ProcessCMakeCompilationDatabase(files.at(i), force, mtimes)) {
+            force = true;
+        }
     }
 }
 
@@ -191,6 +250,8 @@ void CompilationDatabase::CreateDatabase()
         m_db->ExecuteUpdate("CREATE UNIQUE INDEX IF NOT EXISTS SCHEMA_VERSION_IDX1 ON SCHEMA_VERSION(PROPERTY)");
         m_db->ExecuteUpdate("CREATE INDEX IF NOT EXISTS COMPILATION_TABLE_IDX2 ON COMPILATION_TABLE(FILE_PATH)");
         m_db->ExecuteUpdate("CREATE INDEX IF NOT EXISTS COMPILATION_TABLE_IDX3 ON COMPILATION_TABLE(CWD)");
+        m_db->ExecuteUpdate("CREATE TABLE IF NOT EXISTS COMPILE_COMMANDS_FILES (FILE_NAME TEXT PRIMARY KEY, "
+                            "FILE_SIZE INTEGER, LAST_MODIFIED INTEGER, HASH TEXT)");
 
         wxString versionSql;
         versionSql << "INSERT OR IGNORE INTO SCHEMA_VERSION (PROPERTY, VERSION) VALUES ('Db Version', '" << DB_VERSION
@@ -209,6 +270,7 @@ void CompilationDatabase::DropTables()
     try {
 
         // Create the schema
+        m_db->ExecuteUpdate("DROP TABLE IF EXISTS COMPILE_COMMANDS_FILES");
         m_db->ExecuteUpdate("DROP TABLE COMPILATION_TABLE");
         m_db->ExecuteUpdate("DROP TABLE SCHEMA_VERSION");
 
@@ -316,41 +378,112 @@ FileNameVector_t CompilationDatabase::GetCompileCommandsFiles() const
     return files;
 }
 
-void CompilationDatabase::ProcessCMakeCompilationDatabase(const wxFileName& compile_commands)
+bool CompilationDatabase::ProcessCMakeCompilationDatabase(const wxFileName& compile_commands,
+                                                          bool force,
+                                                          const std::vector<long>& mtimes)
 {
-    JSONRoot root(compile_commands);
-    JSONElement arr = root.toElement();
+    wxStructStat buff;
+    if(wxStat(compile_commands.GetFullPath(), &buff) != 0) return false;
+
+    // Skip files that did not change since they were imported. A file that was only touched
+    // (same content, new modification time) is detected by its hash
+    long size = (long)buff.st_size;
+    long mtime = (long)buff.st_mtime;
+    long importedSize(0), importedMtime(0);
+    wxString importedHash;
+    bool imported = !force && GetImportedFileInfo(compile_commands, importedSize, importedMtime, importedHash);
+    if(imported && importedSize == size && importedMtime == mtime) {
+        CL_DEBUG("CompilationDatabase: %s is up to date", compile_commands.GetFullPath());
+        return false;
+    }
 
-    try {
+    wxString hash;
+    long hashedSize(0);
+    if(!FileUtils::GetFileHash(compile_commands, hash, hashedSize)) return false;
 
-        wxString sql;
-        sql = wxT("REPLACE INTO COMPILATION_TABLE (FILE_NAME, FILE_PATH, CWD, COMPILE_FLAGS) VALUES(?, ?, ?, ?)");
-        wxSQLite3Statement st = m_db->PrepareStatement(sql);
+    // A touched file keeps its place in the processing order only if no other file was modified
+    // between its previous and its current modification time
+    bool reordered = false;
+    for(size_t i = 0; i < mtimes.size(); ++i) {
+        if(mtimes.at(i) > importedMtime && mtimes.at(i) < mtime) {
+            reordered = true;
+            break;
+        }
+    }
+    if(imported && importedHash == hash && !reordered) {
+        CL_DEBUG("CompilationDatabase: %s is up to date", compile_commands.GetFullPath());
+        SetImportedFileInfo(compile_commands, size, mtime, hash);
+        return false;
+    }
+
+    try {
+        // The file is streamed: entries are inserted while it is being parsed, in batches
+        CompilationDatabaseInserter inserter(m_db);
+        CompileCommandsReader reader;
         m_db->ExecuteUpdate("BEGIN");
+        bool ok = reader.Read(compile_commands, inserter);
+        m_db->ExecuteUpdate("COMMIT");
 
-        for(int i = 0; i < arr.arraySize(); ++i) {
-            // Each object has 3 properties:
-            // directory, command, file
-            JSONElement element = arr.arrayItem(i);
-            if(element.hasNamedObject("file") && element.hasNamedObject("directory") &&
-               element.hasNamedObject("command")) {
-                wxString cmd = element.namedObject("command").toString();
-                wxString file = element.namedObject("file").toString();
-                wxString path = wxFileName(file).GetPath();
-                wxString cwd = element.namedObject("directory").toString();
-
-                cwd = wxFileName(cwd, "").GetPath();
-                file = wxFileName(file).GetFullPath();
-
-                st.Bind(1, file);
-                st.Bind(2, path);
-                st.Bind(3, cwd);
-                st.Bind(4, cmd);
-                st.ExecuteUpdate();
+        CL_DEBUG("CompilationDatabase: imported %u entries from %s",
+                 (unsigned int)inserter.GetCount(),
+                 compile_commands.GetFullPath());
+        if(ok) {
+            SetImportedFileInfo(compile_commands, size, mtime, hash);
+        } else {
+            CL_WARNING("CompilationDatabase: error while reading %s", compile_commands.GetFullPath());
+        }
+
+    } catch(wxSQLite3Exception& e) {
+        CL_WARNING("CompilationDatabase: failed to import %s: %s",
+                   compile_commands.GetFullPath(),
+                   e.GetMessage());
+        try {
+            if(!m_db->GetAutoCommit()) {
+                m_db->ExecuteUpdate("ROLLBACK");
             }
+        } catch(wxSQLite3Exception& rollbackError) {
+            wxUnusedVar(rollbackError);
         }
+    }
+    return true;
+}
 
-        m_db->ExecuteUpdate("COMMIT");
+bool CompilationDatabase::GetImportedFileInfo(const wxFileName& compile_commands,
+                                              long& size,
+                                              long& mtime,
+                                              wxString& hash)
+{
+    try {
+        wxSQLite3Statement st =
+            m_db->PrepareStatement("SELECT FILE_SIZE, LAST_MODIFIED, HASH FROM COMPILE_COMMANDS_FILES WHERE FILE_NAME=?");
+        st.Bind(1, compile_commands.GetFullPath());
+        wxSQLite3ResultSet rs = st.ExecuteQuery();
+        if(rs.NextRow()) {
+            size = (long)rs.GetInt64(0).GetValue();
+            mtime = (long)rs.GetInt64(1).GetValue();
+            hash = rs.GetString(2);
+            return true;
+        }
+
+    } catch(wxSQLite3Exception& e) {
+        wxUnusedVar(e);
+    }
+    return false;
+}
+
+void CompilationDatabase::SetImportedFileInfo(const wxFileName& compile_commands,
+                                              long size,
+                                              long mtime,
+                                              const wxString& hash)
+{
+    try {
+        wxSQLite3Statement st = m_db->PrepareStatement(
+            "REPLACE INTO COMPILE_COMMANDS_FILES (FILE_NAME, FILE_SIZE, LAST_MODIFIED, HASH) VALUES(?, ?, ?, ?)");
+        st.Bind(1, compile_commands.GetFullPath());
+        st.Bind(2, wxLongLong(size));
+        st.Bind(3, wxLongLong(mtime));
+        st.Bind(4, hash);
+        st.ExecuteUpdate();
 
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
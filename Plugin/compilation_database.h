@@ -43,8 +43,20 @@ protected:
     wxString GetDbVersion();
     /**
      * @brief create our compilation database out of CMake's compile_commands.json file
+     * @param force import the file even if it did not change since it was last imported
+     * @param mtimes the modification times of all the compile_commands.json files being processed
+     * @return true if the file was (even partially) imported
      */
-    void ProcessCMakeCompilationDatabase( const wxFileName &compile_commands );
+    bool ProcessCMakeCompilationDatabase(const wxFileName& compile_commands,
+                                         bool force,
+                                         const std::vector<long>& mtimes);
+
+    /**
+     * @brief return the size, modification time and hash recorded when 'compile_commands' was last imported
+     * @return false if the file was never imported
+     */
+    bool GetImportedFileInfo(const wxFileName& compile_commands, long& size, long& mtime, wxString& hash);
+    void SetImportedFileInfo(const wxFileName& compile_commands, long size, long mtime, const wxString& hash);
     
     wxFileName ConvertCodeLiteCompilationDatabaseToCMake( const wxFileName &compile_file );
     
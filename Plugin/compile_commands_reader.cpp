@@ -0,0 +1,352 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 The CodeLite Team
+// file name            : compile_commands_reader.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "compile_commands_reader.h"
+#include <stdio.h>
+
+// Size of the chunks read from the file
+#define COMPILE_COMMANDS_READ_CHUNK (256 * 1024)
+
+namespace
+{
+int HexValue(int ch)
+{
+    if(ch >= '0' && ch <= '9') return ch - '0';
+    if(ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if(ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+void AppendUTF8(std::string& str, wxUint32 code)
+{
+    if(code < 0x80) {
+        str += (char)code;
+    } else if(code < 0x800) {
+        str += (char)(0xC0 | (code >> 6));
+        str += (char)(0x80 | (code & 0x3F));
+    } else if(code < 0x10000) {
+        str += (char)(0xE0 | (code >> 12));
+        str += (char)(0x80 | ((code >> 6) & 0x3F));
+        str += (char)(0x80 | (code & 0x3F));
+    } else {
+        str += (char)(0xF0 | (code >> 18));
+        str += (char)(0x80 | ((code >> 12) & 0x3F));
+        str += (char)(0x80 | ((code >> 6) & 0x3F));
+        str += (char)(0x80 | (code & 0x3F));
+    }
+}
+}
+
+CompileCommandsReader::CompileCommandsReader()
+    : m_pos(0)
+    , m_len(0)
+{
+}
+
+CompileCommandsReader::~CompileCommandsReader() {}
+
+int CompileCommandsReader::Peek()
+{
+    if(m_pos == m_len) {
+        if(!m_fp.IsOpened() || m_fp.Eof()) return EOF;
+        m_len = m_fp.Read(&m_buffer[0], m_buffer.size());
+        m_pos = 0;
+        if(m_len == 0) return EOF;
+    }
+    return (unsigned char)m_buffer[m_pos];
+}
+
+int CompileCommandsReader::Next()
+{
+    int ch = Peek();
+    if(ch != EOF) {
+        ++m_pos;
+    }
+    return ch;
+}
+
+bool CompileCommandsReader::Expect(int ch)
+{
+    SkipWhitespace();
+    return Next() == ch;
+}
+
+void CompileCommandsReader::SkipWhitespace()
+{
+    int ch = Peek();
+    while(ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
+        ++m_pos;
+        ch = Peek();
+    }
+}
+
+bool CompileCommandsReader::ReadString(std::string& str)
+{
+    str.clear();
+    if(!Expect('"')) return false;
+
+    while(true) {
+        int ch = Next();
+        if(ch == EOF) return false;
+        if(ch == '"') return true;
+        if(ch != '\\') {
+            str += (char)ch;
+            continue;
+        }
+
+        ch = Next();
+        switch(ch) {
+        case 'b':
+            str += '\b';
+            break;
+        case 'f':
+            str += '\f';
+            break;
+        case 'n':
+            str += '\n';
+            break;
+        case 'r':
+            str += '\r';
+            break;
+        case 't':
+            str += '\t';
+            break;
+        case 'u': {
+            wxUint32 code = 0;
+            for(int i = 0; i < 4; ++i) {
+                int digit = HexValue(Next());
+                if(digit < 0) return false;
+                code = (code << 4) | digit;
+            }
+
+            // Surrogate pair
+            if(code >= 0xD800 && code <= 0xDBFF) {
+                wxUint32 low = 0;
+                if(Next() != '\\' || Next() != 'u') return false;
+                for(int i = 0; i < 4; ++i) {
+                    int digit = HexValue(Next());
+                    if(digit < 0) return false;
+                    low = (low << 4) | digit;
+                }
+                if(low < 0xDC00 || low > 0xDFFF) return false;
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            AppendUTF8(str, code);
+        } break;
+        case EOF:
+            return false;
+        default:
+            // \" \\ \/
+            str += (char)ch;
+            break;
+        }
+    }
+}
+
+bool CompileCommandsReader::ReadStringArray(std::vector<std::string>& arr)
+{
+    arr.clear();
+    if(!Expect('[')) return false;
+
+    SkipWhitespace();
+    if(Peek() == ']') {
+        ++m_pos;
+        return true;
+    }
+
+    std::string str;
+    while(true) {
+        if(!ReadString(str)) return false;
+        arr.push_back(str);
+
+        SkipWhitespace();
+        int ch = Next();
+        if(ch == ']') return true;
+        if(ch != ',') return false;
+    }
+}
+
+bool CompileCommandsReader::SkipValue()
+{
+    // Skip a value of any type without keeping it. Nested arrays and objects are skipped by counting
+    // their brackets, only strings need to be parsed (they may contain brackets)
+    int depth = 0;
+    std::string str;
+    do {
+        SkipWhitespace();
+        int ch = Peek();
+        if(ch == EOF) {
+            return false;
+
+        } else if(ch == '"') {
+            if(!ReadString(str)) return false;
+
+        } else if(ch == '[' || ch == '{') {
+            ++m_pos;
+            ++depth;
+
+        } else if(ch == ']' || ch == '}') {
+            if(depth == 0) return false;
+            ++m_pos;
+            --depth;
+
+        } else if(ch == ',' || ch == ':') {
+            if(depth == 0) return false;
+            ++m_pos;
+
+        } else {
+            // number, true, false or null
+            while(ch != EOF && ch != ',' && ch != ']' && ch != '}' && ch != ' ' && ch != '\t' && ch != '\n' &&
+                  ch != '\r') {
+                ++m_pos;
+                ch = Peek();
+            }
+        }
+    } while(depth > 0);
+    return true;
+}
+
+bool CompileCommandsReader::ReadEntry(Entry& entry, bool& complete)
+{
+    entry.file.Clear();
+    entry.directory.Clear();
+    entry.command.Clear();
+
+    bool hasFile(false), hasDirectory(false), hasCommand(false);
+    if(!Expect('{')) return false;
+
+    SkipWhitespace();
+    if(Peek() == '}') {
+        ++m_pos;
+        complete = false;
+        return true;
+    }
+
+    std::string key;
+    std::string value;
+    std::vector<std::string> arguments;
+    while(true) {
+        if(!ReadString(key)) return false;
+        if(!Expect(':')) return false;
+
+        SkipWhitespace();
+        if((key == "file" || key == "directory" || key == "command") && Peek() == '"') {
+            if(!ReadString(value)) return false;
+            wxString str = wxString::FromUTF8(value.c_str(), value.length());
+            if(key == "file") {
+                entry.file.swap(str);
+                hasFile = true;
+            } else if(key == "directory") {
+                entry.directory.swap(str);
+                hasDirectory = true;
+            } else {
+                entry.command.swap(str);
+                hasCommand = true;
+            }
+
+        } else if(key == "arguments" && Peek() == '[') {
+            if(!ReadStringArray(arguments)) return false;
+            // "command" wins when both are present
+            if(!hasCommand) {
+                entry.command = JoinArguments(arguments);
+            }
+
+        } else if(!SkipValue()) {
+            return false;
+        }
+
+        SkipWhitespace();
+        int ch = Next();
+        if(ch == '}') break;
+        if(ch != ',') return false;
+    }
+
+    complete = hasFile && hasDirectory && (hasCommand || !arguments.empty());
+    return true;
+}
+
+wxString CompileCommandsReader::JoinArguments(const std::vector<std::string>& arguments)
+{
+    wxString command;
+    for(size_t i = 0; i < arguments.size(); ++i) {
+        wxString arg = wxString::FromUTF8(arguments.at(i).c_str(), arguments.at(i).length());
+        if(!command.IsEmpty()) {
+            command << " ";
+        }
+
+        if(arg.IsEmpty() || arg.find_first_of(" \t\"'") != wxString::npos) {
+            arg.Replace("\"", "\\\"");
+            command << "\"" << arg << "\"";
+        } else {
+            command << arg;
+        }
+    }
+    return command;
+}
+
+bool CompileCommandsReader::Read(const wxFileName& filename, Listener& listener)
+{
+    if(!m_fp.Open(filename.GetFullPath(), wxT("rb"))) return false;
+
+    m_buffer.resize(COMPILE_COMMANDS_READ_CHUNK);
+    m_pos = m_len = 0;
+
+    // Skip the UTF-8 byte order mark. Peek() fills the buffer, so the mark is all in it
+    if(Peek() == 0xEF && m_len >= 3 && (unsigned char)m_buffer[1] == 0xBB && (unsigned char)m_buffer[2] == 0xBF) {
+        m_pos = 3;
+    }
+
+    bool ok(false);
+    Entry entry;
+    if(Expect('[')) {
+        SkipWhitespace();
+        if(Peek() == ']') {
+            ok = true;
+
+        } else {
+            while(true) {
+                bool complete(false);
+                if(!ReadEntry(entry, complete)) break;
+                if(complete && !listener.OnEntry(entry)) {
+                    ok = true;
+                    break;
+                }
+
+                SkipWhitespace();
+                int ch = Next();
+                if(ch == ']') {
+                    ok = true;
+                    break;
+                }
+                if(ch != ',') break;
+            }
+        }
+    }
+
+    m_fp.Close();
+    m_buffer.clear();
+    m_pos = m_len = 0;
+    return ok;
+}
@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 The CodeLite Team
+// file name            : compile_commands_reader.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMPILECOMMANDSREADER_H
+#define COMPILECOMMANDSREADER_H
+
+#include "codelite_exports.h"
+#include <wx/string.h>
+#include <wx/filename.h>
+#include <wx/ffile.h>
+#include <string>
+#include <vector>
+
+/**
+ * @class CompileCommandsReader
+ * @brief a streaming reader for compile_commands.json files.
+ * The file is read in chunks and every entry is reported as soon as it is parsed, so the memory used
+ * does not depend on the file size. Both the "command" and the "arguments" forms are accepted
+ */
+class WXDLLIMPEXP_SDK CompileCommandsReader
+{
+public:
+    struct Entry {
+        wxString file;
+        wxString directory;
+        wxString command; // when the entry uses "arguments", they are joined into a command line
+    };
+
+    /**
+     * @brief called for every complete entry. Return false to stop reading
+     */
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+        virtual bool OnEntry(const Entry& entry) = 0;
+    };
+
+protected:
+    wxFFile m_fp;
+    std::vector<char> m_buffer;
+    size_t m_pos;
+    size_t m_len;
+
+protected:
+    int Peek();
+    int Next();
+    bool Expect(int ch);
+    void SkipWhitespace();
+    bool ReadString(std::string& str);
+    bool ReadStringArray(std::vector<std::string>& arr);
+    bool SkipValue();
+    bool ReadEntry(Entry& entry, bool& complete);
+
+public:
+    CompileCommandsReader();
+    virtual ~CompileCommandsReader();
+
+    /**
+     * @brief join arguments into a command line, quoting the ones that contain blanks or quotes
+     */
+    static wxString JoinArguments(const std::vector<std::string>& arguments);
+
+    /**
+     * @brief read 'filename' and report its entries to 'listener'
+     * @return false if the file could not be opened or is not a valid compile_commands.json file.
+     * Entries reported before the error are not undone
+     */
+    bool Read(const wxFileName& filename, Listener& listener);
+};
+
+#endif // COMPILECOMMANDSREADER_H
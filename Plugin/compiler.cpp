@@ -36,6 +36,7 @@
 #include <wx/tokenzr.h>
 #include "file_logger.h"
 #include "CxxPreProcessor.h"
+#include "CxxPreProcessorSharedCache.h"
 
 Compiler::Compiler(wxXmlNode* node, Compiler::eRegexType regexType)
     : m_objectNameIdenticalToFileName(false)
@@ -781,6 +782,8 @@ const wxArrayString& Compiler::GetBuiltinMacros()
                 wxLogNull n;
                 ::wxRemoveFile(cmpMacrosFile.GetFullPath());
             }
+            // The temporary file name is not used again
+            CxxPreProcessorSharedCache::Get().ReleaseFile(cmpMacrosFile);
         }
     }
     m_compilerBuiltinDefinitions.swap(definitions);
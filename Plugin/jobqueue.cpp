@@ -25,107 +25,57 @@
 #include "jobqueue.h"
 #include "job.h"
 
-JobQueueWorker::JobQueueWorker(wxMessageQueue<Job*>* queue)
-    : wxThread(wxTHREAD_JOINABLE)
-    , m_queue( queue )
+namespace
 {
-}
-
-JobQueueWorker::~JobQueueWorker()
-{
-}
-void JobQueueWorker::Stop()
+class JobTask : public clTask
 {
-    if ( IsAlive() ) {
-        Delete(NULL, wxTHREAD_WAIT_BLOCK);
-
-    } else {
-        Wait(wxTHREAD_WAIT_BLOCK);
+    Job* m_job;
 
+public:
+    JobTask(Job* job, const clCancellationToken& token)
+        : clTask(clTask::kNormal, token)
+        , m_job(job)
+    {
     }
-}
+    virtual ~JobTask() { wxDELETE(m_job); }
 
-void JobQueueWorker::Start(int priority)
-{
-    Create();
-    SetPriority(priority);
-    Run();
+    virtual void Run() { m_job->Process(wxThread::This()); }
+};
 }
 
-void* JobQueueWorker::Entry()
-{
-    while ( !TestDestroy() ) {
-        Job *job (NULL);
-        if ( (m_queue->ReceiveTimeout(50, job) == wxMSGQUEUE_NO_ERROR) && job ) {
-
-            // Call user's implementation for processing request
-            ProcessJob( job );
-
-            wxThread::Sleep(10);  // Allow other threads to work as well
-            delete job;
-            job = NULL;
-            continue; // to avoid the sleep
-        }
-    }
-    return NULL;
-}
-
-void JobQueueWorker::ProcessJob(Job *job)
-{
-    if ( job ) {
-        job->Process(this);
-    }
-}
-
-//--------------------------------------------------------------
-// JobQueue
-//--------------------------------------------------------------
-
 JobQueue::JobQueue()
+    : m_queue(NULL)
 {
 }
 
 JobQueue::~JobQueue()
 {
-    // Clear the queue and release it memory
-    Job* pJob(NULL);
-    while ( m_queue.ReceiveTimeout(1, pJob) == wxMSGQUEUE_NO_ERROR ) {
-        wxDELETE( pJob );
-    }
+    // The queue is owned by the executor
+    m_queue = NULL;
 }
 
 void JobQueue::PushJob(Job *job)
 {
-    m_queue.Post( job );
+    if ( !m_queue ) {
+        Start();
+    }
+    m_queue->Submit( new JobTask(job, m_token) );
 }
 
 void JobQueue::Start(size_t poolSize, int priority)
 {
-    size_t maxPoolSize = poolSize > 250 ? 250 : poolSize;
-    for(size_t i=0; i<maxPoolSize; i++) {
-        //create new thread
-        JobQueueWorker *worker = new JobQueueWorker( &m_queue );
-        worker->Start(priority);
-        m_threads.push_back(worker);
+    wxUnusedVar(poolSize);
+    wxUnusedVar(priority);
+    if ( !m_queue ) {
+        m_queue = clTaskExecutor::Get()->CreateQueue("JobQueue", false);
     }
 }
 
 void JobQueue::Stop()
 {
-    //first loop and stop all running threads
-    for(size_t i=0; i<m_threads.size(); i++) {
-        JobQueueWorker *worker = m_threads.at(i);
-        //stop it
-        worker->Stop();
-        //delete it
-        delete worker;
-    }
-    m_threads.clear();
+    m_token.Cancel();
 }
 
-//-----------------------------------------------------
-// Job queue singleton
-//-----------------------------------------------------
 JobQueue* JobQueueSingleton::ms_instance = new JobQueue();
 
 JobQueueSingleton::JobQueueSingleton()
@@ -26,68 +26,18 @@
 #define __jobqueue__
 
 #include <wx/thread.h>
-#include <deque>
-#include <vector>
 #include "codelite_exports.h"
-#include <wx/msgqueue.h>
+#include "clTaskExecutor.h"
 
 class Job;
 
-/**
- * @class JobQueueWorker
- * @author Eran
- * @date 05/09/08
- * @file jobqueue.h
- * @brief a thread class used internally by JobQueue
- * @sa JobQueue
- */
-class WXDLLIMPEXP_SDK JobQueueWorker : public wxThread
-{
-    wxMessageQueue<Job*>* m_queue;
-
-public:
-    /// default ctor/dtor
-    JobQueueWorker(wxMessageQueue<Job*>* queue);
-    virtual ~JobQueueWorker();
-
-private:
-    //declare this class as non copyable
-    JobQueueWorker(const JobQueueWorker& rhs);
-    JobQueueWorker& operator=(const JobQueueWorker& rhs);
-
-public:
-    /**
-     * @brief stop the running thread. usually called before calling JobQueue::Release()
-     */
-    void Stop();
-
-    /**
-     * @brief start the thread with given priority
-     * @param priority thread priority (defaulted to WXTHREAD_DEFAULT_PRIORITY)
-     */
-    void Start(int priority = WXTHREAD_DEFAULT_PRIORITY);
-
-
-    /**
-     * @brief implementation of the wxThread pure virtual function Entry()
-     * @sa wxThread
-     */
-    virtual void* Entry();
-
-    /**
-     * @brief the main code that processes the job
-     * @param job job to process
-     * @sa Job
-     */
-    virtual void ProcessJob(Job *job);
-};
-
 /**
  * @class JobQueue
  * @author Eran
  * @date 05/09/08
  * @file jobqueue.h
- * @brief this class provides a convenient way of handling background tasks using Job objects
+ * @brief this class provides a convenient way of handling background tasks using Job objects.
+ * The jobs are run by the shared clTaskExecutor threads
  *
  * @code
  * // somewhere in your application initialization
@@ -108,8 +58,8 @@ public:
  */
 class JobQueue
 {
-    wxMessageQueue<Job*>         m_queue;
-    std::vector<JobQueueWorker*> m_threads;
+    clTaskQueue*        m_queue;
+    clCancellationToken m_token;
 
 public:
     JobQueue();
@@ -123,14 +73,13 @@ public:
     virtual void PushJob(Job *job);
 
     /**
-     * @brief
-     * @param poolSize
-     * @param priority
+     * @brief start accepting jobs. The jobs are run by the shared executor, which is sized
+     * by the number of cores, so 'poolSize' and 'priority' are ignored
      */
     virtual void Start(size_t poolSize = 1, int priority = WXTHREAD_DEFAULT_PRIORITY);
 
     /**
-     * @brief stop all workers threads
+     * @brief discard the jobs that did not start yet, and any job pushed from now on
      */
     virtual void Stop();
 };
@@ -65,6 +65,7 @@ public:
         Opt_FoldHighlightActiveBlock = 0x04000000,
         Opt_EnsureCaptionsVisible = 0x08000000,
         Opt_DisableMouseCtrlZoom = 0x10000000,
+        Opt_FindInFilesIndex = 0x20000000,
     };
 
 protected:
@@ -166,6 +167,9 @@ public:
     void SetNonEditorTabsAtTop(bool b) { EnableOption(Opt_NonEditorTabsBottom, !b); }
     bool IsNonEditorTabsAtTop() const { return !HasOption(Opt_NonEditorTabsBottom); }
 
+    void SetFindInFilesIndex(bool b) { EnableOption(Opt_FindInFilesIndex, b); }
+    bool IsFindInFilesIndex() const { return HasOption(Opt_FindInFilesIndex); }
+
     void SetOptions(size_t options) { this->m_options = options; }
     size_t GetOptions() const { return m_options; }
     void SetTrimOnlyModifiedLines(bool trimOnlyModifiedLines) { this->m_trimOnlyModifiedLines = trimOnlyModifiedLines; }
@@ -40,12 +40,28 @@
 #include "globals.h"
 #include <algorithm>
 #include "fileutils.h"
+#include "clMemoryMappedFile.h"
+#include "clTrigramIndex.h"
+#include "clTaskExecutor.h"
+#include "performance.h"
+#include <string.h>
+#include <vector>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#endif
 
 const wxEventType wxEVT_SEARCH_THREAD_MATCHFOUND = wxNewEventType();
 const wxEventType wxEVT_SEARCH_THREAD_SEARCHEND = wxNewEventType();
 const wxEventType wxEVT_SEARCH_THREAD_SEARCHCANCELED = wxNewEventType();
 const wxEventType wxEVT_SEARCH_THREAD_SEARCHSTARTED = wxNewEventType();
 
+// Maximum number of executor tasks used for searching files
+#define SEARCH_THREAD_MAX_WORKERS 8
+
+// Searches with less files than this are done on the search thread itself
+#define SEARCH_THREAD_PARALLEL_MIN_FILES 16
+
 #define SEND_ST_EVENT()                       \
     if(owner) {                               \
         wxPostEvent(owner, event);            \
@@ -54,12 +70,296 @@ const wxEventType wxEVT_SEARCH_THREAD_SEARCHSTARTED = wxNewEventType();
     }                                         \
     wxThread::Sleep(1);
 
+//----------------------------------------------------------
+// Byte level search helpers, used for UTF-8 files
+//----------------------------------------------------------
+namespace
+{
+inline char AsciiToLower(char ch) { return (ch >= 'A' && ch <= 'Z') ? (char)(ch + ('a' - 'A')) : ch; }
+inline char AsciiToUpper(char ch) { return (ch >= 'a' && ch <= 'z') ? (char)(ch - ('a' - 'A')) : ch; }
+
+bool IsAscii(const char* str, size_t len)
+{
+    for(size_t i = 0; i < len; ++i) {
+        if((unsigned char)str[i] >= 0x80) return false;
+    }
+    return true;
+}
+
+bool EqualsNoCase(const char* haystack, const char* lowerNeedle, size_t len)
+{
+    for(size_t i = 0; i < len; ++i) {
+        if(AsciiToLower(haystack[i]) != lowerNeedle[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief return the first occurrence of 'lower' or its upper case form in [p, end)
+ */
+const char* FindByteNoCase(const char* p, const char* end, char lower)
+{
+    char upper = AsciiToUpper(lower);
+    if(upper == lower) return (const char*)::memchr(p, lower, end - p);
+
+#if defined(__SSE2__) && defined(__GNUC__)
+    // Compare 16 bytes at a time against both forms of the char
+    const __m128i lowerMask = _mm_set1_epi8(lower);
+    const __m128i upperMask = _mm_set1_epi8(upper);
+    while(end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+        int matches = _mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, lowerMask), _mm_cmpeq_epi8(chunk, upperMask)));
+        if(matches) return p + __builtin_ctz(matches);
+        p += 16;
+    }
+#endif
+    for(; p < end; ++p) {
+        if(*p == lower || *p == upper) return p;
+    }
+    return NULL;
+}
+
+/**
+ * @brief find 'needle' in [p, end). When 'noCase' is set, 'needle' must be ASCII lower case
+ */
+const char* FindBytes(const char* p, const char* end, const char* needle, size_t len, bool noCase)
+{
+    while((size_t)(end - p) >= len) {
+        // Only the first byte of the needle is scanned for (memchr is vectorized by the C library),
+        // the rest of it is compared at the candidate positions
+        const char* last = end - len + 1;
+        const char* hit =
+            noCase ? FindByteNoCase(p, last, needle[0]) : (const char*)::memchr(p, needle[0], last - p);
+        if(!hit) return NULL;
+        if(noCase ? EqualsNoCase(hit + 1, needle + 1, len - 1) : (::memcmp(hit + 1, needle + 1, len - 1) == 0)) {
+            return hit;
+        }
+        p = hit + 1;
+    }
+    return NULL;
+}
+
+/**
+ * @brief return the length of a UTF-8 buffer in wxString chars
+ */
+size_t CountChars(const char* p, const char* end)
+{
+    size_t count = 0;
+    for(; p < end; ++p) {
+        unsigned char ch = (unsigned char)*p;
+        // skip continuation bytes
+        if((ch & 0xC0) != 0x80) ++count;
+        // chars outside the BMP take 2 chars with UTF-16 strings
+        if(sizeof(wxChar) == 2 && ch >= 0xF0) ++count;
+    }
+    return count;
+}
+
+struct CandidateLine {
+    wxString line;
+    int lineNumber;
+    int lineOffset;
+};
+}
+
 //----------------------------------------------------------------
 // SearchData
 //----------------------------------------------------------------
 
 const wxString& SearchData::GetExtensions() const { return m_validExt; }
 
+//----------------------------------------------------------------
+// SearchFileContext
+//----------------------------------------------------------------
+
+wxRegEx& SearchFileContext::GetRegex(const wxString& expr, bool matchCase)
+{
+    if(m_reExpr == expr && matchCase == m_matchCase) {
+        return m_regex;
+    } else {
+        m_reExpr = expr;
+        m_matchCase = matchCase;
+#ifndef __WXMAC__
+        int flags = wxRE_ADVANCED;
+#else
+        int flags = wxRE_DEFAULT;
+#endif
+
+        if(!matchCase) flags |= wxRE_ICASE;
+        m_regex.Compile(m_reExpr, flags);
+        StringFindReplacer::GetRegexLiterals(m_reExpr, m_reLiterals);
+    }
+    return m_regex;
+}
+
+const wxArrayString& SearchFileContext::GetRegexLiterals(const wxString& expr, bool matchCase)
+{
+    GetRegex(expr, matchCase);
+    return m_reLiterals;
+}
+
+//----------------------------------------------------------------
+// SearchFilesQueue
+//----------------------------------------------------------------
+
+/**
+ * @class SearchFilesQueue
+ * @brief hand out the files to the search workers and collect their results.
+ * Workers pick the next file as soon as they are done with the previous one, the results are
+ * kept per file so they can be reported in the file list order
+ */
+class SearchFilesQueue
+{
+    struct FileResult {
+        SearchResultList results;
+        bool failed;
+        bool done;
+
+        FileResult()
+            : failed(false)
+            , done(false)
+        {
+        }
+    };
+
+    size_t m_nextFile;
+    bool m_stopped;
+    size_t m_workers;
+    std::vector<FileResult> m_files;
+    wxMutex m_mutex;
+    wxCondition m_fileDone;
+
+public:
+    SearchFilesQueue(size_t count)
+        : m_nextFile(0)
+        , m_stopped(false)
+        , m_workers(0)
+        , m_files(count)
+        , m_fileDone(m_mutex)
+    {
+    }
+
+    /**
+     * @brief return the index of the next file to search. Return false when there are no more files
+     */
+    bool Next(size_t& index)
+    {
+        wxMutexLocker locker(m_mutex);
+        if(m_stopped || m_nextFile >= m_files.size()) return false;
+        index = m_nextFile++;
+        return true;
+    }
+
+    void AddWorker()
+    {
+        wxMutexLocker locker(m_mutex);
+        ++m_workers;
+    }
+
+    /**
+     * @brief a worker is gone: it searched all the files it could get or it was discarded
+     */
+    void WorkerDone()
+    {
+        wxMutexLocker locker(m_mutex);
+        --m_workers;
+        m_fileDone.Broadcast();
+    }
+
+    bool HasWorkers()
+    {
+        wxMutexLocker locker(m_mutex);
+        return m_workers > 0;
+    }
+
+    /**
+     * @brief wait for all the workers to be gone
+     */
+    void WaitForWorkers()
+    {
+        wxMutexLocker locker(m_mutex);
+        while(m_workers > 0) {
+            m_fileDone.Wait();
+        }
+    }
+
+    /**
+     * @brief store the results of file 'index'. The context results are moved
+     */
+    void Done(size_t index, SearchFileContext& context)
+    {
+        wxMutexLocker locker(m_mutex);
+        FileResult& file = m_files.at(index);
+        file.results.swap(context.GetResults());
+        file.failed = context.IsFailed();
+        file.done = true;
+        m_fileDone.Broadcast();
+    }
+
+    /**
+     * @brief wait up to 'timeoutMs' for file 'index' to be searched and move its results into 'context'
+     */
+    bool Wait(size_t index, SearchFileContext& context, long timeoutMs)
+    {
+        wxMutexLocker locker(m_mutex);
+        FileResult& file = m_files.at(index);
+        if(!file.done) {
+            m_fileDone.WaitTimeout(timeoutMs);
+            if(!file.done) return false;
+        }
+        context.Clear();
+        context.GetResults().swap(file.results);
+        context.SetFailed(file.failed);
+        return true;
+    }
+
+    /**
+     * @brief stop handing out files
+     */
+    void Stop()
+    {
+        wxMutexLocker locker(m_mutex);
+        m_stopped = true;
+    }
+};
+
+//----------------------------------------------------------------
+// SearchFilesTask
+//----------------------------------------------------------------
+
+class SearchFilesTask : public clTask
+{
+    SearchThread* m_owner;
+    SearchFilesQueue* m_queue;
+    const wxArrayString& m_files;
+    SearchData m_data; // a private (deep) copy, strings are not shared between threads
+
+public:
+    SearchFilesTask(SearchThread* owner, SearchFilesQueue* queue, const wxArrayString& files, const SearchData* data)
+        : m_owner(owner)
+        , m_queue(queue)
+        , m_files(files)
+        , m_data(*data)
+    {
+        m_queue->AddWorker();
+    }
+    // The task is deleted once it ran, or when the executor discards it
+    virtual ~SearchFilesTask() { m_queue->WorkerDone(); }
+
+    virtual void Run()
+    {
+        SearchFileContext context;
+        size_t index(0);
+        while(!m_owner->TestStopSearch() && m_queue->Next(index)) {
+            context.Clear();
+            wxString fileName = m_files.Item(index).c_str();
+            m_owner->DoSearchFile(fileName, &m_data, context);
+            m_queue->Done(index, context);
+        }
+    }
+};
+
 //----------------------------------------------------------------
 // SearchThread
 //----------------------------------------------------------------
@@ -67,7 +367,7 @@ const wxString& SearchData::GetExtensions() const { return m_validExt; }
 SearchThread::SearchThread()
     : WorkerThread()
     , m_wordChars(wxT("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_"))
-    , m_reExpr(wxT(""))
+    , m_tasksQueue(NULL)
 {
     IndexWordChars();
 }
@@ -88,29 +388,11 @@ void SearchThread::SetWordChars(const wxString& chars)
     IndexWordChars();
 }
 
-wxRegEx& SearchThread::GetRegex(const wxString& expr, bool matchCase)
-{
-    if(m_reExpr == expr && matchCase == m_matchCase) {
-        return m_regex;
-    } else {
-        m_reExpr = expr;
-        m_matchCase = matchCase;
-#ifndef __WXMAC__
-        int flags = wxRE_ADVANCED;
-#else
-        int flags = wxRE_DEFAULT;
-#endif
-
-        if(!matchCase) flags |= wxRE_ICASE;
-        m_regex.Compile(m_reExpr, flags);
-    }
-    return m_regex;
-}
-
 void SearchThread::PerformSearch(const SearchData& data) { Add(new SearchData(data)); }
 
 void SearchThread::ProcessRequest(ThreadRequest* req)
 {
+    CL_TRACE_FUNCTION("search");
     wxStopWatch sw;
     m_summary = SearchSummary();
     DoSearchFiles(req);
@@ -167,6 +449,13 @@ void SearchThread::DoSearchFiles(ThreadRequest* req)
     wxArrayString fileList;
     GetFiles(data, fileList);
 
+    // Skip the files that can not contain the searched text
+    if(clTrigramIndex::Get().IsOpen()) {
+        std::vector<std::string> literals;
+        GetRequiredLiterals(data, literals);
+        clTrigramIndex::Get().Filter(fileList, literals);
+    }
+
     wxStopWatch sw;
 
     // Send startup message to main thread
@@ -181,6 +470,58 @@ void SearchThread::DoSearchFiles(ThreadRequest* req)
         }
     }
 
+    size_t workers = clTaskExecutor::Get()->GetWorkersCount();
+    if(workers == 0) {
+        // the executor threads are started on the first task
+        workers = wxThread::GetCPUCount() > 0 ? (size_t)wxThread::GetCPUCount() : 1;
+    }
+    if(workers > SEARCH_THREAD_MAX_WORKERS) workers = SEARCH_THREAD_MAX_WORKERS;
+    if(workers > 1 && fileList.GetCount() >= SEARCH_THREAD_PARALLEL_MIN_FILES) {
+        DoSearchFilesParallel(fileList, data, workers);
+    } else {
+        DoSearchFilesSerial(fileList, data);
+    }
+}
+
+void SearchThread::GetRequiredLiterals(const SearchData* data, std::vector<std::string>& literals)
+{
+    wxArrayString strings;
+    if(data->IsRegularExpression()) {
+        StringFindReplacer::GetRegexLiterals(data->GetFindString(), strings);
+
+    } else if(data->IsEnablePipeSupport() && data->GetFindString().Find('|') != wxNOT_FOUND) {
+        // all the filters must appear on the matching line as well
+        strings.Add(data->GetFindString().BeforeFirst('|'));
+        wxArrayString filters = ::wxStringTokenize(data->GetFindString().AfterFirst('|'), "|", wxTOKEN_STRTOK);
+        strings.insert(strings.end(), filters.begin(), filters.end());
+    } else {
+        strings.Add(data->GetFindString());
+    }
+
+    // The index is built from the raw file bytes with only the ASCII letters folded. Non ASCII strings can
+    // only be used as-is with UTF-8 files and a case sensitive search, otherwise only their ASCII parts are used
+    bool isUTF8 = (wxFontMapper::GetEncodingFromName(data->GetEncoding()) == wxFONTENCODING_UTF8);
+    for(size_t i = 0; i < strings.size(); ++i) {
+        std::string literal = strings.Item(i).mb_str(wxConvUTF8).data();
+        if(IsAscii(literal.c_str(), literal.length()) || (isUTF8 && data->IsMatchCase())) {
+            literals.push_back(literal);
+            continue;
+        }
+
+        size_t start = 0;
+        for(size_t pos = 0; pos <= literal.length(); ++pos) {
+            if(pos < literal.length() && (unsigned char)literal[pos] < 0x80) continue;
+            if(pos > start) {
+                literals.push_back(literal.substr(start, pos - start));
+            }
+            start = pos + 1;
+        }
+    }
+}
+
+void SearchThread::DoSearchFilesSerial(const wxArrayString& fileList, const SearchData* data)
+{
+    SearchFileContext context;
     for(size_t i = 0; i < fileList.Count(); i++) {
         m_summary.SetNumFileScanned((int)i + 1);
 
@@ -191,10 +532,75 @@ void SearchThread::DoSearchFiles(ThreadRequest* req)
             StopSearch(false);
             break;
         }
-        DoSearchFile(fileList.Item(i), data);
+        context.Clear();
+        DoSearchFile(fileList.Item(i), data, context);
+        DoReportFileResults(fileList.Item(i), data, context);
     }
 }
 
+void SearchThread::DoSearchFilesParallel(const wxArrayString& fileList, const SearchData* data, size_t workers)
+{
+    if(!m_tasksQueue) {
+        m_tasksQueue = clTaskExecutor::Get()->CreateQueue("Find In Files", false);
+    }
+
+    SearchFilesQueue queue(fileList.GetCount());
+    for(size_t i = 0; i < workers; ++i) {
+        m_tasksQueue->Submit(new SearchFilesTask(this, &queue, fileList, data));
+    }
+
+    // Report the results in the file list order while the workers search ahead
+    SearchFileContext context;
+    bool cancelled(false);
+    for(size_t i = 0; i < fileList.Count() && !cancelled; i++) {
+        while(!queue.Wait(i, context, 50)) {
+            // give user chance to cancel the search ...
+            if(TestStopSearch()) {
+                cancelled = true;
+                break;
+            }
+
+            // The executor was stopped before all the files were searched
+            if(!queue.HasWorkers() && !queue.Wait(i, context, 0)) {
+                cancelled = true;
+                break;
+            }
+        }
+
+        if(cancelled || TestStopSearch()) {
+            cancelled = true;
+            break;
+        }
+        m_summary.SetNumFileScanned((int)i + 1);
+        DoReportFileResults(fileList.Item(i), data, context);
+    }
+
+    // The workers check the stop flag between files, so they exit as soon as their current file is done
+    queue.Stop();
+    queue.WaitForWorkers();
+
+    if(cancelled) {
+        // Send cancel event
+        SendEvent(wxEVT_SEARCH_THREAD_SEARCHCANCELED, data->GetOwner());
+        StopSearch(false);
+    }
+}
+
+void SearchThread::DoReportFileResults(const wxString& fileName, const SearchData* data, SearchFileContext& context)
+{
+    if(context.IsFailed()) {
+        m_summary.GetFailedFiles().Add(fileName);
+    }
+
+    SearchResultList& results = context.GetResults();
+    if(!results.empty()) {
+        m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + (int)results.size());
+        m_results.splice(m_results.end(), results);
+    }
+
+    if(m_results.empty() == false) SendEvent(wxEVT_SEARCH_THREAD_MATCHFOUND, data->GetOwner());
+}
+
 bool SearchThread::TestStopSearch()
 {
     bool stop = false;
@@ -211,18 +617,63 @@ void SearchThread::StopSearch(bool stop)
     m_stopSearch = stop;
 }
 
-void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data)
+void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data, SearchFileContext& context)
 {
+    CL_TRACE_FUNCTION("search");
     // Process single lines
     int lineNumber = 1;
     if(!wxFileName::FileExists(fileName)) {
         return;
     }
 
+    // simple search: prepare the string to search and the pipe filters
+    wxString findString;
+    wxArrayString filters;
+    if(!data->IsRegularExpression()) {
+        findString = data->GetFindString();
+        if(data->IsEnablePipeSupport()) {
+            if(data->GetFindString().Find('|') != wxNOT_FOUND) {
+                findString = data->GetFindString().BeforeFirst('|');
+
+                wxString filtersString = data->GetFindString().AfterFirst('|');
+                filters = ::wxStringTokenize(filtersString, "|", wxTOKEN_STRTOK);
+                if(!data->IsMatchCase()) {
+                    for(size_t i = 0; i < filters.size(); ++i) {
+                        filters.Item(i).MakeLower();
+                    }
+                }
+            }
+        }
+
+        if(!data->IsMatchCase()) {
+            findString.MakeLower();
+        }
+
+        if(DoSearchFileFast(fileName, data, findString, filters, context)) {
+            return;
+        }
+
+    } else {
+        // regular expression: scan the file for the longest literal every match must contain,
+        // only the lines containing it are passed to the regex engine
+        const wxArrayString& literals =
+            context.GetRegexLiterals(data->GetFindString(), data->IsMatchCase());
+        wxString longest;
+        for(size_t i = 0; i < literals.GetCount(); ++i) {
+            if(literals.Item(i).length() > longest.length()) longest = literals.Item(i);
+        }
+        if(!data->IsMatchCase()) {
+            longest.MakeLower();
+        }
+        if(!longest.IsEmpty() && DoSearchFileFast(fileName, data, longest, filters, context)) {
+            return;
+        }
+    }
+
     wxFFile thefile(fileName, wxT("rb"));
     if(!thefile.IsOpened()) {
         // failed to open the file, probably because of permissions
-        m_summary.GetFailedFiles().Add(fileName);
+        context.SetFailed(true);
         return;
     }
 
@@ -234,7 +685,7 @@ void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data
     wxFontEncoding enc = wxFontMapper::GetEncodingFromName(data->GetEncoding().c_str());
     wxCSConv fontEncConv(enc);
     if(!thefile.ReadAll(&fileData, fontEncConv)) {
-        m_summary.GetFailedFiles().Add(fileName);
+        context.SetFailed(true);
         return;
     }
 
@@ -266,53 +717,122 @@ void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data
         while(tkz.HasMoreTokens()) {
             // Read the next line
             wxString line = tkz.NextToken();
-            DoSearchLineRE(line, lineNumber, lineOffset, fileName, data, states);
+            DoSearchLineRE(line, lineNumber, lineOffset, fileName, data, states, context);
             lineOffset += line.Length() + 1;
             lineNumber++;
         }
     } else {
         // simple search
-        wxString findString;
-        wxArrayString filters;
-        findString = data->GetFindString();
-        if(data->IsEnablePipeSupport()) {
-            if(data->GetFindString().Find('|') != wxNOT_FOUND) {
-                findString = data->GetFindString().BeforeFirst('|');
-
-                wxString filtersString = data->GetFindString().AfterFirst('|');
-                filters = ::wxStringTokenize(filtersString, "|", wxTOKEN_STRTOK);
-                if(!data->IsMatchCase()) {
-                    for(size_t i = 0; i < filters.size(); ++i) {
-                        filters.Item(i).MakeLower();
-                    }
-                }
-            }
-        }
-
-        if(!data->IsMatchCase()) {
-            findString.MakeLower();
-        }
-
         while(tkz.HasMoreTokens()) {
 
             // Read the next line
             wxString line = tkz.NextToken();
-            DoSearchLine(line, lineNumber, lineOffset, fileName, data, findString, filters, states);
+            DoSearchLine(line, lineNumber, lineOffset, fileName, data, findString, filters, states, context);
             lineOffset += line.Length() + 1;
             lineNumber++;
         }
     }
 
-    if(m_results.empty() == false) SendEvent(wxEVT_SEARCH_THREAD_MATCHFOUND, data->GetOwner());
 }
+
+bool SearchThread::DoSearchFileFast(const wxString& fileName,
+                                    const SearchData* data,
+                                    const wxString& findWhat,
+                                    const wxArrayString& filters,
+                                    SearchFileContext& context)
+{
+    // Only UTF-8 files can be searched as raw bytes
+    if(wxFontMapper::GetEncodingFromName(data->GetEncoding()) != wxFONTENCODING_UTF8) return false;
+    if(findWhat.IsEmpty() || findWhat.Find('\n') != wxNOT_FOUND) return false;
+
+    wxCharBuffer needle = findWhat.mb_str(wxConvUTF8);
+    size_t needleLen = ::strlen(needle.data());
+    if(needleLen == 0) return false;
+
+    // Case insensitive search is done with ASCII case folding
+    bool noCase = !data->IsMatchCase();
+    if(noCase && !IsAscii(needle.data(), needleLen)) return false;
+
+    clMemoryMappedFile file(fileName);
+    if(!file.IsOk()) return false; // let the default search report the error
+
+    const char* buffer = file.GetData();
+    const char* end = buffer + file.GetSize();
+
+    // Collect the lines containing the search string. Line numbers and offsets are
+    // only computed up to the lines with matches
+    std::vector<CandidateLine> candidates;
+    const char* lineStart = buffer;
+    int lineNumber = 1;
+    size_t lineOffset = 0;
+    const char* p = buffer;
+    while(p && p < end) {
+        const char* hit = FindBytes(p, end, needle.data(), needleLen, noCase);
+        if(!hit) break;
+
+        const char* newLineStart = lineStart;
+        const char* nl = NULL;
+        while((nl = (const char*)::memchr(newLineStart, '\n', hit - newLineStart))) {
+            ++lineNumber;
+            newLineStart = nl + 1;
+        }
+        lineOffset += CountChars(lineStart, newLineStart);
+        lineStart = newLineStart;
+
+        const char* lineEnd = (const char*)::memchr(hit, '\n', end - hit);
+        if(!lineEnd) lineEnd = end;
+
+        CandidateLine candidate;
+        candidate.line = wxString::FromUTF8(lineStart, lineEnd - lineStart);
+        if(candidate.line.IsEmpty()) {
+            // Not a valid UTF-8 content
+            return false;
+        }
+        candidate.lineNumber = lineNumber;
+        candidate.lineOffset = (int)lineOffset;
+        candidates.push_back(candidate);
+
+        if(lineEnd == end) break;
+        p = lineEnd + 1;
+    }
+
+    // The lines are searched by the default line search so the matches are reported exactly as before
+    TextStatesPtr states(NULL);
+    for(size_t i = 0; i < candidates.size(); ++i) {
+        const CandidateLine& candidate = candidates.at(i);
+        if(data->IsRegularExpression()) {
+            DoSearchLineRE(
+                candidate.line, candidate.lineNumber, candidate.lineOffset, fileName, data, states, context);
+        } else {
+            DoSearchLine(candidate.line,
+                         candidate.lineNumber,
+                         candidate.lineOffset,
+                         fileName,
+                         data,
+                         findWhat,
+                         filters,
+                         states,
+                         context);
+        }
+    }
+    return true;
+}
+
 void SearchThread::DoSearchLineRE(const wxString& line,
                                   const int lineNum,
                                   const int lineOffset,
                                   const wxString& fileName,
                                   const SearchData* data,
-                                  TextStatesPtr statesPtr)
+                                  TextStatesPtr statesPtr,
+                                  SearchFileContext& context)
 {
-    wxRegEx& re = GetRegex(data->GetFindString(), data->IsMatchCase());
+    wxRegEx& re = context.GetRegex(data->GetFindString(), data->IsMatchCase());
+
+    // Lines that do not contain the literals required by the expression can not match
+    if(!StringFindReplacer::ContainsLiterals(
+           line, context.GetRegexLiterals(data->GetFindString(), data->IsMatchCase()), data->IsMatchCase())) {
+        return;
+    }
     size_t col = 0;
     int iCorrectedCol = 0;
     int iCorrectedLen = 0;
@@ -349,8 +869,8 @@ void SearchThread::DoSearchLineRE(const wxString& line,
             }
 
             if(statesPtr && position != wxNOT_FOUND && data->GetSkipComments()) {
-                if(statesPtr->states.size() > (size_t)position) {
-                    short state = statesPtr->states.at(position).state;
+                if(statesPtr->GetLength() > (size_t)position) {
+                    short state = statesPtr->GetState(position);
                     if(state == CppWordScanner::STATE_CPP_COMMENT || state == CppWordScanner::STATE_C_COMMENT) {
                         canAdd = false;
                     }
@@ -358,8 +878,8 @@ void SearchThread::DoSearchLineRE(const wxString& line,
             }
 
             if(statesPtr && position != wxNOT_FOUND && data->GetSkipStrings()) {
-                if(statesPtr->states.size() > (size_t)position) {
-                    short state = statesPtr->states.at(position).state;
+                if(statesPtr->GetLength() > (size_t)position) {
+                    short state = statesPtr->GetState(position);
                     if(state == CppWordScanner::STATE_DQ_STRING || state == CppWordScanner::STATE_SINGLE_STRING) {
                         canAdd = false;
                     }
@@ -369,8 +889,8 @@ void SearchThread::DoSearchLineRE(const wxString& line,
             result.SetMatchState(CppWordScanner::STATE_NORMAL);
             if(canAdd && statesPtr && position != wxNOT_FOUND && data->GetColourComments()) {
                 // set the match state
-                if(statesPtr->states.size() > (size_t)position) {
-                    short state = statesPtr->states.at(position).state;
+                if(statesPtr->GetLength() > (size_t)position) {
+                    short state = statesPtr->GetState(position);
                     if(state == CppWordScanner::STATE_C_COMMENT || state == CppWordScanner::STATE_CPP_COMMENT) {
                         result.SetMatchState(state);
                     }
@@ -378,8 +898,7 @@ void SearchThread::DoSearchLineRE(const wxString& line,
             }
 
             if(canAdd) {
-                m_results.push_back(result);
-                m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + 1);
+                context.AddResult(result);
             }
 
             col += len;
@@ -398,7 +917,8 @@ void SearchThread::DoSearchLine(const wxString& line,
                                 const SearchData* data,
                                 const wxString& findWhat,
                                 const wxArrayString& filters,
-                                TextStatesPtr statesPtr)
+                                TextStatesPtr statesPtr,
+                                SearchFileContext& context)
 {
     wxString modLine = line;
 
@@ -482,8 +1002,8 @@ void SearchThread::DoSearchLine(const wxString& line,
 
             // Make sure our match is not on a comment
             if(statesPtr && position != wxNOT_FOUND && data->GetSkipComments()) {
-                if(statesPtr->states.size() > (size_t)position) {
-                    short state = statesPtr->states.at(position).state;
+                if(statesPtr->GetLength() > (size_t)position) {
+                    short state = statesPtr->GetState(position);
                     if(state == CppWordScanner::STATE_CPP_COMMENT || state == CppWordScanner::STATE_C_COMMENT) {
                         canAdd = false;
                     }
@@ -491,8 +1011,8 @@ void SearchThread::DoSearchLine(const wxString& line,
             }
 
             if(statesPtr && position != wxNOT_FOUND && data->GetSkipStrings()) {
-                if(statesPtr->states.size() > (size_t)position) {
-                    short state = statesPtr->states.at(position).state;
+                if(statesPtr->GetLength() > (size_t)position) {
+                    short state = statesPtr->GetState(position);
                     if(state == CppWordScanner::STATE_DQ_STRING || state == CppWordScanner::STATE_SINGLE_STRING) {
                         canAdd = false;
                     }
@@ -502,8 +1022,8 @@ void SearchThread::DoSearchLine(const wxString& line,
             result.SetMatchState(CppWordScanner::STATE_NORMAL);
             if(canAdd && statesPtr && position != wxNOT_FOUND && data->GetColourComments()) {
                 // set the match state
-                if(statesPtr->states.size() > (size_t)position) {
-                    short state = statesPtr->states.at(position).state;
+                if(statesPtr->GetLength() > (size_t)position) {
+                    short state = statesPtr->GetState(position);
                     if(state == CppWordScanner::STATE_C_COMMENT || state == CppWordScanner::STATE_CPP_COMMENT) {
                         result.SetMatchState(state);
                     }
@@ -511,8 +1031,7 @@ void SearchThread::DoSearchLine(const wxString& line,
             }
 
             if(canAdd) {
-                m_results.push_back(result);
-                m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + 1);
+                context.AddResult(result);
             }
 
             if(!AdjustLine(modLine, pos, findWhat)) {
@@ -29,6 +29,8 @@
 #include <list>
 #include <wx/string.h>
 #include <map>
+#include <vector>
+#include <string>
 #include "singleton.h"
 #include "wx/event.h"
 #include "wx/filename.h"
@@ -303,22 +305,70 @@ public:
     }
 };
 
+//----------------------------------------------------------
+// The state of a single file search
+//----------------------------------------------------------
+
+class WXDLLIMPEXP_SDK SearchFileContext
+{
+    wxString m_reExpr;
+    wxRegEx m_regex;
+    bool m_matchCase;
+    wxArrayString m_reLiterals;
+    SearchResultList m_results;
+    bool m_failed;
+
+public:
+    SearchFileContext()
+        : m_matchCase(false)
+        , m_failed(false)
+    {
+    }
+    virtual ~SearchFileContext() {}
+
+    /**
+     * @brief return a compiled regex object for the expression. The last regex is cached
+     */
+    wxRegEx& GetRegex(const wxString& expr, bool matchCase);
+
+    /**
+     * @brief return the literals every match of the expression must contain
+     * (see StringFindReplacer::GetRegexLiterals)
+     */
+    const wxArrayString& GetRegexLiterals(const wxString& expr, bool matchCase);
+
+    /**
+     * @brief prepare the context for searching the next file
+     */
+    void Clear()
+    {
+        m_results.clear();
+        m_failed = false;
+    }
+
+    void AddResult(const SearchResult& result) { m_results.push_back(result); }
+    SearchResultList& GetResults() { return m_results; }
+    void SetFailed(bool failed) { this->m_failed = failed; }
+    bool IsFailed() const { return m_failed; }
+};
+
 //----------------------------------------------------------
 // The search thread
 //----------------------------------------------------------
 
+class SearchFilesTask;
+class clTaskQueue;
 class WXDLLIMPEXP_SDK SearchThread : public WorkerThread
 {
     friend class SearchThreadST;
+    friend class SearchFilesTask;
     wxString m_wordChars;
     std::map<wxChar, bool> m_wordCharsMap; //< Internal
     SearchResultList m_results;
     bool m_stopSearch;
     SearchSummary m_summary;
-    wxString m_reExpr;
-    wxRegEx m_regex;
-    bool m_matchCase;
     wxCriticalSection m_cs;
+    clTaskQueue* m_tasksQueue; // the executor queue of the parallel searches
 
 private:
     /**
@@ -380,8 +430,40 @@ private:
      */
     void DoSearchFiles(ThreadRequest* data);
 
+    /**
+     * @brief return the strings (UTF-8) that a file must contain to match the search
+     */
+    void GetRequiredLiterals(const SearchData* data, std::vector<std::string>& literals);
+
+    /**
+     * @brief search the files one after the other on this thread
+     */
+    void DoSearchFilesSerial(const wxArrayString& fileList, const SearchData* data);
+
+    /**
+     * @brief search the files using 'workers' threads
+     */
+    void DoSearchFilesParallel(const wxArrayString& fileList, const SearchData* data, size_t workers);
+
+    /**
+     * @brief report the results of a single file. Files are reported in the file list order
+     */
+    void DoReportFileResults(const wxString& fileName, const SearchData* data, SearchFileContext& context);
+
     // Perform search on a single file
-    void DoSearchFile(const wxString& fileName, const SearchData* data);
+    void DoSearchFile(const wxString& fileName, const SearchData* data, SearchFileContext& context);
+
+    /**
+     * @brief search a UTF-8 file without converting it: the file is mapped into memory and scanned
+     * as raw bytes for 'findWhat', only the lines containing it are converted and passed to DoSearchLine
+     * (or DoSearchLineRE, in which case 'findWhat' is a literal required by the expression)
+     * @return false if the file can not be searched this way (the caller should use the default search)
+     */
+    bool DoSearchFileFast(const wxString& fileName,
+                          const SearchData* data,
+                          const wxString& findWhat,
+                          const wxArrayString& filters,
+                          SearchFileContext& context);
 
     // Perform search on a line
     void DoSearchLine(const wxString& line,
@@ -391,7 +473,8 @@ private:
                       const SearchData* data,
                       const wxString& findWhat,
                       const wxArrayString& filters,
-                      TextStatesPtr statesPtr);
+                      TextStatesPtr statesPtr,
+                      SearchFileContext& context);
 
     // Perform search on a line using regular expression
     void DoSearchLineRE(const wxString& line,
@@ -399,14 +482,12 @@ private:
                         const int lineOffset,
                         const wxString& fileName,
                         const SearchData* data,
-                        TextStatesPtr statesPtr);
+                        TextStatesPtr statesPtr,
+                        SearchFileContext& context);
 
     // Send an event to the notified window
     void SendEvent(wxEventType type, wxEvtHandler* owner);
 
-    // return a compiled regex object for the expression
-    wxRegEx& GetRegex(const wxString& expr, bool matchCase);
-
     // Internal function
     bool AdjustLine(wxString& line, int& pos, const wxString& findString);
 
@@ -24,8 +24,10 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "stringsearcher.h"
 #include <wx/regex.h>
+#include <wx/thread.h>
 #include <algorithm>
 #include <string>
+#include <vector>
 #include "globals.h"
 
 static std::wstring Reverse(const std::wstring& str)
@@ -62,15 +64,186 @@ wxString StringFindReplacer::GetString(const wxString& input, int from, bool sea
     }
 }
 
+bool StringFindReplacer::GetRegexLiterals(const wxString& expr, wxArrayString& literals)
+{
+    literals.Clear();
+
+    // Director prefixes ("***=", "***:") and embedded options ("(?i)") change the expression meaning
+    if(expr.StartsWith("***") || expr.StartsWith("(?")) return false;
+
+    // The literals of every open group. The literals of a group are required by the enclosing group
+    // unless the group has alternatives, is optional or is not a plain capturing group
+    struct Group {
+        wxArrayString literals;
+        bool required;
+        Group()
+            : required(true)
+        {
+        }
+    };
+    std::vector<Group> groups(1);
+
+    wxString current;
+    // the current literal run ends here
+    auto flush = [&]() {
+        if(!current.IsEmpty()) groups.back().literals.Add(current);
+        current.Clear();
+    };
+
+    size_t len = expr.length();
+    for(size_t i = 0; i < len; ++i) {
+        wxChar ch = expr.GetChar(i);
+        bool isLiteral = false;
+        switch(ch) {
+        case '\\':
+            if(i + 1 >= len) return false;
+            ++i;
+            ch = expr.GetChar(i);
+            if(!wxIsalnum(ch)) {
+                // an escaped special character
+                isLiteral = true;
+            } else if(wxStrchr(wxT("wWdDsSbBmMyYAZ"), ch)) {
+                // a class escape or a constraint, it breaks the literal
+            } else {
+                // character entry escapes (e.g. \x41, \n) and back references
+                literals.Clear();
+                return false;
+            }
+            break;
+        case '[': {
+            // skip the bracket expression. A ']' right after the opening (or after '^') is part of the set
+            size_t j = i + 1;
+            if(j < len && expr.GetChar(j) == '^') ++j;
+            if(j < len && expr.GetChar(j) == ']') ++j;
+            while(j < len && expr.GetChar(j) != ']') {
+                if(expr.GetChar(j) == '[' && j + 1 < len && wxStrchr(wxT(":.="), expr.GetChar(j + 1))) {
+                    // [:class:], [.coll.] or [=equiv=]
+                    wxChar closer = expr.GetChar(j + 1);
+                    j += 2;
+                    while(j + 1 < len && !(expr.GetChar(j) == closer && expr.GetChar(j + 1) == ']')) ++j;
+                    ++j;
+                }
+                ++j;
+            }
+            i = j;
+            break;
+        }
+        case '(':
+            flush();
+            groups.push_back(Group());
+            // (?:...), (?=...) and (?!...)
+            if(i + 1 < len && expr.GetChar(i + 1) == '?') {
+                groups.back().required = false;
+                ++i;
+            }
+            break;
+        case ')': {
+            flush();
+            if(groups.size() < 2) return false;
+            Group group = groups.back();
+            groups.pop_back();
+
+            // a quantifier that allows zero occurrences makes the group optional
+            if(i + 1 < len && (expr.GetChar(i + 1) == '*' || expr.GetChar(i + 1) == '?')) {
+                group.required = false;
+            } else if(i + 1 < len && expr.GetChar(i + 1) == '{') {
+                long minCount = 0;
+                expr.Mid(i + 2).BeforeFirst('}').BeforeFirst(',').ToLong(&minCount);
+                if(minCount == 0) group.required = false;
+            }
+            if(group.required) {
+                for(size_t j = 0; j < group.literals.GetCount(); ++j) {
+                    groups.back().literals.Add(group.literals.Item(j));
+                }
+            }
+            break;
+        }
+        case '|':
+            // only one of the alternatives is required
+            if(groups.size() == 1) {
+                literals.Clear();
+                return false;
+            }
+            groups.back().required = false;
+            break;
+        case '*':
+        case '?':
+            // the previous atom is optional
+            if(!current.IsEmpty()) current.RemoveLast();
+            break;
+        case '{': {
+            // a bound: {m}, {m,} or {m,n}. The previous atom is optional if 'm' is 0
+            size_t j = i + 1;
+            while(j < len && expr.GetChar(j) != '}') ++j;
+            long minCount = 0;
+            expr.Mid(i + 1, j - i - 1).BeforeFirst(',').ToLong(&minCount);
+            if(minCount == 0 && !current.IsEmpty()) current.RemoveLast();
+            i = j;
+            break;
+        }
+        case '+':
+        case '.':
+        case '^':
+        case '$':
+            break;
+        default:
+            isLiteral = true;
+            break;
+        }
+
+        if(isLiteral) {
+            current << ch;
+        } else {
+            flush();
+        }
+    }
+    flush();
+    if(groups.size() != 1) return false;
+
+    literals = groups.front().literals;
+    return !literals.IsEmpty();
+}
+
+bool StringFindReplacer::ContainsLiterals(const wxString& str, const wxArrayString& literals, bool matchCase)
+{
+    for(size_t i = 0; i < literals.GetCount(); ++i) {
+        const wxString& literal = literals.Item(i);
+        if(literal.IsEmpty()) continue;
+
+        if(matchCase) {
+            if(str.find(literal) == wxString::npos) return false;
+            continue;
+        }
+
+        // case insensitive search, without copying the input
+        bool found = false;
+        wxChar first = wxTolower(literal.GetChar(0));
+        size_t last = str.length() >= literal.length() ? str.length() - literal.length() : 0;
+        for(size_t pos = 0; !found && str.length() >= literal.length() && pos <= last; ++pos) {
+            if(wxTolower(str.GetChar(pos)) != first) continue;
+            size_t j = 1;
+            while(j < literal.length() && wxTolower(str.GetChar(pos + j)) == wxTolower(literal.GetChar(j))) ++j;
+            found = (j == literal.length());
+        }
+        if(!found) return false;
+    }
+    return true;
+}
+
 bool StringFindReplacer::DoWildcardSearch(const wxString& input,
                                           int startOffset,
                                           const wxString& find_what,
                                           size_t flags,
                                           int& pos,
                                           int& matchLen)
+{
+    return DoRESearch(input, startOffset, WildcardToRegex(find_what), flags, pos, matchLen);
+}
+
+wxString StringFindReplacer::WildcardToRegex(const wxString& wildcard)
 {
     // Conver the wildcard to regex
-    wxString regexPattern = find_what;
+    wxString regexPattern = wildcard;
 
     // Escape braces
     regexPattern.Replace("(", "\\(");
@@ -85,7 +258,7 @@ bool StringFindReplacer::DoWildcardSearch(const wxString& input,
     regexPattern.Replace("*",
                          "[^\\n]*?"); // Non greedy wildcard '*', but don't allow matches to go beyond a single line
 
-    return DoRESearch(input, startOffset, regexPattern, flags, pos, matchLen);
+    return regexPattern;
 }
 
 bool StringFindReplacer::DoRESearch(const wxString& input,
@@ -105,17 +278,41 @@ bool StringFindReplacer::DoRESearch(const wxString& input,
 #else
     int re_flags = wxRE_DEFAULT;
 #endif
-    wxRegEx re;
     bool matchCase = flags & wxSD_MATCHCASE ? true : false;
     if(!matchCase) re_flags |= wxRE_ICASE;
     re_flags |= wxRE_NEWLINE; // Handle \n as a special character
-    re.Compile(find_what, re_flags);
+
+    // The last expression is kept compiled (along with its literals) since the editor searches
+    // the same expression over and over (find next, replace all). The cache is used by the main thread only
+    static wxString s_lastExpr;
+    static int s_lastFlags = 0;
+    static wxRegEx s_lastRe;
+    static wxArrayString s_lastLiterals;
+
+    wxRegEx localRe;
+    wxArrayString localLiterals;
+    bool useCache = wxThread::IsMain();
+    wxRegEx& re = useCache ? s_lastRe : localRe;
+    wxArrayString& literals = useCache ? s_lastLiterals : localLiterals;
+    if(!useCache || s_lastExpr != find_what || s_lastFlags != re_flags || !re.IsValid()) {
+        re.Compile(find_what, re_flags);
+        GetRegexLiterals(find_what, literals);
+        if(useCache) {
+            s_lastExpr = find_what;
+            s_lastFlags = re_flags;
+        }
+    }
 
     // incase we are scanning NOT backwared, set the offset
     if(!(flags & wxSD_SEARCH_BACKWARD)) {
         pos = startOffset;
     }
 
+    // No need to run the regex engine if the text does not contain the literals every match requires
+    if(!ContainsLiterals(str, literals, matchCase)) {
+        return false;
+    }
+
     if(re.IsValid()) {
         if(flags & wxSD_SEARCH_BACKWARD) {
             size_t start(0), len(0);
@@ -313,3 +510,98 @@ bool StringFindReplacer::Search(const wchar_t* input,
     int posInChars(0), matchLenInChars(0);
     return StringFindReplacer::Search(input, startOffset, find_what, flags, pos, matchLen, posInChars, matchLenInChars);
 }
+
+static bool IsWordChar(wchar_t ch) { return ch < 128 && (isalnum(ch) || ch == '_'); }
+
+void StringFindReplacer::DoSimpleSearchAll(const wxString& input,
+                                           const wxString& find_what,
+                                           size_t flags,
+                                           std::vector<std::pair<int, int> >& matches)
+{
+    std::wstring str(input.wc_str());
+    std::wstring find_str(find_what.wc_str());
+    if(!(flags & wxSD_MATCHCASE)) {
+        std::transform(find_str.begin(), find_str.end(), find_str.begin(), towlower);
+        std::transform(str.begin(), str.end(), str.begin(), towlower);
+    }
+
+    size_t len = find_str.length();
+    size_t upos = str.find(find_str);
+    while(upos != std::wstring::npos) {
+        if(flags & wxSD_MATCHWHOLEWORD) {
+            // the characters before and after the match must not be word chars [a-zA-Z0-9_]
+            if((upos > 0 && IsWordChar(str[upos - 1])) || (upos + len < str.length() && IsWordChar(str[upos + len]))) {
+                // A whole word match may start inside the rejected one (e.g. "a a" in "ba a a")
+                upos = str.find(find_str, upos + 1);
+                continue;
+            }
+        }
+        matches.push_back(std::make_pair((int)upos, (int)len));
+        upos = str.find(find_str, upos + len);
+    }
+}
+
+void StringFindReplacer::DoRESearchAll(const wxString& input,
+                                       const wxString& find_what,
+                                       size_t flags,
+                                       std::vector<std::pair<int, int> >& matches)
+{
+#ifndef __WXMAC__
+    int re_flags = wxRE_ADVANCED;
+#else
+    int re_flags = wxRE_DEFAULT;
+#endif
+    bool matchCase = flags & wxSD_MATCHCASE ? true : false;
+    if(!matchCase) re_flags |= wxRE_ICASE;
+    re_flags |= wxRE_NEWLINE; // Handle \n as a special character
+
+    wxRegEx re(find_what, re_flags);
+    if(!re.IsValid()) return;
+
+    // No need to run the regex engine if the text does not contain the literals every match requires
+    wxArrayString literals;
+    GetRegexLiterals(find_what, literals);
+    if(!ContainsLiterals(input, literals, matchCase)) return;
+
+    // Match in place: the regex runs from the current offset without copying the rest of the text
+    const wxChar* text = input.wc_str();
+    size_t length = input.length();
+    size_t offset = 0;
+    while(offset < length) {
+        // '^' matches only at the start of a line
+        int matchFlags = (offset > 0 && text[offset - 1] != '\n') ? wxRE_NOTBOL : 0;
+#ifdef wxHAS_REGEX_ADVANCED
+        if(!re.Matches(text + offset, matchFlags, length - offset)) break;
+#else
+        if(!re.Matches(text + offset, matchFlags)) break;
+#endif
+        size_t start(0), len(0);
+        if(!re.GetMatch(&start, &len)) break;
+
+        matches.push_back(std::make_pair((int)(offset + start), (int)len));
+        // an empty match must not be found again at the same position
+        offset += start + (len ? len : 1);
+    }
+}
+
+bool StringFindReplacer::SearchAll(const wxString& input,
+                                   const wxString& find_what,
+                                   size_t flags,
+                                   std::vector<std::pair<int, int> >& matches)
+{
+    matches.clear();
+    if(input.IsEmpty() || find_what.IsEmpty()) {
+        return false;
+    }
+
+    if(flags & wxSD_WILDCARD) {
+        DoRESearchAll(input, WildcardToRegex(find_what), flags, matches);
+
+    } else if(flags & wxSD_REGULAREXPRESSION) {
+        DoRESearchAll(input, find_what, flags, matches);
+
+    } else {
+        DoSimpleSearchAll(input, find_what, flags, matches);
+    }
+    return !matches.empty();
+}
@@ -26,7 +26,10 @@
 #define __stringsearcher__
 
 #include <wx/string.h>
+#include <wx/arrstr.h>
 #include "codelite_exports.h"
+#include <vector>
+#include <utility>
 
 // Possible search data options:
 enum {
@@ -66,8 +69,30 @@ protected:
                                size_t flags,
                                int& pos,
                                int& matchLen);
+    static wxString WildcardToRegex(const wxString& wildcard);
+    static void DoSimpleSearchAll(const wxString& input,
+                                  const wxString& find_what,
+                                  size_t flags,
+                                  std::vector<std::pair<int, int> >& matches);
+    static void DoRESearchAll(const wxString& input,
+                              const wxString& find_what,
+                              size_t flags,
+                              std::vector<std::pair<int, int> >& matches);
 
 public:
+    /**
+     * @brief collect the literal strings that any match of the regular expression 'expr' must contain.
+     * The extraction is conservative: expressions with top level alternation, embedded options or
+     * escapes that are not understood yield no literals
+     * @return true if at least one literal was found
+     */
+    static bool GetRegexLiterals(const wxString& expr, wxArrayString& literals);
+
+    /**
+     * @brief return true if 'str' contains all the 'literals'
+     */
+    static bool ContainsLiterals(const wxString& str, const wxArrayString& literals, bool matchCase);
+
     static bool
     Search(const wchar_t* input, int startOffset, const wchar_t* find_what, size_t flags, int& pos, int& matchLen);
     // overloaded method because of that ReplaceAll methods works on wxString and needs results in chars and other
@@ -81,5 +106,15 @@ public:
                        int& matchLen,
                        int& posInChars,
                        int& matchLenInChars);
+
+    /**
+     * @brief find all the matches of 'find_what' in 'input' in a single pass (always forward)
+     * @param matches [output] (position, length) of every match, in chars and ordered by their position
+     * @return true if a match was found
+     */
+    static bool SearchAll(const wxString& input,
+                          const wxString& find_what,
+                          size_t flags,
+                          std::vector<std::pair<int, int> >& matches);
 };
 #endif // __stringsearcher__
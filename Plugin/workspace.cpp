@@ -23,6 +23,7 @@
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 #include "workspace.h"
+#include "performance.h"
 #include <wx/log.h>
 #include <wx/app.h>
 #include <wx/msgdlg.h>
@@ -119,6 +120,7 @@ bool clCxxWorkspace::OpenReadOnly(const wxString& fileName, wxString& errMsg)
 
 bool clCxxWorkspace::OpenWorkspace(const wxString& fileName, wxString& errMsg)
 {
+    CL_TRACE_FUNCTION("workspace");
     CloseWorkspace();
     m_buildMatrix.Reset(NULL);
     wxFileName workSpaceFile(fileName);
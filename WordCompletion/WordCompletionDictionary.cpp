@@ -5,119 +5,123 @@
 #include "globals.h"
 #include "ieditor.h"
 #include "imanager.h"
-#include <wx/stc/stc.h>
+#include <wx/app.h>
 
 WordCompletionDictionary::WordCompletionDictionary()
 {
     EventNotifier::Get()->Bind(wxEVT_ACTIVE_EDITOR_CHANGED, &WordCompletionDictionary::OnEditorChanged, this);
+    EventNotifier::Get()->Bind(wxEVT_EDITOR_CLOSING, &WordCompletionDictionary::OnEditorClosing, this);
     EventNotifier::Get()->Bind(wxEVT_ALL_EDITORS_CLOSED, &WordCompletionDictionary::OnAllEditorsClosed, this);
-    EventNotifier::Get()->Bind(wxEVT_FILE_SAVED, &WordCompletionDictionary::OnFileSaved, this);
-
-    m_thread = new WordCompletionThread(this);
-    m_thread->Start();
+    wxTheApp->Bind(wxEVT_STC_MODIFIED, &WordCompletionDictionary::OnStcModified, this);
 }
 
 WordCompletionDictionary::~WordCompletionDictionary()
 {
     EventNotifier::Get()->Unbind(wxEVT_ACTIVE_EDITOR_CHANGED, &WordCompletionDictionary::OnEditorChanged, this);
+    EventNotifier::Get()->Unbind(wxEVT_EDITOR_CLOSING, &WordCompletionDictionary::OnEditorClosing, this);
     EventNotifier::Get()->Unbind(wxEVT_ALL_EDITORS_CLOSED, &WordCompletionDictionary::OnAllEditorsClosed, this);
-    EventNotifier::Get()->Unbind(wxEVT_FILE_SAVED, &WordCompletionDictionary::OnFileSaved, this);
-
-    m_thread->Stop();   // Stop the thread
-    wxDELETE(m_thread); // Delete it
+    wxTheApp->Unbind(wxEVT_STC_MODIFIED, &WordCompletionDictionary::OnStcModified, this);
 }
 
 void WordCompletionDictionary::OnEditorChanged(wxCommandEvent& event)
 {
     event.Skip();
+    DoIndexEditors();
+}
 
-    // 1) Get a list of all open editors and set the compare it to the current cached files
-    //    and delete all "closed" editors
-    // 2) Request to cache the newly opened file's words
-    IEditor::List_t allEditors;
-    wxArrayString openEditors, cachedEditors, closedEditors;
-    ::clGetManager()->GetAllEditors(allEditors);
+void WordCompletionDictionary::OnEditorClosing(wxCommandEvent& event)
+{
+    event.Skip();
+    IEditor* editor = reinterpret_cast<IEditor*>(event.GetClientData());
+    CHECK_PTR_RET(editor);
 
-    std::for_each(allEditors.begin(), allEditors.end(), [&](IEditor* editor) {
-        openEditors.Add(editor->GetFileName().GetFullPath());
-    });
+    DocumentMap_t::iterator iter = m_documents.find(editor->GetCtrl());
+    if(iter != m_documents.end()) {
+        m_index.Clear(iter->second);
+        m_documents.erase(iter);
+    }
+}
 
-    std::for_each(m_files.begin(), m_files.end(), [&](const std::pair<wxString, wxStringSet_t>& p) {
-        cachedEditors.Add(p.first);
+void WordCompletionDictionary::OnAllEditorsClosed(wxCommandEvent& event)
+{
+    event.Skip();
+    std::for_each(m_documents.begin(), m_documents.end(), [&](DocumentMap_t::value_type& p) {
+        m_index.Clear(p.second);
     });
+    m_documents.clear();
+}
 
-    // std::set_difference requires that both arrays will be sorted
-    openEditors.Sort();
-    cachedEditors.Sort();
+void WordCompletionDictionary::DoIndexEditors()
+{
+    // 1) Remove the documents of editors that are no longer open
+    // 2) Index the editors that we did not see yet
+    IEditor::List_t allEditors;
+    ::clGetManager()->GetAllEditors(allEditors);
 
-    // Create a new array "closedEditors" which contains list of files that exists
-    // in the cachedEditors but not in openEditors list
-    std::set_difference(cachedEditors.begin(),
-                        cachedEditors.end(),
-                        openEditors.begin(),
-                        openEditors.end(),
-                        std::back_inserter(closedEditors));
+    std::set<wxStyledTextCtrl*> openEditors;
+    std::for_each(allEditors.begin(), allEditors.end(), [&](IEditor* editor) {
+        openEditors.insert(editor->GetCtrl());
+    });
 
-    for(size_t i = 0; i < closedEditors.size(); ++i) {
-        m_files.erase(closedEditors.Item(i));
+    DocumentMap_t::iterator iter = m_documents.begin();
+    while(iter != m_documents.end()) {
+        if(openEditors.count(iter->first) == 0) {
+            m_index.Clear(iter->second);
+            m_documents.erase(iter++);
+        } else {
+            ++iter;
+        }
     }
 
-    // 2: cache the active editor
-    DoCacheActiveEditor(false);
+    std::for_each(openEditors.begin(), openEditors.end(), [&](wxStyledTextCtrl* stc) {
+        if(stc && m_documents.count(stc) == 0) {
+            DoIndexDocument(stc, m_documents[stc]);
+        }
+    });
 }
 
-void WordCompletionDictionary::OnSuggestThread(const WordCompletionThreadReply& reply)
+void WordCompletionDictionary::DoIndexDocument(wxStyledTextCtrl* stc, WordCompletionIndex::Document& doc)
 {
-    // Remove the current file's dictionary
-    std::map<wxString, wxStringSet_t>::iterator iter = m_files.find(reply.filename.GetFullPath());
-    if(iter != m_files.end()) m_files.erase(iter);
-
-    // Keep the words
-    m_files.insert(std::make_pair(reply.filename.GetFullPath(), reply.suggest));
+    // Scan the editor buffer in place, no copy
+    const char* text = stc->GetCharacterPointer();
+    m_index.SetText(doc, text ? text : "", text ? stc->GetLength() : 0);
 }
 
-void WordCompletionDictionary::OnAllEditorsClosed(wxCommandEvent& event)
+void WordCompletionDictionary::OnStcModified(wxStyledTextEvent& event)
 {
     event.Skip();
-    m_files.clear();
-}
+    if(!(event.GetModificationType() & (wxSTC_MOD_INSERTTEXT | wxSTC_MOD_DELETETEXT))) return;
+
+    wxStyledTextCtrl* stc = dynamic_cast<wxStyledTextCtrl*>(event.GetEventObject());
+    DocumentMap_t::iterator iter = m_documents.find(stc);
+    if(iter == m_documents.end()) return;
+    WordCompletionIndex::Document& doc = iter->second;
+
+    // The modified text is within the line that contains the event position, which was
+    // split into 1 + linesAdded lines (insertion) or merged with -linesAdded following lines (deletion)
+    int linesAdded = event.GetLinesAdded();
+    int lineCount = stc->GetLineCount();
+    if((int)doc.GetLineCount() + linesAdded != lineCount) {
+        // We missed a change, index the whole document again
+        DoIndexDocument(stc, doc);
+        return;
+    }
 
-void WordCompletionDictionary::DoCacheActiveEditor(bool overwrite)
-{
-    // Step 2: cache the active editor (if not already cached)
-    IEditor* activeEditor = ::clGetManager()->GetActiveEditor();
-    CHECK_PTR_RET(activeEditor);
-
-    if(!overwrite && m_files.count(activeEditor->GetFileName().GetFullPath()))
-        return; // we already have this file in the cache
-        
-    m_files.erase(activeEditor->GetFileName().GetFullPath());
-    
-    // Insert a dummy entry, so we won't queue this file if not needed
-    m_files.insert(std::make_pair(activeEditor->GetFileName().GetFullPath(), wxStringSet_t()));
-    
-    // Queue this file
-    wxStyledTextCtrl* stc = activeEditor->GetCtrl();
-    
-    // Invoke the thread to parse and suggets words for this file
-    WordCompletionThreadRequest* req = new WordCompletionThreadRequest;
-    req->buffer = stc->GetText();
-    req->filename = activeEditor->GetFileName();
-    req->filter = "filter";
-    m_thread->Add(req);
-}
+    int line = stc->LineFromPosition(event.GetPosition());
+    size_t oldCount = 1 + (linesAdded < 0 ? -linesAdded : 0);
+    size_t newCount = 1 + (linesAdded > 0 ? linesAdded : 0);
+    int startPos = stc->PositionFromLine(line);
+    int endPos = (line + (int)newCount < lineCount) ? stc->PositionFromLine(line + newCount) : stc->GetLength();
 
-void WordCompletionDictionary::OnFileSaved(clCommandEvent& event)
-{
-    event.Skip();
-    DoCacheActiveEditor(true);
+    wxCharBuffer text = stc->GetTextRangeRaw(startPos, endPos);
+    m_index.ReplaceLines(doc, line, oldCount, newCount, text.data() ? text.data() : "", text.length());
 }
 
-wxStringSet_t WordCompletionDictionary::GetWords() const
+void WordCompletionDictionary::GetWords(const wxString& filter,
+                                        WordCompletionIndex::eMatch match,
+                                        wxStringSet_t& words)
 {
-    wxStringSet_t words;
-    std::for_each(m_files.begin(), m_files.end(), [&](const std::pair<wxString, wxStringSet_t>& p){
-        words.insert(p.second.begin(), p.second.end());
-    });
-    return words;
+    // Make sure that all the open editors are indexed
+    DoIndexEditors();
+    m_index.GetWords(filter, match, words);
 }
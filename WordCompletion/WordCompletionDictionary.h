@@ -4,37 +4,34 @@
 #include "macros.h"
 #include <wx/string.h>
 #include <wx/event.h>
-#include "WordCompletionThread.h"
-#include "WordCompletionRequestReply.h"
-#include "cl_command_event.h"
+#include <wx/stc/stc.h>
+#include <map>
+#include "WordCompletionIndex.h"
 
 class WordCompletionDictionary : public wxEvtHandler
 {
-    std::map<wxString, wxStringSet_t> m_files;
-    WordCompletionThread* m_thread;
+    typedef std::map<wxStyledTextCtrl*, WordCompletionIndex::Document> DocumentMap_t;
+    DocumentMap_t m_documents;
+    WordCompletionIndex m_index;
 
 protected:
     void OnEditorChanged(wxCommandEvent& event);
+    void OnEditorClosing(wxCommandEvent& event);
     void OnAllEditorsClosed(wxCommandEvent& event);
-    void OnFileSaved(clCommandEvent& event);
+    void OnStcModified(wxStyledTextEvent& event);
 
 private:
-    void DoCacheActiveEditor(bool overwrite);
+    void DoIndexEditors();
+    void DoIndexDocument(wxStyledTextCtrl* stc, WordCompletionIndex::Document& doc);
 
 public:
     WordCompletionDictionary();
     virtual ~WordCompletionDictionary();
-    
-    /**
-     * @brief this function is called by the word completion thread when parsing phase is done
-     * @param reply
-     */
-    void OnSuggestThread(const WordCompletionThreadReply& reply);
-    
+
     /**
-     * @brief return a set of words from the current editors
+     * @brief collect the words of the open editors which match 'filter'
      */
-    wxStringSet_t GetWords() const;
+    void GetWords(const wxString& filter, WordCompletionIndex::eMatch match, wxStringSet_t& words);
 };
 
 #endif // WORDCOMPLETIONDICTIONARY_H
@@ -0,0 +1,170 @@
+#include "WordCompletionIndex.h"
+#include <algorithm>
+
+namespace
+{
+// The characters that separate words
+struct WordDelimiters {
+    bool table[256];
+    WordDelimiters()
+    {
+        std::fill(table, table + 256, false);
+        const char* delims = "\r\n \t->./\\'\"[]()<>*&^%#!@+=:,;{}|/";
+        for(const char* p = delims; *p; ++p) {
+            table[(unsigned char)*p] = true;
+        }
+    }
+    bool IsDelimiter(char ch) const { return table[(unsigned char)ch]; }
+};
+const WordDelimiters s_delimiters;
+}
+
+WordCompletionIndex::WordCompletionIndex() {}
+
+WordCompletionIndex::~WordCompletionIndex() {}
+
+void WordCompletionIndex::DoAddWord(const char* word, size_t len, WordIdVec_t& line)
+{
+    // Numbers are not words
+    if(word[0] >= '0' && word[0] <= '9') return;
+
+    std::pair<IdMap_t::iterator, bool> res = m_ids.insert(std::make_pair(std::string(word, len), 0));
+    if(res.second) {
+        // A new word
+        unsigned int id;
+        if(m_freeIds.empty()) {
+            id = m_words.size();
+            m_words.push_back(Word());
+        } else {
+            id = m_freeIds.back();
+            m_freeIds.pop_back();
+        }
+        Word& w = m_words.at(id);
+        w.key = res.first;
+        w.word = wxString(word, wxConvUTF8, len);
+        w.sorted = m_sorted.insert(std::make_pair(w.word.Lower(), id));
+        w.refs = 0;
+        res.first->second = id;
+    }
+
+    unsigned int id = res.first->second;
+    ++m_words.at(id).refs;
+    line.push_back(id);
+}
+
+void WordCompletionIndex::DoRelease(const WordIdVec_t& line)
+{
+    for(size_t i = 0; i < line.size(); ++i) {
+        Word& w = m_words.at(line.at(i));
+        if(--w.refs == 0) {
+            // The last occurrence of this word is gone
+            m_sorted.erase(w.sorted);
+            m_ids.erase(w.key);
+            w.word.Clear();
+            m_freeIds.push_back(line.at(i));
+        }
+    }
+}
+
+void WordCompletionIndex::DoScan(const char* text, size_t len, std::vector<WordIdVec_t>& lines)
+{
+    lines.push_back(WordIdVec_t());
+    size_t start = std::string::npos;
+    for(size_t i = 0; i < len; ++i) {
+        char ch = text[i];
+        if(!s_delimiters.IsDelimiter(ch)) {
+            if(start == std::string::npos) start = i;
+            continue;
+        }
+
+        if(start != std::string::npos) {
+            DoAddWord(text + start, i - start, lines.back());
+            start = std::string::npos;
+        }
+
+        // A new line starts after LF, CR LF or a lone CR
+        if(ch == '\n' || (ch == '\r' && (i + 1 == len || text[i + 1] != '\n'))) {
+            lines.push_back(WordIdVec_t());
+        }
+    }
+
+    if(start != std::string::npos) {
+        DoAddWord(text + start, len - start, lines.back());
+    }
+}
+
+void WordCompletionIndex::SetText(Document& doc, const char* text, size_t len)
+{
+    Clear(doc);
+    DoScan(text, len, doc.m_lines);
+}
+
+void WordCompletionIndex::ReplaceLines(Document& doc,
+                                       size_t line,
+                                       size_t oldCount,
+                                       size_t newCount,
+                                       const char* text,
+                                       size_t len)
+{
+    line = std::min(line, doc.m_lines.size());
+    oldCount = std::min(oldCount, doc.m_lines.size() - line);
+
+    std::vector<WordIdVec_t> lines;
+    DoScan(text, len, lines);
+    // The text ends with an EOL, so the scanner sees an extra (empty) line after it
+    if(lines.size() > newCount) {
+        for(size_t i = newCount; i < lines.size(); ++i) {
+            DoRelease(lines.at(i));
+        }
+    }
+    lines.resize(newCount);
+
+    // Release the words of the replaced lines only after scanning the new ones: most of the words
+    // are still there and we don't want to drop them from the index just to add them back
+    std::vector<WordIdVec_t>::iterator first = doc.m_lines.begin() + line;
+    std::vector<WordIdVec_t>::iterator last = first + oldCount;
+    for(std::vector<WordIdVec_t>::iterator iter = first; iter != last; ++iter) {
+        DoRelease(*iter);
+    }
+
+    // Swap the lines that exist in both ranges and insert / erase the rest
+    size_t common = std::min(oldCount, newCount);
+    for(size_t i = 0; i < common; ++i) {
+        doc.m_lines.at(line + i).swap(lines.at(i));
+    }
+    if(newCount > oldCount) {
+        doc.m_lines.insert(doc.m_lines.begin() + line + common, lines.begin() + common, lines.end());
+    } else if(oldCount > newCount) {
+        doc.m_lines.erase(doc.m_lines.begin() + line + common, doc.m_lines.begin() + line + oldCount);
+    }
+}
+
+void WordCompletionIndex::Clear(Document& doc)
+{
+    for(size_t i = 0; i < doc.m_lines.size(); ++i) {
+        DoRelease(doc.m_lines.at(i));
+    }
+    doc.m_lines.clear();
+}
+
+void WordCompletionIndex::GetWords(const wxString& filter, eMatch match, wxStringSet_t& words) const
+{
+    wxString lcFilter = filter.Lower();
+    SortedMap_t::const_iterator iter = m_sorted.begin();
+    if(match == kMatchStartsWith) {
+        iter = m_sorted.lower_bound(lcFilter);
+    }
+
+    for(; iter != m_sorted.end(); ++iter) {
+        if(match == kMatchStartsWith) {
+            if(!iter->first.StartsWith(lcFilter)) break; // sorted: no more matches
+        } else if(!lcFilter.IsEmpty() && !iter->first.Contains(lcFilter)) {
+            continue;
+        }
+
+        const wxString& word = m_words.at(iter->second).word;
+        if(!word.IsEmpty() && word != filter) {
+            words.insert(word);
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef WORDCOMPLETIONINDEX_H
+#define WORDCOMPLETIONINDEX_H
+
+#include "macros.h"
+#include <wx/string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @class WordCompletionIndex
+ * @brief an incremental index of the words found in the open editors.
+ * Every editor has a Document which keeps, line by line, the IDs of the words it contains. Words are interned
+ * once for all the documents and reference counted, a word is removed from the index when its last occurrence
+ * is gone. The words in use are kept sorted by their lower case form, so "starts with" queries are a binary search.
+ * The text is never stored: the editor reports the lines that were changed and the index re-scans only them
+ */
+class WordCompletionIndex
+{
+public:
+    enum eMatch {
+        kMatchStartsWith = 0, // case insensitive
+        kMatchContains,       // case insensitive
+    };
+
+    typedef std::vector<unsigned int> WordIdVec_t;
+
+    /**
+     * @class Document
+     * @brief the words of a single editor, by line
+     */
+    class Document
+    {
+        friend class WordCompletionIndex;
+        std::vector<WordIdVec_t> m_lines;
+
+    public:
+        size_t GetLineCount() const { return m_lines.size(); }
+    };
+
+protected:
+    typedef std::multimap<wxString, unsigned int> SortedMap_t; // lower case word -> word ID
+    typedef std::map<std::string, unsigned int> IdMap_t;       // UTF-8 word -> word ID
+
+    struct Word {
+        IdMap_t::iterator key;
+        SortedMap_t::iterator sorted;
+        wxString word;
+        size_t refs;
+    };
+
+    std::vector<Word> m_words;
+    std::vector<unsigned int> m_freeIds;
+    IdMap_t m_ids;
+    SortedMap_t m_sorted;
+
+protected:
+    void DoScan(const char* text, size_t len, std::vector<WordIdVec_t>& lines);
+    void DoAddWord(const char* word, size_t len, WordIdVec_t& line);
+    void DoRelease(const WordIdVec_t& line);
+
+public:
+    WordCompletionIndex();
+    virtual ~WordCompletionIndex();
+
+    /**
+     * @brief index the whole content of a document, replacing whatever was indexed for it
+     * @param text the document text (UTF-8)
+     */
+    void SetText(Document& doc, const char* text, size_t len);
+
+    /**
+     * @brief the document lines [line, line + oldCount) were replaced by 'newCount' lines whose text is 'text'
+     */
+    void ReplaceLines(Document& doc, size_t line, size_t oldCount, size_t newCount, const char* text, size_t len);
+
+    /**
+     * @brief remove the document words from the index
+     */
+    void Clear(Document& doc);
+
+    /**
+     * @brief collect the words which match 'filter'. An empty filter matches all the words, a word identical to
+     * 'filter' is not returned
+     */
+    void GetWords(const wxString& filter, eMatch match, wxStringSet_t& words) const;
+
+    /**
+     * @brief return the number of unique words in the index
+     */
+    size_t GetWordsCount() const { return m_sorted.size(); }
+};
+
+#endif // WORDCOMPLETIONINDEX_H
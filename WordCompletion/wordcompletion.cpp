@@ -1,6 +1,5 @@
 #include "wordcompletion.h"
 #include <wx/xrc/xmlres.h>
-#include "WordCompletionThread.h"
 #include <wx/stc/stc.h>
 #include "clKeyboardManager.h"
 #include <wx/app.h>
@@ -101,36 +100,14 @@ void WordCompletionPlugin::OnWordComplete(wxCommandEvent& event)
     if(curPos < start) return;
 
     wxString filter = stc->GetTextRange(start, curPos);
-    wxString lcFilter = filter.Lower();
-
-    wxStringSet_t words = m_dictionary->GetWords();
-    // Parse the current bufer (if modified), to include non saved words
-    if(activeEditor->IsModified()) {
-        wxStringSet_t unsavedBufferWords;
-        WordCompletionThread::ParseBuffer(stc->GetText(), unsavedBufferWords);
-        
-        // Merge the results
-        words.insert(unsavedBufferWords.begin(), unsavedBufferWords.end());
-    }
-    
+
+    // The index follows the editors changes, so unsaved words are included
     wxStringSet_t filterdSet;
-    if(lcFilter.IsEmpty()) {
-        filterdSet.swap(words);
-    } else {
-        for(wxStringSet_t::iterator iter = words.begin(); iter != words.end(); ++iter) {
-            wxString word = *iter;
-            wxString lcWord = word.Lower();
-            if(settings.GetComparisonMethod() == WordCompletionSettings::kComparisonStartsWith) {
-                if(lcWord.StartsWith(lcFilter) && filter != word) {
-                    filterdSet.insert(word);
-                }
-            } else {
-                if(lcWord.Contains(lcFilter) && filter != word) {
-                    filterdSet.insert(word);
-                }
-            }
-        }
-    }
+    m_dictionary->GetWords(filter,
+                           settings.GetComparisonMethod() == WordCompletionSettings::kComparisonStartsWith ?
+                               WordCompletionIndex::kMatchStartsWith :
+                               WordCompletionIndex::kMatchContains,
+                           filterdSet);
     for(wxStringSet_t::iterator iter = filterdSet.begin(); iter != filterdSet.end(); ++iter) {
         entries.push_back(wxCodeCompletionBoxEntry::New(*iter, 0));
     }
@@ -2,7 +2,6 @@
 #define __WordCompletion__
 
 #include "plugin.h"
-#include "WordCompletionRequestReply.h"
 #include "UI.h"
 #include "cl_command_event.h"
 #include "macros.h"
@@ -1,7 +1,8 @@
 #include "PHPSymbolsCacher.h"
-#include <wx/ffile.h>
 #include <wx/stopwatch.h>
 #include "php_code_completion.h"
+#include "PHPLookupTable.h"
+#include "file_logger.h"
 
 PHPSymbolsCacher::PHPSymbolsCacher(PHPCodeCompletion* owner, const wxString& dbfile)
     : m_owner(owner)
@@ -16,12 +17,11 @@ void PHPSymbolsCacher::Process(wxThread* thread)
     wxStopWatch sw;
     sw.Start();
 
-    wxFFile dbFile(m_filename, "rb");
-    if(dbFile.IsOpened()) {
-        wxString fileContent;
-        wxCSConv fontEncConv(wxFONTENCODING_ISO8859_1);
-        dbFile.ReadAll(&fileContent, fontEncConv);
-        dbFile.Close();
+    // Load the symbols index of the database. The index is shared with the code completion lookup table
+    PHPLookupTable lookupTable;
+    lookupTable.Open(wxFileName(m_filename));
+    if(lookupTable.LoadSymbolsIndex()) {
+        CL_DEBUG("PHP: symbols index loaded in %ld milliseconds", sw.Time());
         m_owner->CallAfter(&PHPCodeCompletion::OnSymbolsCached);
     } else {
         m_owner->CallAfter(&PHPCodeCompletion::OnSymbolsCacheError);
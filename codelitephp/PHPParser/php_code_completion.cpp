@@ -570,8 +570,7 @@ void PHPCodeCompletion::Open(const wxFileName& workspaceFile)
     Close();
     m_lookupTable.Open(workspaceFile.GetPath());
 
-    // Cache the symbols into the OS caching, this is done by simply reading the entire file content and
-    // then closing it
+    // Load the symbols index in the background. Until it is loaded, the lookups go to the database
     wxFileName fnDBFile(workspaceFile.GetPath(), "phpsymbols.db");
     fnDBFile.AppendDir(".codelite");
     JobQueueSingleton::Instance()->PushJob(new PHPSymbolsCacher(this, fnDBFile.GetFullPath()));
@@ -621,9 +620,9 @@ void PHPCodeCompletion::OnInsertDoxyBlock(clCodeCompletionEvent& e)
     }
 }
 
-void PHPCodeCompletion::OnSymbolsCached() { wxLogMessage("PHP Symbols cached into OS cache"); }
+void PHPCodeCompletion::OnSymbolsCached() { wxLogMessage("PHP symbols index loaded"); }
 
-void PHPCodeCompletion::OnSymbolsCacheError() { wxLogMessage("Error encountered while caching PHP symbols"); }
+void PHPCodeCompletion::OnSymbolsCacheError() { wxLogMessage("Error encountered while loading the PHP symbols index"); }
 
 void PHPCodeCompletion::OnQuickJump(clCodeCompletionEvent& e)
 {
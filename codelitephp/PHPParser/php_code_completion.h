@@ -112,14 +112,13 @@ public:
     void Close();
 
     /**
-     * @brief called by the PHP symbols cache job.
-     * This is to optimize the searching the database (loading the symbols into the
-     * memory forces a kernel caching)
+     * @brief called by the PHP symbols cache job once the in-memory symbols index
+     * of the workspace database is loaded
      */
     void OnSymbolsCached();
 
     /**
-     * @brief same as the above function, but the caching went bad...
+     * @brief same as the above function, but loading the index went bad...
      */
     void OnSymbolsCacheError();
     /**
@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <vector>
 #include "workerthread.h"
 #include "utils.h"
 #include "equeue.h"
@@ -29,13 +31,17 @@ int main(int argc, char **argv)
 	int  max_requests(5000);
 	int  requests(0);
 	long parent_pid (0);
+	long workers (0);
 	if(argc < 2){
-		printf("Usage: %s <string> [--pid]\n",    argv[0]);
+		printf("Usage: %s <string> [--pid] [--parent <pid>] [--workers <N>]\n",    argv[0]);
 		printf("Usage: %s --batch <file_list> <output file>\n", argv[0]);
-		printf("   <string> - a unique string that identifies this indexer from other instances               \n");
-		printf("   --pid    - when set, <string> is handled as process number and the indexer will            \n");
-		printf("              check if this process alive. If it is down, the indexer will go down as well\n");
-		printf("   --batch  - when set, batch parsing is done using list of files set in file_list argument   \n");
+		printf("   <string>  - a unique string that identifies this indexer from other instances               \n");
+		printf("   --pid     - when set, <string> is handled as process number and the indexer will            \n");
+		printf("               check if this process alive. If it is down, the indexer will go down as well\n");
+		printf("   --parent  - same as --pid, but the process number is given explicitly                       \n");
+		printf("   --workers - when set, run <N> indexer worker processes behind this one and distribute      \n");
+		printf("               the requests between them                                                      \n");
+		printf("   --batch   - when set, batch parsing is done using list of files set in file_list argument   \n");
 		return 1;
 	}
 
@@ -45,9 +51,18 @@ int main(int argc, char **argv)
 		return 0;
 	}
 
-	if ( argc == 3 && strcmp( argv[2], "--pid") == 0 ) {
-		parent_pid = atol( argv[1] );
-		printf("INFO: parent PID is set on %s\n", argv[1]);
+	for ( int i=2; i<argc; i++ ) {
+		if ( strcmp( argv[i], "--pid") == 0 ) {
+			parent_pid = atol( argv[1] );
+			printf("INFO: parent PID is set on %s\n", argv[1]);
+
+		} else if ( strcmp( argv[i], "--parent") == 0 && (i+1) < argc ) {
+			parent_pid = atol( argv[++i] );
+			printf("INFO: parent PID is set on %ld\n", parent_pid);
+
+		} else if ( strcmp( argv[i], "--workers") == 0 && (i+1) < argc ) {
+			workers = atol( argv[++i] );
+		}
 	}
 
 	// create the connection factory
@@ -56,12 +71,31 @@ int main(int argc, char **argv)
 
 	clNamedPipeConnectionsServer server(channel_name);
 
-	// start the worker thread
+	// In worker pool mode, this process only accepts the connections and hands them to
+	// the proxies. Each proxy forwards its requests to its own child indexer process
 	WorkerThread  worker( &g_connectionQueue );
+	std::vector<ProxyWorkerThread*> proxies;
+	if ( workers > 1 ) {
+		std::string exe = get_executable_path(argv[0]);
+		for ( long i=0; i<workers; i++ ) {
+			char worker_id[1024];
+			sprintf(worker_id, "%s_w%ld", argv[1], i);
+
+			char worker_channel[1024];
+			sprintf(worker_channel, PIPE_NAME, worker_id);
+
+			ProxyWorkerThread *proxy = new ProxyWorkerThread( &g_connectionQueue, exe, worker_id, worker_channel );
+			proxies.push_back( proxy );
+			proxy->run();
+		}
+		printf("INFO: running with %ld worker processes\n", workers);
+
+	} else {
+		worker.run();
+	}
 
 	// start the 'is alive thread'
 	IsAliveThread isAliveThread( parent_pid, channel_name  );
-	worker.run();
 	if ( parent_pid ) {
 		isAliveThread.run();
 	}
@@ -82,7 +116,9 @@ int main(int argc, char **argv)
 		g_connectionQueue.put( conn );
 		requests ++;
 
-		if(requests == max_requests) {
+		// In worker pool mode, the child indexers enforce the requests limit and the
+		// proxies restart them as needed
+		if(proxies.empty() && requests == max_requests) {
 			// stop the worker thread and exit
 			printf("INFO: Max requests reached, going down\n");
 			worker.requestStop();
@@ -44,10 +44,18 @@ void clIndexerReply::fromBinary(char* data)
 	// string       | file name string
 	// integer      | tags length
 	// string       | tags string
+	// integer      | batched blocks length
+	// string       | batched blocks
 	////////////////////////////////////////////////////////
 	UNPACK_INT(m_completionCode, data);
 	UNPACK_STD_STRING(m_fileName, data);
 	UNPACK_STD_STRING(m_tags, data);
+
+	// the blocks can be very large, assign them directly without the temporary
+	// buffer used by UNPACK_STD_STRING
+	size_t blocksLen(0);
+	UNPACK_INT(blocksLen, data);
+	m_blocks.assign(data, blocksLen);
 }
 
 char* clIndexerReply::toBinary(size_t& buffer_size)
@@ -58,12 +66,53 @@ char* clIndexerReply::toBinary(size_t& buffer_size)
 	buffer_size += m_fileName.length();
 	buffer_size += sizeof(size_t);
 	buffer_size += m_tags.length();
+	buffer_size += sizeof(size_t);
+	buffer_size += m_blocks.length();
 
 	char *data = new char[buffer_size];
 	char *ptr = data;
 	PACK_INT(data, m_completionCode);
 	PACK_STD_STRING(data, m_fileName);
 	PACK_STD_STRING(data, m_tags);
+	PACK_STD_STRING(data, m_blocks);
 	return ptr;
 }
 
+void clIndexerReply::addFileTags(const std::string& fileName, const char* tags, size_t tagsLen)
+{
+	size_t nameLen = fileName.length();
+	m_blocks.append((const char*)&nameLen, sizeof(nameLen));
+	m_blocks.append(fileName);
+	m_blocks.append((const char*)&tagsLen, sizeof(tagsLen));
+	if(tags && tagsLen) {
+		m_blocks.append(tags, tagsLen);
+	}
+}
+
+bool clIndexerReply::nextBlock(size_t& offset, Block& block) const
+{
+	const char *data = m_blocks.data();
+	size_t total = m_blocks.length();
+
+	// file name
+	if(offset + sizeof(size_t) > total)
+		return false;
+	memcpy(&block.fileNameLen, data + offset, sizeof(size_t));
+	offset += sizeof(size_t);
+	if(offset + block.fileNameLen > total)
+		return false;
+	block.fileName = data + offset;
+	offset += block.fileNameLen;
+
+	// tags
+	if(offset + sizeof(size_t) > total)
+		return false;
+	memcpy(&block.tagsLen, data + offset, sizeof(size_t));
+	offset += sizeof(size_t);
+	if(offset + block.tagsLen > total)
+		return false;
+	block.tags = data + offset;
+	offset += block.tagsLen;
+	return true;
+}
+
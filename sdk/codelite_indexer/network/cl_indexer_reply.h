@@ -32,6 +32,19 @@ class clIndexerReply
 	size_t m_completionCode;
 	std::string m_fileName;
 	std::string m_tags;
+	std::string m_blocks; // batched replies: per-file tag blocks, stored back to back
+
+public:
+	/**
+	 * @brief a single file's tags in a batched reply. The pointers point into the reply buffer
+	 * and are valid for as long as the reply object is alive and unmodified
+	 */
+	struct Block {
+		const char *fileName;
+		size_t      fileNameLen;
+		const char *tags;
+		size_t      tagsLen;
+	};
 
 public:
 	clIndexerReply();
@@ -58,5 +71,31 @@ public:
 	const std::string& getTags() const {
 		return m_tags;
 	}
+
+	/**
+	 * @brief reserve room for 'bytes' of batched tags blocks
+	 */
+	void reserveBlocks(size_t bytes) {
+		m_blocks.reserve(bytes);
+	}
+
+	/**
+	 * @brief append the tags of 'fileName' to the batched reply.
+	 * Each block is length prefixed: [size_t][file name][size_t][tags]
+	 */
+	void addFileTags(const std::string &fileName, const char *tags, size_t tagsLen);
+
+	/**
+	 * @brief iterate over the batched reply blocks. Start with offset = 0
+	 * @return false when there are no more blocks
+	 */
+	bool nextBlock(size_t &offset, Block &block) const;
+
+	/**
+	 * @brief return true if this reply contains batched blocks
+	 */
+	bool hasBlocks() const {
+		return !m_blocks.empty();
+	}
 };
 #endif // __clindexerreply__
@@ -38,7 +38,8 @@ class clIndexerRequest
 public:
 	enum {
 		CLI_PARSE,
-		CLI_PARSE_AND_SAVE
+		CLI_PARSE_AND_SAVE,
+		CLI_PARSE_BATCH     // parse many files, reply with a tags block per file
 	};
 
 public:
@@ -29,6 +29,9 @@
 
 #define ACK_MAGIC 1975
 
+// Dont read replies larger than this (batched replies carry the tags of many files)
+#define MAX_REPLY_SIZE_MB 64
+
 class CharDeleter {
 	char *m_ptr;
 public:
@@ -68,8 +71,8 @@ bool clIndexerProtocol::ReadReply(clNamedPipe* conn, clIndexerReply& reply)
 		return false;
 	}
 
-	if ((buff_len / (1024*1024)) > 15) {
-		// Dont read buffers larger than 15MB...
+	if ((buff_len / (1024*1024)) > MAX_REPLY_SIZE_MB) {
+		// Dont read buffers larger than MAX_REPLY_SIZE_MB...
 		return false;
 	}
 
@@ -15,6 +15,9 @@
 #    include <Tlhelp32.h>
 #else
 #    include <signal.h>
+#    include <unistd.h>
+#    include <sys/types.h>
+#    include <sys/wait.h>
 #endif
 
 #ifdef __FreeBSD__
@@ -107,6 +110,102 @@ bool is_process_alive(long pid)
 #endif
 }
 
+long start_process(const std::string &exe, const std::vector<std::string> &args)
+{
+#ifdef __WXMSW__
+	std::string cmd = "\"" + exe + "\"";
+	for(size_t i=0; i<args.size(); i++) {
+		cmd += " \"" + args.at(i) + "\"";
+	}
+
+	STARTUPINFOA si;
+	PROCESS_INFORMATION pi;
+	memset(&si, 0, sizeof(si));
+	memset(&pi, 0, sizeof(pi));
+	si.cb = sizeof(si);
+
+	std::vector<char> cmdline(cmd.begin(), cmd.end());
+	cmdline.push_back(0);
+	if ( !CreateProcessA(NULL, &cmdline[0], NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi) ) {
+		return -1;
+	}
+	CloseHandle(pi.hThread);
+	CloseHandle(pi.hProcess);
+	return (long)pi.dwProcessId;
+
+#else
+	std::vector<char*> argv;
+	argv.push_back(const_cast<char*>(exe.c_str()));
+	for(size_t i=0; i<args.size(); i++) {
+		argv.push_back(const_cast<char*>(args.at(i).c_str()));
+	}
+	argv.push_back(NULL);
+
+	pid_t pid = fork();
+	if ( pid == 0 ) {
+		// child. Use the PATH in case we were started without a full path
+		execvp(exe.c_str(), &argv[0]);
+		_exit(127);
+	}
+	return pid < 0 ? -1 : (long)pid;
+#endif
+}
+
+void kill_process(long pid)
+{
+	if ( pid <= 0 )
+		return;
+
+#ifdef __WXMSW__
+	HANDLE hProc = OpenProcess(PROCESS_TERMINATE, FALSE, (DWORD)pid);
+	if ( hProc ) {
+		TerminateProcess(hProc, 0);
+		CloseHandle(hProc);
+	}
+#else
+	kill((pid_t)pid, SIGTERM);
+	// reap it so we dont leave zombies behind
+	int status(0);
+	waitpid((pid_t)pid, &status, 0);
+#endif
+}
+
+bool is_child_process_alive(long pid)
+{
+	if ( pid <= 0 )
+		return false;
+
+#ifdef __WXMSW__
+	HANDLE hProc = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)pid);
+	if ( !hProc )
+		return false;
+	bool alive = (WaitForSingleObject(hProc, 0) == WAIT_TIMEOUT);
+	CloseHandle(hProc);
+	return alive;
+#else
+	int status(0);
+	return waitpid((pid_t)pid, &status, WNOHANG) == 0;
+#endif
+}
+
+std::string get_executable_path(const char *argv0)
+{
+#ifdef __WXMSW__
+	char path[MAX_PATH+1];
+	DWORD len = GetModuleFileNameA(NULL, path, MAX_PATH);
+	if ( len > 0 && len < MAX_PATH ) {
+		return std::string(path, len);
+	}
+#elif defined(__linux__)
+	char path[4096];
+	ssize_t len = readlink("/proc/self/exe", path, sizeof(path)-1);
+	if ( len > 0 ) {
+		return std::string(path, len);
+	}
+#endif
+	return argv0;
+}
+
 static char *load_file(const char *fileName) {
 	FILE *fp;
 	long len;
@@ -28,4 +28,31 @@ std::vector<std::string> string_tokenize(const std::string &str, const std::stri
  */
 bool is_process_alive(long pid);
 
+/**
+ * @brief start a process in the background
+ * @param exe the executable to run
+ * @param args the arguments (not including the executable)
+ * @return the process ID or -1 on failure
+ */
+long start_process(const std::string &exe, const std::vector<std::string> &args);
+
+/**
+ * @brief terminate a process that was started with start_process and release its resources
+ * @param pid process id
+ */
+void kill_process(long pid);
+
+/**
+ * @brief return true if a process that was started with start_process is still running.
+ * A child that exited is reaped, it must not be passed to kill_process afterwards
+ * @param pid process id
+ */
+bool is_child_process_alive(long pid);
+
+/**
+ * @brief return the full path of the running executable
+ * @param argv0 the program name as passed to main(), returned when the path can not be determined
+ */
+std::string get_executable_path(const char *argv0);
+
 #endif // __UTILS_H__
@@ -10,6 +10,7 @@
 #include <stdlib.h>
 #include <cstdio>
 #include <memory>
+#include <sstream>
 
 WorkerThread::WorkerThread(eQueue<clNamedPipe*> *queue)
 		: m_queue(queue)
@@ -37,8 +38,13 @@ void WorkerThread::start()
 				continue;
 			}
 
-			char *tags(NULL);
-			// create fies for the requested files
+			clIndexerReply reply;
+			bool batched = (req.getCmd() == clIndexerRequest::CLI_PARSE_BATCH);
+
+			// Collect the tags into a single growable buffer. Appending is amortized O(1),
+			// unlike re-allocating and copying the whole buffer for every file
+			std::string tags;
+			bool hasTags(false);
 			for (size_t i=0; i<req.getFiles().size(); i++) {
 
 #ifdef __DEBUG
@@ -50,24 +56,22 @@ void WorkerThread::start()
 #endif
 
 				char *new_tags = ctags_make_tags(req.getCtagOptions().c_str(), req.getFiles().at(i).c_str());
-				if (tags && new_tags) {
-					// re-allocate the buffer to containt the new tags + 2 chars: 1 for terminating null and one for the '\n'
-					// that will be appended
-					char *ptmp = (char*)malloc(strlen(tags) + strlen(new_tags) + 2);
-					memset(ptmp, 0, strlen(tags) + strlen(new_tags) + 2);
-					strcat(ptmp, tags);
-					strcat(ptmp, "\n");
-					strcat(ptmp, new_tags);
+				size_t new_tags_len = new_tags ? strlen(new_tags) : 0;
+				if (batched) {
+					// Always add a block, even an empty one, so the client gets a block per file
+					reply.addFileTags(req.getFiles().at(i), new_tags, new_tags_len);
+					hasTags = true;
 
-					ctags_free(new_tags);
-					ctags_free(tags);
-
-					tags = ptmp;
+				} else if (new_tags) {
+					if (hasTags) {
+						tags.append("\n");
+					}
+					tags.append(new_tags, new_tags_len);
+					hasTags = true;
+				}
 
-				} else if(new_tags) {
-					// first time
-					tags = new_tags;
-					new_tags = NULL;
+				if (new_tags) {
+					ctags_free(new_tags);
 				}
 			}
 
@@ -79,8 +83,7 @@ void WorkerThread::start()
 			}
 #endif
 
-			clIndexerReply reply;
-			if (tags) {
+			if (hasTags) {
 				// prepare reply
 				reply.setCompletionCode(1);
 				reply.setTags(tags);
@@ -88,8 +91,6 @@ void WorkerThread::start()
 				reply.setCompletionCode(0);
 			}
 
-			ctags_free(tags);
-
 			// send the reply
 			if ( !clIndexerProtocol::SendReply(conn, reply) ) {
 				fprintf(stderr, "ERROR: Protocol error: failed to send reply for file %s\n", reply.getFileName().c_str());
@@ -101,6 +102,129 @@ void WorkerThread::start()
 	exit(-1);
 }
 
+// ---------------------------------------------
+// worker pool proxy thread
+// ---------------------------------------------
+
+// how many times we try to connect to a child indexer that was just started
+#define PROXY_CONNECT_RETRIES 50
+
+ProxyWorkerThread::ProxyWorkerThread(eQueue<clNamedPipe*> *queue, const std::string &exe, const std::string &workerId, const std::string &channel)
+	: m_queue(queue)
+	, m_exe(exe)
+	, m_workerId(workerId)
+	, m_channel(channel)
+	, m_childPid(-1)
+{
+}
+
+ProxyWorkerThread::~ProxyWorkerThread()
+{
+	stopWorker();
+}
+
+bool ProxyWorkerThread::startWorker()
+{
+	stopWorker();
+
+	// the child watches our process and goes down with us
+	std::stringstream s;
+#ifdef __WXMSW__
+	s << GetCurrentProcessId();
+#else
+	s << getpid();
+#endif
+
+	std::vector<std::string> args;
+	args.push_back(m_workerId);
+	args.push_back("--parent");
+	args.push_back(s.str());
+
+	m_childPid = start_process(m_exe, args);
+	if ( m_childPid == -1 ) {
+		fprintf(stderr, "ERROR: ProxyWorkerThread: failed to start worker %s\n", m_workerId.c_str());
+		return false;
+	}
+	printf("INFO: ProxyWorkerThread: started worker %s (PID %ld)\n", m_workerId.c_str(), m_childPid);
+	return true;
+}
+
+void ProxyWorkerThread::stopWorker()
+{
+	if ( m_childPid != -1 ) {
+		kill_process(m_childPid);
+		m_childPid = -1;
+	}
+}
+
+bool ProxyWorkerThread::forward(clIndexerRequest &req, clIndexerReply &reply)
+{
+	clNamedPipeClient client(m_channel.c_str());
+
+	// the child might still be starting up
+	bool connected(false);
+	for (int i=0; i<PROXY_CONNECT_RETRIES && !testDestroy(); i++) {
+		if ( client.connect() ) {
+			connected = true;
+			break;
+		}
+
+		// dont wait for a child that is gone (it exits after serving max_requests)
+		if ( !is_child_process_alive(m_childPid) ) {
+			m_childPid = -1;
+			break;
+		}
+		eThreadSleep(100);
+	}
+
+	if ( !connected ) {
+		return false;
+	}
+
+	if ( !clIndexerProtocol::SendRequest(&client, req) ) {
+		return false;
+	}
+	return clIndexerProtocol::ReadReply(&client, reply);
+}
+
+void ProxyWorkerThread::start()
+{
+	printf("INFO: ProxyWorkerThread: Started\n");
+	startWorker();
+
+	while ( !testDestroy() ) {
+		clNamedPipe *conn(NULL);
+		if (!m_queue->get(conn, 100)) {
+			continue;
+		}
+
+		if (conn) {
+			std::auto_ptr<clNamedPipe> p( conn );
+			clIndexerRequest req;
+			if ( !clIndexerProtocol::ReadRequest(conn, req) ) {
+				continue;
+			}
+
+			clIndexerReply reply;
+			if ( !forward(req, reply) ) {
+				// The worker went down (it exits after serving a fixed number of requests or it crashed
+				// on a file), start a new one and try again
+				startWorker();
+				if ( !forward(req, reply) ) {
+					reply.setCompletionCode(0);
+				}
+			}
+
+			if ( !clIndexerProtocol::SendReply(conn, reply) ) {
+				fprintf(stderr, "ERROR: Protocol error: failed to send reply for file %s\n", reply.getFileName().c_str());
+			}
+		}
+	}
+
+	stopWorker();
+	printf("INFO: ProxyWorkerThread: Going down\n");
+}
+
 // ---------------------------------------------
 // is alive thread
 // ---------------------------------------------
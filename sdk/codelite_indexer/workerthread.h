@@ -4,6 +4,10 @@
 #include "network/named_pipe.h"
 #include "ethread.h"
 #include "equeue.h"
+#include <string>
+
+class clIndexerRequest;
+class clIndexerReply;
 
 // ---------------------------------------------
 // parsing thread
@@ -20,6 +24,41 @@ public:
 	virtual void start();
 };
 
+// ---------------------------------------------
+// worker pool proxy thread
+// ---------------------------------------------
+
+/**
+ * \brief a thread that owns a single child indexer process and forwards the requests
+ * it picks from the connection queue to it. libctags keeps global state, so the
+ * only way to run several parsers concurrently is to run them in separate processes
+ */
+class ProxyWorkerThread : public eThread {
+	eQueue<clNamedPipe*> *m_queue;
+	std::string m_exe;
+	std::string m_workerId;
+	std::string m_channel;
+	long        m_childPid;
+
+protected:
+	bool startWorker();
+	void stopWorker();
+	bool forward(clIndexerRequest &req, clIndexerReply &reply);
+
+public:
+	/**
+	 * \param queue the connections queue shared by all the proxies
+	 * \param exe path to the indexer executable
+	 * \param workerId the unique string identifying the child indexer
+	 * \param channel the named pipe the child indexer listens on
+	 */
+	ProxyWorkerThread(eQueue<clNamedPipe*> *queue, const std::string &exe, const std::string &workerId, const std::string &channel);
+	~ProxyWorkerThread();
+
+public:
+	virtual void start();
+};
+
 // ---------------------------------------------
 // is alive thread
 // ---------------------------------------------